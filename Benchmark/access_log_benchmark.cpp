@@ -0,0 +1,54 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "benchmark.h"
+
+#include "net/http/access_log.h"
+
+BENCHMARK_CASE(AccessLog_Log)
+{
+    using net::http::AccessLog;
+    auto request = net::http::Request::Create("GET", "http://example.com/api/v1/items?page=2&sort=name");
+    request->SetRemoteAddress("192.168.1.20:51234");
+    request->SetHeader("Referer", "https://example.com/items");
+    request->SetHeader("User-Agent", "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36");
+
+    size_t written = 0;
+    auto log = AccessLog::Create([&written](const std::string& lines) { written += lines.size(); }, AccessLog::kCombined);
+    log->SetFlushInterval(std::chrono::milliseconds(60000));
+
+    // The records of a round fit in a ring, Log is timed apart from the thread of the
+    // log which formats and writes them in Flush.
+    const size_t kRecords = 400;
+    const int kRounds = 1000;
+    double logging = 0;
+    double writing = 0;
+    for (int round = 0; round < kRounds; ++round)
+    {
+        bench::Stopwatch watch;
+        for (size_t i = 0; i < kRecords; ++i)
+            log->Log(*request, 200, 1024, std::chrono::microseconds(120));
+        logging += watch.ElapsedNanoseconds();
+        watch.Restart();
+        log->Flush();
+        writing += watch.ElapsedNanoseconds();
+    }
+    bench::Report("Log", logging / (kRecords * kRounds), "ns/record");
+    bench::Report("Format+Write", writing / (kRecords * kRounds), "ns/record");
+    bench::Report("Dropped", (double)log->GetDropped(), "records");
+}
@@ -0,0 +1,239 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+namespace {
+
+struct Case
+{
+    const char* Name;
+    std::function<void()> Function;
+};
+
+// Result is a line of the report, a Measure run when Iterations is not 0.
+struct Result
+{
+    std::string Name;
+    size_t Iterations;
+    double RealTime;
+    double CpuTime;
+    double BytesPerSecond;
+    double Value;
+    std::string Unit;
+};
+
+std::vector<Case>& Cases()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+const char* g_running = "";
+bool g_console = true;
+std::vector<Result> g_results;
+const void* volatile g_address = nullptr;
+
+thread_local size_t t_allocations = 0;
+thread_local size_t t_allocatedBytes = 0;
+
+std::string JsonString(const std::string& str)
+{
+    std::string quoted = "\"";
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        if ((unsigned char)c < 0x20)
+            continue;
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// WriteJson writes the results in the JSON format of Google Benchmark, so that its
+// tools/compare.py can compare two runs. Report lines have a value and a unit instead
+// of the times.
+void WriteJson(FILE* f)
+{
+    char date[32] = "";
+    time_t now = time(nullptr);
+    struct tm local;
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &local);
+
+    fprintf(f, "{\n  \"context\": {\n");
+    fprintf(f, "    \"date\": \"%s\",\n", date);
+    fprintf(f, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+    fprintf(f, "    \"library_build_type\": \"release\"\n");
+#else
+    fprintf(f, "    \"library_build_type\": \"debug\"\n");
+#endif
+    fprintf(f, "  },\n  \"benchmarks\": [");
+    for (size_t i = 0; i < g_results.size(); ++i)
+    {
+        auto& r = g_results[i];
+        fprintf(f, "%s\n    {\n      \"name\": %s,\n", i > 0 ? "," : "", JsonString(r.Name).c_str());
+        if (r.Iterations > 0)
+        {
+            fprintf(f, "      \"run_name\": %s,\n", JsonString(r.Name).c_str());
+            fprintf(f, "      \"run_type\": \"iteration\",\n");
+            fprintf(f, "      \"iterations\": %zu,\n", r.Iterations);
+            fprintf(f, "      \"real_time\": %.4f,\n", r.RealTime);
+            fprintf(f, "      \"cpu_time\": %.4f,\n", r.CpuTime);
+            if (r.BytesPerSecond > 0)
+                fprintf(f, "      \"bytes_per_second\": %.4f,\n", r.BytesPerSecond);
+            fprintf(f, "      \"time_unit\": \"ns\"\n    }");
+        }
+        else
+        {
+            fprintf(f, "      \"run_type\": \"report\",\n");
+            fprintf(f, "      \"value\": %.4f,\n", r.Value);
+            fprintf(f, "      \"unit\": %s\n    }", JsonString(r.Unit).c_str());
+        }
+    }
+    fprintf(f, "\n  ]\n}\n");
+}
+
+} // !namespace anonymous
+
+size_t AllocationCount()
+{
+    return t_allocations;
+}
+
+size_t AllocatedBytes()
+{
+    return t_allocatedBytes;
+}
+
+void UseAddress(const void* p)
+{
+    g_address = p;
+}
+
+bool Register(const char* name, std::function<void()> function)
+{
+    Cases().push_back({ name, function });
+    return true;
+}
+
+void Report(const std::string& metric, double value, const std::string& unit)
+{
+    g_results.push_back({ std::string(g_running) + "/" + metric, 0, 0, 0, 0, value, unit });
+    if (g_console)
+        printf("%-32s %-32s %14.2f %s\n", g_running, metric.c_str(), value, unit.c_str());
+}
+
+void ReportRun(const std::string& metric, size_t iterations,
+    double realNanoseconds, double cpuNanoseconds, size_t bytes)
+{
+    double bytesPerSecond = bytes > 0 ? bytes * iterations * 1e9 / realNanoseconds : 0;
+    g_results.push_back({ std::string(g_running) + "/" + metric, iterations,
+        realNanoseconds / iterations, cpuNanoseconds / iterations, bytesPerSecond, 0, "" });
+    if (!g_console)
+        return;
+    printf("%-32s %-32s %14.2f ns", g_running, metric.c_str(), realNanoseconds / iterations);
+    if (bytesPerSecond > 0)
+        printf(" %10.1f MiB/s", bytesPerSecond / (1024 * 1024));
+    printf("\n");
+}
+
+} // !namespace bench
+
+// Count the allocations, the array and nothrow forms end up here too.
+void* operator new(size_t size)
+{
+    ++bench::t_allocations;
+    bench::t_allocatedBytes += size;
+    void* p = malloc(size > 0 ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+// Usage: Benchmark [--benchmark_format=json] [--benchmark_out=<file>] [name...]
+// The benchmarks whose names contain one of the names are run, all of them without names.
+// The results are printed as a table, or as JSON with --benchmark_format=json, and
+// --benchmark_out writes them as JSON to <file> as well.
+int main(int argc, char* argv[])
+{
+    const std::string kFormat = "--benchmark_format=";
+    const std::string kOut = "--benchmark_out=";
+    std::string out;
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, kFormat.size(), kFormat) == 0)
+            bench::g_console = arg.substr(kFormat.size()) != "json";
+        else if (arg.compare(0, kOut.size(), kOut) == 0)
+            out = arg.substr(kOut.size());
+        else
+            names.push_back(arg);
+    }
+
+    for (auto& c : bench::Cases())
+    {
+        bool run = names.empty();
+        for (size_t i = 0; i < names.size() && !run; ++i)
+            run = std::string(c.Name).find(names[i]) != std::string::npos;
+        if (!run)
+            continue;
+        bench::g_running = c.Name;
+        c.Function();
+    }
+
+    if (!bench::g_console)
+        bench::WriteJson(stdout);
+    if (!out.empty())
+    {
+        FILE* f = fopen(out.c_str(), "w");
+        if (!f)
+        {
+            fprintf(stderr, "can't open %s\n", out.c_str());
+            return 1;
+        }
+        bench::WriteJson(f);
+        fclose(f);
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <functional>
+#include <string>
+
+namespace bench {
+
+// Register adds a benchmark to run, BENCHMARK_CASE registers one at startup.
+bool Register(const char* name, std::function<void()> function);
+
+// Report prints a result of the running benchmark.
+void Report(const std::string& metric, double value, const std::string& unit);
+
+// ReportRun prints the result of Measure: the wall and CPU time of |iterations| calls,
+// and the throughput if |bytes| per call is not 0.
+void ReportRun(const std::string& metric, size_t iterations,
+    double realNanoseconds, double cpuNanoseconds, size_t bytes);
+
+// UseAddress keeps the compiler from optimizing away what DoNotOptimize is given.
+void UseAddress(const void* p);
+
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+    UseAddress(&value);
+}
+
+// AllocationCount and AllocatedBytes return the number of operator new calls and the
+// bytes they asked for on the calling thread so far.
+size_t AllocationCount();
+size_t AllocatedBytes();
+
+// Stopwatch measures the time since it was started.
+class Stopwatch
+{
+public:
+    Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+
+    void Restart() { m_start = std::chrono::steady_clock::now(); }
+
+    double ElapsedNanoseconds() const
+    {
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// Measure calls |function| until it has run for at least half a second, growing the
+// number of iterations from the time taken by the last round, and reports the time per
+// call. |bytes| is the size of the input of a call, for the throughput.
+template <typename Function>
+void Measure(const std::string& metric, size_t bytes, Function function)
+{
+    const double kMinTime = 5e8;
+    const size_t kMaxIterations = 1000000000;
+    for (size_t iterations = 1; ; )
+    {
+        std::clock_t cpu = std::clock();
+        Stopwatch watch;
+        for (size_t i = 0; i < iterations; ++i)
+            function();
+        double elapsed = watch.ElapsedNanoseconds();
+        if (elapsed >= kMinTime || iterations >= kMaxIterations)
+        {
+            double cpuElapsed = (double)(std::clock() - cpu) * 1e9 / CLOCKS_PER_SEC;
+            ReportRun(metric, iterations, elapsed, cpuElapsed, bytes);
+            return;
+        }
+        // Aim 40% past the minimum time, growing at most tenfold a round.
+        double multiplier = elapsed > kMinTime / 10 ? kMinTime * 1.4 / elapsed : 10;
+        size_t next = (size_t)(iterations * multiplier);
+        iterations = next > iterations ? (next < kMaxIterations ? next : kMaxIterations) : iterations + 1;
+    }
+}
+
+} // !namespace bench
+
+#define BENCHMARK_CASE(name) \
+    static void name(); \
+    static bool name##_registered = bench::Register(#name, name); \
+    static void name()
@@ -0,0 +1,44 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Representative inputs of the benchmarks.
+namespace corpus {
+
+// HeaderSets returns the header lines of requests sent by a browser, curl and an API client.
+const std::vector<std::vector<std::string>>& HeaderSets();
+
+// Urls returns URLs as they appear in requests and links: short paths, long queries,
+// escaped characters, user info and fragments.
+const std::vector<std::string>& Urls();
+
+// Requests returns the requests of HeaderSets one after another, as received from a
+// pipelining client.
+std::string Requests();
+
+// Text returns |size| bytes of English-like text with escapable characters.
+std::string Text(size_t size);
+
+// Binary returns |size| random bytes.
+std::string Binary(size_t size);
+
+} // !namespace corpus
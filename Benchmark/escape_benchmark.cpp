@@ -0,0 +1,124 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "benchmark.h"
+#include "corpus.h"
+
+#include "net/base/base64.h"
+#include "net/base/escape.h"
+
+BENCHMARK_CASE(Escape_Strings)
+{
+    std::string query = "name=\xE5\xBC\xA0\xE4\xB8\x89&note=leave at the door & ring twice&coupon=SPRING-2024";
+    std::string text = corpus::Text(64 * 1024);
+    std::string escapedQuery = base::EscapeUrlEncodedData(query, true);
+    std::string escapedText = base::Escape(text);
+
+    bench::Measure("Escape/query", query.size(), [&] {
+        bench::DoNotOptimize(base::Escape(query));
+    });
+    bench::Measure("Escape/64K", text.size(), [&] {
+        bench::DoNotOptimize(base::Escape(text));
+    });
+    bench::Measure("EscapeUrlComponent/query", query.size(), [&] {
+        bench::DoNotOptimize(base::EscapeUrlComponent(query));
+    });
+    // Tokens such as session ids and signatures are mostly safe, non-ASCII text is not.
+    std::string safe = corpus::Binary(64 * 1024);
+    for (auto& c : safe)
+        c = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz-."[static_cast<unsigned char>(c) % 64];
+    std::string unsafe;
+    while (unsafe.size() < 64 * 1024)
+        unsafe += "\xE4\xB8\x96\xE7\x95\x8C ";
+    bench::Measure("EscapeUrlComponent/64K_safe", safe.size(), [&] {
+        bench::DoNotOptimize(base::EscapeUrlComponent(safe));
+    });
+    bench::Measure("EscapeUrlComponent/64K_unsafe", unsafe.size(), [&] {
+        bench::DoNotOptimize(base::EscapeUrlComponent(unsafe));
+    });
+    bench::Measure("EscapeUrlEncodedData/64K", text.size(), [&] {
+        bench::DoNotOptimize(base::EscapeUrlEncodedData(text, true));
+    });
+    bench::Measure("EscapeForHTML/64K", text.size(), [&] {
+        bench::DoNotOptimize(base::EscapeForHTML(text));
+    });
+    bench::Measure("Unescape/query", escapedQuery.size(), [&] {
+        bench::DoNotOptimize(base::Unescape(escapedQuery, true));
+    });
+    bench::Measure("Unescape/64K", escapedText.size(), [&] {
+        bench::DoNotOptimize(base::Unescape(escapedText));
+    });
+    // A tracking pixel query, long values with a few escapes each.
+    std::string tracking;
+    for (size_t i = 0; tracking.size() < 8 * 1024; i += 97)
+        tracking += "k" + std::to_string(i) + "=" + safe.substr(i, 90) + "%2F" + safe.substr(i + 90, 7) + "&";
+    bench::Measure("Unescape/tracking_8K", tracking.size(), [&] {
+        bench::DoNotOptimize(base::Unescape(tracking, true));
+    });
+    std::string buffer;
+    bench::Measure("UnescapeInPlace/tracking_8K", tracking.size(), [&] {
+        buffer.assign(tracking);
+        base::UnescapeInPlace(buffer, true);
+        bench::DoNotOptimize(buffer);
+    });
+    bench::Measure("UnescapeView/64K_safe", safe.size(), [&] {
+        bench::DoNotOptimize(base::UnescapeView(safe, buffer, true));
+    });
+}
+
+BENCHMARK_CASE(Base64_Sizes)
+{
+    // A Basic credential, a WebSocket key sized value, a small image and a large attachment.
+    const size_t kSizes[] = { 24, 256, 16 * 1024, 1024 * 1024 };
+    for (auto size : kSizes)
+    {
+        std::string data = corpus::Binary(size);
+        std::string encoded = base::base64::Encode(data);
+        std::string suffix = size >= 1024 ? std::to_string(size / 1024) + "K" : std::to_string(size);
+        bench::Measure("Encode/" + suffix, data.size(), [&] {
+            bench::DoNotOptimize(base::base64::Encode(data));
+        });
+        bench::Measure("Decode/" + suffix, encoded.size(), [&] {
+            bench::DoNotOptimize(base::base64::Decode(encoded));
+        });
+    }
+
+    // A payload embedded in pieces of 16K, with the URL safe alphabet.
+    std::string payload = corpus::Binary(1024 * 1024);
+    std::string encoded;
+    std::string decoded;
+    bench::Measure("Encoder/1M_in_16K", payload.size(), [&] {
+        base::base64::Encoder encoder(base::base64::kUrlSafe | base::base64::kNoPadding);
+        encoded.clear();
+        for (size_t i = 0; i < payload.size(); i += 16 * 1024)
+            encoder.Update(reinterpret_cast<const unsigned char*>(payload.data()) + i, 16 * 1024, encoded);
+        encoder.Final(encoded);
+        bench::DoNotOptimize(encoded);
+    });
+    bench::Measure("Decoder/1M_in_16K", encoded.size(), [&] {
+        base::base64::Decoder decoder(base::base64::kUrlSafe | base::base64::kNoPadding);
+        decoded.clear();
+        for (size_t i = 0; i < encoded.size(); i += 16 * 1024)
+        {
+            size_t n = encoded.size() - i < 16 * 1024 ? encoded.size() - i : 16 * 1024;
+            decoder.Update(reinterpret_cast<const unsigned char*>(encoded.data()) + i, n, decoded);
+        }
+        decoder.Final(decoded);
+        bench::DoNotOptimize(decoded);
+    });
+}
@@ -0,0 +1,82 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "benchmark.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "net/http/metrics.h"
+
+namespace {
+
+net::http::Metrics::RequestSample ServedSample()
+{
+    using net::http::Metrics;
+    Metrics::RequestSample sample;
+    sample.StatusCode = 200;
+    sample.BytesReceived = 420;
+    sample.BytesSent = 180;
+    sample.Latency[Metrics::kReadHeader] = 12;
+    sample.Latency[Metrics::kHandler] = 3;
+    sample.Latency[Metrics::kWrite] = 40;
+    sample.Latency[Metrics::kRequest] = 60;
+    return sample;
+}
+
+} // !namespace anonymous
+
+// The server records a request with RecordRequest after reading the clock once a phase,
+// i.e. five times.
+BENCHMARK_CASE(Metrics_Record)
+{
+    using net::http::Metrics;
+    auto metrics = Metrics::Create();
+    auto sample = ServedSample();
+
+    bench::Measure("RecordRequest", 0, [&] {
+        metrics->RecordRequest(sample);
+    });
+    bench::Measure("Add", 0, [&] {
+        metrics->Add(Metrics::kConnectionsAccepted);
+    });
+    bench::Measure("steady_clock::now", 0, [] {
+        bench::DoNotOptimize(std::chrono::steady_clock::now());
+    });
+
+    // Concurrent recorders lease different shards.
+    const int kThreads = 8;
+    const size_t kRequests = 2000000;
+    std::vector<std::thread> threads;
+    bench::Stopwatch watch;
+    for (int i = 0; i < kThreads; ++i)
+    {
+        threads.emplace_back([&] {
+            for (size_t j = 0; j < kRequests; ++j)
+                metrics->RecordRequest(sample);
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    bench::Report("RecordRequest/8_threads", watch.ElapsedNanoseconds() / (kThreads * kRequests), "ns/request");
+
+    bench::Measure("ToPrometheus", 0, [&] {
+        bench::DoNotOptimize(metrics->ToPrometheus());
+    });
+}
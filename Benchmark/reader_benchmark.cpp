@@ -0,0 +1,93 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "benchmark.h"
+#include "corpus.h"
+
+#include "net/http/reader.h"
+#include "net/http/utils.h"
+
+namespace {
+
+using namespace net::http;
+
+// BufferReader reads the messages from memory instead of a socket.
+class BufferReader
+    : public Reader
+{
+public:
+    void Load(const std::string& bytes)
+    {
+        m_buffer = bytes;
+        m_offset = 0;
+    }
+};
+
+// ReadRequests parses the pipelined requests of |reader| the way Connection does.
+size_t ReadRequests(BufferReader& reader)
+{
+    size_t count = 0;
+    while (reader.GetBufferedBytes() > 0)
+    {
+        auto startLine = reader.ExtractStartLine();
+        auto parts = base::strings::SplitN(startLine, " ", 3);
+        if (parts.size() != 3)
+            break;
+        bool error;
+        auto lines = reader.ExtractHeaders(error);
+        if (error)
+            break;
+        Header header;
+        ParseHeader(lines, header);
+        auto request = Request::Create(parts[0], "http://" + header.find("Host")->second + parts[1]);
+        request->SetHeader(std::move(header));
+        reader.ExtractRequestMessage(request);
+        bench::DoNotOptimize(request);
+        ++count;
+    }
+    return count;
+}
+
+} // !namespace anonymous
+
+BENCHMARK_CASE(Reader_Pipelined)
+{
+    std::string requests = corpus::Requests();
+    BufferReader reader;
+    bench::Measure("Requests/corpus", requests.size(), [&] {
+        reader.Load(requests);
+        ReadRequests(reader);
+    });
+
+    // A large header block takes many lines.
+    std::string large = "GET / HTTP/1.1\r\nHost: localhost\r\n";
+    for (int i = 0; i < 100; ++i)
+        large += "X-Header-" + std::to_string(i) + ": " + corpus::Text(64) + "\r\n";
+    large += "\r\n";
+    bench::Measure("Requests/100_headers", large.size(), [&] {
+        reader.Load(large);
+        ReadRequests(reader);
+    });
+
+    std::string upload = "POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: 1048576\r\n\r\n" +
+        corpus::Binary(1024 * 1024);
+    bench::Measure("Requests/1M_body", upload.size(), [&] {
+        reader.Load(upload);
+        ReadRequests(reader);
+    });
+}
@@ -0,0 +1,187 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "benchmark.h"
+
+#include <thread>
+#include <vector>
+
+#include "net/http/connection.h"
+#include "net/socket/ServerSocket.h"
+
+namespace {
+
+using namespace net;
+
+const int kRequests = 100000;
+const char kRequest[] =
+    "GET /search?q=net&page=2 HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "User-Agent: Benchmark\r\n"
+    "Accept: */*\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "\r\n";
+
+const size_t kUploadSize = 50 * 1024 * 1024;
+const int kUploads = 5;
+
+// ConnectLoopback connects |client| to |server| through 127.0.0.1.
+bool ConnectLoopback(std::shared_ptr<StreamSocket>& client, std::shared_ptr<StreamSocket>& server)
+{
+    ServerSocket listener;
+    if (!listener.Bind(SocketAddress("127.0.0.1", 0)) || !listener.Listen())
+        return false;
+    client = std::make_shared<StreamSocket>();
+    if (!client->Connect(SocketAddress("127.0.0.1", listener.GetLocalAddress().GetPort())))
+        return false;
+    server = listener.Accept();
+    return server != nullptr;
+}
+
+// ServeKeepAlive serves kRequests pipelined requests of a loopback connection the way
+// http::Server does, and reports the allocations and the time per request.
+void ServeKeepAlive(bool recycling)
+{
+    std::shared_ptr<StreamSocket> client, s;
+    if (!ConnectLoopback(client, s))
+        return;
+
+    std::thread sender([client] {
+        std::string batch;
+        for (int i = 0; i < 100; ++i)
+            batch += kRequest;
+        for (int i = 0; i < kRequests / 100; ++i)
+            client->Send(batch.data(), (int)batch.size());
+    });
+    std::thread receiver([client] {
+        char buffer[65536];
+        while (client->Receive(buffer, sizeof(buffer)) > 0)
+        {
+        }
+    });
+
+    http::Connection conn(s);
+    conn.SetRecycling(recycling);
+    size_t allocations = bench::AllocationCount();
+    bench::Stopwatch watch;
+    int served = 0;
+    for (; served < kRequests; ++served)
+    {
+        auto request = conn.ReadRequest();
+        if (!request)
+            break;
+        auto ctx = conn.NewContext(request);
+        ctx->Write("Hello, World!");
+        ctx->Finish();
+        if (!conn.HasBufferedRequest() && !conn.Flush())
+            break;
+    }
+    conn.Flush();
+    double elapsed = watch.ElapsedNanoseconds();
+    allocations = bench::AllocationCount() - allocations;
+    s->Shutdown();
+    sender.join();
+    receiver.join();
+
+    if (served == 0)
+        return;
+    bench::Report(recycling ? "Recycled" : "New objects", (double)allocations / served, "allocs/request");
+    bench::Report(recycling ? "Recycled" : "New objects", elapsed / served, "ns/request");
+}
+
+// EchoUploads serves kUploads large POST requests whose handler sends the body back,
+// through a copy of the body or a view of it, and reports the bytes allocated and
+// the time per request.
+void EchoUploads(bool view)
+{
+    std::shared_ptr<StreamSocket> client, s;
+    if (!ConnectLoopback(client, s))
+        return;
+
+    std::thread sender([client] {
+        std::string header = "POST /upload HTTP/1.1\r\nHost: localhost\r\n"
+            "Content-Type: application/octet-stream\r\n"
+            "Content-Length: " + std::to_string(kUploadSize) + "\r\n\r\n";
+        std::string body(kUploadSize, 'x');
+        for (int i = 0; i < kUploads; ++i)
+        {
+            client->Send(header.data(), (int)header.size());
+            for (size_t sent = 0; sent < body.size(); )
+            {
+                int n = client->Send(body.data() + sent, (int)(body.size() - sent));
+                if (n <= 0)
+                    return;
+                sent += n;
+            }
+        }
+    });
+    std::thread receiver([client] {
+        std::vector<char> buffer(1024 * 1024);
+        while (client->Receive(buffer.data(), (int)buffer.size()) > 0)
+        {
+        }
+    });
+
+    http::Connection conn(s);
+    size_t bytes = bench::AllocatedBytes();
+    bench::Stopwatch watch;
+    int served = 0;
+    for (; served < kUploads; ++served)
+    {
+        auto request = conn.ReadRequest();
+        if (!request)
+            break;
+        auto ctx = conn.NewContext(request);
+        if (view)
+        {
+            auto body = request->GetBodyView();
+            ctx->Write(body.data(), (int)body.size());
+        }
+        else
+        {
+            ctx->Write(request->GetBody());
+        }
+        ctx->Finish();
+        if (!conn.Flush())
+            break;
+    }
+    double elapsed = watch.ElapsedNanoseconds();
+    bytes = bench::AllocatedBytes() - bytes;
+    s->Shutdown();
+    sender.join();
+    receiver.join();
+
+    if (served == 0)
+        return;
+    bench::Report(view ? "GetBodyView" : "GetBody", (double)bytes / served / (1024 * 1024), "MiB allocated/request");
+    bench::Report(view ? "GetBodyView" : "GetBody", elapsed / served / 1e6, "ms/request");
+}
+
+} // !namespace anonymous
+
+BENCHMARK_CASE(Connection_KeepAliveRequests)
+{
+    ServeKeepAlive(false);
+    ServeKeepAlive(true);
+}
+
+BENCHMARK_CASE(Connection_LargeUpload)
+{
+    EchoUploads(false);
+    EchoUploads(true);
+}
@@ -0,0 +1,85 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "benchmark.h"
+#include "corpus.h"
+
+#include "net/base/strings/string_utils.h"
+
+BENCHMARK_CASE(Strings_Utils)
+{
+    using namespace base::strings;
+
+    auto& browser = corpus::HeaderSets()[0];
+    std::string accept = browser[8].substr(8);
+    std::string cookie = browser[16].substr(8);
+    std::string text = corpus::Text(4096);
+
+    bench::Measure("Split/accept", accept.size(), [&] {
+        bench::DoNotOptimize(Split(accept, ","));
+    });
+    bench::Measure("Split/cookie", cookie.size(), [&] {
+        bench::DoNotOptimize(Split(cookie, ";"));
+    });
+    bench::Measure("SplitN/header_lines", 0, [&] {
+        for (auto& line : browser)
+            bench::DoNotOptimize(SplitN(line, ":", 2));
+    });
+    bench::Measure("SplitPieces/cookie", cookie.size(), [&] {
+        size_t n = 0;
+        for (auto piece : SplitPieces(cookie, ";"))
+            n += piece.size();
+        bench::DoNotOptimize(n);
+    });
+    bench::Measure("SplitPiecesN/header_lines", 0, [&] {
+        for (auto& line : browser)
+            bench::DoNotOptimize(SplitPiecesN<2>(line, ":"));
+    });
+    std::string padded = "   \t keep-alive \r\n";
+    bench::Measure("TrimSpace/padded", 0, [&] {
+        bench::DoNotOptimize(TrimSpace(padded));
+    });
+    bench::Measure("TrimSpace/padded_piece", 0, [&] {
+        bench::DoNotOptimize(TrimSpace(StringPiece(padded)));
+    });
+    std::string spaces = std::string(4096, ' ') + "x";
+    bench::Measure("TrimLeftSelf/4K", spaces.size(), [&] {
+        std::string str = spaces;
+        TrimLeftSelf(str, " ");
+        bench::DoNotOptimize(str);
+    });
+    bench::Measure("ToLower/4K", text.size(), [&] {
+        bench::DoNotOptimize(ToLower(text));
+    });
+    bench::Measure("ToUpper/method", 0, [] {
+        bench::DoNotOptimize(ToUpper("get"));
+    });
+    bench::Measure("Equal/ignore_case", 0, [] {
+        bench::DoNotOptimize(Equal("Content-Type", "content-type", true));
+    });
+    bench::Measure("StartsWith/ignore_case", 0, [&] {
+        bench::DoNotOptimize(StartsWith(accept, "TEXT/HTML", true));
+    });
+    std::string upper = ToUpper(text);
+    bench::Measure("Equal/ignore_case_4K", text.size(), [&] {
+        bench::DoNotOptimize(Equal(text, upper, true));
+    });
+    bench::Measure("HashIgnoreCase/header_name", 0, [] {
+        bench::DoNotOptimize(HashIgnoreCase("Accept-Encoding"));
+    });
+}
@@ -0,0 +1,109 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "benchmark.h"
+
+#include <random>
+#include <vector>
+
+#include "net/base/timer_wheel.h"
+
+namespace {
+
+const size_t kTimers = 1000000;
+// The deadlines spread over an hour, like the idle timeouts of many connections.
+const uint64_t kMaxDelay = 3600 * 1000;
+
+std::vector<uint64_t> RandomDelays()
+{
+    std::mt19937_64 random(1);
+    std::vector<uint64_t> delays(kTimers);
+    for (auto& delay : delays)
+        delay = random() % kMaxDelay;
+    return delays;
+}
+
+} // !namespace anonymous
+
+BENCHMARK_CASE(TimerWheel_MillionTimers)
+{
+    auto delays = RandomDelays();
+    base::TimerWheel wheel;
+    std::vector<base::TimerWheel::TimerId> ids(kTimers);
+    size_t fired = 0;
+
+    bench::Stopwatch watch;
+    for (size_t i = 0; i < kTimers; ++i)
+        ids[i] = wheel.Schedule(delays[i], [&fired] { ++fired; });
+    bench::Report("Schedule", watch.ElapsedNanoseconds() / kTimers, "ns/timer");
+
+    // A request finishing before its deadline cancels the timer and arms the next one.
+    watch.Restart();
+    for (size_t i = 0; i < kTimers; i += 2)
+    {
+        wheel.Cancel(ids[i]);
+        ids[i] = wheel.Schedule(delays[i] / 2, [&fired] { ++fired; });
+    }
+    bench::Report("Cancel+Schedule", watch.ElapsedNanoseconds() / (kTimers / 2), "ns/timer");
+
+    // Advance a millisecond at a time like TimerService, the timers move down the
+    // levels and fire on the way.
+    std::vector<base::TimerWheel::Callback> expired;
+    watch.Restart();
+    for (uint64_t now = 1; now <= kMaxDelay; ++now)
+    {
+        wheel.Advance(now, expired);
+        for (auto& callback : expired)
+            callback();
+        expired.clear();
+    }
+    double elapsed = watch.ElapsedNanoseconds();
+    bench::Report("Advance", elapsed / kMaxDelay, "ns/tick");
+    bench::Report("Advance+Fire", elapsed / fired, "ns/timer");
+    bench::Report("Fired", (double)fired, "timers");
+}
+
+BENCHMARK_CASE(TimerWheel_Cancel)
+{
+    auto delays = RandomDelays();
+    base::TimerWheel wheel;
+    std::vector<base::TimerWheel::TimerId> ids(kTimers);
+    for (size_t i = 0; i < kTimers; ++i)
+        ids[i] = wheel.Schedule(delays[i], [] {});
+
+    bench::Stopwatch watch;
+    for (auto id : ids)
+        wheel.Cancel(id);
+    bench::Report("Cancel", watch.ElapsedNanoseconds() / kTimers, "ns/timer");
+}
+
+BENCHMARK_CASE(TimerService_ScheduleCancel)
+{
+    base::TimerService service;
+    std::vector<base::TimerWheel::TimerId> ids(kTimers);
+
+    bench::Stopwatch watch;
+    for (size_t i = 0; i < kTimers; ++i)
+        ids[i] = service.Schedule(std::chrono::milliseconds(1000 + i % 60000), [] {});
+    bench::Report("Schedule", watch.ElapsedNanoseconds() / kTimers, "ns/timer");
+
+    watch.Restart();
+    for (auto id : ids)
+        service.Cancel(id);
+    bench::Report("Cancel", watch.ElapsedNanoseconds() / kTimers, "ns/timer");
+}
@@ -0,0 +1,120 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "benchmark.h"
+#include "corpus.h"
+
+#include "net/base/url.h"
+#include "net/http/form.h"
+#include "net/http/utils.h"
+
+BENCHMARK_CASE(Url_Corpus)
+{
+    using namespace net::http;
+
+    auto& urls = corpus::Urls();
+    size_t bytes = 0;
+    for (auto& url : urls)
+        bytes += url.size();
+    bench::Measure("Parse/corpus", bytes, [&] {
+        for (auto& url : urls)
+            bench::DoNotOptimize(Url::Parse(url));
+    });
+    bench::Measure("UrlView::Parse/corpus", bytes, [&] {
+        for (auto& url : urls)
+            bench::DoNotOptimize(UrlView::Parse(url));
+    });
+    Url reused;
+    bench::Measure("Url::Assign/corpus", bytes, [&] {
+        for (auto& url : urls)
+            reused.Assign(UrlView::Parse(url));
+        bench::DoNotOptimize(reused);
+    });
+
+    auto base = Url::Parse("http://www.example.com/a/b/c/index.html?x=1");
+    bench::Measure("ResolveReference/relative", 0, [&] {
+        bench::DoNotOptimize(base.ResolveReference("../../d/e.html?y=2#top"));
+    });
+
+    auto url = Url::Parse(urls[5]);
+    bench::Measure("ToString", 0, [&] {
+        bench::DoNotOptimize(url.ToString());
+    });
+}
+
+BENCHMARK_CASE(Form_Queries)
+{
+    using namespace net::http;
+
+    std::string shortQuery = "q=net&page=2";
+    std::string longQuery = Url::Parse(corpus::Urls()[10]).GetRawQuery();
+    std::string body = "item=42&quantity=3&note=leave+at+the+door&coupon=SPRING%2D2024";
+    for (int i = 0; i < 5; ++i)
+        body += "&" + body;
+
+    bench::Measure("ParseQueryForm/short", shortQuery.size(), [&] {
+        bench::DoNotOptimize(ParseQueryForm(shortQuery));
+    });
+    bench::Measure("ParseQueryForm/oauth", longQuery.size(), [&] {
+        bench::DoNotOptimize(ParseQueryForm(longQuery));
+    });
+    bench::Measure("ParseQueryForm/body", body.size(), [&] {
+        bench::DoNotOptimize(ParseQueryForm(body));
+    });
+
+    // An analytics POST with 200 fields, of which the handler reads three.
+    std::string analytics;
+    for (int i = 0; i < 200; ++i)
+        analytics += (i ? "&field_" : "field_") + std::to_string(i) + "=value%20" + std::to_string(i * 31);
+    bench::Measure("ParseQueryForm/analytics_200", analytics.size(), [&] {
+        auto values = ParseQueryForm(analytics);
+        bench::DoNotOptimize(values.find("field_7"));
+        bench::DoNotOptimize(values.find("field_120"));
+        bench::DoNotOptimize(values.find("missing"));
+    });
+    FormIndex index;
+    std::string value;
+    bench::Measure("FormIndex/analytics_200", analytics.size(), [&] {
+        index.Clear();
+        bench::DoNotOptimize(index.Find(analytics, "field_7", value));
+        bench::DoNotOptimize(index.Find(analytics, "field_120", value));
+        bench::DoNotOptimize(index.Find(analytics, "missing", value));
+    });
+    bench::Measure("FormIndex/short", shortQuery.size(), [&] {
+        index.Clear();
+        bench::DoNotOptimize(index.Find(shortQuery, "page", value));
+    });
+}
+
+BENCHMARK_CASE(Header_Sets)
+{
+    using namespace net::http;
+
+    const char* kNames[] = { "browser", "curl", "api" };
+    auto& sets = corpus::HeaderSets();
+    for (size_t i = 0; i < sets.size(); ++i)
+    {
+        auto& lines = sets[i];
+        size_t bytes = 0;
+        for (auto& line : lines)
+            bytes += line.size() + 2;
+        bench::Measure(std::string("ParseHeader/") + kNames[i], bytes, [&] {
+            bench::DoNotOptimize(ParseHeader(lines));
+        });
+    }
+}
@@ -0,0 +1,76 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "benchmark.h"
+#include "corpus.h"
+
+#include "net/base/zip.h"
+
+BENCHMARK_CASE(Zip_Sizes)
+{
+    // A JSON reply, an HTML page and a large log or report.
+    const size_t kSizes[] = { 1024, 64 * 1024, 1024 * 1024 };
+    for (auto size : kSizes)
+    {
+        std::string text = corpus::Text(size);
+        std::string compressed = base::zip::Compress(text);
+        std::string gzipped = base::zip::GCompress(text);
+        std::string suffix = std::to_string(size / 1024) + "K";
+        bench::Measure("Compress/" + suffix, text.size(), [&] {
+            bench::DoNotOptimize(base::zip::Compress(text));
+        });
+        bench::Measure("Decompress/" + suffix, text.size(), [&] {
+            bench::DoNotOptimize(base::zip::Decompress(compressed));
+        });
+        bench::Measure("GCompress/" + suffix, text.size(), [&] {
+            bench::DoNotOptimize(base::zip::GCompress(text));
+        });
+        bench::Measure("GDecompress/" + suffix, text.size(), [&] {
+            bench::DoNotOptimize(base::zip::GDecompress(gzipped));
+        });
+        bench::Measure("Inflater/" + suffix + "_in_16K", text.size(), [&] {
+            // A chunked response, inflated as the chunks arrive.
+            auto inflater = base::zip::AcquireInflater();
+            std::string out;
+            for (size_t i = 0; i < gzipped.size(); i += 16 * 1024)
+            {
+                size_t n = gzipped.size() - i < 16 * 1024 ? gzipped.size() - i : 16 * 1024;
+                inflater->Inflate(gzipped.data() + i, n, out);
+            }
+            bench::DoNotOptimize(out);
+        });
+        bench::Report("Ratio/" + suffix, (double)text.size() / gzipped.size(), "x");
+    }
+}
+
+BENCHMARK_CASE(Zip_Parallel)
+{
+    // A large response body or log archive, GCompress is the single threaded baseline.
+    std::string text = corpus::Text(16 * 1024 * 1024);
+    bench::Measure("GCompress/16M", text.size(), [&] {
+        bench::DoNotOptimize(base::zip::GCompress(text));
+    });
+    const size_t kThreads[] = { 1, 2, 4, 8, 16 };
+    for (auto threads : kThreads)
+    {
+        bench::Measure("GCompressParallel/16M/" + std::to_string(threads), text.size(), [&] {
+            bench::DoNotOptimize(base::zip::GCompressParallel(text, threads));
+        });
+    }
+    bench::Report("Ratio/16M", (double)text.size() / base::zip::GCompressParallel(text).size(), "x");
+}
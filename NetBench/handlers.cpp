@@ -0,0 +1,109 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "handlers.h"
+
+#include <chrono>
+#include <thread>
+
+#include "net/http/context.h"
+
+namespace netbench {
+
+namespace {
+
+using namespace net::http;
+
+class BytesHandler
+    : public Handler
+{
+public:
+    explicit BytesHandler(const std::string& body) : m_body(body) {}
+
+    void ServeHTTP(std::shared_ptr<Context> ctx) override
+    {
+        ctx->Write(m_body);
+    }
+
+private:
+    std::string m_body;
+};
+
+class EchoHandler
+    : public Handler
+{
+public:
+    void ServeHTTP(std::shared_ptr<Context> ctx) override
+    {
+        auto body = ctx->GetRequest()->GetBodyView();
+        ctx->Write(body.data(), (int)body.size());
+    }
+};
+
+class SleepHandler
+    : public Handler
+{
+public:
+    explicit SleepHandler(std::chrono::milliseconds delay) : m_delay(delay) {}
+
+    void ServeHTTP(std::shared_ptr<Context> ctx) override
+    {
+        std::this_thread::sleep_for(m_delay);
+        ctx->Write("Hello, World!");
+    }
+
+private:
+    std::chrono::milliseconds m_delay;
+};
+
+// ParseArgument parses the number after the colon of |spec|, it returns -1 if there is none.
+long long ParseArgument(const std::string& spec)
+{
+    auto colon = spec.find(':');
+    if (colon == std::string::npos)
+        return -1;
+    try
+    {
+        return std::stoll(spec.substr(colon + 1));
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+} // !namespace anonymous
+
+std::shared_ptr<Handler> CreateHandler(const std::string& spec)
+{
+    if (spec == "hello")
+        return std::make_shared<BytesHandler>("Hello, World!");
+    if (spec == "echo")
+        return std::make_shared<EchoHandler>();
+
+    long long n = ParseArgument(spec);
+    if (n < 0)
+        return nullptr;
+    if (spec.compare(0, 6, "bytes:") == 0)
+        return std::make_shared<BytesHandler>(std::string((size_t)n, 'x'));
+    if (spec.compare(0, 6, "sleep:") == 0)
+        return std::make_shared<SleepHandler>(std::chrono::milliseconds(n));
+    return nullptr;
+}
+
+} // !namespace netbench
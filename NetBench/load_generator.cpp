@@ -0,0 +1,271 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "load_generator.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "net/base/strings/string_utils.h"
+#include "net/http/reader.h"
+#include "net/http/utils.h"
+#include "net/socket/StreamSocket.h"
+
+namespace netbench {
+
+namespace {
+
+using namespace net;
+typedef std::chrono::steady_clock Clock;
+
+// Worker is the share of the load of a connection, or of a sequence of connections
+// without keep-alive.
+struct Worker
+{
+    Worker() : Latency(60 * 1000 * 1000, 3) {}
+
+    Clock::time_point Start;
+    Clock::duration Interval;
+    Clock::time_point End;
+    uint64_t Sent = 0;
+    uint64_t Completed = 0;
+    uint64_t Errors = 0;
+    base::Histogram Latency;
+};
+
+std::string MakeRequest(const LoadOptions& options)
+{
+    std::string request = options.BodySize > 0 ? "POST" : "GET";
+    request += " / HTTP/1.1\r\nHost: 127.0.0.1\r\nUser-Agent: net_bench\r\n";
+    if (!options.KeepAlive)
+        request += "Connection: close\r\n";
+    if (options.BodySize > 0)
+    {
+        request += "Content-Type: application/octet-stream\r\n";
+        request += "Content-Length: " + std::to_string(options.BodySize) + "\r\n\r\n";
+        request += std::string(options.BodySize, 'x');
+    }
+    else
+    {
+        request += "\r\n";
+    }
+    return request;
+}
+
+bool SendAll(StreamSocket& s, const std::string& data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        int n = s.Send(data.data() + sent, (int)(data.size() - sent));
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+// ReadResponse reads a response and returns its status code, -1 on failure.
+int ReadResponse(http::Reader& reader)
+{
+    auto startLine = reader.ExtractStartLine();
+    auto parts = base::strings::SplitN(startLine, " ", 3);
+    if (parts.size() < 2)
+        return -1;
+    bool error;
+    auto lines = reader.ExtractHeaders(error);
+    if (error)
+        return -1;
+    auto response = http::Response::Create();
+    response->SetHeader(http::ParseHeader(lines));
+    reader.ExtractContentMessage(response);
+    try
+    {
+        return std::stoi(parts[1]);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+void Record(Worker& worker, Clock::time_point due, int status)
+{
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - due);
+    worker.Latency.Record((uint64_t)latency.count());
+    ++worker.Completed;
+    if (status >= 400)
+        ++worker.Errors;
+}
+
+std::shared_ptr<StreamSocket> Connect(uint16_t port)
+{
+    auto s = std::make_shared<StreamSocket>();
+    if (!s->Connect(SocketAddress("127.0.0.1", port)))
+        return nullptr;
+    s->SetNoDelay(true);
+    return s;
+}
+
+// RunKeepAlive sends on schedule from this thread and reads the responses on another.
+void RunKeepAlive(const LoadOptions& options, const std::string& request, Worker& worker)
+{
+    auto s = Connect(options.Port);
+    if (!s)
+    {
+        ++worker.Errors;
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    // The due times of the requests in flight.
+    std::deque<Clock::time_point> inflight;
+    bool sending = true;
+    bool failed = false;
+
+    std::thread receiver([&] {
+        http::Reader reader;
+        reader.Reset(s.get());
+        while (true)
+        {
+            Clock::time_point due;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return !inflight.empty() || !sending || failed; });
+                if (inflight.empty() || failed)
+                    break;
+                due = inflight.front();
+            }
+            int status = ReadResponse(reader);
+            if (status > 0)
+                Record(worker, due, status);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                inflight.pop_front();
+                if (status < 0)
+                    failed = true;
+            }
+            changed.notify_all();
+            if (status < 0)
+            {
+                ++worker.Errors;
+                break;
+            }
+        }
+    });
+
+    for (auto due = worker.Start; due < worker.End; due += worker.Interval)
+    {
+        std::this_thread::sleep_until(due);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return (int)inflight.size() < options.PipelineDepth || failed; });
+            if (failed)
+                break;
+            inflight.push_back(due);
+        }
+        changed.notify_all();
+        if (!SendAll(*s, request))
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            failed = true;
+            break;
+        }
+        ++worker.Sent;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sending = false;
+    }
+    changed.notify_all();
+    if (failed)
+        s->Shutdown();
+    receiver.join();
+}
+
+// RunConnectionPerRequest connects, sends and reads a response for every request.
+void RunConnectionPerRequest(const LoadOptions& options, const std::string& request, Worker& worker)
+{
+    for (auto due = worker.Start; due < worker.End; due += worker.Interval)
+    {
+        std::this_thread::sleep_until(due);
+        auto s = Connect(options.Port);
+        if (!s || !SendAll(*s, request))
+        {
+            ++worker.Errors;
+            continue;
+        }
+        ++worker.Sent;
+        http::Reader reader;
+        reader.Reset(s.get());
+        int status = ReadResponse(reader);
+        if (status > 0)
+            Record(worker, due, status);
+        else
+            ++worker.Errors;
+    }
+}
+
+} // !namespace anonymous
+
+void RunLoad(const LoadOptions& options, LoadResult& result)
+{
+    int connections = options.Connections > 0 ? options.Connections : 1;
+    auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(connections / options.Rate));
+    auto start = Clock::now() + std::chrono::milliseconds(10);
+    auto request = MakeRequest(options);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < connections; ++i)
+    {
+        std::unique_ptr<Worker> worker(new Worker());
+        // Spread the schedules of the connections over an interval.
+        worker->Start = start + interval * i / connections;
+        worker->Interval = interval;
+        worker->End = start + options.Duration;
+        auto w = worker.get();
+        threads.emplace_back([&options, &request, w] {
+            if (options.KeepAlive)
+                RunKeepAlive(options, request, *w);
+            else
+                RunConnectionPerRequest(options, request, *w);
+        });
+        workers.push_back(std::move(worker));
+    }
+    for (auto& t : threads)
+        t.join();
+
+    result.Elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+    for (auto& worker : workers)
+    {
+        result.Sent += worker->Sent;
+        result.Completed += worker->Completed;
+        result.Errors += worker->Errors;
+        result.Latency.Add(worker->Latency);
+    }
+}
+
+} // !namespace netbench
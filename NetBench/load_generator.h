@@ -0,0 +1,64 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "net/base/histogram.h"
+
+namespace netbench {
+
+struct LoadOptions
+{
+    uint16_t Port = 8990;
+    // The requests per second of all the connections together.
+    double Rate = 1000;
+    std::chrono::milliseconds Duration = std::chrono::milliseconds(10000);
+    int Connections = 16;
+    // Without keep-alive every request has a connection of its own.
+    bool KeepAlive = true;
+    // The requests a keep-alive connection may have in flight.
+    int PipelineDepth = 1;
+    // The requests are POSTs with a body of that size if it is not 0.
+    size_t BodySize = 0;
+};
+
+struct LoadResult
+{
+    LoadResult() : Latency(60 * 1000 * 1000, 3) {}
+
+    uint64_t Sent = 0;
+    uint64_t Completed = 0;
+    // The failed connections, sends and reads, and the responses with a status >= 400.
+    uint64_t Errors = 0;
+    std::chrono::nanoseconds Elapsed = std::chrono::nanoseconds(0);
+    // The latencies in microseconds, up to a minute.
+    base::Histogram Latency;
+};
+
+// RunLoad sends requests to the server on 127.0.0.1 open-loop: each connection sends
+// its share of the rate on a fixed schedule, whatever the responses take. A latency is
+// counted from the time its request was due rather than sent, so that a stalled server
+// delays the measured latencies and not the load (no coordinated omission).
+// A connection with PipelineDepth requests in flight waits for a response before sending
+// the next one, which is late then.
+void RunLoad(const LoadOptions& options, LoadResult& result);
+
+} // !namespace netbench
@@ -0,0 +1,165 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "handlers.h"
+#include "load_generator.h"
+#include "process_stats.h"
+#include "net/http/server.h"
+
+namespace {
+
+const char kUsage[] =
+    "Usage: net_bench [options]\n"
+    "Serves 127.0.0.1 with http::Server and loads it with an open-loop generator.\n"
+    "  --handler=<spec>     hello, bytes:<n>, echo or sleep:<ms> (hello)\n"
+    "  --rate=<n>           requests per second, all connections together (1000)\n"
+    "  --duration=<s>       seconds of load (10)\n"
+    "  --connections=<n>    client connections (16)\n"
+    "  --keepalive=<0|1>    reuse the connections, or one per request (1)\n"
+    "  --pipeline=<n>       requests in flight per keep-alive connection (1)\n"
+    "  --body=<n>           POST bodies of n bytes instead of GETs (0)\n"
+    "  --port=<n>           port of the server (8990)\n";
+
+// ParseOption sets |value| from an argument of the form --name=value.
+bool ParseOption(const std::string& arg, const char* name, std::string& value)
+{
+    std::string prefix = std::string("--") + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+bool ParseArguments(int argc, char* argv[], netbench::LoadOptions& options, std::string& handler)
+{
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            std::string value;
+            if (ParseOption(arg, "handler", value))
+                handler = value;
+            else if (ParseOption(arg, "rate", value))
+                options.Rate = std::stod(value);
+            else if (ParseOption(arg, "duration", value))
+                options.Duration = std::chrono::milliseconds((long long)(std::stod(value) * 1000));
+            else if (ParseOption(arg, "connections", value))
+                options.Connections = std::stoi(value);
+            else if (ParseOption(arg, "keepalive", value))
+                options.KeepAlive = std::stoi(value) != 0;
+            else if (ParseOption(arg, "pipeline", value))
+                options.PipelineDepth = std::stoi(value);
+            else if (ParseOption(arg, "body", value))
+                options.BodySize = (size_t)std::stoull(value);
+            else if (ParseOption(arg, "port", value))
+                options.Port = (uint16_t)std::stoi(value);
+            else
+                return false;
+        }
+    }
+    catch (...)
+    {
+        return false;
+    }
+    return options.Rate > 0 && options.Connections > 0 && options.PipelineDepth > 0;
+}
+
+// WaitForServer returns once the server accepts connections, false after five seconds.
+bool WaitForServer(uint16_t port)
+{
+    for (int i = 0; i < 500; ++i)
+    {
+        net::StreamSocket s;
+        if (s.Connect(net::SocketAddress("127.0.0.1", port)))
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+double Milliseconds(uint64_t microseconds)
+{
+    return microseconds / 1000.0;
+}
+
+} // !namespace anonymous
+
+int main(int argc, char* argv[])
+{
+    netbench::LoadOptions options;
+    std::string spec = "hello";
+    if (!ParseArguments(argc, argv, options, spec))
+    {
+        fprintf(stderr, "%s", kUsage);
+        return 1;
+    }
+    auto handler = netbench::CreateHandler(spec);
+    if (!handler)
+    {
+        fprintf(stderr, "unknown handler %s\n%s", spec.c_str(), kUsage);
+        return 1;
+    }
+
+    auto server = net::http::Server::Create(net::SocketAddress("127.0.0.1", options.Port));
+    server->SetHandler(handler);
+    std::thread listener([server] { server->ListenAndServe(); });
+    if (!WaitForServer(options.Port))
+    {
+        fprintf(stderr, "the server doesn't listen on port %u\n", options.Port);
+        server->Shutdown(std::chrono::seconds(0));
+        listener.join();
+        return 1;
+    }
+
+    printf("handler=%s rate=%.0f duration=%.1fs connections=%d keepalive=%d pipeline=%d body=%zu\n",
+        spec.c_str(), options.Rate, options.Duration.count() / 1000.0, options.Connections,
+        options.KeepAlive ? 1 : 0, options.PipelineDepth, options.BodySize);
+
+    auto before = netbench::ProcessStats::Sample();
+    netbench::LoadResult result;
+    netbench::RunLoad(options, result);
+    auto after = netbench::ProcessStats::Sample();
+    server->Shutdown(std::chrono::seconds(5));
+    listener.join();
+
+    double seconds = result.Elapsed.count() / 1e9;
+    auto& latency = result.Latency;
+    double cpu = ((after.UserTime - before.UserTime) + (after.SystemTime - before.SystemTime)).count() / 1e6;
+    printf("requests    %llu sent, %llu completed, %llu errors\n",
+        (unsigned long long)result.Sent, (unsigned long long)result.Completed,
+        (unsigned long long)result.Errors);
+    printf("throughput  %.1f req/s\n", result.Completed / seconds);
+    printf("latency     p50 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms, mean %.3f ms\n",
+        Milliseconds(latency.Percentile(50)), Milliseconds(latency.Percentile(99)),
+        Milliseconds(latency.Percentile(99.9)), Milliseconds(latency.GetMax()),
+        latency.GetMean() / 1000);
+    // The load generator runs in the process too.
+    printf("cpu         %.2f s user, %.2f s system, %.0f%% of a core, %.1f us/request\n",
+        (after.UserTime - before.UserTime).count() / 1e6,
+        (after.SystemTime - before.SystemTime).count() / 1e6, cpu / seconds * 100,
+        result.Completed > 0 ? cpu * 1e6 / result.Completed : 0);
+    printf("rss         %.1f MiB, peak %.1f MiB\n",
+        after.Rss / (1024.0 * 1024), after.PeakRss / (1024.0 * 1024));
+    return 0;
+}
@@ -0,0 +1,57 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "process_stats.h"
+
+#include <windows.h>
+#include <psapi.h>
+
+namespace netbench {
+
+namespace {
+
+std::chrono::microseconds ToMicroseconds(const FILETIME& time)
+{
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    // FILETIME counts 100 nanoseconds.
+    return std::chrono::microseconds(value.QuadPart / 10);
+}
+
+} // !namespace anonymous
+
+ProcessStats ProcessStats::Sample()
+{
+    ProcessStats stats = {};
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    {
+        stats.UserTime = ToMicroseconds(user);
+        stats.SystemTime = ToMicroseconds(kernel);
+    }
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory)))
+    {
+        stats.Rss = memory.WorkingSetSize;
+        stats.PeakRss = memory.PeakWorkingSetSize;
+    }
+    return stats;
+}
+
+} // !namespace netbench
@@ -35,7 +35,10 @@ public:
 
 SimpleHttpServer::~SimpleHttpServer()
 {
-    m_thread.detach();
+    if (m_server)
+        m_server->Shutdown(std::chrono::seconds(1));
+    if (m_thread.joinable())
+        m_thread.join();
 }
 
 void SimpleHttpServer::Start(uint16_t port /*= 8080*/)
@@ -43,5 +46,7 @@ void SimpleHttpServer::Start(uint16_t port /*= 8080*/)
     m_server = Server::Create(port);
     m_server->SetHandler(std::make_shared<SimpleHandler>());
 
-    m_thread = std::thread(&Server::ListenAndServe, m_server.get());
+    // The destructor shuts the server down, ListenAndServe returns then.
+    auto server = m_server;
+    m_thread = std::thread([server]() { server->ListenAndServe(); });
 }
@@ -19,6 +19,7 @@
 #include "stdafx.h"
 #include "CppUnitTest.h"
 #include "EchoServer.h"
+#include "net/socket/ServerSocket.h"
 #include "net/socket/SocketAddress.h"
 #include "net/socket/StreamSocket.h"
 
@@ -74,5 +75,28 @@ namespace TestSuite
             Assert::IsTrue(5 == n);
             Assert::AreEqual("Hello", buffer);
         }
+
+        TEST_METHOD(Test_Duplicate)
+        {
+            net::ServerSocket listener(net::SocketAddress("127.0.0.1", 0));
+            auto address = net::SocketAddress("127.0.0.1", listener.GetLocalAddress().GetPort());
+            std::string sharedInfo;
+            Assert::IsTrue(listener.Duplicate(GetCurrentProcessId(), sharedInfo));
+            auto duplicate = net::ServerSocket::FromSharedInfo(sharedInfo);
+            Assert::IsTrue(duplicate.GetNativeHandle() != INVALID_SOCKET);
+
+            // The queue outlives the original socket.
+            listener.Close();
+            net::StreamSocket ss;
+            Assert::IsTrue(ss.Connect(address));
+            auto accepted = duplicate.Accept();
+            Assert::IsTrue(accepted->GetImpl() != nullptr);
+            Assert::AreEqual(5, ss.Send("Hello", 5));
+            char buffer[256] = { 0 };
+            Assert::AreEqual(5, accepted->Receive(buffer, sizeof(buffer)));
+            Assert::AreEqual("Hello", buffer);
+
+            Assert::IsTrue(net::ServerSocket::FromSharedInfo("").GetNativeHandle() == INVALID_SOCKET);
+        }
     };
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <condition_variable>
+#include <mutex>
+
+#include "net/http/access_log.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace TestSuite
+{
+    TEST_CLASS(access_log_Test)
+    {
+    public:
+        TEST_METHOD(Test_Formats)
+        {
+            using net::http::AccessLog;
+            auto request = net::http::Request::Create("GET", "http://example.com/a%20b?x=1&y=%22");
+            request->SetRemoteAddress("10.0.0.1:54321");
+            request->SetHeader("Referer", "http://example.com/");
+            request->SetHeader("User-Agent", "test \"agent\"");
+
+            std::string common;
+            auto log = AccessLog::Create([&common](const std::string& lines) { common += lines; }, AccessLog::kCommon);
+            log->Log(*request, 200, 1234, std::chrono::microseconds(56));
+            log->Flush();
+            Assert::IsTrue(common.find("10.0.0.1 - - [") == 0);
+            Assert::IsTrue(common.find(" +0000] \"GET /a%20b?x=1&y=%22 HTTP/1.1\" 200 1234\n") != std::string::npos);
+
+            std::string combined;
+            log = AccessLog::Create([&combined](const std::string& lines) { combined += lines; }, AccessLog::kCombined);
+            log->Log(*request, 404, 0, std::chrono::microseconds(56));
+            log->Flush();
+            Assert::IsTrue(combined.find("\" 404 - \"http://example.com/\" \"test \\\"agent\\\"\"\n") != std::string::npos);
+
+            std::string json;
+            log = AccessLog::Create([&json](const std::string& lines) { json += lines; }, AccessLog::kJson);
+            log->Log(*request, 500, 10, std::chrono::microseconds(56));
+            log = nullptr;
+            Assert::IsTrue(json.find("{\"time\":\"") == 0);
+            Assert::IsTrue(json.find("Z\",\"remote_addr\":\"10.0.0.1\",\"method\":\"GET\",\"uri\":\"/a%20b?x=1&y=%22\","
+                "\"proto\":\"HTTP/1.1\",\"status\":500,\"bytes\":10,\"duration_us\":56,"
+                "\"referer\":\"http://example.com/\",\"user_agent\":\"test \\\"agent\\\"\"}\n") != std::string::npos);
+        }
+
+        TEST_METHOD(Test_Drops)
+        {
+            using net::http::AccessLog;
+            auto request = net::http::Request::Create("GET", "http://example.com/");
+
+            // The output holds the thread of the log until all the records are logged,
+            // those which don't fit in the ring are dropped.
+            std::mutex mutex;
+            std::condition_variable released;
+            bool release = false;
+            size_t lines = 0;
+            auto log = AccessLog::Create([&](const std::string& batch) {
+                std::unique_lock<std::mutex> lock(mutex);
+                released.wait(lock, [&] { return release; });
+                for (char c : batch)
+                    lines += c == '\n';
+            }, AccessLog::kCommon);
+
+            const size_t kRecords = 100000;
+            for (size_t i = 0; i < kRecords; ++i)
+                log->Log(*request, 200, 0, std::chrono::microseconds(1));
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                release = true;
+            }
+            released.notify_all();
+            log->Flush();
+            Assert::IsTrue(log->GetDropped() > 0);
+            Assert::IsTrue(lines + log->GetDropped() == kRecords);
+        }
+    };
+}
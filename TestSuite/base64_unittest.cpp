@@ -45,6 +45,70 @@ namespace TestSuite
 
             Assert::IsFalse(base::base64::Decode("") != "");
             Assert::IsFalse(base::base64::Decode("ab+-") != "");
+            Assert::IsFalse(base::base64::Decode("TQ==TWFu") != "");
+            Assert::IsFalse(base::base64::Decode("TWF") != "");
+        }
+
+        TEST_METHOD(Test_UrlSafe_NoPadding)
+        {
+            using namespace base::base64;
+            std::string data = "\xfb\xff\xbf?";
+            Assert::IsTrue(Encode(data) == "+/+/Pw==");
+            Assert::IsTrue(Encode(data, kUrlSafe) == "-_-_Pw==");
+            Assert::IsTrue(Encode(data, kUrlSafe | kNoPadding) == "-_-_Pw");
+            Assert::IsTrue(EncodedLength(data.size(), kNoPadding) == 6);
+
+            Assert::IsTrue(Decode("-_-_Pw==", kUrlSafe) == data);
+            Assert::IsTrue(Decode("-_-_Pw", kUrlSafe | kNoPadding) == data);
+            Assert::IsTrue(Decode("-_-_Pw==", kUrlSafe | kNoPadding) == data);
+            Assert::IsTrue(Decode("-_-_Pw", kUrlSafe) == "");
+            Assert::IsTrue(Decode("+/+/Pw==", kUrlSafe) == "");
+            Assert::IsTrue(Decode("-_-_P", kUrlSafe | kNoPadding) == "");
+        }
+
+        TEST_METHOD(Test_Long)
+        {
+            // Long enough for the vector kernels, with a bad char at every position.
+            std::string data;
+            for (int i = 0; i < 1000; ++i)
+                data.push_back(static_cast<char>(i * 7));
+            auto encoded = base::base64::Encode(data);
+            Assert::IsTrue(encoded.size() == 1336);
+            Assert::IsTrue(base::base64::Decode(encoded) == data);
+            for (size_t i = 0; i < encoded.size() - 2; i += 37)
+            {
+                auto bad = encoded;
+                bad[i] = '*';
+                Assert::IsTrue(base::base64::Decode(bad) == "");
+            }
+        }
+
+        TEST_METHOD(Test_Stream)
+        {
+            std::string data = "The quick brown fox jumps over the lazy dog";
+            base::base64::Encoder encoder;
+            std::string encoded;
+            for (size_t i = 0; i < data.size(); i += 5)
+                encoder.Update(data.substr(i, 5), encoded);
+            encoder.Final(encoded);
+            Assert::IsTrue(encoded == base::base64::Encode(data));
+
+            base::base64::Decoder decoder;
+            std::string decoded;
+            for (size_t i = 0; i < encoded.size(); i += 7)
+                Assert::IsTrue(decoder.Update(encoded.substr(i, 7), decoded));
+            Assert::IsTrue(decoder.Final(decoded));
+            Assert::IsTrue(decoded == data);
+
+            // Nothing may follow the padding, and the decoder is reset by Final.
+            decoded.clear();
+            Assert::IsTrue(decoder.Update("TQ==", decoded));
+            Assert::IsFalse(decoder.Update("TWFu", decoded));
+            Assert::IsFalse(decoder.Final(decoded));
+            Assert::IsTrue(decoded == "M");
+            decoded.clear();
+            Assert::IsTrue(decoder.Update("TW", decoded));
+            Assert::IsFalse(decoder.Final(decoded));
         }
     };
 }
\ No newline at end of file
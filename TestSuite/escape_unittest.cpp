@@ -46,6 +46,22 @@ namespace TestSuite
             Assert::IsTrue(base::EscapeUrlEncodedData(url, true) == "http://www.google.com/search%3Fq%3D%E4%B8%96+%E7%95%8C");
         }
 
+        TEST_METHOD(Test_Escape_LongRuns)
+        {
+            // Safe runs longer than a block, with unsafe bytes at the block edges.
+            std::string safe(40, 'a');
+            Assert::IsTrue(base::EscapeUrlComponent(safe) == safe);
+            std::string str = safe + " " + safe.substr(0, 15) + "/" + safe.substr(0, 16) + "~";
+            Assert::IsTrue(base::EscapeUrlComponent(str) == safe + "%20" + safe.substr(0, 15) + "%2F" + safe.substr(0, 16) + "~");
+            Assert::IsTrue(base::EscapeUrlComponent(str, true) == safe + "+" + safe.substr(0, 15) + "%2F" + safe.substr(0, 16) + "~");
+            Assert::IsTrue(base::EscapeUrl(safe + " ", true) == safe + "+");
+
+            std::string expected;
+            for (int i = 0; i < 20; ++i)
+                expected += "%FF";
+            Assert::IsTrue(base::Escape(std::string(20, '\xff')) == expected);
+        }
+
         TEST_METHOD(Test_Unescape)
         {
             std::string str = "Hello,+%20%2520%E4%B8%96%E7%95%8C%AW";
@@ -57,6 +73,24 @@ namespace TestSuite
             Assert::IsTrue(base::Unescape("http%3A%2F%2Fwww.google.com%2Fsearch%3Fq%3D%E4%B8%96+%E7%95%8C", true) == url);
         }
 
+        TEST_METHOD(Test_UnescapeInPlace_UnescapeView)
+        {
+            std::string str = std::string(20, 'a') + "%41+%4" + std::string(20, 'q') + "%zz%";
+            std::string expected = std::string(20, 'a') + "A %4" + std::string(20, 'q') + "%zz%";
+            std::string inPlace = str;
+            base::UnescapeInPlace(inPlace, true);
+            Assert::IsTrue(inPlace == expected);
+
+            std::string buffer;
+            Assert::IsTrue(base::UnescapeView(str, buffer, true).ToString() == expected);
+            Assert::IsTrue(base::UnescapeView(str, buffer).ToString() == std::string(20, 'a') + "A+%4" + std::string(20, 'q') + "%zz%");
+
+            // Nothing is copied when there is nothing to unescape.
+            std::string plain = "a+b";
+            Assert::IsTrue(base::UnescapeView(plain, buffer).data() == plain.data());
+            Assert::IsTrue(base::UnescapeView(plain, buffer, true).ToString() == "a b");
+        }
+
         TEST_METHOD(Test_EscapeForHTML_UnescapeForHTML)
         {
             std::string str = "<html>\"Hello&'world'\"</html>";
@@ -0,0 +1,142 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <atomic>
+#include <thread>
+
+#include "net/http/context.h"
+#include "net/http/event_stream.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace net::http;
+
+namespace TestSuite
+{
+    // BlockingWriter keeps the body and blocks in Write until it is released.
+    class BlockingWriter
+        : public ResponseWriter
+    {
+    public:
+        int WriteHeader(const Response& response, const void* body, int length) override
+        {
+            return length;
+        }
+
+        int Write(const void* buffer, int length) override
+        {
+            while (Blocked)
+                std::this_thread::yield();
+            std::lock_guard<std::mutex> lock(Mutex);
+            Body.append((const char*)buffer, length);
+            return length;
+        }
+
+        bool Flush() override { return true; }
+        bool Finish() override { return true; }
+
+        std::atomic<bool> Blocked = { false };
+        std::mutex Mutex;
+        std::string Body;
+    };
+
+    TEST_CLASS(event_stream_Test)
+    {
+    public:
+        TEST_METHOD(Test_Format)
+        {
+            ServerSentEvent event;
+            event.Data = "hello";
+            Assert::IsTrue(sse::Format(event) == "data: hello\n\n");
+
+            event.Id = "7";
+            event.Event = "update";
+            event.Retry = 1000;
+            event.Data = "a\nb\r\nc\rd";
+            Assert::IsTrue(sse::Format(event) ==
+                "id: 7\nevent: update\nretry: 1000\ndata: a\ndata: b\ndata: c\ndata: d\n\n");
+
+            ServerSentEvent empty;
+            Assert::IsTrue(sse::Format(empty) == "data: \n\n");
+
+            ServerSentEvent id;
+            id.Id = "1\nevent: injected";
+            Assert::IsTrue(sse::Format(id) == "id: 1\ndata: \n\n");
+        }
+
+        TEST_METHOD(Test_HeartbeatInterval)
+        {
+            auto broadcaster = EventBroadcaster::Create();
+            broadcaster->SetHeartbeatInterval(std::chrono::seconds(0));
+            Assert::IsTrue(broadcaster->GetHeartbeatInterval() == std::chrono::seconds(1));
+            broadcaster->SetHeartbeatInterval(std::chrono::seconds(30));
+            Assert::IsTrue(broadcaster->GetHeartbeatInterval() == std::chrono::seconds(30));
+        }
+
+        TEST_METHOD(Test_Broadcast)
+        {
+            auto broadcaster = EventBroadcaster::Create();
+            broadcaster->SetHighWaterMark(1024);
+
+            auto fast = std::make_shared<BlockingWriter>();
+            auto slow = std::make_shared<BlockingWriter>();
+            slow->Blocked = true;
+            bool fastResult = false;
+            bool slowResult = true;
+            std::thread t1([&] {
+                fastResult = broadcaster->Serve(Context::Create(fast, Request::Create("GET", "/")));
+            });
+            std::thread t2([&] {
+                slowResult = broadcaster->Serve(Context::Create(slow, Request::Create("GET", "/")));
+            });
+            while (broadcaster->GetSubscriberCount() < 2)
+                std::this_thread::yield();
+
+            // The slow subscriber is stuck writing the first event, the next ones are queued
+            // until the high-water mark is reached.
+            ServerSentEvent event;
+            event.Data = std::string(100, 'x');
+            for (int i = 0; i < 20; ++i)
+            {
+                broadcaster->Publish(event);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            Assert::IsTrue(broadcaster->GetSubscriberCount() == 1);
+
+            slow->Blocked = false;
+            t2.join();
+            Assert::IsFalse(slowResult);
+
+            while (true)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(fast->Mutex);
+                    if (fast->Body.size() == 20 * sse::Format(event).size())
+                        break;
+                }
+                std::this_thread::yield();
+            }
+            broadcaster->Close();
+            t1.join();
+            Assert::IsTrue(fastResult);
+            Assert::IsTrue(broadcaster->GetSubscriberCount() == 0);
+        }
+    };
+}
@@ -0,0 +1,126 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include "net/http/form.h"
+#include "net/http/request.h"
+
+using namespace net::http;
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace TestSuite
+{
+    TEST_CLASS(Form_Test)
+    {
+    public:
+        TEST_METHOD(Test_Find)
+        {
+            std::string query = " a =1&b=x%20y&&=z&c&a=2&d=e=f";
+            FormIndex index;
+            std::string value;
+            Assert::IsTrue(index.Find(query, "a", value));
+            Assert::IsTrue(value == "1");
+            Assert::IsTrue(index.Find(query, "b", value));
+            Assert::IsTrue(value == "x y");
+            Assert::IsTrue(index.Find(query, "c", value));
+            Assert::IsTrue(value.empty());
+            Assert::IsTrue(index.Find(query, "d", value));
+            Assert::IsTrue(value == "e=f");
+            Assert::IsFalse(index.Find(query, "", value));
+            Assert::IsFalse(index.Find(query, "A", value));
+            Assert::IsTrue(index.Size(query) == 5);
+
+            // Another string is indexed again.
+            std::string other = "a=3";
+            Assert::IsTrue(index.Find(other, "a", value));
+            Assert::IsTrue(value == "3");
+            Assert::IsFalse(index.Find(other, "b", value));
+        }
+
+        TEST_METHOD(Test_Find_Hashed)
+        {
+            std::string form;
+            for (int i = 0; i < 100; ++i)
+                form += "k" + std::to_string(i) + "=v" + std::to_string(i) + "&K" + std::to_string(i) + "=V&";
+            form += "k7=again";
+            FormIndex index;
+            std::string value;
+            for (int i = 0; i < 100; ++i)
+            {
+                Assert::IsTrue(index.Find(form, "k" + std::to_string(i), value));
+                Assert::IsTrue(value == "v" + std::to_string(i));
+            }
+            Assert::IsTrue(index.Find(form, "K7", value));
+            Assert::IsTrue(value == "V");
+            Assert::IsFalse(index.Find(form, "k100", value));
+            Assert::IsTrue(index.Size(form) == 201);
+        }
+
+        TEST_METHOD(Test_Request)
+        {
+            auto request = Request::Create("POST", "http://www.google.com/?q=abc&page=2", "q=body&n=%31");
+            Assert::IsTrue(request->FormValue("q") == "abc");
+            Assert::IsTrue(request->PostFormValue("q").empty());
+
+            request->UseBodyAsPostForm();
+            Assert::IsTrue(request->FormValue("q") == "body");
+            Assert::IsTrue(request->FormValue("page") == "2");
+            Assert::IsTrue(request->PostFormValue("n") == "1");
+            Assert::IsTrue(request->PostFormValue("page").empty());
+
+            request->SetFormValues(Values{ { "page", "3" } });
+            Assert::IsTrue(request->FormValue("page") == "3");
+            request->SetUrl(Url::Parse("http://www.google.com/?page=4"));
+            Assert::IsTrue(request->FormValue("page") == "3");
+
+            Assert::IsTrue(request->Reset("GET", "http://www.google.com/?page=5"));
+            Assert::IsTrue(request->FormValue("page") == "5");
+            Assert::IsTrue(request->PostFormValue("n").empty());
+        }
+
+        TEST_METHOD(Test_Request_Changed)
+        {
+            auto request = Request::Create("POST", "http://www.google.com/?q=abc&page=2", "q=body&n=%31");
+            request->UseBodyAsPostForm();
+            Assert::IsTrue(request->FormValue("q") == "body");
+            Assert::IsTrue(request->FormValue("page") == "2");
+
+            // A form of the same length is copied into the same memory, its pairs
+            // are elsewhere.
+            std::string body = "n=%32&q=BODY";
+            request->SetBody(body);
+            Assert::IsTrue(request->FormValue("q") == "BODY");
+            Assert::IsTrue(request->PostFormValue("n") == "2");
+
+            // Through the base class as well.
+            body = "q=Body&n=%33";
+            CommonRequestResponse& common = *request;
+            common.SetBody(body);
+            Assert::IsTrue(request->FormValue("q") == "Body");
+            Assert::IsTrue(request->PostFormValue("n") == "3");
+
+            request->SetRawQuery("page=7&q=abc");
+            Assert::IsTrue(request->FormValue("page") == "7");
+            request->GetUrl().SetRawQuery("q=xyz&page=8");
+            Assert::IsTrue(request->FormValue("page") == "8");
+        }
+    };
+}
\ No newline at end of file
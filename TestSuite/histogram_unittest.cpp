@@ -0,0 +1,75 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include "net/base/histogram.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace TestSuite
+{
+    TEST_CLASS(histogram_Test)
+    {
+    public:
+        TEST_METHOD(Test_Percentile)
+        {
+            base::Histogram h(3600 * 1000 * 1000ULL, 3);
+            Assert::IsTrue(h.Percentile(50) == 0);
+            for (uint64_t v = 1; v <= 10000; ++v)
+                h.Record(v);
+            Assert::IsTrue(h.GetCount() == 10000);
+            Assert::IsTrue(h.GetMin() == 1);
+            Assert::IsTrue(h.GetMax() == 10000);
+            Assert::IsTrue(h.GetMean() == 5000.5);
+            // Three significant digits: the values up to 2048 are exact, the others
+            // within 0.1%.
+            Assert::IsTrue(h.Percentile(10) == 1000);
+            Assert::IsTrue(h.Percentile(50) >= 5000 && h.Percentile(50) <= 5005);
+            Assert::IsTrue(h.Percentile(99) >= 9900 && h.Percentile(99) <= 9910);
+            Assert::IsTrue(h.Percentile(100) == 10000);
+
+            // Values above the highest are counted as the highest.
+            base::Histogram small(1000, 2);
+            small.Record(5000);
+            Assert::IsTrue(small.GetMax() == 1000);
+        }
+
+        TEST_METHOD(Test_Add)
+        {
+            base::Histogram a(1000000, 3);
+            base::Histogram b(1000000, 3);
+            base::Histogram c(100000000, 2);
+            a.Record(100, 99);
+            b.Record(100000);
+            c.Add(a);
+            c.Add(b);
+            Assert::IsTrue(c.GetCount() == 100);
+            Assert::IsTrue(c.GetMin() == 100);
+            Assert::IsTrue(c.GetMax() == 100000);
+            Assert::IsTrue(c.Percentile(99) == 100);
+            // The highest value of a bucket is reported, capped by the maximum.
+            Assert::IsTrue(c.Percentile(100) == 100000);
+            a.Add(b);
+            Assert::IsTrue(a.Percentile(99.9) >= 100000 && a.Percentile(99.9) <= 100100);
+            a.Reset();
+            Assert::IsTrue(a.GetCount() == 0 && a.GetMax() == 0);
+        }
+    };
+}
@@ -0,0 +1,128 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include "net/http/hpack.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace net::http;
+
+namespace TestSuite
+{
+    TEST_CLASS(hpack_Test)
+    {
+    public:
+        TEST_METHOD(Test_Integer)
+        {
+            // RFC 7541, C.1.
+            std::string out;
+            hpack::EncodeInteger(10, 5, 0, out);
+            Assert::IsTrue(out == "\x0a");
+            out.clear();
+            hpack::EncodeInteger(1337, 5, 0, out);
+            Assert::IsTrue(out == "\x1f\x9a\x0a");
+
+            const uint8_t* p = (const uint8_t*)out.data();
+            uint64_t value = 0;
+            Assert::IsTrue(hpack::DecodeInteger(p, p + out.size(), 5, value));
+            Assert::IsTrue(value == 1337);
+            p = (const uint8_t*)out.data();
+            Assert::IsFalse(hpack::DecodeInteger(p, p + 2, 5, value));
+
+            // Continuation bytes which add nothing are not taken forever.
+            std::string padded = "\x1f" + std::string(16, '\x80') + "\x01";
+            p = (const uint8_t*)padded.data();
+            Assert::IsFalse(hpack::DecodeInteger(p, p + padded.size(), 5, value));
+        }
+
+        TEST_METHOD(Test_Huffman)
+        {
+            std::string encoded;
+            hpack::HuffmanEncode("www.example.com", encoded);
+            Assert::IsTrue(encoded == "\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff");
+            Assert::IsTrue(hpack::HuffmanEncodedLength("www.example.com") == 12);
+
+            std::string decoded;
+            Assert::IsTrue(hpack::HuffmanDecode((const uint8_t*)encoded.data(), encoded.size(), decoded));
+            Assert::IsTrue(decoded == "www.example.com");
+        }
+
+        TEST_METHOD(Test_Decode)
+        {
+            // RFC 7541, C.3.1 and C.4.1.
+            const std::string plain("\x82\x86\x84\x41\x0f\x77\x77\x77\x2e\x65\x78\x61\x6d\x70\x6c\x65\x2e\x63\x6f\x6d", 20);
+            const std::string huffman("\x82\x86\x84\x41\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff", 17);
+            for (auto& block : { plain, huffman })
+            {
+                HpackDecoder decoder;
+                HeaderFieldList headers;
+                Assert::IsTrue(decoder.Decode(block.data(), block.size(), headers));
+                Assert::IsTrue(headers.size() == 4);
+                Assert::IsTrue(headers[0] == HeaderField(":method", "GET"));
+                Assert::IsTrue(headers[1] == HeaderField(":scheme", "http"));
+                Assert::IsTrue(headers[2] == HeaderField(":path", "/"));
+                Assert::IsTrue(headers[3] == HeaderField(":authority", "www.example.com"));
+            }
+
+            // An index out of the tables.
+            HpackDecoder decoder;
+            HeaderFieldList headers;
+            Assert::IsFalse(decoder.Decode("\xff\x00", 2, headers));
+
+            // A large entry of the dynamic table, which a byte repeats, counts every time.
+            HpackDecoder limited;
+            limited.SetMaxHeaderListSize(16 * 1024);
+            std::string block("\x40\x01x\x7f\xa1\x1e", 6);
+            block += std::string(4000, 'a');
+            block += std::string(3, '\xbe');
+            headers.clear();
+            Assert::IsTrue(limited.Decode(block.data(), block.size(), headers));
+            Assert::IsTrue(headers.size() == 4);
+            block = "\xbe";
+            block += std::string(4, '\xbe');
+            headers.clear();
+            Assert::IsFalse(limited.Decode(block.data(), block.size(), headers));
+        }
+
+        TEST_METHOD(Test_EncodeDecode)
+        {
+            HpackEncoder encoder;
+            HpackDecoder decoder;
+            HeaderFieldList headers = {
+                { ":method", "POST" },
+                { ":path", "/upload?name=a" },
+                { "content-type", "application/x-www-form-urlencoded" },
+                { "authorization", "Basic dXNlcjpwYXNz" },
+                { "x-custom", "value" },
+            };
+            std::string first, second;
+            encoder.Encode(headers, first);
+            encoder.Encode(headers, second);
+            // The fields indexed by the first block make the second one smaller.
+            Assert::IsTrue(second.size() < first.size());
+
+            HeaderFieldList decoded1, decoded2;
+            Assert::IsTrue(decoder.Decode(first.data(), first.size(), decoded1));
+            Assert::IsTrue(decoder.Decode(second.data(), second.size(), decoded2));
+            Assert::IsTrue(decoded1 == headers);
+            Assert::IsTrue(decoded2 == headers);
+        }
+    };
+}
@@ -0,0 +1,111 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <thread>
+#include <vector>
+
+#include "net/http/metrics.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace TestSuite
+{
+    TEST_CLASS(metrics_Test)
+    {
+    public:
+        TEST_METHOD(Test_RecordRequest)
+        {
+            using net::http::Metrics;
+            auto metrics = Metrics::Create();
+            metrics->Add(Metrics::kConnectionsAccepted, 3);
+            metrics->Add(Metrics::kConnectionsClosed);
+            Assert::IsTrue(metrics->GetActiveConnections() == 2);
+
+            Metrics::RequestSample sample;
+            sample.StatusCode = 404;
+            sample.BytesReceived = 100;
+            sample.BytesSent = 200;
+            sample.Latency[Metrics::kHandler] = 50;
+            metrics->RecordRequest(sample);
+            sample.StatusCode = 200;
+            sample.Latency[Metrics::kHandler] = 150;
+            metrics->RecordRequest(sample);
+            Assert::IsTrue(metrics->Get(Metrics::kRequests2xx) == 1);
+            Assert::IsTrue(metrics->Get(Metrics::kRequests4xx) == 1);
+            Assert::IsTrue(metrics->Get(Metrics::kBytesReceived) == 200);
+            Assert::IsTrue(metrics->Get(Metrics::kBytesSent) == 400);
+
+            base::Histogram handler;
+            metrics->GetLatency(Metrics::kHandler, handler);
+            Assert::IsTrue(handler.GetCount() == 2);
+            Assert::IsTrue(handler.GetMin() == 50);
+            Assert::IsTrue(handler.GetMax() == 150);
+            // The phases which have not been measured are not recorded.
+            base::Histogram write;
+            metrics->GetLatency(Metrics::kWrite, write);
+            Assert::IsTrue(write.GetCount() == 0);
+        }
+
+        TEST_METHOD(Test_Threads)
+        {
+            using net::http::Metrics;
+            auto metrics = Metrics::Create();
+            std::vector<std::thread> threads;
+            for (int i = 0; i < 8; ++i)
+            {
+                threads.emplace_back([metrics] {
+                    Metrics::RequestSample sample;
+                    sample.StatusCode = 200;
+                    sample.BytesSent = 1;
+                    sample.Latency[Metrics::kRequest] = 10;
+                    for (int j = 0; j < 10000; ++j)
+                        metrics->RecordRequest(sample);
+                });
+            }
+            for (auto& t : threads)
+                t.join();
+            Assert::IsTrue(metrics->Get(Metrics::kRequests2xx) == 80000);
+            Assert::IsTrue(metrics->Get(Metrics::kBytesSent) == 80000);
+            base::Histogram latency;
+            metrics->GetLatency(Metrics::kRequest, latency);
+            Assert::IsTrue(latency.GetCount() == 80000);
+        }
+
+        TEST_METHOD(Test_Prometheus)
+        {
+            using net::http::Metrics;
+            auto metrics = Metrics::Create();
+            metrics->Add(Metrics::kConnectionsAccepted);
+            Metrics::RequestSample sample;
+            sample.StatusCode = 503;
+            sample.Latency[Metrics::kFirstByte] = 1500;
+            metrics->RecordRequest(sample);
+
+            auto text = metrics->ToPrometheus("net");
+            Assert::IsTrue(text.find("# TYPE net_connections_accepted_total counter\n") != std::string::npos);
+            Assert::IsTrue(text.find("\nnet_connections_accepted_total 1\n") != std::string::npos);
+            Assert::IsTrue(text.find("\nnet_connections_active 1\n") != std::string::npos);
+            Assert::IsTrue(text.find("\nnet_requests_total{code=\"5xx\"} 1\n") != std::string::npos);
+            Assert::IsTrue(text.find("\nnet_phase_duration_seconds{phase=\"first_byte\",quantile=\"0.5\"} 0.0015") != std::string::npos);
+            Assert::IsTrue(text.find("\nnet_phase_duration_seconds_count{phase=\"first_byte\"} 1\n") != std::string::npos);
+        }
+    };
+}
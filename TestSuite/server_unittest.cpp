@@ -19,13 +19,69 @@
 #include "stdafx.h"
 #include "CppUnitTest.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #include "SimpleHttpServer.h"
 #include "net/http/client.h"
+#include "net/http/hpack.h"
+#include "net/http/http2_frame.h"
+#include "net/socket/ServerSocket.h"
+#include "net/socket/StreamSocket.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 namespace TestSuite
 {
+    class SlowHandler : public net::http::Handler
+    {
+    public:
+        virtual void ServeHTTP(std::shared_ptr<net::http::Context> ctx) override
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+            ctx->Write("slow");
+        }
+    };
+
+    class TextHandler : public net::http::Handler
+    {
+    public:
+        TextHandler(const std::string& text) : m_text(text) {}
+
+        virtual void ServeHTTP(std::shared_ptr<net::http::Context> ctx) override
+        {
+            ctx->Write(m_text);
+        }
+
+    private:
+        std::string m_text;
+    };
+
+    class EchoHandler : public net::http::Handler
+    {
+    public:
+        virtual void ServeHTTP(std::shared_ptr<net::http::Context> ctx) override
+        {
+            ctx->Write(ctx->GetRequest()->GetBody());
+        }
+    };
+
+    // BlockingHandler writes its response, then blocks until it is released.
+    class BlockingHandler : public net::http::Handler
+    {
+    public:
+        virtual void ServeHTTP(std::shared_ptr<net::http::Context> ctx) override
+        {
+            ctx->Write("ready");
+            while (!Released)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        std::atomic<bool> Released = { false };
+    };
+
     TEST_CLASS(Http_Server_Test)
     {
     public:
@@ -39,5 +95,448 @@ namespace TestSuite
             Assert::IsTrue(response != nullptr);
             Assert::IsTrue(response->GetBody() == "Hello World");
         }
+
+        TEST_METHOD(Test_Pipelining)
+        {
+            SimpleHttpServer server;
+            server.Start(8081);
+
+            net::StreamSocket ss;
+            Assert::IsTrue(ss.Connect(net::SocketAddress("127.0.0.1", 8081)));
+            std::string requests =
+                "GET /1 HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n"
+                "POST /2 HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 5\r\n\r\nhello"
+                "GET /3 HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+            Assert::AreEqual((int)requests.length(), ss.Send(requests.c_str(), requests.length()));
+
+            std::string responses;
+            char buffer[1024];
+            int n = 0;
+            while ((n = ss.Receive(buffer, sizeof(buffer))) > 0)
+                responses.append(buffer, n);
+
+            std::string expected = "HTTP/1.1 200 OK\r\nContent-Length: 11\r\n\r\nHello World";
+            Assert::IsTrue(responses.compare(0, 2 * expected.length(), expected + expected) == 0);
+            // The last response tells the client the connection is closed.
+            auto last = responses.substr(2 * expected.length());
+            Assert::IsTrue(last.find("HTTP/1.1 200 OK\r\n") == 0);
+            Assert::IsTrue(last.find("\r\nConnection: close\r\n") != std::string::npos);
+            Assert::IsTrue(last.find("\r\nContent-Length: 11\r\n") != std::string::npos);
+            Assert::IsTrue(last.length() == expected.length() + 19);
+        }
+
+        TEST_METHOD(Test_Http2PriorKnowledge)
+        {
+            using namespace net::http;
+
+            SimpleHttpServer server;
+            server.Start(8082);
+
+            auto ss = std::make_shared<net::StreamSocket>();
+            Assert::IsTrue(ss->Connect(net::SocketAddress("127.0.0.1", 8082)));
+
+            std::string block;
+            HpackEncoder encoder;
+            encoder.Encode({ { ":method", "GET" }, { ":scheme", "http" },
+                { ":authority", "127.0.0.1" }, { ":path", "/" } }, block);
+            std::string out = kHttp2Preface;
+            http2::AppendFrame(out, Http2Settings, 0, 0, nullptr, 0);
+            http2::AppendFrame(out, Http2Headers, Http2FlagEndHeaders | Http2FlagEndStream, 1, block.data(), block.size());
+            Assert::AreEqual((int)out.length(), ss->Send(out.data(), (int)out.length()));
+
+            Http2FrameReader reader;
+            reader.Reset(ss.get());
+            HpackDecoder decoder;
+            HeaderFieldList headers;
+            std::string body;
+            Http2Frame frame;
+            bool frameSizeError = false;
+            while (reader.ReadFrame(frame, frameSizeError))
+            {
+                if (frame.Type == Http2Headers && frame.StreamId == 1)
+                    Assert::IsTrue(decoder.Decode(frame.Payload.data(), frame.Payload.size(), headers));
+                if (frame.Type == Http2Data && frame.StreamId == 1)
+                    body += frame.Payload;
+                if ((frame.Type == Http2Headers || frame.Type == Http2Data) && (frame.Flags & Http2FlagEndStream))
+                    break;
+            }
+            Assert::IsTrue(!headers.empty() && headers[0] == HeaderField(":status", "200"));
+            Assert::IsTrue(body == "Hello World");
+        }
+
+        TEST_METHOD(Test_Http2Client)
+        {
+            SimpleHttpServer server;
+            server.Start(8083);
+
+            auto client = net::http::Client::Create();
+            client->SetHttp2(true);
+            auto response = client->Get("http://127.0.0.1:8083/");
+            Assert::IsTrue(response != nullptr);
+            Assert::IsTrue(response->GetProto() == "HTTP/2.0");
+            Assert::IsTrue(response->GetBody() == "Hello World");
+
+            // The concurrent requests share the connection.
+            std::vector<std::thread> threads;
+            std::vector<std::string> bodies(16);
+            for (size_t i = 0; i < bodies.size(); ++i)
+            {
+                threads.emplace_back([&client, &bodies, i]() {
+                    auto r = client->Post("http://127.0.0.1:8083/post", "text/plain", "body");
+                    if (r)
+                        bodies[i] = r->GetBody();
+                });
+            }
+            for (auto& t : threads)
+                t.join();
+            for (auto& body : bodies)
+                Assert::IsTrue(body == "Hello World");
+        }
+
+        TEST_METHOD(Test_Shutdown)
+        {
+            auto server = net::http::Server::Create(net::SocketAddress("127.0.0.1", 8084));
+            server->SetHandler(std::make_shared<SlowHandler>());
+            bool served = false;
+            std::thread t([&]() { served = server->ListenAndServe(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // An idle connection and one in the middle of a request.
+            net::StreamSocket idle;
+            Assert::IsTrue(idle.Connect(net::SocketAddress("127.0.0.1", 8084)));
+            net::StreamSocket busy;
+            Assert::IsTrue(busy.Connect(net::SocketAddress("127.0.0.1", 8084)));
+            std::string request = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+            Assert::AreEqual((int)request.length(), busy.Send(request.c_str(), request.length()));
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            Assert::IsTrue(server->Shutdown(std::chrono::seconds(5)));
+            t.join();
+            Assert::IsTrue(served);
+
+            // The request has been answered, then its connection was closed.
+            std::string response;
+            char buffer[1024];
+            int n = 0;
+            while ((n = busy.Receive(buffer, sizeof(buffer))) > 0)
+                response.append(buffer, n);
+            Assert::IsTrue(response.find("HTTP/1.1 200 OK\r\n") == 0);
+            Assert::IsTrue(response.find("\r\n\r\nslow") != std::string::npos);
+            Assert::IsTrue(idle.Receive(buffer, sizeof(buffer)) <= 0);
+
+            // No connection is accepted anymore.
+            net::StreamSocket late;
+            Assert::IsFalse(late.Connect(net::SocketAddress("127.0.0.1", 8084)));
+            Assert::IsFalse(server->ListenAndServe());
+        }
+
+        TEST_METHOD(Test_HandOff)
+        {
+            auto old = net::http::Server::Create(net::SocketAddress("127.0.0.1", 8085));
+            old->SetHandler(std::make_shared<TextHandler>("old"));
+            std::thread oldThread([&]() { old->ListenAndServe(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // The new server takes the listening socket over a control connection.
+            net::ServerSocket control(net::SocketAddress("127.0.0.1", 0));
+            bool handedOff = false;
+            std::thread handOff([&]() {
+                auto channel = control.Accept();
+                handedOff = old->HandOff(*channel);
+            });
+            net::StreamSocket channel;
+            Assert::IsTrue(channel.Connect(net::SocketAddress("127.0.0.1", control.GetLocalAddress().GetPort())));
+            auto listener = net::ServerSocket::TakeOver(channel);
+            handOff.join();
+            Assert::IsTrue(handedOff);
+            auto server = net::http::Server::Create(listener);
+            Assert::IsTrue(server != nullptr);
+            server->SetHandler(std::make_shared<TextHandler>("new"));
+            std::thread t([&]() { server->ListenAndServe(); });
+
+            Assert::IsTrue(old->Shutdown(std::chrono::seconds(5)));
+            oldThread.join();
+
+            // The connections are accepted by the new server from the same socket.
+            auto client = net::http::Client::Create();
+            auto response = client->Get("http://127.0.0.1:8085/");
+            Assert::IsTrue(response != nullptr);
+            Assert::IsTrue(response->GetBody() == "new");
+
+            Assert::IsTrue(server->Shutdown(std::chrono::seconds(5)));
+            t.join();
+        }
+
+        TEST_METHOD(Test_Http2StalledWindow)
+        {
+            using namespace net::http;
+
+            auto server = Server::Create(net::SocketAddress("127.0.0.1", 8087));
+            server->SetHandler(std::make_shared<TextHandler>(std::string(1024 * 1024, 'x')));
+            std::thread t([&]() { server->ListenAndServe(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // The client allows no data, so the handler blocks once its stream is full.
+            std::string block;
+            HpackEncoder encoder;
+            encoder.Encode({ { ":method", "GET" }, { ":scheme", "http" },
+                { ":authority", "127.0.0.1" }, { ":path", "/" } }, block);
+            std::string settings;
+            http2::AppendSetting(settings, Http2SettingInitialWindowSize, 0);
+            std::string out = kHttp2Preface;
+            http2::AppendFrame(out, Http2Settings, 0, 0, settings.data(), settings.size());
+            http2::AppendFrame(out, Http2Headers, Http2FlagEndHeaders | Http2FlagEndStream, 1, block.data(), block.size());
+            net::StreamSocket stalled;
+            Assert::IsTrue(stalled.Connect(net::SocketAddress("127.0.0.1", 8087)));
+            Assert::AreEqual((int)out.length(), stalled.Send(out.data(), (int)out.length()));
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+            // Closing the connection ends the handler and the connection.
+            stalled.Close();
+            Assert::IsTrue(server->Shutdown(std::chrono::seconds(5)));
+            t.join();
+        }
+
+        TEST_METHOD(Test_Http2EvenStream)
+        {
+            using namespace net::http;
+
+            SimpleHttpServer server;
+            server.Start(8088);
+
+            // A client can't open a stream with an even identifier.
+            std::string block;
+            HpackEncoder encoder;
+            encoder.Encode({ { ":method", "GET" }, { ":scheme", "http" },
+                { ":authority", "127.0.0.1" }, { ":path", "/" } }, block);
+            std::string out = kHttp2Preface;
+            http2::AppendFrame(out, Http2Settings, 0, 0, nullptr, 0);
+            http2::AppendFrame(out, Http2Headers, Http2FlagEndHeaders | Http2FlagEndStream, 2, block.data(), block.size());
+            auto ss = std::make_shared<net::StreamSocket>();
+            Assert::IsTrue(ss->Connect(net::SocketAddress("127.0.0.1", 8088)));
+            Assert::AreEqual((int)out.length(), ss->Send(out.data(), (int)out.length()));
+
+            Http2FrameReader reader;
+            reader.Reset(ss.get());
+            Http2Frame frame;
+            bool frameSizeError = false;
+            uint32_t errorCode = Http2NoError;
+            while (reader.ReadFrame(frame, frameSizeError))
+            {
+                Assert::IsFalse(frame.Type == Http2Headers);
+                if (frame.Type == Http2GoAway)
+                {
+                    errorCode = http2::ReadUInt32(frame.Payload.data() + 4);
+                    break;
+                }
+            }
+            Assert::IsTrue(errorCode == Http2ProtocolError);
+        }
+
+        TEST_METHOD(Test_Http2ContentLength)
+        {
+            using namespace net::http;
+
+            SimpleHttpServer server;
+            server.Start(8093);
+
+            // The stream 1 sends less data than its Content-Length, the stream 3 as much.
+            std::string out = kHttp2Preface;
+            http2::AppendFrame(out, Http2Settings, 0, 0, nullptr, 0);
+            HpackEncoder encoder;
+            for (uint32_t id = 1; id <= 3; id += 2)
+            {
+                std::string block;
+                encoder.Encode({ { ":method", "POST" }, { ":scheme", "http" },
+                    { ":authority", "127.0.0.1" }, { ":path", "/" }, { "content-length", "5" } }, block);
+                http2::AppendFrame(out, Http2Headers, Http2FlagEndHeaders, id, block.data(), block.size());
+            }
+            http2::AppendFrame(out, Http2Data, Http2FlagEndStream, 1, "abc", 3);
+            http2::AppendFrame(out, Http2Data, Http2FlagEndStream, 3, "hello", 5);
+            auto ss = std::make_shared<net::StreamSocket>();
+            Assert::IsTrue(ss->Connect(net::SocketAddress("127.0.0.1", 8093)));
+            Assert::AreEqual((int)out.length(), ss->Send(out.data(), (int)out.length()));
+
+            Http2FrameReader reader;
+            reader.Reset(ss.get());
+            Http2Frame frame;
+            bool frameSizeError = false;
+            uint32_t errorCode = Http2NoError;
+            bool answered = false;
+            while ((errorCode == Http2NoError || !answered) && reader.ReadFrame(frame, frameSizeError))
+            {
+                if (frame.Type == Http2RstStream && frame.StreamId == 1)
+                    errorCode = http2::ReadUInt32(frame.Payload.data());
+                Assert::IsFalse(frame.Type == Http2Headers && frame.StreamId == 1);
+                if (frame.Type == Http2Headers && frame.StreamId == 3)
+                    answered = true;
+            }
+            Assert::IsTrue(errorCode == Http2ProtocolError);
+            Assert::IsTrue(answered);
+        }
+
+        TEST_METHOD(Test_Http2PingFlood)
+        {
+            using namespace net::http;
+
+            SimpleHttpServer server;
+            server.Start(8092);
+
+            // A client which sends PINGs and never reads the acknowledgements is cut off,
+            // rather than having them queued without bound.
+            std::string out = kHttp2Preface;
+            http2::AppendFrame(out, Http2Settings, 0, 0, nullptr, 0);
+            net::StreamSocket ss;
+            Assert::IsTrue(ss.Connect(net::SocketAddress("127.0.0.1", 8092)));
+            Assert::AreEqual((int)out.length(), ss.Send(out.data(), (int)out.length()));
+            std::string pings;
+            for (int i = 0; i < 1000; ++i)
+                http2::AppendFrame(pings, Http2Ping, 0, 0, "12345678", 8);
+            size_t sent = 0;
+            while (sent < 64 * 1024 * 1024 && ss.Send(pings.data(), (int)pings.length()) == (int)pings.length())
+                sent += pings.length();
+            Assert::IsTrue(sent < 64 * 1024 * 1024);
+        }
+
+        TEST_METHOD(Test_RequestBody)
+        {
+            auto server = net::http::Server::Create(net::SocketAddress("127.0.0.1", 8086));
+            server->SetHandler(std::make_shared<TextHandler>("ok"));
+            server->SetMaxRequestBodySize(8);
+            std::thread t([&]() { server->ListenAndServe(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // A body beyond the limit closes the connection without a response.
+            net::StreamSocket large;
+            Assert::IsTrue(large.Connect(net::SocketAddress("127.0.0.1", 8086)));
+            std::string requests =
+                "POST /1 HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 5\r\n\r\nhello"
+                "POST /2 HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 9\r\n\r\n123456789";
+            Assert::AreEqual((int)requests.length(), large.Send(requests.c_str(), requests.length()));
+            std::string responses;
+            char buffer[1024];
+            int n = 0;
+            while ((n = large.Receive(buffer, sizeof(buffer))) > 0)
+                responses.append(buffer, n);
+            Assert::IsTrue(responses == "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+
+            // So does a body shorter than its Content-Length.
+            net::StreamSocket shorter;
+            Assert::IsTrue(shorter.Connect(net::SocketAddress("127.0.0.1", 8086)));
+            std::string request = "POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 6\r\n\r\nabc";
+            Assert::AreEqual((int)request.length(), shorter.Send(request.c_str(), request.length()));
+            Assert::IsTrue(shorter.ShutdownSend());
+            Assert::IsTrue(shorter.Receive(buffer, sizeof(buffer)) <= 0);
+
+            Assert::IsTrue(server->Shutdown(std::chrono::seconds(5)));
+            t.join();
+        }
+
+        TEST_METHOD(Test_ChunkedRequestBody)
+        {
+            auto server = net::http::Server::Create(net::SocketAddress("127.0.0.1", 8090));
+            server->SetHandler(std::make_shared<EchoHandler>());
+            std::thread t([&]() { server->ListenAndServe(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // A chunked body is decoded, the request behind it is served next.
+            net::StreamSocket chunked;
+            Assert::IsTrue(chunked.Connect(net::SocketAddress("127.0.0.1", 8090)));
+            std::string requests =
+                "POST /1 HTTP/1.1\r\nHost: 127.0.0.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                "5;ext=1\r\nhello\r\n6\r\n world\r\n0\r\nTrailer: x\r\n\r\n"
+                "POST /2 HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+            Assert::AreEqual((int)requests.length(), chunked.Send(requests.c_str(), requests.length()));
+            std::string responses;
+            char buffer[1024];
+            int n = 0;
+            while ((n = chunked.Receive(buffer, sizeof(buffer))) > 0)
+                responses.append(buffer, n);
+            Assert::IsTrue(responses.find("\r\n\r\nhello world") != std::string::npos);
+            Assert::IsTrue(responses.find("\r\n\r\nok") != std::string::npos);
+
+            // A request framed by both Transfer-Encoding and Content-Length, or with a
+            // Content-Length which isn't a number, closes the connection without a response.
+            const char* invalid[] = {
+                "POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n",
+                "POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nTransfer-Encoding: gzip\r\n\r\n",
+                "POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: +2\r\n\r\nok",
+                "POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 2abc\r\n\r\nok",
+            };
+            for (auto request : invalid)
+            {
+                net::StreamSocket s;
+                Assert::IsTrue(s.Connect(net::SocketAddress("127.0.0.1", 8090)));
+                Assert::AreEqual((int)strlen(request), s.Send(request, (int)strlen(request)));
+                Assert::IsTrue(s.Receive(buffer, sizeof(buffer)) <= 0);
+            }
+
+            Assert::IsTrue(server->Shutdown(std::chrono::seconds(5)));
+            t.join();
+        }
+
+        TEST_METHOD(Test_WriteNotHeldBack)
+        {
+            auto server = net::http::Server::Create(net::SocketAddress("127.0.0.1", 8091));
+            auto handler = std::make_shared<BlockingHandler>();
+            server->SetHandler(handler);
+            std::thread t([&]() { server->ListenAndServe(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // Without a pipelined request behind it, the response is sent while the handler still runs.
+            std::thread release([&]() {
+                std::this_thread::sleep_for(std::chrono::seconds(3));
+                handler->Released = true;
+            });
+            net::StreamSocket s;
+            Assert::IsTrue(s.Connect(net::SocketAddress("127.0.0.1", 8091)));
+            std::string request = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+            Assert::AreEqual((int)request.length(), s.Send(request.c_str(), request.length()));
+            std::string response;
+            char buffer[1024];
+            while (response.find("ready") == std::string::npos)
+            {
+                int n = s.Receive(buffer, sizeof(buffer));
+                Assert::IsTrue(n > 0);
+                response.append(buffer, n);
+            }
+            Assert::IsFalse(handler->Released);
+            release.join();
+
+            Assert::IsTrue(server->Shutdown(std::chrono::seconds(5)));
+            t.join();
+        }
+
+        TEST_METHOD(Test_RequestTimeout)
+        {
+            auto server = net::http::Server::Create(net::SocketAddress("127.0.0.1", 8089));
+            server->SetHandler(std::make_shared<SlowHandler>());
+            server->SetRequestTimeout(std::chrono::milliseconds(100));
+            std::thread t([&]() { server->ListenAndServe(); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // The handler takes longer than the request timeout, which only bounds reading the request.
+            net::StreamSocket s;
+            Assert::IsTrue(s.Connect(net::SocketAddress("127.0.0.1", 8089)));
+            std::string request = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+            Assert::AreEqual((int)request.length(), s.Send(request.c_str(), request.length()));
+            std::string response;
+            char buffer[1024];
+            int n = 0;
+            while ((n = s.Receive(buffer, sizeof(buffer))) > 0)
+                response.append(buffer, n);
+            Assert::IsTrue(response.find("HTTP/1.1 200 OK\r\n") == 0);
+            Assert::IsTrue(response.find("\r\n\r\nslow") != std::string::npos);
+
+            // A request which isn't completed in time is cut.
+            net::StreamSocket partial;
+            Assert::IsTrue(partial.Connect(net::SocketAddress("127.0.0.1", 8089)));
+            request = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n";
+            Assert::AreEqual((int)request.length(), partial.Send(request.c_str(), request.length()));
+            Assert::IsTrue(partial.Receive(buffer, sizeof(buffer)) <= 0);
+
+            Assert::IsTrue(server->Shutdown(std::chrono::seconds(5)));
+            t.join();
+        }
     };
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include "net/base/base64.h"
+#include "net/base/sha1.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace TestSuite
+{
+    TEST_CLASS(sha1_Test)
+    {
+    public:
+        TEST_METHOD(Test_Sum)
+        {
+            Assert::IsTrue(base::base64::Encode(base::sha1::Sum("")) == "2jmj7l5rSw0yVb/vlWAYkK/YBwk=");
+            Assert::IsTrue(base::base64::Encode(base::sha1::Sum("abc")) == "qZk+NkcGgWq6PiVxeFDCbJzQ2J0=");
+            // 56 bytes, the length goes to a second block.
+            Assert::IsTrue(base::base64::Encode(base::sha1::Sum(
+                "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")) == "hJg+RBw70m66rkqh+VEp5eVGcPE=");
+            Assert::IsTrue(base::base64::Encode(base::sha1::Sum(std::string(1000, 'a'))) == "KR6abGaZSUm1e6XmUDYemPw2sbo=");
+        }
+
+        TEST_METHOD(Test_WebSocketAccept)
+        {
+            // RFC 6455, 1.3.
+            Assert::IsTrue(base::base64::Encode(base::sha1::Sum(
+                "dGhlIHNhbXBsZSBub25jZQ==258EAFA5-E914-47DA-95CA-C5AB0DC85B11")) == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+        }
+    };
+}
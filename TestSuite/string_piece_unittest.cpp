@@ -0,0 +1,68 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include "net/base/strings/string_piece.h"
+#include "net/http/request.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace TestSuite
+{
+    TEST_CLASS(string_piece_Test)
+    {
+    public:
+        TEST_METHOD(Test_StringPiece)
+        {
+            using base::strings::StringPiece;
+
+            std::string s = "Content-Type: text/html";
+            StringPiece piece(s);
+            Assert::IsTrue(piece.data() == s.data());
+            Assert::IsTrue(piece.size() == s.size());
+            Assert::IsTrue(piece.find(':') == 12);
+            Assert::IsTrue(piece.find("text") == 14);
+            Assert::IsTrue(piece.find("html", 20) == StringPiece::npos);
+            Assert::IsTrue(piece.find("") == 0);
+            Assert::IsTrue(piece.substr(14) == "text/html");
+            Assert::IsTrue(piece.substr(14, 4).ToString() == "text");
+            Assert::IsTrue(piece.substr(100).empty());
+            Assert::IsTrue(StringPiece("abc") < StringPiece("abd"));
+            Assert::IsTrue(StringPiece("ab") < StringPiece("abc"));
+            Assert::IsTrue(StringPiece() == "");
+        }
+
+        TEST_METHOD(Test_RequestViews)
+        {
+            auto request = net::http::Request::Create("POST", "http://localhost/", std::string(1000, 'x'));
+            auto view = request->GetBodyView();
+            Assert::IsTrue(view.size() == 1000);
+            Assert::IsTrue(request->GetHeaderView("host") == "localhost");
+            Assert::IsTrue(request->GetHeaderView("Referer").empty());
+
+            // TakeBody moves the body out without copying it.
+            auto body = request->TakeBody();
+            Assert::IsTrue(body.data() == view.data());
+            Assert::IsTrue(request->GetBodyView().empty());
+            request->SetBody(std::move(body));
+            Assert::IsTrue(request->GetBodyView().data() == view.data());
+        }
+    };
+}
@@ -291,5 +291,102 @@ namespace TestSuite
             Assert::IsTrue(base::strings::IsDigit(str) == true);
             Assert::IsTrue(base::strings::IsDigit(str, true) == false);
         }
+
+        TEST_METHOD(Test_Equal)
+        {
+            Assert::IsTrue(base::strings::Equal("Content-Type", "Content-Type"));
+            Assert::IsTrue(base::strings::Equal("Content-Type", "content-type") == false);
+            Assert::IsTrue(base::strings::Equal("Content-Type", "CONTENT-type", true));
+            Assert::IsTrue(base::strings::Equal("Content-Type", "Content-Typ", true) == false);
+            Assert::IsTrue(base::strings::Equal("", "", true));
+
+            // Long strings are compared 16 bytes at a time, the case of other bytes than
+            // ASCII letters is not ignored.
+            std::string lower = "accept-encoding: gzip, deflate, br; q=0.9 [@`{]";
+            std::string upper = "ACCEPT-ENCODING: GZIP, DEFLATE, BR; Q=0.9 [@`{]";
+            Assert::IsTrue(base::strings::Equal(lower, upper, true));
+            for (size_t i = 0; i < lower.size(); ++i)
+            {
+                std::string other = upper;
+                other[i] ^= 0x20;
+                bool letter = ('a' <= lower[i] && lower[i] <= 'z');
+                Assert::IsTrue(base::strings::Equal(lower, other, true) == letter);
+            }
+            Assert::IsTrue(base::strings::Equal(std::string(20, '\xC1'), std::string(20, '\xE1'), true) == false);
+            Assert::IsTrue(base::strings::ToLower(std::string(20, '\xC1')) == std::string(20, '\xC1'));
+            Assert::IsTrue(base::strings::ToUpper(lower) == upper);
+            Assert::IsTrue(base::strings::ToLower(upper) == lower);
+        }
+
+        TEST_METHOD(Test_HashIgnoreCase)
+        {
+            Assert::IsTrue(base::strings::HashIgnoreCase("Content-Length") == base::strings::HashIgnoreCase("content-length"));
+            Assert::IsTrue(base::strings::HashIgnoreCase("Content-Length") != base::strings::HashIgnoreCase("Content-Type"));
+        }
+
+        TEST_METHOD(Test_StringPiece)
+        {
+            std::string str = " \t Hello, World \r\n";
+            base::strings::StringPiece piece(str);
+            auto trimmed = base::strings::TrimSpace(piece);
+            Assert::IsTrue(trimmed == "Hello, World");
+            Assert::IsTrue(trimmed.data() == str.data() + 3);
+            Assert::IsTrue(base::strings::TrimLeftSpace(piece) == "Hello, World \r\n");
+            Assert::IsTrue(base::strings::TrimRightSpace(piece) == " \t Hello, World");
+            Assert::IsTrue(base::strings::Trim(trimmed, "Hd") == "ello, Worl");
+            Assert::IsTrue(base::strings::TrimLeft(trimmed, "") == trimmed);
+            Assert::IsTrue(base::strings::TrimRight(trimmed, "dlroW ,") == "He");
+            Assert::IsTrue(base::strings::TrimSpace(base::strings::StringPiece(" \t ")).empty());
+
+            base::strings::StringPiece hello("helloHELLO world");
+            Assert::IsTrue(base::strings::TrimPrefix(hello, "hello") == "HELLO world");
+            Assert::IsTrue(base::strings::TrimPrefix(hello, "hello", true, true) == " world");
+            Assert::IsTrue(base::strings::TrimSuffix(hello, "WORLD", true) == "helloHELLO ");
+            Assert::IsTrue(base::strings::TrimSuffix(hello, "WORLD") == hello);
+            Assert::IsTrue(base::strings::StartsWith(hello, "HELLOhello", true));
+            Assert::IsTrue(base::strings::EndsWith(hello, "O WORLD", true));
+
+            // The methods on strings trim in place.
+            str = "xxyxHelloxyy";
+            base::strings::TrimSelf(str, "xy");
+            Assert::IsTrue(str == "Hello");
+        }
+
+        TEST_METHOD(Test_SplitPieces)
+        {
+            // The pieces are those of Split.
+            const char* strs[] = { "", "a", "a,b", ",a,,b,", "A1a2A", "abc" };
+            const char* seps[] = { ",", "a", "" };
+            for (auto str : strs)
+            {
+                for (auto sep : seps)
+                {
+                    for (int n = -1; n <= 4; ++n)
+                    {
+                        for (int i = 0; i < 4; ++i)
+                        {
+                            bool bIgnoreCase = (i & 1) != 0;
+                            bool bAfter = (i & 2) != 0;
+                            auto expected = bAfter ? base::strings::SplitAfterN(str, sep, n, bIgnoreCase)
+                                                   : base::strings::SplitN(str, sep, n, bIgnoreCase);
+                            std::vector<std::string> pieces;
+                            auto range = bAfter ? base::strings::SplitAfterPiecesN(str, sep, n, bIgnoreCase)
+                                                : base::strings::SplitPiecesN(str, sep, n, bIgnoreCase);
+                            for (auto piece : range)
+                                pieces.push_back(piece.ToString());
+                            Assert::IsTrue(pieces == expected);
+                        }
+                    }
+                }
+            }
+
+            std::string str = "key = value = more";
+            auto kv = base::strings::SplitPiecesN<2>(str, "=");
+            Assert::IsTrue(kv.size() == 2 && kv[0] == "key " && kv[1] == " value = more");
+            Assert::IsTrue(kv[0].data() == str.data());
+            auto parts = base::strings::SplitPiecesN<4>(str, " ");
+            Assert::IsTrue(parts.size() == 4 && parts.back() == "= more");
+            Assert::IsTrue(base::strings::SplitPiecesN<2>("", "=").size() == 1);
+        }
     };
 }
\ No newline at end of file
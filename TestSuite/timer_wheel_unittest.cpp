@@ -0,0 +1,138 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include <atomic>
+#include <thread>
+
+#include "net/base/timer_wheel.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace TestSuite
+{
+    TEST_CLASS(timer_wheel_Test)
+    {
+    public:
+        TEST_METHOD(Test_Expire)
+        {
+            base::TimerWheel wheel;
+            std::vector<uint64_t> fired;
+            // Delays on every level, each timer records the time it fired at.
+            std::vector<uint64_t> delays = { 0, 1, 255, 256, 300, 16383, 16384, 70000, 1048576, 5000000, 70000000 };
+            for (auto delay : delays)
+                wheel.Schedule(delay, [&fired, delay] { fired.push_back(delay); });
+            Assert::IsTrue(wheel.GetSize() == delays.size());
+
+            std::vector<base::TimerWheel::Callback> expired;
+            uint64_t now = 0;
+            while (wheel.GetSize() > 0)
+            {
+                // Advance in uneven steps, a timer fires in the step which reaches it.
+                uint64_t last = now;
+                now += 1 + now / 3;
+                size_t before = fired.size();
+                wheel.Advance(now, expired);
+                for (auto& callback : expired)
+                    callback();
+                expired.clear();
+                for (size_t i = before; i < fired.size(); ++i)
+                    Assert::IsTrue(fired[i] <= now && (fired[i] > last || fired[i] == 0));
+            }
+            Assert::IsTrue(fired.size() == delays.size());
+            // The timers of a tick fire in any order, a delay of 0 expires at the next tick.
+            for (size_t i = 1; i < fired.size(); ++i)
+                Assert::IsTrue(fired[i - 1] <= fired[i] || fired[i] <= 1);
+        }
+
+        TEST_METHOD(Test_ExactTick)
+        {
+            base::TimerWheel wheel(1000);
+            std::vector<base::TimerWheel::Callback> expired;
+            for (uint64_t delay : { 1, 256, 257, 20000, 2000000 })
+            {
+                bool done = false;
+                wheel.Schedule(delay, [&done] { done = true; });
+                uint64_t start = wheel.GetTime();
+                wheel.Advance(start + delay - 1, expired);
+                Assert::IsTrue(expired.empty());
+                Assert::IsTrue(wheel.NextTimeout() <= delay);
+                wheel.Advance(start + delay, expired);
+                Assert::IsTrue(expired.size() == 1);
+                expired[0]();
+                expired.clear();
+                Assert::IsTrue(done);
+            }
+            Assert::IsTrue(wheel.NextTimeout() == UINT64_MAX);
+        }
+
+        TEST_METHOD(Test_Cancel)
+        {
+            base::TimerWheel wheel;
+            int count = 0;
+            auto id1 = wheel.Schedule(10, [&count] { ++count; });
+            auto id2 = wheel.Schedule(100000, [&count] { ++count; });
+            auto id3 = wheel.Schedule(10, [&count] { ++count; });
+            Assert::IsTrue(wheel.Cancel(id1));
+            Assert::IsFalse(wheel.Cancel(id1));
+            Assert::IsTrue(wheel.Cancel(id2));
+            Assert::IsTrue(wheel.GetSize() == 1);
+
+            // The slot of a cancelled timer is reused with another id.
+            auto id4 = wheel.Schedule(5, [&count] { count += 10; });
+            Assert::IsTrue(id4 != id1 && id4 != id2);
+            Assert::IsFalse(wheel.Cancel(id1));
+
+            std::vector<base::TimerWheel::Callback> expired;
+            wheel.Advance(200000, expired);
+            for (auto& callback : expired)
+                callback();
+            Assert::IsTrue(count == 11);
+            Assert::IsFalse(wheel.Cancel(id3));
+            Assert::IsTrue(wheel.GetSize() == 0);
+        }
+
+        TEST_METHOD(Test_TimerService)
+        {
+            base::TimerService service;
+            std::atomic<int> count(0);
+            auto start = std::chrono::steady_clock::now();
+            service.Schedule(std::chrono::milliseconds(50), [&count] { ++count; });
+            auto id = service.Schedule(std::chrono::milliseconds(20), [&count] { count += 100; });
+            Assert::IsTrue(service.Cancel(id));
+            while (count == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            Assert::IsTrue(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+            Assert::IsTrue(count == 1);
+
+            std::atomic<bool> expired(false);
+            base::Deadline deadline([&expired] { expired = true; }, service);
+            deadline.Reset(std::chrono::milliseconds(10));
+            deadline.Reset(std::chrono::milliseconds(1000));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            Assert::IsFalse(expired);
+            Assert::IsFalse(deadline.Expired());
+            deadline.Reset(std::chrono::milliseconds(1));
+            while (!expired)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            Assert::IsTrue(deadline.Expired());
+        }
+    };
+}
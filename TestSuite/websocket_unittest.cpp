@@ -0,0 +1,94 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include "net/http/websocket.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace net::http;
+
+namespace TestSuite
+{
+    TEST_CLASS(websocket_Test)
+    {
+    public:
+        TEST_METHOD(Test_AcceptKey)
+        {
+            // RFC 6455, 1.3.
+            Assert::IsTrue(websocket::AcceptKey("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+        }
+
+        TEST_METHOD(Test_AppendFrame)
+        {
+            // RFC 6455, 5.7.
+            std::string frame;
+            websocket::AppendFrame(frame, WebSocketText, true, false, "Hello", 5);
+            Assert::IsTrue(frame == std::string("\x81\x05Hello", 7));
+
+            const uint8_t key[4] = { 0x37, 0xfa, 0x21, 0x3d };
+            frame.clear();
+            websocket::AppendFrame(frame, WebSocketText, true, false, "Hello", 5, key);
+            Assert::IsTrue(frame == std::string("\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58", 11));
+
+            frame.clear();
+            websocket::AppendFrame(frame, WebSocketText, false, false, "Hel", 3);
+            websocket::AppendFrame(frame, WebSocketContinuation, true, false, "lo", 2);
+            Assert::IsTrue(frame == std::string("\x01\x03Hel\x80\x02lo", 9));
+
+            std::string payload(256, 'a');
+            frame.clear();
+            websocket::AppendFrame(frame, WebSocketBinary, true, false, payload.data(), payload.size());
+            Assert::IsTrue(frame.compare(0, 4, std::string("\x82\x7E\x01\x00", 4)) == 0);
+            Assert::IsTrue(frame.size() == 4 + payload.size());
+
+            payload.assign(65536, 'a');
+            frame.clear();
+            websocket::AppendFrame(frame, WebSocketBinary, true, true, payload.data(), payload.size());
+            Assert::IsTrue(frame.compare(0, 10, std::string("\xC2\x7F\x00\x00\x00\x00\x00\x01\x00\x00", 10)) == 0);
+            Assert::IsTrue(frame.size() == 10 + payload.size());
+        }
+
+        TEST_METHOD(Test_Mask)
+        {
+            const uint8_t key[4] = { 0x12, 0x34, 0x56, 0x78 };
+            std::string data;
+            for (int i = 0; i < 1000; ++i)
+                data.push_back((char)(i * 7));
+
+            std::string masked = data;
+            websocket::Mask(&masked[0], masked.size(), key);
+            for (size_t i = 0; i < data.size(); ++i)
+                Assert::IsTrue((uint8_t)masked[i] == ((uint8_t)data[i] ^ key[i % 4]));
+
+            // Masking in pieces with offsets gives the same result.
+            std::string pieces = data;
+            size_t offset = 0;
+            for (size_t length : { 3, 17, 64, 1, 915 })
+            {
+                websocket::Mask(&pieces[offset], length, key, offset);
+                offset += length;
+            }
+            Assert::IsTrue(pieces == masked);
+
+            websocket::Mask(&masked[0], masked.size(), key);
+            Assert::IsTrue(masked == data);
+        }
+    };
+}
@@ -44,5 +44,158 @@ namespace TestSuite
             Assert::IsTrue(strDecompressData == data);
             Assert::IsTrue(base::zip::Decompress(data).empty());
         }
+
+        TEST_METHOD(Test_GDecompress)
+        {
+            std::string data;
+            for (int i = 0; i < 10000; ++i)
+                data += "hello world " + std::to_string(i) + "\n";
+            std::string gzipped = base::zip::GCompress(data);
+            Assert::IsTrue(gzipped.size() < data.size());
+            Assert::IsTrue(base::zip::GDecompress(gzipped) == data);
+            Assert::IsTrue(base::zip::GDecompress(gzipped.substr(0, gzipped.size() / 2)).empty());
+            Assert::IsTrue(base::zip::GDecompress(data).empty());
+        }
+
+        TEST_METHOD(Test_GDecompress_Limits)
+        {
+            using namespace base::zip;
+
+            // The members of a gzip stream are concatenated, trailing zeros are ignored.
+            std::string first(3000, 'a');
+            std::string second = "second member";
+            std::string gzipped = GCompress(first) + GCompress(second);
+            Assert::IsTrue(GDecompress(gzipped) == first + second);
+            Assert::IsTrue(GDecompress(gzipped + std::string(8, '\0')) == first + second);
+            Assert::IsTrue(GDecompress(gzipped + "x").empty());
+            char buffer[4096];
+            Assert::IsTrue(GDecompress(buffer, sizeof(buffer), gzipped.data(), gzipped.size()) == first.size() + second.size());
+
+            // A member boundary between two parts.
+            Inflater inflater(kGzip);
+            std::string out;
+            size_t firstSize = GCompress(first).size();
+            Assert::IsTrue(inflater.Inflate(gzipped.data(), firstSize, out));
+            Assert::IsTrue(inflater.IsFinished());
+            Assert::IsTrue(inflater.Inflate(gzipped.data() + firstSize, gzipped.size() - firstSize, out));
+            Assert::IsTrue(inflater.IsFinished() && out == first + second);
+
+            // A bomb stops at the ratio, no matter what the trailer claims.
+            std::string zeros(16 * 1024 * 1024, '\0');
+            std::string bomb = GCompress(zeros);
+            Assert::IsTrue(GDecompress(bomb).empty());
+            out.clear();
+            Assert::IsFalse(GDecompress(bomb.data(), bomb.size(), out, Limits(0, 256)));
+            Assert::IsTrue(out.size() <= bomb.size() * 256 + 1024 * 1024 + 1);
+            out.clear();
+            Assert::IsTrue(GDecompress(bomb.data(), bomb.size(), out, Limits()));
+            Assert::IsTrue(out == zeros);
+            out.clear();
+            Assert::IsFalse(GDecompress(gzipped.data(), gzipped.size(), out, Limits(first.size(), 0)));
+            Assert::IsTrue(out.size() <= first.size() + 1);
+
+            // The limits hold over the parts of a message.
+            inflater.Reset();
+            inflater.SetLimits(Limits(first.size() + 100, 0));
+            out.clear();
+            Assert::IsTrue(inflater.Inflate(gzipped.data(), firstSize, out));
+            Assert::IsFalse(inflater.Inflate(bomb.data(), bomb.size(), out));
+            Assert::IsTrue(inflater.IsTooLarge());
+        }
+
+        TEST_METHOD(Test_GCompressParallel)
+        {
+            using namespace base::zip;
+
+            std::string data;
+            for (int i = 0; data.size() < 5 * kParallelBlockSize / 2; ++i)
+                data += "line " + std::to_string(i * 31 % 977) + " of the log\n";
+
+            // The inflater checks the combined CRC and the size.
+            std::string gzipped = GCompressParallel(data, 4);
+            Assert::IsTrue(GDecompress(gzipped) == data);
+            Assert::IsTrue(GCompressParallel(data, 1) == gzipped);
+            Assert::IsTrue(gzipped.size() < GCompress(data).size() * 11 / 10);
+
+            std::string small = data.substr(0, 1000);
+            Assert::IsTrue(GDecompress(GCompressParallel(small)) == small);
+        }
+
+        TEST_METHOD(Test_Stream)
+        {
+            using namespace base::zip;
+
+            std::string data;
+            for (int i = 0; i < 5000; ++i)
+                data += std::to_string(i * 7919 % 10007) + ",";
+
+            // Compress in small pieces into a small buffer.
+            Deflater deflater(kGzip);
+            Assert::IsTrue(deflater.IsValid());
+            std::string gzipped;
+            for (int round = 0; round < 2; ++round)
+            {
+                gzipped.clear();
+                const char* src = data.data();
+                size_t srcLength = data.size();
+                Status status = kOk;
+                while (status == kOk)
+                {
+                    char buffer[100];
+                    char* dst = buffer;
+                    size_t dstLength = sizeof(buffer);
+                    size_t piece = srcLength < 333 ? srcLength : 333;
+                    size_t rest = srcLength - piece;
+                    status = deflater.Update(src, piece, dst, dstLength, rest == 0 ? kFinish : kNoFlush);
+                    srcLength = piece + rest;
+                    gzipped.append(buffer, sizeof(buffer) - dstLength);
+                }
+                Assert::IsTrue(status == kStreamEnd);
+                Assert::IsTrue(base::zip::GDecompress(gzipped) == data);
+                deflater.Reset();
+            }
+
+            // Inflate in pieces, a reset inflater takes the next message.
+            Inflater inflater(kGzip);
+            for (int round = 0; round < 2; ++round)
+            {
+                std::string out;
+                for (size_t i = 0; i < gzipped.size(); i += 7)
+                    Assert::IsTrue(inflater.Inflate(gzipped.data() + i, gzipped.size() - i < 7 ? gzipped.size() - i : 7, out));
+                Assert::IsTrue(inflater.IsFinished());
+                Assert::IsTrue(out == data);
+                inflater.Reset();
+            }
+
+            // The output stops at the limit.
+            std::string limited;
+            Assert::IsFalse(inflater.Inflate(gzipped.data(), gzipped.size(), limited, 1000));
+            Assert::IsTrue(limited.size() <= 1001);
+        }
+
+        TEST_METHOD(Test_Pool)
+        {
+            using namespace base::zip;
+
+            Inflater* first = nullptr;
+            {
+                auto inflater = AcquireInflater(kGzip);
+                first = &*inflater;
+                auto other = AcquireInflater(kGzip);
+                Assert::IsTrue(&*other != first);
+            }
+            // The stream released last is taken first.
+            auto inflater = AcquireInflater(kGzip);
+            Assert::IsTrue(&*inflater == first);
+
+            auto deflater = AcquireDeflater(kRaw, 9);
+            Assert::IsTrue(deflater->GetFormat() == kRaw && deflater->GetLevel() == 9);
+            std::string raw;
+            Assert::IsTrue(deflater->Compress("hello hello hello", 17, raw));
+            Inflater rawInflater(kRaw);
+            std::string out;
+            Assert::IsTrue(rawInflater.Inflate(raw.data(), raw.size(), out));
+            Assert::IsTrue(out == "hello hello hello");
+        }
     };
 }
\ No newline at end of file
@@ -1,93 +1,554 @@
 #include "base64.h"
 
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BASE_BASE64_TARGET(x)
+#else
+#define BASE_BASE64_TARGET(x) __attribute__((target(x)))
+#endif
+#define BASE_BASE64_X86
+#endif
+
 namespace base {
 namespace base64 {
 
 namespace {
-    const std::string kBase64Table =
+    const char kStandardAlphabet[] =
         "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
         "abcdefghijklmnopqrstuvwxyz"
-        "0123456789+/=";
+        "0123456789+/";
+    const char kUrlSafeAlphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+        "abcdefghijklmnopqrstuvwxyz"
+        "0123456789-_";
+
+    const uint8_t kInvalid = 0xFF;
+
+    // DecodeTable maps the chars of an alphabet to their values and the others to kInvalid.
+    struct DecodeTable
+    {
+        uint8_t Values[256];
+
+        explicit DecodeTable(const char* alphabet)
+        {
+            memset(Values, kInvalid, sizeof(Values));
+            for (int i = 0; i < 64; ++i)
+                Values[static_cast<unsigned char>(alphabet[i])] = static_cast<uint8_t>(i);
+        }
+    };
+
+    const char* GetAlphabet(int flags)
+    {
+        return (flags & kUrlSafe) ? kUrlSafeAlphabet : kStandardAlphabet;
+    }
+
+    const DecodeTable& GetDecodeTable(int flags)
+    {
+        static const DecodeTable kStandardTable(kStandardAlphabet);
+        static const DecodeTable kUrlSafeTable(kUrlSafeAlphabet);
+        return (flags & kUrlSafe) ? kUrlSafeTable : kStandardTable;
+    }
+
+    // EncodeScalar encodes the groups of three bytes of |p| and returns the number of
+    // bytes encoded.
+    size_t EncodeScalar(const unsigned char* p, size_t len, char* out, const char* alphabet)
+    {
+        size_t i = 0;
+        for (; i + 3 <= len; i += 3, out += 4)
+        {
+            uint32_t v = (p[i] << 16) | (p[i + 1] << 8) | p[i + 2];
+            out[0] = alphabet[v >> 18];
+            out[1] = alphabet[(v >> 12) & 0x3F];
+            out[2] = alphabet[(v >> 6) & 0x3F];
+            out[3] = alphabet[v & 0x3F];
+        }
+        return i;
+    }
+
+    // DecodeScalar decodes the groups of four chars of |p| until one of them has a char
+    // out of the alphabet, and returns the number of chars decoded.
+    size_t DecodeScalar(const unsigned char* p, size_t len, unsigned char* out, const DecodeTable& table)
+    {
+        size_t i = 0;
+        for (; i + 4 <= len; i += 4, out += 3)
+        {
+            uint32_t a = table.Values[p[i]];
+            uint32_t b = table.Values[p[i + 1]];
+            uint32_t c = table.Values[p[i + 2]];
+            uint32_t d = table.Values[p[i + 3]];
+            if ((a | b | c | d) & 0x80)
+                break;
+            uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+            out[0] = static_cast<unsigned char>(v >> 16);
+            out[1] = static_cast<unsigned char>(v >> 8);
+            out[2] = static_cast<unsigned char>(v);
+        }
+        return i;
+    }
+
+#if defined(BASE_BASE64_X86)
+    // The vector kernels follow W. Mula and D. Lemire, "Faster Base64 Encoding and
+    // Decoding Using AVX2 Instructions". The SSSE3 ones handle 12 bytes a block and the
+    // AVX2 ones 24, the CPU is asked once which of them can run.
+    enum Kernel
+    {
+        kScalar,
+        kSsse3,
+        kAvx2
+    };
+
+    Kernel DetectKernel()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+        __cpuid(info, 1);
+        bool ssse3 = (info[2] & (1 << 9)) != 0;
+        // The OS must save the YMM registers, see OSXSAVE and XCR0.
+        bool ymm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+        bool avx2 = false;
+        if (ymm && maxLeaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        bool ssse3 = __builtin_cpu_supports("ssse3") != 0;
+        bool avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+        return avx2 ? kAvx2 : (ssse3 ? kSsse3 : kScalar);
+    }
+
+    Kernel GetKernel()
+    {
+        static const Kernel kKernel = DetectKernel();
+        return kKernel;
+    }
+
+    // EncodeShifts holds the offsets from the values to the chars, by ranges: a-z, 0-9,
+    // the 62nd char, the 63rd char and A-Z.
+    __m128i EncodeShifts(const char* alphabet)
+    {
+        const char kDigit = '0' - 52;
+        return _mm_setr_epi8('a' - 26, kDigit, kDigit, kDigit, kDigit, kDigit, kDigit, kDigit, kDigit, kDigit, kDigit,
+                             static_cast<char>(alphabet[62] - 62), static_cast<char>(alphabet[63] - 63), 'A', 0, 0);
+    }
+
+    // InRange marks the bytes of |v| within [first, first + count).
+    inline __m128i InRange(__m128i v, char first, char count)
+    {
+        __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(static_cast<char>(first + 0x80)));
+        return _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(0x80 + count)));
+    }
+
+    BASE_BASE64_TARGET("avx2")
+    inline __m256i InRange(__m256i v, char first, char count)
+    {
+        __m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(static_cast<char>(first + 0x80)));
+        return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(0x80 + count)), shifted);
+    }
+
+    BASE_BASE64_TARGET("ssse3")
+    size_t EncodeSsse3(const unsigned char* p, size_t len, char* out, const char* alphabet)
+    {
+        const __m128i shifts = EncodeShifts(alphabet);
+        const __m128i spread = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+        size_t i = 0;
+        // A block reads 16 bytes and encodes the first 12 of them.
+        for (; i + 16 <= len; i += 12, out += 16)
+        {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            in = _mm_shuffle_epi8(in, spread);
+            // Each 6 bits go to a byte of their own.
+            __m128i hi = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+            __m128i lo = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+            __m128i values = _mm_or_si128(hi, lo);
+            __m128i range = _mm_subs_epu8(values, _mm_set1_epi8(51));
+            range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), values), _mm_set1_epi8(13)));
+            __m128i chars = _mm_add_epi8(values, _mm_shuffle_epi8(shifts, range));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+        }
+        return i;
+    }
+
+    BASE_BASE64_TARGET("avx2")
+    size_t EncodeAvx2(const unsigned char* p, size_t len, char* out, const char* alphabet)
+    {
+        const __m128i shifts128 = EncodeShifts(alphabet);
+        const __m256i shifts = _mm256_inserti128_si256(_mm256_castsi128_si256(shifts128), shifts128, 1);
+        const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                                1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+        size_t i = 0;
+        // Each lane reads 16 bytes and encodes the first 12 of them.
+        for (; i + 28 <= len; i += 24, out += 32)
+        {
+            __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 12));
+            __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(first), second, 1);
+            in = _mm256_shuffle_epi8(in, spread);
+            __m256i hi = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+            __m256i lo = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+            __m256i values = _mm256_or_si256(hi, lo);
+            __m256i range = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+            range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), values), _mm256_set1_epi8(13)));
+            __m256i chars = _mm256_add_epi8(values, _mm256_shuffle_epi8(shifts, range));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), chars);
+        }
+        return i;
+    }
+
+    // The decoders map the chars to values by ranges and stop at the first block with
+    // a char out of the alphabet, the scalar code finds out whether it is the padding.
+    BASE_BASE64_TARGET("ssse3")
+    size_t DecodeSsse3(const unsigned char* p, size_t len, unsigned char* out, const char* alphabet)
+    {
+        const __m128i c62 = _mm_set1_epi8(alphabet[62]);
+        const __m128i c63 = _mm_set1_epi8(alphabet[63]);
+        const __m128i gather = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        size_t i = 0;
+        for (; i + 16 <= len; i += 16, out += 12)
+        {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            __m128i upper = InRange(in, 'A', 26);
+            __m128i lower = InRange(in, 'a', 26);
+            __m128i digit = InRange(in, '0', 10);
+            __m128i is62 = _mm_cmpeq_epi8(in, c62);
+            __m128i is63 = _mm_cmpeq_epi8(in, c63);
+            __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(is62, is63)));
+            if (_mm_movemask_epi8(valid) != 0xFFFF)
+                break;
+            __m128i shift = _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')), _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+                _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+                             _mm_or_si128(_mm_and_si128(is62, _mm_set1_epi8(static_cast<char>(62 - alphabet[62]))),
+                                          _mm_and_si128(is63, _mm_set1_epi8(static_cast<char>(63 - alphabet[63]))))));
+            __m128i values = _mm_add_epi8(in, shift);
+            // Four values of 6 bits are packed to 24 bits, and the 3 bytes are put in order.
+            __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+            __m128i packed = _mm_shuffle_epi8(_mm_madd_epi16(merged, _mm_set1_epi32(0x00011000)), gather);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out), packed);
+            uint32_t last = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(packed, 8)));
+            memcpy(out + 8, &last, 4);
+        }
+        return i;
+    }
+
+    BASE_BASE64_TARGET("avx2")
+    size_t DecodeAvx2(const unsigned char* p, size_t len, unsigned char* out, const char* alphabet)
+    {
+        const __m256i c62 = _mm256_set1_epi8(alphabet[62]);
+        const __m256i c63 = _mm256_set1_epi8(alphabet[63]);
+        const __m256i gather = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+        size_t i = 0;
+        for (; i + 32 <= len; i += 32, out += 24)
+        {
+            __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            __m256i upper = InRange(in, 'A', 26);
+            __m256i lower = InRange(in, 'a', 26);
+            __m256i digit = InRange(in, '0', 10);
+            __m256i is62 = _mm256_cmpeq_epi8(in, c62);
+            __m256i is63 = _mm256_cmpeq_epi8(in, c63);
+            __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, _mm256_or_si256(is62, is63)));
+            if (_mm256_movemask_epi8(valid) != -1)
+                break;
+            __m256i shift = _mm256_or_si256(
+                _mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')), _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+                _mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+                                _mm256_or_si256(_mm256_and_si256(is62, _mm256_set1_epi8(static_cast<char>(62 - alphabet[62]))),
+                                                _mm256_and_si256(is63, _mm256_set1_epi8(static_cast<char>(63 - alphabet[63]))))));
+            __m256i values = _mm256_add_epi8(in, shift);
+            __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+            __m256i packed = _mm256_shuffle_epi8(_mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000)), gather);
+            // The 12 bytes of each lane are moved together.
+            packed = _mm256_permutevar8x32_epi32(packed, compact);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(packed));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 16), _mm256_extracti128_si256(packed, 1));
+        }
+        return i;
+    }
+#endif
+
+    // EncodeBlocks encodes the groups of three bytes of |p| with the widest kernel and
+    // returns the number of bytes encoded.
+    size_t EncodeBlocks(const unsigned char* p, size_t len, char* out, const char* alphabet)
+    {
+        size_t i = 0;
+#if defined(BASE_BASE64_X86)
+        Kernel kernel = GetKernel();
+        if (kAvx2 == kernel)
+            i = EncodeAvx2(p, len, out, alphabet);
+        else if (kSsse3 == kernel)
+            i = EncodeSsse3(p, len, out, alphabet);
+#endif
+        return i + EncodeScalar(p + i, len - i, out + i / 3 * 4, alphabet);
+    }
+
+    // DecodeBlocks decodes the groups of four chars of |p| with the widest kernel until
+    // one of them has a char out of the alphabet, and returns the number of chars decoded.
+    size_t DecodeBlocks(const unsigned char* p, size_t len, unsigned char* out, int flags)
+    {
+        size_t i = 0;
+#if defined(BASE_BASE64_X86)
+        Kernel kernel = GetKernel();
+        if (kAvx2 == kernel)
+            i = DecodeAvx2(p, len, out, GetAlphabet(flags));
+        else if (kSsse3 == kernel)
+            i = DecodeSsse3(p, len, out, GetAlphabet(flags));
+#endif
+        return i + DecodeScalar(p + i, len - i, out + i / 4 * 3, GetDecodeTable(flags));
+    }
+
+    // EncodeRest encodes the last one or two bytes of the data and returns the number
+    // of chars written.
+    size_t EncodeRest(const unsigned char* p, size_t n, char* out, int flags)
+    {
+        const char* alphabet = GetAlphabet(flags);
+        uint32_t v = (p[0] << 16) | (n == 2 ? p[1] << 8 : 0);
+        out[0] = alphabet[v >> 18];
+        out[1] = alphabet[(v >> 12) & 0x3F];
+        if (n == 2)
+            out[2] = alphabet[(v >> 6) & 0x3F];
+        if (flags & kNoPadding)
+            return n + 1;
+        if (n == 1)
+            out[2] = '=';
+        out[3] = '=';
+        return 4;
+    }
+
+    // DecodeLast decodes the last group of the data, four chars which may end with
+    // padding, or two or three chars if the padding may be left out. It returns the
+    // number of bytes written or -1 if the group is not valid.
+    int DecodeLast(const unsigned char* p, size_t n, unsigned char* out, int flags)
+    {
+        if (n == 4 && '=' == p[3])
+            n = '=' == p[2] ? 2 : 3;
+        else if (n < 4 && !(flags & kNoPadding))
+            return -1;
+        if (n < 2)
+            return -1;
+
+        const DecodeTable& table = GetDecodeTable(flags);
+        uint32_t v = 0;
+        uint8_t bad = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint8_t value = table.Values[p[i]];
+            bad |= value;
+            v |= static_cast<uint32_t>(value & 0x3F) << (18 - 6 * i);
+        }
+        if (bad & 0x80)
+            return -1;
+        out[0] = static_cast<unsigned char>(v >> 16);
+        if (n > 2)
+            out[1] = static_cast<unsigned char>(v >> 8);
+        if (n > 3)
+            out[2] = static_cast<unsigned char>(v);
+        return static_cast<int>(n - 1);
+    }
 } // !namespace anonymous
 
-std::string Encode(const std::string & str)
+size_t EncodedLength(size_t len, int flags /*= kStandard*/)
 {
-    return Encode((const unsigned char*)str.c_str(), str.length());
+    if (flags & kNoPadding)
+        return len / 3 * 4 + (len % 3 ? len % 3 + 1 : 0);
+    return (len + 2) / 3 * 4;
 }
 
-std::string Encode(const unsigned char * str, size_t len)
+std::string Encode(const std::string & str, int flags /*= kStandard*/)
+{
+    return Encode((const unsigned char*)str.c_str(), str.length(), flags);
+}
+
+std::string Encode(const unsigned char * str, size_t len, int flags /*= kStandard*/)
 {
     std::string base64String;
-    if (nullptr == str)
+    if (nullptr == str || 0 == len)
         return base64String;
 
-    unsigned char b;
-    for (size_t i = 0; i < len; i += 3)
+    base64String.resize(EncodedLength(len, flags));
+    char* out = &base64String[0];
+    size_t i = EncodeBlocks(str, len, out, GetAlphabet(flags));
+    if (i < len)
+        EncodeRest(str + i, len - i, out + i / 3 * 4, flags);
+    return base64String;
+}
+
+std::string Decode(const std::string & str, int flags /*= kStandard*/)
+{
+    return Decode((const unsigned char*)str.c_str(), str.length(), flags);
+}
+
+std::string Decode(const unsigned char * str, size_t len, int flags /*= kStandard*/)
+{
+    std::string decodedString;
+    if (nullptr == str || 0 == len)
+        return decodedString;
+    if (!(flags & kNoPadding) && len % 4 != 0)
+        return decodedString;
+
+    decodedString.resize(len / 4 * 3 + 2);
+    auto out = reinterpret_cast<unsigned char*>(&decodedString[0]);
+    size_t i = DecodeBlocks(str, len, out, flags);
+    size_t size = i / 4 * 3;
+    if (i < len)
     {
-        b = (str[i] & 0xFC) >> 2;
-        base64String += kBase64Table[b];
-        b = (str[i] & 0x03) << 4;
-        if ((i + 1) < len)
-        {
-            b |= (str[i + 1] & 0xF0) >> 4;
-            base64String += kBase64Table[b];
-            b = (str[i + 1] & 0x0F) << 2;
-            if ((i + 2) < len)
-            {
-                b |= (str[i + 2] & 0xC0) >> 6;
-                base64String += kBase64Table[b];
-                b = str[i + 2] & 0x3F;
-                base64String += kBase64Table[b];
-            }
-            else
-            {
-                base64String += kBase64Table[b];
-                base64String += "=";
-            }
-        }
-        else
+        // Only the last group may have padding.
+        int n = len - i <= 4 ? DecodeLast(str + i, len - i, out + size, flags) : -1;
+        if (n < 0)
+            return "";
+        size += n;
+    }
+    decodedString.resize(size);
+    return decodedString;
+}
+
+Encoder::Encoder(int flags /*= kStandard*/)
+    : m_flags(flags)
+{
+}
+
+void Encoder::Update(const unsigned char* data, size_t len, std::string& out)
+{
+    if (m_pendingSize > 0)
+    {
+        while (m_pendingSize < 3 && len > 0)
         {
-            base64String += kBase64Table[b];
-            base64String += "==";
+            m_pending[m_pendingSize++] = *data++;
+            --len;
         }
+        if (m_pendingSize < 3)
+            return;
+        size_t pos = out.size();
+        out.resize(pos + 4);
+        EncodeScalar(m_pending, 3, &out[pos], GetAlphabet(m_flags));
+        m_pendingSize = 0;
     }
-    return base64String;
+
+    size_t groups = len / 3 * 3;
+    if (groups > 0)
+    {
+        size_t pos = out.size();
+        out.resize(pos + groups / 3 * 4);
+        EncodeBlocks(data, groups, &out[pos], GetAlphabet(m_flags));
+    }
+    m_pendingSize = len - groups;
+    memcpy(m_pending, data + groups, m_pendingSize);
 }
-std::string Decode(const std::string & str)
+
+void Encoder::Update(const std::string& data, std::string& out)
 {
-    return Decode((const unsigned char*)str.c_str(), str.length());
+    Update((const unsigned char*)data.c_str(), data.length(), out);
 }
-std::string Decode(const unsigned char * str, size_t len)
+
+void Encoder::Final(std::string& out)
 {
-    std::string decodedString;
+    if (m_pendingSize > 0)
+    {
+        size_t pos = out.size();
+        out.resize(pos + 4);
+        out.resize(pos + EncodeRest(m_pending, m_pendingSize, &out[pos], m_flags));
+    }
+    m_pendingSize = 0;
+}
 
-    if (nullptr == str || len % 4 != 0)
-        return decodedString;
+Decoder::Decoder(int flags /*= kStandard*/)
+    : m_flags(flags)
+{
+}
 
-    unsigned char b[4];
-    for (size_t i = 0; i < len; i += 4)
+bool Decoder::Update(const unsigned char* data, size_t len, std::string& out)
+{
+    if (m_failed)
+        return false;
+    if (m_pendingSize > 0)
     {
-        b[0] = (unsigned char)kBase64Table.find_first_of(str[i]);
-        b[1] = (unsigned char)kBase64Table.find_first_of(str[i + 1]);
-        b[2] = (unsigned char)kBase64Table.find_first_of(str[i + 2]);
-        b[3] = (unsigned char)kBase64Table.find_first_of(str[i + 3]);
+        while (m_pendingSize < 4 && len > 0)
+        {
+            m_pending[m_pendingSize++] = *data++;
+            --len;
+        }
+        if (m_pendingSize < 4)
+            return true;
+        m_pendingSize = 0;
+        if (!DecodeGroups(m_pending, 4, out))
+            return false;
+    }
 
-        if (0xFF == b[0] || 0xFF == b[1] || 0xFF == b[2] || 0xFF == b[3])
-            return "";
+    size_t groups = len / 4 * 4;
+    if (!DecodeGroups(data, groups, out))
+        return false;
+    // Nothing may follow the padding.
+    if (m_padded && len > groups)
+    {
+        m_failed = true;
+        return false;
+    }
+    m_pendingSize = len - groups;
+    memcpy(m_pending, data + groups, m_pendingSize);
+    return true;
+}
+
+bool Decoder::Update(const std::string& data, std::string& out)
+{
+    return Update((const unsigned char*)data.c_str(), data.length(), out);
+}
 
-        decodedString += (b[0] << 2) | (b[1] >> 4);
-        if (b[2] < 64)
+bool Decoder::Final(std::string& out)
+{
+    bool ok = !m_failed;
+    if (ok && m_pendingSize > 0)
+    {
+        size_t pos = out.size();
+        out.resize(pos + 3);
+        int n = DecodeLast(m_pending, m_pendingSize, reinterpret_cast<unsigned char*>(&out[pos]), m_flags);
+        ok = n >= 0;
+        out.resize(pos + (ok ? n : 0));
+    }
+    m_pendingSize = 0;
+    m_padded = false;
+    m_failed = false;
+    return ok;
+}
+
+// DecodeGroups decodes whole groups of four chars, the last of which may have padding.
+bool Decoder::DecodeGroups(const unsigned char* data, size_t len, std::string& out)
+{
+    if (0 == len)
+        return true;
+    if (m_padded)
+    {
+        m_failed = true;
+        return false;
+    }
+
+    size_t pos = out.size();
+    out.resize(pos + len / 4 * 3);
+    auto p = reinterpret_cast<unsigned char*>(&out[pos]);
+    size_t i = DecodeBlocks(data, len, p, m_flags);
+    if (i < len)
+    {
+        int n = len - i == 4 ? DecodeLast(data + i, 4, p + i / 4 * 3, m_flags) : -1;
+        if (n < 0)
         {
-            decodedString += (b[1] << 4) | (b[2] >> 2);
-            if (b[3] < 64)
-            {
-                decodedString += (b[2] << 6) | b[3];
-            }
+            out.resize(pos + i / 4 * 3);
+            m_failed = true;
+            return false;
         }
+        out.resize(pos + i / 4 * 3 + n);
+        m_padded = true;
     }
-    return decodedString;
+    return true;
 }
 
 } // !namespace base64
 } // !namespace base
-
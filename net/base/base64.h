@@ -24,10 +24,74 @@
 namespace base {
 namespace base64 {
 
-std::string Encode(const std::string& str);
-std::string Encode(const unsigned char* str, size_t len);
-std::string Decode(const std::string& str);
-std::string Decode(const unsigned char* str, size_t len);
+// Flags select the alphabet and the padding, they are combined with |.
+enum Flag
+{
+    kStandard = 0,
+    // The URL and filename safe alphabet (RFC 4648, 5), - and _ instead of + and /.
+    kUrlSafe = 1,
+    // No trailing '=' is written. When decoding, the padding may be left out.
+    kNoPadding = 2,
+};
+
+// EncodedLength returns the size of the encoded form of |len| bytes.
+size_t EncodedLength(size_t len, int flags = kStandard);
+
+std::string Encode(const std::string& str, int flags = kStandard);
+std::string Encode(const unsigned char* str, size_t len, int flags = kStandard);
+
+// Decode returns an empty string if the input is not valid, including padding
+// which is not at the end.
+std::string Decode(const std::string& str, int flags = kStandard);
+std::string Decode(const unsigned char* str, size_t len, int flags = kStandard);
+
+// Encoder encodes data which comes in pieces, e.g. a file sent in chunks.
+// The pieces together are encoded as Encode would encode them at once.
+class Encoder
+{
+public:
+    explicit Encoder(int flags = kStandard);
+
+    // Update appends the encoded form of |data| to |out|, the last one or two
+    // bytes are kept until more data comes.
+    void Update(const unsigned char* data, size_t len, std::string& out);
+    void Update(const std::string& data, std::string& out);
+
+    // Final appends the bytes kept and the padding, then the encoder can be used
+    // for another stream.
+    void Final(std::string& out);
+
+private:
+    int m_flags;
+    unsigned char m_pending[3];
+    size_t m_pendingSize = 0;
+};
+
+// Decoder decodes data which comes in pieces. Update and Final return false
+// once the data is not valid, and the decoder must be reset by Final.
+class Decoder
+{
+public:
+    explicit Decoder(int flags = kStandard);
+
+    // Update appends the decoded form of |data| to |out|, an incomplete group of
+    // four chars is kept until more data comes.
+    bool Update(const unsigned char* data, size_t len, std::string& out);
+    bool Update(const std::string& data, std::string& out);
+
+    // Final decodes the chars kept, which must be the end of the data, and
+    // resets the decoder.
+    bool Final(std::string& out);
+
+private:
+    bool DecodeGroups(const unsigned char* data, size_t len, std::string& out);
+
+    int m_flags;
+    unsigned char m_pending[4];
+    size_t m_pendingSize = 0;
+    bool m_padded = false;
+    bool m_failed = false;
+};
 
 } // !namespace base64
 } // !namespace base
\ No newline at end of file
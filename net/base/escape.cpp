@@ -16,9 +16,18 @@
 // WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
 // 
 
-#include <locale>
+#include <cstdint>
 #include <map>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define BASE_ESCAPE_SSE2
+#endif
+
 #include "net/base/escape.h"
 #include "net/base/strings/string_utils.h"
 
@@ -26,87 +35,284 @@ namespace base {
 
 namespace {
     
-    const std::string kHexString = "0123456789ABCDEF";
-    
+    const char kHexChars[] = "0123456789ABCDEF";
 
-} // !namespace
+    // CharBitmap marks the chars which are not escaped, one bit per char.
+    struct CharBitmap
+    {
+        uint32_t Words[8];
 
-std::string Escape(const std::string& str, const std::set<char>& excludedSet,
-                   bool bKeepEscaped /*= false*/, bool bUsePlus /*= false*/)
-{
-    std::string strResult;
-    strResult.reserve(str.length() * 3);
-    for (size_t i = 0; i < str.length(); ++i)
+        bool Contains(unsigned char c) const
+        {
+            return (Words[c >> 5] & (1u << (c & 31))) != 0;
+        }
+
+        void Add(unsigned char c)
+        {
+            Words[c >> 5] |= 1u << (c & 31);
+        }
+
+        void Remove(unsigned char c)
+        {
+            Words[c >> 5] &= ~(1u << (c & 31));
+        }
+    };
+
+    constexpr uint32_t MakeWord(const char* chars, int word)
     {
-        if (bUsePlus && ' ' == str[i])
-            strResult.push_back('+');
-        else if (bKeepEscaped && '%' == str[i]
-            && (i + 2) < str.length()
-            && base::strings::IsDigit(str[i + 1], true)
-            && base::strings::IsDigit(str[i + 2], true))
-            strResult.push_back('%');
-        else if (excludedSet.find(str[i]) != excludedSet.end()
-            || std::isalnum(str[i], std::locale()))
-            strResult.push_back(str[i]);
-        else
+        return *chars == '\0' ? 0 :
+            ((static_cast<unsigned char>(*chars) >> 5) == word ? 1u << (*chars & 31) : 0)
+            | MakeWord(chars + 1, word);
+    }
+
+    constexpr CharBitmap MakeBitmap(const char* chars)
+    {
+        return CharBitmap{ { MakeWord(chars, 0), MakeWord(chars, 1), MakeWord(chars, 2), MakeWord(chars, 3),
+                             MakeWord(chars, 4), MakeWord(chars, 5), MakeWord(chars, 6), MakeWord(chars, 7) } };
+    }
+
+#define BASE_ESCAPE_ALNUM "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+    constexpr char kAlnumChars[] = BASE_ESCAPE_ALNUM;
+    constexpr char kEscapeChars[] = BASE_ESCAPE_ALNUM "*+-./@";
+    constexpr char kUrlChars[] = BASE_ESCAPE_ALNUM "!#$&'()*+,-./:;=?@~";
+    constexpr char kUrlComponentChars[] = BASE_ESCAPE_ALNUM "!'()*-.~";
+    constexpr char kUrlEncodedDataChars[] = BASE_ESCAPE_ALNUM "()*,-./:@_~";
+#undef BASE_ESCAPE_ALNUM
+
+    constexpr CharBitmap kAlnum = MakeBitmap(kAlnumChars);
+    constexpr CharBitmap kEscapeSafe = MakeBitmap(kEscapeChars);
+    constexpr CharBitmap kUrlSafe = MakeBitmap(kUrlChars);
+    constexpr CharBitmap kUrlComponentSafe = MakeBitmap(kUrlComponentChars);
+    constexpr CharBitmap kUrlEncodedDataSafe = MakeBitmap(kUrlEncodedDataChars);
+
+    // kHexValues maps a hex digit to its value and other chars to -1.
+    const int8_t kHexValues[256] = {
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+         0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+        -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    };
+
+#if defined(BASE_ESCAPE_SSE2)
+    // InRange marks the bytes of |v| within [first, first + count), the range is moved
+    // to the bottom of the signed bytes for one comparison.
+    inline __m128i InRange(__m128i v, char first, char count)
+    {
+        __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(static_cast<char>(first + 0x80)));
+        return _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(0x80 + count)));
+    }
+#endif
+
+    // SafeRun returns the number of chars from |p| which are not escaped. Blocks of
+    // alphanumerics, the bulk of most text, are skipped 16 bytes at a time.
+    size_t SafeRun(const unsigned char* p, size_t n, const CharBitmap& safe)
+    {
+        size_t i = 0;
+#if defined(BASE_ESCAPE_SSE2)
+        for (; i + 16 <= n; i += 16)
         {
-            auto c = static_cast<unsigned char>(str[i]);
-            strResult.push_back('%');
-            strResult.push_back(kHexString[c >> 4]);
-            strResult.push_back(kHexString[c & 0x0f]);
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            __m128i digits = InRange(v, '0', 10);
+            __m128i letters = InRange(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 26);
+            if (_mm_movemask_epi8(_mm_or_si128(digits, letters)) != 0xFFFF)
+                break;
         }
+#endif
+        while (i < n && safe.Contains(p[i]))
+            ++i;
+        return i;
     }
-    return strResult;
+
+    int CountTrailingZeros(uint32_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, value);
+        return (int)index;
+#else
+        return __builtin_ctz(value);
+#endif
+    }
+
+    // FindSpecial returns the position of the first '%', or '+' if |bReplacePlus|
+    // is true, in |p|. It returns |n| if there is none.
+    size_t FindSpecial(const char* p, size_t n, bool bReplacePlus)
+    {
+        size_t i = 0;
+#if defined(BASE_ESCAPE_SSE2)
+        const __m128i percent = _mm_set1_epi8('%');
+        const __m128i plus = _mm_set1_epi8(bReplacePlus ? '+' : '%');
+        for (; i + 16 <= n; i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, percent), _mm_cmpeq_epi8(v, plus)));
+            if (mask != 0)
+                return i + CountTrailingZeros(static_cast<uint32_t>(mask));
+        }
+#endif
+        for (; i < n; ++i)
+        {
+            if ('%' == p[i] || (bReplacePlus && '+' == p[i]))
+                return i;
+        }
+        return n;
+    }
+
+    // UnescapeTo writes the unescaped form of |p| to |out| and returns its size.
+    // |out| may be |p|, since the output never gets ahead of the input.
+    size_t UnescapeTo(const char* p, size_t n, char* out, bool bReplacePlus)
+    {
+        size_t size = 0;
+        for (size_t i = 0; i < n; )
+        {
+            size_t run = FindSpecial(p + i, n - i, bReplacePlus);
+            if (out + size != p + i)
+                memmove(out + size, p + i, run);
+            size += run;
+            i += run;
+            if (i == n)
+                break;
+            if ('+' == p[i])
+            {
+                out[size++] = ' ';
+                ++i;
+                continue;
+            }
+            int hi = i + 2 < n ? kHexValues[static_cast<unsigned char>(p[i + 1])] : -1;
+            int lo = hi >= 0 ? kHexValues[static_cast<unsigned char>(p[i + 2])] : -1;
+            if (lo >= 0)
+            {
+                out[size++] = static_cast<char>((hi << 4) | lo);
+                i += 3;
+            }
+            else
+                out[size++] = p[i++];
+        }
+        return size;
+    }
+
+    bool IsEscaped(const unsigned char* p, size_t i, size_t n)
+    {
+        return i + 2 < n && base::strings::IsDigit(p[i + 1], true) && base::strings::IsDigit(p[i + 2], true);
+    }
+
+    // EscapeWith escapes the chars of |str| missing from |safe|. The size of the result
+    // is counted first so that it is allocated once, then the runs of safe chars are
+    // copied as they are.
+    std::string EscapeWith(const std::string& str, CharBitmap safe, bool bKeepEscaped, bool bUsePlus)
+    {
+        if (bUsePlus)
+            safe.Remove(' ');
+        auto p = reinterpret_cast<const unsigned char*>(str.data());
+        size_t n = str.size();
+
+        size_t first = SafeRun(p, n, safe);
+        if (first == n)
+            return str;
+        size_t size = n;
+        for (size_t i = first; i < n; i += SafeRun(p + i, n - i, safe))
+        {
+            if (!(bUsePlus && ' ' == p[i]) && !(bKeepEscaped && '%' == p[i] && IsEscaped(p, i, n)))
+                size += 2;
+            ++i;
+        }
+
+        std::string strResult(size, '\0');
+        auto out = &strResult[0];
+        for (size_t i = 0; i < n; )
+        {
+            size_t run = SafeRun(p + i, n - i, safe);
+            memcpy(out, p + i, run);
+            out += run;
+            i += run;
+            if (i == n)
+                break;
+            unsigned char c = p[i++];
+            if (bUsePlus && ' ' == c)
+                *out++ = '+';
+            else if (bKeepEscaped && '%' == c && IsEscaped(p, i - 1, n))
+                *out++ = '%';
+            else
+            {
+                *out++ = '%';
+                *out++ = kHexChars[c >> 4];
+                *out++ = kHexChars[c & 0x0f];
+            }
+        }
+        return strResult;
+    }
+
+} // !namespace
+
+std::string Escape(const std::string& str, const std::set<char>& excludedSet,
+                   bool bKeepEscaped /*= false*/, bool bUsePlus /*= false*/)
+{
+    CharBitmap safe = kAlnum;
+    for (auto c : excludedSet)
+        safe.Add(static_cast<unsigned char>(c));
+    return EscapeWith(str, safe, bKeepEscaped, bUsePlus);
 }
 
 std::string Escape(const std::string& str, bool bKeepEscaped /*= false*/)
 {
-    return Escape(str, { '*', '+', '-', '.', '/', '@' }, bKeepEscaped, false);
+    return EscapeWith(str, kEscapeSafe, bKeepEscaped, false);
 }
 
 std::string EscapeUrl(const std::string& strUrl, bool bUsePlus /*= false*/)
 {
-    return Escape(strUrl, { '!','#','$','&','\'','(',')','*','+',',',
-                            '-','.','/',':',';','=','?','@','~' },
-                  false, bUsePlus);
+    return EscapeWith(strUrl, kUrlSafe, false, bUsePlus);
 }
 
 std::string EscapeUrlComponent(const std::string& strUrl, bool bUsePlus /*= false*/)
 {
-    return Escape(strUrl, { '!','\'','(',')','*','-','.','~' }, false, bUsePlus);
+    return EscapeWith(strUrl, kUrlComponentSafe, false, bUsePlus);
 }
 
 std::string EscapeUrlEncodedData(const std::string& strData, bool bUsePlus /*= false*/)
 {
-    return Escape(strData, { '(',')','*',',','-','.','/',':','@','_','~' }, false, bUsePlus);
+    return EscapeWith(strData, kUrlEncodedDataSafe, false, bUsePlus);
 }
 
-std::string Unescape(const std::string& str, bool bReplacePlus /*= false*/)
+std::string Unescape(base::strings::StringPiece str, bool bReplacePlus /*= false*/)
 {
-    std::string strResult;
-    strResult.reserve(str.size());
-    for (size_t i = 0; i < str.length();)
-    {
-        if (bReplacePlus && '+' == str[i])
-            strResult.push_back(' ');
-        else if ('%' == str[i]
-                && i + 2 < str.length()
-                && base::strings::IsDigit(str[i + 1], true)
-                && base::strings::IsDigit(str[i + 2], true))
-        {
-            char c = (base::strings::HexDigitToInt(str[i + 1]) << 4)
-                        + base::strings::HexDigitToInt(str[i + 2]);
-            strResult.push_back(c);
-            i += 3;
-            continue;
-        }
-        else
-            strResult.push_back(str[i]);
-        ++i;
-    }
+    std::string strResult(str.data(), str.size());
+    UnescapeInPlace(strResult, bReplacePlus);
     return strResult;
 }
 
+void UnescapeInPlace(std::string& str, bool bReplacePlus /*= false*/)
+{
+    size_t first = FindSpecial(str.data(), str.size(), bReplacePlus);
+    if (first == str.size())
+        return;
+    auto p = &str[0] + first;
+    str.resize(first + UnescapeTo(p, str.size() - first, p, bReplacePlus));
+}
+
+base::strings::StringPiece UnescapeView(base::strings::StringPiece str, std::string& buffer,
+                                        bool bReplacePlus /*= false*/)
+{
+    size_t first = FindSpecial(str.data(), str.size(), bReplacePlus);
+    if (first == str.size())
+        return str;
+    buffer.resize(str.size());
+    memcpy(&buffer[0], str.data(), first);
+    buffer.resize(first + UnescapeTo(str.data() + first, str.size() - first, &buffer[0] + first, bReplacePlus));
+    return buffer;
+}
+
 std::string EscapeForHTML(const std::string& str)
 {
     typedef std::map<char, std::string> EscapeMap;
@@ -21,6 +21,8 @@
 #include <set>
 #include <string>
 
+#include "net/base/strings/string_piece.h"
+
 namespace base {
 
 // Escape |str| and |excludedSet| is a set of chars that will not be escaped.
@@ -52,7 +54,16 @@ std::string EscapeUrlEncodedData(const std::string& strData, bool bUsePlus = fal
 
 // Unescape |str| and if |bReplacePlus| is true, the + will be replaced with space.
 // Substrings in |str| like %XX will be escaped and X is a hex digit.
-std::string Unescape(const std::string& str, bool bReplacePlus = false);
+std::string Unescape(base::strings::StringPiece str, bool bReplacePlus = false);
+
+// UnescapeInPlace unescapes |str| like Unescape, overwriting it. The unescaped
+// form is never longer, so nothing is allocated.
+void UnescapeInPlace(std::string& str, bool bReplacePlus = false);
+
+// UnescapeView returns |str| itself if it has nothing to unescape. Otherwise the
+// unescaped form is written to |buffer| and the returned piece refers to it.
+base::strings::StringPiece UnescapeView(base::strings::StringPiece str, std::string& buffer,
+                                        bool bReplacePlus = false);
 
 // Escape HTML tags(<, >, &, ", ').
 std::string EscapeForHTML(const std::string& str);
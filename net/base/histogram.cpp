@@ -0,0 +1,207 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/base/histogram.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace base {
+
+namespace {
+
+int CountLeadingZeros(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return 63 - (int)index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanReverse(&index, (unsigned long)(value >> 32)))
+        return 31 - (int)index;
+    _BitScanReverse(&index, (unsigned long)value);
+    return 63 - (int)index;
+#else
+    return __builtin_clzll(value);
+#endif
+}
+
+// Increase adds to a counter only its owner thread writes, without a locked instruction.
+void Increase(std::atomic<uint64_t>& counter, uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+} // !namespace anonymous
+
+Histogram::Histogram(uint64_t highest /*= 3600ULL * 1000 * 1000*/, int significantDigits /*= 3*/)
+    : m_highest(highest < 2 ? 2 : highest)
+    , m_count(0)
+    , m_sum(0)
+    , m_min(UINT64_MAX)
+    , m_max(0)
+{
+    if (significantDigits < 1)
+        significantDigits = 1;
+    if (significantDigits > 5)
+        significantDigits = 5;
+
+    // The values below 2 * 10^digits are counted one by one, the buckets above double
+    // the width of their slots and keep the same number of them.
+    uint64_t singleUnitResolution = 2;
+    for (int i = 0; i < significantDigits; ++i)
+        singleUnitResolution *= 10;
+    int subBucketCountMagnitude = 64 - CountLeadingZeros(singleUnitResolution - 1);
+    m_subBucketHalfCountMagnitude = subBucketCountMagnitude - 1;
+    m_subBucketHalfCount = (size_t)1 << m_subBucketHalfCountMagnitude;
+    m_subBucketMask = ((uint64_t)1 << subBucketCountMagnitude) - 1;
+
+    size_t buckets = 1;
+    for (uint64_t untrackable = m_subBucketMask + 1; untrackable <= m_highest; untrackable <<= 1)
+    {
+        ++buckets;
+        if (untrackable > UINT64_MAX / 2)
+            break;
+    }
+    m_size = (buckets + 1) * m_subBucketHalfCount;
+    m_counts.reset(new std::atomic<uint64_t>[m_size]());
+}
+
+void Histogram::Record(uint64_t value, uint64_t count /*= 1*/)
+{
+    if (value > m_highest)
+        value = m_highest;
+    Increase(m_counts[Index(value)], count);
+    Increase(m_count, count);
+    Increase(m_sum, value * count);
+    if (value < m_min.load(std::memory_order_relaxed))
+        m_min.store(value, std::memory_order_relaxed);
+    if (value > m_max.load(std::memory_order_relaxed))
+        m_max.store(value, std::memory_order_relaxed);
+}
+
+void Histogram::Add(const Histogram& other)
+{
+    for (size_t i = 0; i < other.m_size; ++i)
+    {
+        uint64_t count = other.m_counts[i].load(std::memory_order_relaxed);
+        if (count == 0)
+            continue;
+        uint64_t width;
+        uint64_t value = other.ValueAt(i, width);
+        if (other.m_subBucketMask == m_subBucketMask && value <= m_highest)
+            Increase(m_counts[i], count);
+        else
+            Increase(m_counts[Index(value > m_highest ? m_highest : value)], count);
+        Increase(m_count, count);
+    }
+    Increase(m_sum, other.m_sum.load(std::memory_order_relaxed));
+    uint64_t min = other.GetMin();
+    uint64_t max = other.GetMax();
+    if (other.GetCount() > 0 && min < m_min.load(std::memory_order_relaxed))
+        m_min.store(min, std::memory_order_relaxed);
+    if (max > m_max.load(std::memory_order_relaxed))
+        m_max.store(max > m_highest ? m_highest : max, std::memory_order_relaxed);
+}
+
+void Histogram::Reset()
+{
+    for (size_t i = 0; i < m_size; ++i)
+        m_counts[i].store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(UINT64_MAX, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::GetHighest() const
+{
+    return m_highest;
+}
+
+uint64_t Histogram::GetCount() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::GetMin() const
+{
+    return GetCount() > 0 ? m_min.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t Histogram::GetMax() const
+{
+    return m_max.load(std::memory_order_relaxed);
+}
+
+double Histogram::GetMean() const
+{
+    uint64_t count = GetCount();
+    return count > 0 ? (double)m_sum.load(std::memory_order_relaxed) / count : 0;
+}
+
+uint64_t Histogram::Percentile(double percentile) const
+{
+    uint64_t count = GetCount();
+    if (count == 0)
+        return 0;
+    if (percentile > 100)
+        percentile = 100;
+    uint64_t target = (uint64_t)(percentile / 100 * count + 0.5);
+    if (target < 1)
+        target = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < m_size; ++i)
+    {
+        seen += m_counts[i].load(std::memory_order_relaxed);
+        if (seen >= target)
+        {
+            uint64_t width;
+            uint64_t highest = ValueAt(i, width) + width - 1;
+            uint64_t max = GetMax();
+            return highest < max ? highest : max;
+        }
+    }
+    return GetMax();
+}
+
+size_t Histogram::Index(uint64_t value) const
+{
+    int pow2Ceiling = 64 - CountLeadingZeros(value | m_subBucketMask);
+    int bucket = pow2Ceiling - (m_subBucketHalfCountMagnitude + 1);
+    size_t subBucket = (size_t)(value >> bucket);
+    return ((size_t)(bucket + 1) << m_subBucketHalfCountMagnitude) + subBucket - m_subBucketHalfCount;
+}
+
+uint64_t Histogram::ValueAt(size_t index, uint64_t& width) const
+{
+    int bucket = (int)(index >> m_subBucketHalfCountMagnitude) - 1;
+    size_t subBucket = (index & (m_subBucketHalfCount - 1)) + m_subBucketHalfCount;
+    if (bucket < 0)
+    {
+        subBucket -= m_subBucketHalfCount;
+        bucket = 0;
+    }
+    width = (uint64_t)1 << bucket;
+    return (uint64_t)subBucket << bucket;
+}
+
+} // !namespace base
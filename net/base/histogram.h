@@ -0,0 +1,76 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace base {
+
+// Histogram counts values in log-linear buckets like HdrHistogram: the values up to
+// |highest| keep |significantDigits| decimal digits of precision, in a fixed amount of
+// memory set at construction. One thread records, Record is a few instructions and
+// never allocates. Other threads may read the histogram or Add it to theirs at the same
+// time, e.g. to merge per-thread histograms on read.
+class Histogram
+{
+public:
+    explicit Histogram(uint64_t highest = 3600ULL * 1000 * 1000, int significantDigits = 3);
+    ~Histogram() {}
+
+    // Record counts |value| |count| times, the values above the highest trackable
+    // value are counted as that value.
+    void Record(uint64_t value, uint64_t count = 1);
+
+    // Add records the values of |other|, the histograms may have different layouts.
+    void Add(const Histogram& other);
+
+    void Reset();
+
+    uint64_t GetHighest() const;
+    uint64_t GetCount() const;
+    uint64_t GetMin() const;
+    uint64_t GetMax() const;
+    double GetMean() const;
+
+    // Percentile returns the value at or below which |percentile| percent of the values
+    // fall, e.g. 99.9, as the highest value its bucket stands for. It returns 0 if the
+    // histogram is empty.
+    uint64_t Percentile(double percentile) const;
+
+private:
+    size_t Index(uint64_t value) const;
+    // ValueAt returns the lowest value of the bucket |index|, and its width in |width|.
+    uint64_t ValueAt(size_t index, uint64_t& width) const;
+
+private:
+    uint64_t m_highest;
+    int m_subBucketHalfCountMagnitude;
+    size_t m_subBucketHalfCount;
+    uint64_t m_subBucketMask;
+    size_t m_size;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_counts;
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_min;
+    std::atomic<uint64_t> m_max;
+};
+
+} // !namespace base
@@ -0,0 +1,133 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+namespace base {
+
+// LeasePool lends objects to one user at a time without a lock, e.g. the shards of
+// counters several threads write: a user leases an object with a single exchange,
+// writes it without locked instructions and gives it back. The objects are made on
+// demand, as many as have been leased at the same time, at most N. They live as long
+// as the pool, ForEach visits them for the readers.
+template <typename T, size_t N = 64>
+class LeasePool
+{
+    struct Entry
+    {
+        Entry() : Busy(false) {}
+
+        std::atomic<bool> Busy;
+        T Item;
+    };
+
+public:
+    // Lease gives its object back when it is destroyed.
+    class Lease
+    {
+    public:
+        explicit Lease(Entry* entry) : m_entry(entry) {}
+        Lease(Lease&& other) : m_entry(other.m_entry) { other.m_entry = nullptr; }
+        ~Lease()
+        {
+            if (m_entry)
+                m_entry->Busy.store(false, std::memory_order_release);
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator = (const Lease&) = delete;
+
+        T& operator * () const { return m_entry->Item; }
+        T* operator -> () const { return &m_entry->Item; }
+
+    private:
+        Entry* m_entry;
+    };
+
+    LeasePool()
+    {
+        for (auto& slot : m_slots)
+            slot.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~LeasePool()
+    {
+        for (auto& slot : m_slots)
+            delete slot.load(std::memory_order_relaxed);
+    }
+
+    LeasePool(const LeasePool&) = delete;
+    LeasePool& operator = (const LeasePool&) = delete;
+
+    // Acquire leases an object, it waits if all the N objects are leased.
+    Lease Acquire()
+    {
+        // The object the thread has leased last is tried first, a new one is only made
+        // when all the ones before it are leased.
+        static thread_local size_t hint = 0;
+        while (true)
+        {
+            size_t start = hint;
+            for (size_t i = 0; i < N; ++i)
+            {
+                size_t index = (start + i) % N;
+                auto entry = m_slots[index].load(std::memory_order_acquire);
+                if (!entry)
+                {
+                    auto created = new Entry();
+                    created->Busy.store(true, std::memory_order_relaxed);
+                    if (m_slots[index].compare_exchange_strong(entry, created, std::memory_order_acq_rel))
+                    {
+                        hint = index;
+                        return Lease(created);
+                    }
+                    // Another user has made it first, |entry| is that one.
+                    delete created;
+                }
+                if (!entry->Busy.load(std::memory_order_relaxed) &&
+                    !entry->Busy.exchange(true, std::memory_order_acquire))
+                {
+                    hint = index;
+                    return Lease(entry);
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // ForEach calls |function| with each object made so far, leased or not.
+    template <typename Function>
+    void ForEach(Function function) const
+    {
+        for (auto& slot : m_slots)
+        {
+            auto entry = slot.load(std::memory_order_acquire);
+            if (entry)
+                function(entry->Item);
+        }
+    }
+
+private:
+    std::atomic<Entry*> m_slots[N];
+};
+
+} // !namespace base
@@ -0,0 +1,123 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/base/sha1.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace base {
+namespace sha1 {
+
+namespace {
+
+inline uint32_t RotateLeft(uint32_t value, int bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+void ProcessBlock(uint32_t state[5], const unsigned char* block)
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i)
+    {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+            ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; ++i)
+        w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; ++i)
+    {
+        uint32_t f, k;
+        if (i < 20)
+        {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        }
+        else if (i < 40)
+        {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        }
+        else if (i < 60)
+        {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        }
+        else
+        {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t temp = RotateLeft(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = RotateLeft(b, 30);
+        b = a;
+        a = temp;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+} // !namespace anonymous
+
+std::string Sum(const std::string & str)
+{
+    return Sum((const unsigned char*)str.data(), str.length());
+}
+
+std::string Sum(const unsigned char * str, size_t len)
+{
+    uint32_t state[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    uint64_t bitLength = (uint64_t)len * 8;
+
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64)
+        ProcessBlock(state, str + i);
+
+    // The last blocks hold the rest, a 1 bit, zeros and the length in bits.
+    unsigned char block[128] = { 0 };
+    size_t rest = len - i;
+    if (rest > 0)
+        memcpy(block, str + i, rest);
+    block[rest] = 0x80;
+    size_t blocks = rest + 1 + 8 > 64 ? 2 : 1;
+    for (int j = 0; j < 8; ++j)
+        block[blocks * 64 - 1 - j] = (unsigned char)(bitLength >> (j * 8));
+    for (size_t j = 0; j < blocks; ++j)
+        ProcessBlock(state, block + j * 64);
+
+    std::string digest(kDigestLength, '\0');
+    for (int j = 0; j < 5; ++j)
+    {
+        digest[j * 4] = (char)(state[j] >> 24);
+        digest[j * 4 + 1] = (char)(state[j] >> 16);
+        digest[j * 4 + 2] = (char)(state[j] >> 8);
+        digest[j * 4 + 3] = (char)state[j];
+    }
+    return digest;
+}
+
+} // !namespace sha1
+} // !namespace base
@@ -0,0 +1,114 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2015 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <cstring>
+#include <string>
+
+namespace base {
+namespace strings {
+
+// StringPiece refers to characters it doesn't own, like std::string_view of C++17.
+// The characters must outlive the piece, e.g. a piece of a request header is valid
+// until the header is changed.
+class StringPiece
+{
+public:
+    typedef const char* const_iterator;
+    static const size_t npos = static_cast<size_t>(-1);
+
+    StringPiece() {}
+    StringPiece(const char* str) : m_data(str), m_size(str ? strlen(str) : 0) {}
+    StringPiece(const char* data, size_t size) : m_data(data), m_size(size) {}
+    StringPiece(const std::string& str) : m_data(str.data()), m_size(str.size()) {}
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    size_t length() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+    char operator[](size_t i) const { return m_data[i]; }
+    char front() const { return m_data[0]; }
+    char back() const { return m_data[m_size - 1]; }
+
+    void remove_prefix(size_t n) { m_data += n; m_size -= n; }
+    void remove_suffix(size_t n) { m_size -= n; }
+
+    // substr never copies, |pos| is clamped to the size like |count|.
+    StringPiece substr(size_t pos, size_t count = npos) const
+    {
+        if (pos > m_size)
+            pos = m_size;
+        if (count > m_size - pos)
+            count = m_size - pos;
+        return StringPiece(m_data + pos, count);
+    }
+
+    size_t find(char c, size_t pos = 0) const
+    {
+        if (pos >= m_size)
+            return npos;
+        auto p = static_cast<const char*>(memchr(m_data + pos, c, m_size - pos));
+        return p ? p - m_data : npos;
+    }
+
+    size_t find(StringPiece s, size_t pos = 0) const
+    {
+        if (pos > m_size || s.m_size > m_size - pos)
+            return npos;
+        if (s.empty())
+            return pos;
+        for (size_t last = m_size - s.m_size; pos <= last; ++pos)
+        {
+            pos = find(s[0], pos);
+            if (pos == npos || pos > last)
+                return npos;
+            if (memcmp(m_data + pos, s.m_data, s.m_size) == 0)
+                return pos;
+        }
+        return npos;
+    }
+
+    int compare(StringPiece s) const
+    {
+        size_t n = m_size < s.m_size ? m_size : s.m_size;
+        int r = n > 0 ? memcmp(m_data, s.m_data, n) : 0;
+        if (r != 0)
+            return r;
+        return m_size < s.m_size ? -1 : (m_size > s.m_size ? 1 : 0);
+    }
+
+    std::string ToString() const { return std::string(m_data, m_size); }
+
+private:
+    const char* m_data = "";
+    size_t m_size = 0;
+};
+
+inline bool operator==(StringPiece a, StringPiece b)
+{
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size()) == 0);
+}
+
+inline bool operator!=(StringPiece a, StringPiece b) { return !(a == b); }
+inline bool operator<(StringPiece a, StringPiece b) { return a.compare(b) < 0; }
+
+} // !namespace strings
+} // !namespace base
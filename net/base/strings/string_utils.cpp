@@ -17,310 +17,481 @@
 // 
 
 #include <cassert>
-#include <functional>
-#include <locale>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define BASE_STRINGS_SSE2
+#endif
 
 #include "net/base/strings/string_utils.h"
 
 namespace base {
 namespace strings {
 
-bool Equal(const std::string& str1, const std::string& str2, bool bIgnoreCase /*= false*/)
+namespace {
+
+// The ASCII case conversions, the other bytes are kept.
+const unsigned char kToLowerTable[256] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+    0x40, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+    0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F,
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0x8E, 0x8F,
+    0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x9F,
+    0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF,
+    0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF,
+    0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF,
+    0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF,
+    0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xEB, 0xEC, 0xED, 0xEE, 0xEF,
+    0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF,
+};
+
+const unsigned char kToUpperTable[256] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+    0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+    0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+    0x60, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+    0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F,
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0x8E, 0x8F,
+    0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x9F,
+    0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF,
+    0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF,
+    0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF,
+    0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF,
+    0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xEB, 0xEC, 0xED, 0xEE, 0xEF,
+    0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF,
+};
+
+#if defined(BASE_STRINGS_SSE2)
+// ShiftCase adds |delta| to the bytes of |v| within [first, first + 26). The range is moved
+// to the bottom of the signed bytes, so that one comparison finds it.
+inline __m128i ShiftCase(__m128i v, char first, char delta)
+{
+    __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(static_cast<char>(first + 0x80)));
+    __m128i inRange = _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(0x80 + 26)));
+    return _mm_add_epi8(v, _mm_and_si128(inRange, _mm_set1_epi8(delta)));
+}
+
+inline __m128i ToLower16(__m128i v)
+{
+    return ShiftCase(v, 'A', 'a' - 'A');
+}
+#endif
+
+void ConvertCase(char* p, size_t n, const unsigned char* table, char first, char delta)
 {
-    if (str1.length() != str2.length())
-        return false;
-    auto fnEqual = bIgnoreCase ? std::function<bool(char, char)>(
-                                    [](char c1, char c2) -> bool {
-                                        return std::tolower(c1, std::locale()) == std::tolower(c2, std::locale());
-                                    })
-                               : std::function<bool(char, char)>(
-                                    [](char c1, char c2) -> bool { return c1 == c2; });
-    for (size_t i = 0; i < str1.length(); ++i)
+    size_t i = 0;
+#if defined(BASE_STRINGS_SSE2)
+    for (; i + 16 <= n; i += 16)
     {
-        if (!fnEqual(str1[i], str2[i]))
+        auto q = reinterpret_cast<__m128i*>(p + i);
+        _mm_storeu_si128(q, ShiftCase(_mm_loadu_si128(q), first, delta));
+    }
+#else
+    (void)first;
+    (void)delta;
+#endif
+    for (; i < n; ++i)
+        p[i] = static_cast<char>(table[static_cast<unsigned char>(p[i])]);
+}
+
+bool EqualIgnoreCase(const char* p1, const char* p2, size_t n)
+{
+    size_t i = 0;
+#if defined(BASE_STRINGS_SSE2)
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v1 = ToLower16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + i)));
+        __m128i v2 = ToLower16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p2 + i)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2)) != 0xFFFF)
+            return false;
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        if (kToLowerTable[static_cast<unsigned char>(p1[i])] != kToLowerTable[static_cast<unsigned char>(p2[i])])
             return false;
     }
     return true;
 }
 
-template<typename InputIterator1, typename InputIterator2>
-static bool StartsWithOrEndsWith(InputIterator1 First1, InputIterator1 Last1,
-                                    InputIterator2 First2, InputIterator2 Last2, bool IgnoreCase)
+bool EqualBytes(const char* p1, const char* p2, size_t n, bool bIgnoreCase)
+{
+    return bIgnoreCase ? EqualIgnoreCase(p1, p2, n) : (n == 0 || memcmp(p1, p2, n) == 0);
+}
+
+// CharSet looks up the chars to trim in a bitmap rather than searching them for each char.
+class CharSet
 {
-    if (First2 == Last2)
+public:
+    explicit CharSet(StringPiece chars)
+    {
+        for (char c : chars)
+        {
+            auto b = static_cast<unsigned char>(c);
+            m_bits[b >> 5] |= 1u << (b & 31);
+        }
+    }
+
+    bool operator()(char c) const
+    {
+        auto b = static_cast<unsigned char>(c);
+        return (m_bits[b >> 5] & (1u << (b & 31))) != 0;
+    }
+
+private:
+    uint32_t m_bits[8] = {};
+};
+
+bool IsTrimSpace(char c)
+{
+    switch (static_cast<unsigned char>(c))
+    {
+    case '\t': case '\n': case '\v': case '\f': case '\r': case ' ': case 0x85: case 0xA0:
         return true;
-    if (std::distance(First1, Last1) < std::distance(First2, Last2))
+    default:
         return false;
-    auto fnEqual = IgnoreCase ? std::function<bool(InputIterator1, InputIterator1)>(
-                                    [](InputIterator1 c1, InputIterator1 c2) -> bool {
-                                        return std::tolower(*c1, std::locale()) == std::tolower(*c2, std::locale()); })
-                              : std::function<bool(InputIterator1, InputIterator1)>(
-                                    [](InputIterator1 c1, InputIterator1 c2) -> bool { return *c1 == *c2; });
-    for (; First1 != Last1 && First2 != Last2; ++First1, ++First2)
-    {
-        if (!fnEqual(First1, First2))
-            return false;
     }
-    return true;
 }
 
-bool StartsWith(const std::string& strData, const std::string& strSearch, bool bIgnoreCase /* = false */)
+template<typename Predicate>
+StringPiece TrimLeftIf(StringPiece str, Predicate predicate)
+{
+    size_t i = 0;
+    while (i < str.size() && predicate(str[i]))
+        ++i;
+    str.remove_prefix(i);
+    return str;
+}
+
+template<typename Predicate>
+StringPiece TrimRightIf(StringPiece str, Predicate predicate)
+{
+    size_t n = str.size();
+    while (n > 0 && predicate(str[n - 1]))
+        --n;
+    str.remove_suffix(str.size() - n);
+    return str;
+}
+
+// Assign makes |str| the |trimmed| piece of itself, moving the chars once.
+void Assign(std::string& str, StringPiece trimmed)
+{
+    size_t offset = trimmed.data() - str.data();
+    str.resize(offset + trimmed.size());
+    str.erase(0, offset);
+}
+
+} // !namespace anonymous
+
+bool Equal(StringPiece str1, StringPiece str2, bool bIgnoreCase /*= false*/)
+{
+    return str1.size() == str2.size() && EqualBytes(str1.data(), str2.data(), str1.size(), bIgnoreCase);
+}
+
+bool StartsWith(StringPiece strData, StringPiece strSearch, bool bIgnoreCase /* = false */)
 {
-    return StartsWithOrEndsWith(strData.cbegin(), strData.cend(), strSearch.cbegin(), strSearch.cend(), bIgnoreCase);
+    return strData.size() >= strSearch.size()
+        && EqualBytes(strData.data(), strSearch.data(), strSearch.size(), bIgnoreCase);
 }
 
-bool EndsWith(const std::string& strData, const std::string& strSearch, bool bIgnoreCase /* = false */)
+bool EndsWith(StringPiece strData, StringPiece strSearch, bool bIgnoreCase /* = false */)
 {
-    return StartsWithOrEndsWith(strData.crbegin(), strData.crend(), strSearch.crbegin(), strSearch.crend(), bIgnoreCase);
+    return strData.size() >= strSearch.size()
+        && EqualBytes(strData.data() + strData.size() - strSearch.size(), strSearch.data(),
+                      strSearch.size(), bIgnoreCase);
 }
 
-std::string ToLower(const std::string& str)
+char ToLower(char c)
 {
-    std::string strLower(str);
+    return static_cast<char>(kToLowerTable[static_cast<unsigned char>(c)]);
+}
+
+char ToUpper(char c)
+{
+    return static_cast<char>(kToUpperTable[static_cast<unsigned char>(c)]);
+}
+
+std::string ToLower(StringPiece str)
+{
+    std::string strLower(str.data(), str.size());
     ToLowerSelf(strLower);
     return strLower;
 }
 
-std::string ToUpper(const std::string& str)
+std::string ToUpper(StringPiece str)
 {
-    std::string strUpper(str);
+    std::string strUpper(str.data(), str.size());
     ToUpperSelf(strUpper);
     return strUpper;
 }
 
 void ToLowerSelf(std::string& str)
 {
-    for (size_t i = 0; i < str.length(); ++i)
-    {
-        str[i] = std::tolower(str[i], std::locale());
-    }
+    if (!str.empty())
+        ConvertCase(&str[0], str.size(), kToLowerTable, 'A', 'a' - 'A');
 }
 
 void ToUpperSelf(std::string& str)
 {
-    for (size_t i = 0; i < str.length(); ++i)
+    if (!str.empty())
+        ConvertCase(&str[0], str.size(), kToUpperTable, 'a', 'A' - 'a');
+}
+
+size_t HashIgnoreCase(StringPiece str)
+{
+    // FNV-1a over the lowercase bytes.
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : str)
     {
-        str[i] = std::toupper(str[i], std::locale());
+        hash ^= kToLowerTable[static_cast<unsigned char>(c)];
+        hash *= 1099511628211ULL;
     }
+    return static_cast<size_t>(hash);
 }
 
 void TrimLeftSelf(std::string& str, const std::string& strTrimChars)
 {
-    if (strTrimChars.empty())
-        return;
-    while (!str.empty())
-    {
-        if (std::string::npos != strTrimChars.find_first_of(str.front()))
-            str.erase(str.begin());
-        else
-            return;
-    }
+    Assign(str, TrimLeft(StringPiece(str), StringPiece(strTrimChars)));
 }
 
 void TrimRightSelf(std::string& str, const std::string& strTrimChars)
 {
-    if (strTrimChars.empty())
-        return;
-    while (!str.empty())
-    {
-        if (std::string::npos != strTrimChars.find_first_of(str.back()))
-            str.pop_back();
-        else
-            return;
-    }
+    Assign(str, TrimRight(StringPiece(str), StringPiece(strTrimChars)));
 }
 
 void TrimSelf(std::string& str, const std::string& strTrimChars)
 {
-    TrimLeftSelf(str, strTrimChars);
-    TrimRightSelf(str, strTrimChars);
+    Assign(str, Trim(StringPiece(str), StringPiece(strTrimChars)));
 }
 
 std::string TrimLeft(const std::string& str, const std::string& strTrimChars)
 {
-    std::string strTrimmed(str);
-    TrimLeftSelf(strTrimmed, strTrimChars);
-    return strTrimmed;
+    return TrimLeft(StringPiece(str), StringPiece(strTrimChars)).ToString();
 }
 
 std::string TrimRight(const std::string& str, const std::string& strTrimChars)
 {
-    std::string strTrimmed(str);
-    TrimRightSelf(strTrimmed, strTrimChars);
-    return strTrimmed;
+    return TrimRight(StringPiece(str), StringPiece(strTrimChars)).ToString();
 }
 
 std::string Trim(const std::string& str, const std::string& strTrimChars)
 {
-    std::string strTrimmed(str);
-    TrimLeftSelf(strTrimmed, strTrimChars);
-    TrimRightSelf(strTrimmed, strTrimChars);
-    return strTrimmed;
+    return Trim(StringPiece(str), StringPiece(strTrimChars)).ToString();
+}
+
+StringPiece TrimLeft(StringPiece str, StringPiece strTrimChars)
+{
+    return TrimLeftIf(str, CharSet(strTrimChars));
+}
+
+StringPiece TrimRight(StringPiece str, StringPiece strTrimChars)
+{
+    return TrimRightIf(str, CharSet(strTrimChars));
+}
+
+StringPiece Trim(StringPiece str, StringPiece strTrimChars)
+{
+    CharSet set(strTrimChars);
+    return TrimRightIf(TrimLeftIf(str, set), set);
 }
 
 void TrimLeftSpaceSelf(std::string& str)
 {
-#ifdef _WIN32
-#pragma warning(push)
-#pragma warning(disable: 4309)
-#endif
-    std::string strTrimChars = "\t\n\v\f\r ";
-    strTrimChars.append({ static_cast<char>(0x85), static_cast<char>(0xA0) });
-    TrimLeftSelf(str, strTrimChars);
-#ifdef _WIN32
-#pragma warning(pop)
-#endif
+    Assign(str, TrimLeftSpace(StringPiece(str)));
 }
 
 void TrimRightSpaceSelf(std::string& str)
 {
-#ifdef _WIN32
-#pragma warning(push)
-#pragma warning(disable: 4309)
-#endif
-    std::string strTrimChars = "\t\n\v\f\r ";
-    strTrimChars.append({ static_cast<char>(0x85), static_cast<char>(0xA0) });
-    TrimRightSelf(str, strTrimChars);
-#ifdef _WIN32
-#pragma warning(pop)
-#endif
+    Assign(str, TrimRightSpace(StringPiece(str)));
 }
 
 void TrimSpaceSelf(std::string& str)
 {
-    TrimLeftSpaceSelf(str);
-    TrimRightSpaceSelf(str);
+    Assign(str, TrimSpace(StringPiece(str)));
 }
 
 std::string TrimLeftSpace(const std::string& str)
 {
-    std::string strTrimmed(str);
-    TrimLeftSpaceSelf(strTrimmed);
-    return strTrimmed;
+    return TrimLeftSpace(StringPiece(str)).ToString();
 }
 
 std::string TrimRightSpace(const std::string& str)
 {
-    std::string strTrimmed(str);
-    TrimRightSpaceSelf(strTrimmed);
-    return strTrimmed;
+    return TrimRightSpace(StringPiece(str)).ToString();
 }
 
 std::string TrimSpace(const std::string& str)
 {
-    std::string strTrimmed(str);
-    TrimLeftSpaceSelf(strTrimmed);
-    TrimRightSpaceSelf(strTrimmed);
-    return strTrimmed;
+    return TrimSpace(StringPiece(str)).ToString();
+}
+
+StringPiece TrimLeftSpace(StringPiece str)
+{
+    return TrimLeftIf(str, IsTrimSpace);
+}
+
+StringPiece TrimRightSpace(StringPiece str)
+{
+    return TrimRightIf(str, IsTrimSpace);
+}
+
+StringPiece TrimSpace(StringPiece str)
+{
+    return TrimRightIf(TrimLeftIf(str, IsTrimSpace), IsTrimSpace);
 }
 
 void TrimPrefixSelf(std::string& str, const std::string& strPrefix,
                     bool bIgnoreCase /*= false*/, bool bRecursive /*= false*/)
 {
-    if (str.empty() || strPrefix.empty())
-        return;
-    do 
-    {
-        if (!StartsWith(str, strPrefix, bIgnoreCase))
-            break;
-        str.erase(0, strPrefix.length());
-    } while (bRecursive);
+    Assign(str, TrimPrefix(StringPiece(str), StringPiece(strPrefix), bIgnoreCase, bRecursive));
 }
 
 void TrimSuffixSelf(std::string& str, const std::string& strSuffix,
                     bool bIgnoreCase /*= false*/, bool bRecursive /*= false*/)
 {
-    if (str.empty() || strSuffix.empty())
-        return;
-    do 
-    {
-        if (!EndsWith(str, strSuffix, bIgnoreCase))
-            break;
-        str.erase(str.length() - strSuffix.length(), strSuffix.length());
-    } while (bRecursive);
+    Assign(str, TrimSuffix(StringPiece(str), StringPiece(strSuffix), bIgnoreCase, bRecursive));
 }
 
 std::string TrimPrefix(const std::string& str, const std::string& strPrefix,
                        bool bIgnoreCase /*= false*/, bool bRecursive /*= false*/)
 {
-    std::string strTrimmed(str);
-    TrimPrefixSelf(strTrimmed, strPrefix, bIgnoreCase, bRecursive);
-    return strTrimmed;
+    return TrimPrefix(StringPiece(str), StringPiece(strPrefix), bIgnoreCase, bRecursive).ToString();
 }
 
 std::string TrimSuffix(const std::string& str, const std::string& strSuffix,
                        bool bIgnoreCase /*= false*/, bool bRecursive /*= false*/)
 {
-    std::string strTrimmed(str);
-    TrimSuffixSelf(strTrimmed, strSuffix, bIgnoreCase, bRecursive);
-    return strTrimmed;
+    return TrimSuffix(StringPiece(str), StringPiece(strSuffix), bIgnoreCase, bRecursive).ToString();
 }
 
-static std::vector<std::string>
-Split(const std::string& str, const std::string& sep,
-      bool bAfter, int n, bool bIgnoreCase)
+StringPiece TrimPrefix(StringPiece str, StringPiece strPrefix,
+                       bool bIgnoreCase /*= false*/, bool bRecursive /*= false*/)
 {
-    std::vector<std::string> splitList;
-    do 
+    if (strPrefix.empty())
+        return str;
+    do
     {
-        if (0 == n)
+        if (!StartsWith(str, strPrefix, bIgnoreCase))
             break;
-        if (sep.empty())
+        str.remove_prefix(strPrefix.size());
+    } while (bRecursive);
+    return str;
+}
+
+StringPiece TrimSuffix(StringPiece str, StringPiece strSuffix,
+                       bool bIgnoreCase /*= false*/, bool bRecursive /*= false*/)
+{
+    if (strSuffix.empty())
+        return str;
+    do
+    {
+        if (!EndsWith(str, strSuffix, bIgnoreCase))
+            break;
+        str.remove_suffix(strSuffix.size());
+    } while (bRecursive);
+    return str;
+}
+
+SplitIterator::SplitIterator(StringPiece str, StringPiece sep, int n /*= -1*/,
+                             bool bIgnoreCase /*= false*/, bool bAfter /*= false*/)
+    : m_rest(str)
+    , m_sep(sep)
+    , m_left(n)
+    , m_bIgnoreCase(bIgnoreCase)
+    , m_bAfter(bAfter)
+    , m_bLast(false)
+    , m_bEnd(false)
+{
+    ++*this;
+}
+
+SplitIterator& SplitIterator::operator++()
+{
+    // Without a separator |str| is split by each byte, an empty |str| has no substring.
+    if (m_bLast || m_left == 0 || (m_sep.empty() && m_rest.empty()))
+    {
+        m_bEnd = true;
+        m_bLast = true;
+        return *this;
+    }
+    if (m_left > 0)
+        --m_left;
+    size_t pos = StringPiece::npos;
+    if (m_left != 0)
+    {
+        if (m_sep.empty())
+            pos = m_rest.size() > 1 ? 1 : StringPiece::npos;
+        else if (!m_bIgnoreCase)
+            pos = m_rest.find(m_sep);
+        else
         {
-            // FIXME: Here we maybe split |str| by its encoding(UTF-8, UTF-16, GBK or others).
-            splitList.resize((n < 0 || n > (int)str.length()) ? str.length() : n);
-            if (n < 0)
-                std::copy(str.begin(), str.end(), splitList.begin());
-            else
+            for (size_t i = 0; i + m_sep.size() <= m_rest.size(); ++i)
             {
-                int i = 0;
-                for (; i < n - 1; ++i)
+                if (EqualIgnoreCase(m_rest.data() + i, m_sep.data(), m_sep.size()))
                 {
-                    splitList[i] = str.substr(i, 1);
+                    pos = i;
+                    break;
                 }
-                splitList[i] = str.substr(i);
-            }
-            break;
-        }
-        // We define a particular equal function for performance.
-        auto fnEqual =
-            bIgnoreCase ?
-                std::function<bool(const std::string&, size_t, const std::string&)> (
-                    [] (const std::string& str, size_t start,
-                        const std::string& sep) {
-                        for (size_t i = 0; i < sep.length(); ++start, ++i)
-                        {
-                            if (std::tolower(str[start], std::locale()) != std::tolower(sep[i], std::locale()))
-                                return false;
-                        }
-                        return true;
-                    })  : std::function<bool(const std::string&, size_t, const std::string&)>(
-                            [] (const std::string& str, size_t start,
-                                const std::string& sep) {
-                                for (size_t i = 0; i < sep.length(); ++start, ++i)
-                                {
-                                    if (str[start] != sep[i])
-                                        return false;
-                                }
-                                return true;
-                            });
-        size_t start = 0;
-        size_t maxCount = n < 0 ? SIZE_MAX : n;
-        for (size_t i = 0; i + sep.length() <= str.length() && splitList.size() < maxCount - 1;)
-        {
-            if (fnEqual(str, i, sep))
-            { 
-                splitList.push_back(str.substr(start, bAfter ? (i - start) + sep.length() : i - start));
-                i += sep.length();
-                start = i;
-                continue;
             }
-            ++i;
         }
-        splitList.push_back(str.substr(start, str.length() - start));
-    } while (0);
+    }
+    if (StringPiece::npos == pos)
+    {
+        m_piece = m_rest;
+        m_bLast = true;
+        return *this;
+    }
+    m_piece = m_rest.substr(0, m_bAfter ? pos + m_sep.size() : pos);
+    m_rest.remove_prefix(pos + m_sep.size());
+    return *this;
+}
+
+bool SplitIterator::operator==(const SplitIterator& other) const
+{
+    if (m_bEnd || other.m_bEnd)
+        return m_bEnd == other.m_bEnd;
+    return m_piece.data() == other.m_piece.data() && m_piece.size() == other.m_piece.size();
+}
+
+SplitRange SplitPieces(StringPiece str, StringPiece sep, bool bIgnoreCase /*= false*/)
+{
+    return SplitRange(SplitIterator(str, sep, -1, bIgnoreCase, false));
+}
+
+SplitRange SplitPiecesN(StringPiece str, StringPiece sep, int n, bool bIgnoreCase /*= false*/)
+{
+    return SplitRange(SplitIterator(str, sep, n, bIgnoreCase, false));
+}
+
+SplitRange SplitAfterPieces(StringPiece str, StringPiece sep, bool bIgnoreCase /*= false*/)
+{
+    return SplitRange(SplitIterator(str, sep, -1, bIgnoreCase, true));
+}
+
+SplitRange SplitAfterPiecesN(StringPiece str, StringPiece sep, int n, bool bIgnoreCase /*= false*/)
+{
+    return SplitRange(SplitIterator(str, sep, n, bIgnoreCase, true));
+}
+
+static std::vector<std::string>
+Split(const std::string& str, const std::string& sep,
+      bool bAfter, int n, bool bIgnoreCase)
+{
+    std::vector<std::string> splitList;
+    for (auto piece : SplitRange(SplitIterator(str, sep, n, bIgnoreCase, bAfter)))
+        splitList.emplace_back(piece.data(), piece.size());
     return splitList;
 }
+
 std::vector<std::string> SplitN(const std::string& str, const std::string& sep,
                                 int n, bool bIgnoreCase /*= false*/)
 {
@@ -347,7 +518,10 @@ std::vector<std::string> SplitAfter(const std::string& str, const std::string& s
 
 bool IsDigit(int c, bool bHex /*= false*/)
 {
-    return bHex ? std::isxdigit(c, std::locale()) : std::isdigit(c, std::locale());
+    // std::isxdigit(c, std::locale()) would look for a ctype<int> facet, which doesn't exist.
+    if ('0' <= c && c <= '9')
+        return true;
+    return bHex && (('a' <= c && c <= 'f') || ('A' <= c && c <= 'F'));
 }
 
 bool IsDigit(const std::string& str, bool bHex /*= false*/)
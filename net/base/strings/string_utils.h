@@ -21,18 +21,27 @@
 #include <string>
 #include <vector>
 
+#include "net/base/strings/string_piece.h"
+
 namespace base {
 namespace strings {
 
-bool Equal(const std::string& str1, const std::string& str2, bool bIgnoreCase = false);
-bool StartsWith(const std::string& strData, const std::string& strSearch, bool bIgnoreCase = false);
-bool EndsWith(const std::string& strData, const std::string& strSearch, bool bIgnoreCase = false);
+// The case is ignored and converted for ASCII letters only, whatever the locale,
+// the other bytes are compared and kept as they are.
+bool Equal(StringPiece str1, StringPiece str2, bool bIgnoreCase = false);
+bool StartsWith(StringPiece strData, StringPiece strSearch, bool bIgnoreCase = false);
+bool EndsWith(StringPiece strData, StringPiece strSearch, bool bIgnoreCase = false);
 
-std::string ToLower(const std::string& str);
-std::string ToUpper(const std::string& str);
+char ToLower(char c);
+char ToUpper(char c);
+std::string ToLower(StringPiece str);
+std::string ToUpper(StringPiece str);
 void ToLowerSelf(std::string& str);
 void ToUpperSelf(std::string& str);
 
+// HashIgnoreCase hashes |str| as ToLower(str) would be, without a copy.
+size_t HashIgnoreCase(StringPiece str);
+
 // The method with Self suffix will make changes on the source string.
 // |strTrimChars| is a set of chars that will be trimmed.
 void TrimLeftSelf(std::string& str, const std::string& strTrimChars);
@@ -45,6 +54,11 @@ std::string TrimLeft(const std::string& str, const std::string& strTrimChars);
 std::string TrimRight(const std::string& str, const std::string& strTrimChars);
 std::string Trim(const std::string& str, const std::string& strTrimChars);
 
+// The methods taking a StringPiece return a piece of it, nothing is copied.
+StringPiece TrimLeft(StringPiece str, StringPiece strTrimChars);
+StringPiece TrimRight(StringPiece str, StringPiece strTrimChars);
+StringPiece Trim(StringPiece str, StringPiece strTrimChars);
+
 // The space including '\t', '\n', '\v', '\f', '\r', ' ', 0x85, 0xA0 will be trimmed.
 void TrimLeftSpaceSelf(std::string& str);
 void TrimRightSpaceSelf(std::string& str);
@@ -52,6 +66,9 @@ void TrimSpaceSelf(std::string& str);
 std::string TrimLeftSpace(const std::string& str);
 std::string TrimRightSpace(const std::string& str);
 std::string TrimSpace(const std::string& str);
+StringPiece TrimLeftSpace(StringPiece str);
+StringPiece TrimRightSpace(StringPiece str);
+StringPiece TrimSpace(StringPiece str);
 
 // |bRecursive| means whether we should trim a particular prefix or suffix recursively.
 // For example, "hellohello world", we trim the "hello" prefix and if |bRecursive| is true,
@@ -64,6 +81,10 @@ std::string TrimPrefix(const std::string& str, const std::string& strPrefix,
                        bool bIgnoreCase = false, bool bRecursive = false);
 std::string TrimSuffix(const std::string& str, const std::string& strSuffix,
                        bool bIgnoreCase = false, bool bRecursive = false);
+StringPiece TrimPrefix(StringPiece str, StringPiece strPrefix,
+                       bool bIgnoreCase = false, bool bRecursive = false);
+StringPiece TrimSuffix(StringPiece str, StringPiece strSuffix,
+                       bool bIgnoreCase = false, bool bRecursive = false);
 
 // |str| is the source string which will be split.
 // |sep| is the separator which will be used to split the str.
@@ -80,6 +101,82 @@ std::vector<std::string> SplitAfterN(const std::string& str, const std::string&
 std::vector<std::string> Split(const std::string& str, const std::string& sep, bool bIgnoreCase = false);
 std::vector<std::string> SplitAfter(const std::string& str, const std::string& sep, bool bIgnoreCase = false);
 
+// SplitIterator walks the substrings Split would return as pieces of |str|, nothing is
+// copied nor allocated. |n|, |bIgnoreCase| and |bAfter| are those of SplitN and SplitAfterN.
+// A default constructed iterator is the end.
+class SplitIterator
+{
+public:
+    SplitIterator() {}
+    SplitIterator(StringPiece str, StringPiece sep, int n = -1,
+                  bool bIgnoreCase = false, bool bAfter = false);
+
+    const StringPiece& operator*() const { return m_piece; }
+    const StringPiece* operator->() const { return &m_piece; }
+    SplitIterator& operator++();
+    bool operator==(const SplitIterator& other) const;
+    bool operator!=(const SplitIterator& other) const { return !(*this == other); }
+
+private:
+    StringPiece m_rest;
+    StringPiece m_sep;
+    StringPiece m_piece;
+    int m_left = 0;
+    bool m_bIgnoreCase = false;
+    bool m_bAfter = false;
+    bool m_bLast = true;
+    bool m_bEnd = true;
+};
+
+// SplitRange is the range of a SplitIterator, for a range-based for loop.
+class SplitRange
+{
+public:
+    explicit SplitRange(const SplitIterator& begin) : m_begin(begin) {}
+
+    SplitIterator begin() const { return m_begin; }
+    SplitIterator end() const { return SplitIterator(); }
+
+private:
+    SplitIterator m_begin;
+};
+
+// The Pieces methods split like those without the suffix but lazily, into pieces of |str|.
+// e.g. for (auto item : SplitPieces(value, ",")) { ... }
+SplitRange SplitPieces(StringPiece str, StringPiece sep, bool bIgnoreCase = false);
+SplitRange SplitPiecesN(StringPiece str, StringPiece sep, int n, bool bIgnoreCase = false);
+SplitRange SplitAfterPieces(StringPiece str, StringPiece sep, bool bIgnoreCase = false);
+SplitRange SplitAfterPiecesN(StringPiece str, StringPiece sep, int n, bool bIgnoreCase = false);
+
+// PieceArray holds up to N pieces without allocating, like a small vector.
+template<size_t N>
+class PieceArray
+{
+public:
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const StringPiece& operator[](size_t i) const { return m_pieces[i]; }
+    const StringPiece& back() const { return m_pieces[m_size - 1]; }
+    const StringPiece* begin() const { return m_pieces; }
+    const StringPiece* end() const { return m_pieces + m_size; }
+    void push_back(StringPiece piece) { m_pieces[m_size++] = piece; }
+
+private:
+    StringPiece m_pieces[N];
+    size_t m_size = 0;
+};
+
+// SplitPiecesN<N> is SplitN(str, sep, N) into a PieceArray, the last piece is the
+// unsplit remainder. e.g. auto kv = SplitPiecesN<2>(pair, "=");
+template<size_t N>
+PieceArray<N> SplitPiecesN(StringPiece str, StringPiece sep, bool bIgnoreCase = false)
+{
+    PieceArray<N> pieces;
+    for (auto piece : SplitPiecesN(str, sep, static_cast<int>(N), bIgnoreCase))
+        pieces.push_back(piece);
+    return pieces;
+}
+
 // Determines whether |c| is a decimal or hexadecimal based on |bHex|.
 bool IsDigit(int c, bool bHex = false);
 
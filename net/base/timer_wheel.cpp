@@ -0,0 +1,385 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/base/timer_wheel.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace base {
+
+namespace {
+
+const uint32_t kNil = 0xFFFFFFFF;
+const int kFirstBits = 8;
+const int kLevelBits = 6;
+const size_t kFirstSlots = 1 << kFirstBits;
+const size_t kLevelSlots = 1 << kLevelBits;
+// Timers further away are kept in the last level and move down when it turns.
+const uint64_t kMaxDelta = (1ULL << (kFirstBits + 4 * kLevelBits)) - 1;
+
+int CountTrailingZeros(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, (unsigned long)value))
+        return (int)index;
+    _BitScanForward(&index, (unsigned long)(value >> 32));
+    return (int)index + 32;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+// LevelSlot returns the first slot of |level| and the slot index of |expires| in it.
+size_t LevelSlot(int level, uint64_t expires)
+{
+    if (level == 0)
+        return (size_t)(expires & (kFirstSlots - 1));
+    int shift = kFirstBits + (level - 1) * kLevelBits;
+    return kFirstSlots + (level - 1) * kLevelSlots + (size_t)((expires >> shift) & (kLevelSlots - 1));
+}
+
+} // !namespace anonymous
+
+TimerWheel::TimerWheel(uint64_t now /*= 0*/)
+    : m_next(now + 1)
+{
+    for (auto& head : m_heads)
+        head = kNil;
+    for (auto& word : m_bitmap)
+        word = 0;
+}
+
+uint64_t TimerWheel::GetTime() const
+{
+    return m_next - 1;
+}
+
+size_t TimerWheel::GetSize() const
+{
+    return m_size;
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(uint64_t delay, Callback callback)
+{
+    uint32_t index;
+    if (!m_free.empty())
+    {
+        index = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        index = (uint32_t)m_nodes.size();
+        m_nodes.emplace_back();
+    }
+    auto& node = m_nodes[index];
+    node.Expires = GetTime() + delay;
+    node.Active = true;
+    node.Function = std::move(callback);
+    Link(index);
+    ++m_size;
+    return ((TimerId)node.Generation << 32) | index;
+}
+
+bool TimerWheel::Cancel(TimerId id)
+{
+    uint32_t index = (uint32_t)id;
+    if (index >= m_nodes.size())
+        return false;
+    auto& node = m_nodes[index];
+    if (!node.Active || node.Generation != (uint32_t)(id >> 32))
+        return false;
+    Unlink(index);
+    Release(index);
+    return true;
+}
+
+void TimerWheel::Advance(uint64_t now, std::vector<Callback>& expired)
+{
+    while (m_next <= now)
+    {
+        if (m_size == 0)
+        {
+            m_next = now + 1;
+            break;
+        }
+
+        size_t slot = (size_t)(m_next & (kFirstSlots - 1));
+        if (slot == 0)
+        {
+            // The first level has turned, move the timers of the next slot of each
+            // level down, a level turns when the one below it does.
+            for (int level = 1; level < kLevels; ++level)
+            {
+                size_t levelSlot = LevelSlot(level, m_next);
+                Cascade(levelSlot);
+                if (levelSlot != LevelSlot(level, 0))
+                    break;
+            }
+        }
+
+        uint32_t index = m_heads[slot];
+        while (index != kNil)
+        {
+            uint32_t next = m_nodes[index].Next;
+            expired.push_back(std::move(m_nodes[index].Function));
+            Release(index);
+            index = next;
+        }
+        m_heads[slot] = kNil;
+        m_bitmap[slot >> 6] &= ~(1ULL << (slot & 63));
+
+        // Skip the empty slots up to the next timer or the next turn.
+        uint64_t turn = (m_next | (kFirstSlots - 1)) + 1;
+        size_t nextSlot = NextSlot(slot + 1);
+        uint64_t target = nextSlot < kFirstSlots ? turn - kFirstSlots + nextSlot : turn;
+        m_next = target <= now ? target : now + 1;
+    }
+}
+
+uint64_t TimerWheel::NextTimeout() const
+{
+    if (m_size == 0)
+        return UINT64_MAX;
+    size_t slot = (size_t)(m_next & (kFirstSlots - 1));
+    size_t nextSlot = NextSlot(slot);
+    return nextSlot - slot + 1;
+}
+
+void TimerWheel::Link(uint32_t index)
+{
+    auto& node = m_nodes[index];
+    uint64_t expires = node.Expires < m_next ? m_next : node.Expires;
+    uint64_t delta = expires - m_next;
+    size_t slot;
+    if (delta < kFirstSlots)
+    {
+        slot = LevelSlot(0, expires);
+        m_bitmap[slot >> 6] |= 1ULL << (slot & 63);
+    }
+    else
+    {
+        int level = 1;
+        while (level < kLevels - 1 && delta >= (1ULL << (kFirstBits + level * kLevelBits)))
+            ++level;
+        if (delta > kMaxDelta)
+            expires = m_next + kMaxDelta;
+        slot = LevelSlot(level, expires);
+    }
+
+    node.Slot = (uint32_t)slot;
+    node.Prev = kNil;
+    node.Next = m_heads[slot];
+    if (node.Next != kNil)
+        m_nodes[node.Next].Prev = index;
+    m_heads[slot] = index;
+}
+
+void TimerWheel::Unlink(uint32_t index)
+{
+    auto& node = m_nodes[index];
+    if (node.Prev != kNil)
+        m_nodes[node.Prev].Next = node.Next;
+    else
+        m_heads[node.Slot] = node.Next;
+    if (node.Next != kNil)
+        m_nodes[node.Next].Prev = node.Prev;
+    if (node.Slot < kFirstSlots && m_heads[node.Slot] == kNil)
+        m_bitmap[node.Slot >> 6] &= ~(1ULL << (node.Slot & 63));
+}
+
+void TimerWheel::Release(uint32_t index)
+{
+    auto& node = m_nodes[index];
+    node.Active = false;
+    node.Function = nullptr;
+    ++node.Generation;
+    m_free.push_back(index);
+    --m_size;
+}
+
+void TimerWheel::Cascade(size_t slot)
+{
+    uint32_t index = m_heads[slot];
+    m_heads[slot] = kNil;
+    while (index != kNil)
+    {
+        uint32_t next = m_nodes[index].Next;
+        Link(index);
+        index = next;
+    }
+}
+
+size_t TimerWheel::NextSlot(size_t slot) const
+{
+    while (slot < kFirstSlots)
+    {
+        uint64_t word = m_bitmap[slot >> 6] & (~0ULL << (slot & 63));
+        if (word != 0)
+            return (slot & ~(size_t)63) + CountTrailingZeros(word);
+        slot = (slot & ~(size_t)63) + 64;
+    }
+    return kFirstSlots;
+}
+
+TimerService::TimerService()
+    : m_start(std::chrono::steady_clock::now())
+{
+    m_thread = std::thread(&TimerService::Run, this);
+}
+
+TimerService::~TimerService()
+{
+    Stop();
+}
+
+TimerService & TimerService::Default()
+{
+    // Never destroyed, the timers may be used until the process exits.
+    static TimerService* service = new TimerService();
+    return *service;
+}
+
+TimerWheel::TimerId TimerService::Schedule(std::chrono::milliseconds delay, TimerWheel::Callback callback)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t now = Now();
+    uint64_t expires = now + (delay.count() > 0 ? (uint64_t)delay.count() : 0);
+    auto id = m_wheel.Schedule(expires - m_wheel.GetTime(), std::move(callback));
+    if (expires < m_sleepUntil)
+        m_wakeup.notify_one();
+    return id;
+}
+
+bool TimerService::Cancel(TimerWheel::TimerId id)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_wheel.Cancel(id))
+        return true;
+    // The timer may be in the batch being fired, wait for it.
+    if (std::this_thread::get_id() != m_thread.get_id())
+        m_idle.wait(lock, [this] { return !m_firing; });
+    return false;
+}
+
+size_t TimerService::GetSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_wheel.GetSize();
+}
+
+void TimerService::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopped)
+            return;
+        m_stopped = true;
+        m_wakeup.notify_one();
+    }
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void TimerService::Run()
+{
+    std::vector<TimerWheel::Callback> expired;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopped)
+    {
+        m_wheel.Advance(Now(), expired);
+        if (!expired.empty())
+        {
+            m_firing = true;
+            lock.unlock();
+            for (auto& callback : expired)
+                callback();
+            expired.clear();
+            lock.lock();
+            m_firing = false;
+            m_idle.notify_all();
+            continue;
+        }
+
+        uint64_t timeout = m_wheel.NextTimeout();
+        if (timeout == UINT64_MAX)
+        {
+            m_sleepUntil = UINT64_MAX;
+            m_wakeup.wait(lock);
+        }
+        else
+        {
+            m_sleepUntil = m_wheel.GetTime() + timeout;
+            m_wakeup.wait_for(lock, std::chrono::milliseconds(timeout));
+        }
+        m_sleepUntil = 0;
+    }
+}
+
+uint64_t TimerService::Now() const
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - m_start).count();
+}
+
+Deadline::Deadline(std::function<void()> onExpired, TimerService & service /*= TimerService::Default()*/)
+    : m_service(service)
+    , m_onExpired(onExpired)
+    , m_expired(std::make_shared<std::atomic<bool>>(false))
+{
+}
+
+Deadline::~Deadline()
+{
+    Cancel();
+}
+
+void Deadline::Reset(std::chrono::milliseconds timeout)
+{
+    Cancel();
+    *m_expired = false;
+    if (timeout.count() <= 0)
+        return;
+    auto onExpired = m_onExpired;
+    auto expired = m_expired;
+    m_timer = m_service.Schedule(timeout, [onExpired, expired] {
+        *expired = true;
+        onExpired();
+    });
+}
+
+void Deadline::Cancel()
+{
+    if (m_timer != 0)
+        m_service.Cancel(m_timer);
+    m_timer = 0;
+}
+
+bool Deadline::Expired() const
+{
+    return *m_expired;
+}
+
+} // !namespace base
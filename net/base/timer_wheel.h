@@ -0,0 +1,162 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace base {
+
+// TimerWheel is a hashed hierarchical timing wheel with a resolution of one tick,
+// a millisecond for TimerService. Schedule and Cancel are O(1), the timers move
+// down one level at most every 256 ticks. It is not thread safe.
+class TimerWheel
+{
+public:
+    typedef uint64_t TimerId;
+    typedef std::function<void()> Callback;
+
+    explicit TimerWheel(uint64_t now = 0);
+    ~TimerWheel() {}
+
+    // GetTime returns the time Advance has run to.
+    uint64_t GetTime() const;
+
+    // GetSize returns the number of armed timers.
+    size_t GetSize() const;
+
+    // Schedule arms a timer which expires |delay| ticks after GetTime().
+    // The returned id is never 0.
+    TimerId Schedule(uint64_t delay, Callback callback);
+
+    // Cancel disarms a timer, it returns false if the timer has expired already.
+    bool Cancel(TimerId id);
+
+    // Advance moves the time to |now| and appends the callbacks of the expired timers
+    // to |expired|, tick by tick.
+    void Advance(uint64_t now, std::vector<Callback>& expired);
+
+    // NextTimeout returns the number of ticks after which Advance may have a timer
+    // to expire or move down, UINT64_MAX if there is no timer.
+    uint64_t NextTimeout() const;
+
+private:
+    struct Node
+    {
+        uint64_t Expires = 0;
+        uint32_t Prev = 0;
+        uint32_t Next = 0;
+        uint32_t Generation = 1;
+        uint32_t Slot = 0;
+        bool Active = false;
+        Callback Function;
+    };
+
+    void Link(uint32_t index);
+    void Unlink(uint32_t index);
+    void Release(uint32_t index);
+    void Cascade(size_t slot);
+    // NextSlot returns the first non-empty slot of the first level from |slot| on, or 256.
+    size_t NextSlot(size_t slot) const;
+
+private:
+    // The first level has 256 slots of one tick, the next four levels 64 slots each.
+    static const int kLevels = 5;
+    static const size_t kSlots = 256 + 4 * 64;
+
+    // The next tick to process.
+    uint64_t m_next;
+    size_t m_size = 0;
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_free;
+    uint32_t m_heads[kSlots];
+    uint64_t m_bitmap[4];
+};
+
+// TimerService runs the callbacks of a millisecond TimerWheel on its own thread.
+class TimerService
+{
+public:
+    TimerService();
+    ~TimerService();
+
+    // Default returns the service shared by the HTTP servers and clients.
+    static TimerService& Default();
+
+    TimerWheel::TimerId Schedule(std::chrono::milliseconds delay, TimerWheel::Callback callback);
+
+    // Cancel disarms a timer. Once it returns, the callback neither runs nor will run,
+    // unless Cancel is called by a callback. It returns false if the timer has fired.
+    bool Cancel(TimerWheel::TimerId id);
+
+    size_t GetSize() const;
+
+    // Stop ends the thread, the armed timers never fire.
+    void Stop();
+
+private:
+    void Run();
+    uint64_t Now() const;
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::condition_variable m_idle;
+    TimerWheel m_wheel;
+    std::chrono::steady_clock::time_point m_start;
+    // The wheel time the thread sleeps until.
+    uint64_t m_sleepUntil = UINT64_MAX;
+    bool m_firing = false;
+    bool m_stopped = false;
+    std::thread m_thread;
+};
+
+// Deadline calls a function once a timeout has passed, e.g. to shut a connection down
+// and unblock its reads and writes. Reset arms it again with another timeout.
+class Deadline
+{
+public:
+    explicit Deadline(std::function<void()> onExpired, TimerService& service = TimerService::Default());
+    ~Deadline();
+
+    Deadline(const Deadline&) = delete;
+    Deadline& operator = (const Deadline&) = delete;
+
+    // A timeout of 0 disarms the deadline.
+    void Reset(std::chrono::milliseconds timeout);
+    void Cancel();
+
+    // Expired returns whether the deadline has passed since it was last reset.
+    bool Expired() const;
+
+private:
+    TimerService& m_service;
+    std::function<void()> m_onExpired;
+    TimerWheel::TimerId m_timer = 0;
+    std::shared_ptr<std::atomic<bool>> m_expired;
+};
+
+} // !namespace base
@@ -27,7 +27,7 @@ namespace http {
 
 namespace {
 
-bool IsValidScheme(const std::string& strScheme)
+bool IsValidScheme(base::strings::StringPiece strScheme)
 {
     if (strScheme.empty())
         return false;
@@ -49,169 +49,214 @@ bool IsValidScheme(const std::string& strScheme)
     }
     return true;
 }
-bool ParseScheme(const std::string& strRawUrl,
-                 std::string& strScheme, std::string& strRest)
+
+// FindOnce returns the position of |c| in |str|, or |kTwice| if it appears more than once.
+const size_t kTwice = base::strings::StringPiece::npos - 1;
+size_t FindOnce(base::strings::StringPiece str, char c)
+{
+    auto pos = str.find(c);
+    if (pos != base::strings::StringPiece::npos && str.find(c, pos + 1) != base::strings::StringPiece::npos)
+        return kTwice;
+    return pos;
+}
+
+bool ParsePort(base::strings::StringPiece strPort, int& iPort)
+{
+    if (strPort.empty() || strPort.size() > 5)
+        return false;
+    int port = 0;
+    for (auto c : strPort)
+    {
+        if (c < '0' || c > '9')
+            return false;
+        port = port * 10 + (c - '0');
+    }
+    if (port > 65535)
+        return false;
+    iPort = port;
+    return true;
+}
+
+void AssignUnescaped(std::string& str, base::strings::StringPiece piece)
+{
+    str.assign(piece.data(), piece.size());
+    base::UnescapeInPlace(str);
+}
+
+} // !namespace
+
+UrlView UrlView::Parse(StringPiece raw)
 {
-    // Extract scheme.
-    auto pos = strRawUrl.find(':');
-    if (pos != std::string::npos)
+    // <scheme>://<user>:<password>@<host>:<port>/<path>?<query>#<frag>
+    // <scheme>:opaque?query#fragment
+    UrlView url;
+    if (raw.empty())
+        return url;
+
+    // Firstly, the fragment and the query string, each of them appears once at most.
+    auto pos = FindOnce(raw, '#');
+    if (kTwice == pos)
+        return url;
+    if (pos != StringPiece::npos)
+    {
+        url.m_fragment = raw.substr(pos + 1);
+        raw = raw.substr(0, pos);
+    }
+    pos = FindOnce(raw, '?');
+    if (kTwice == pos)
+        return url;
+    if (pos != StringPiece::npos)
+    {
+        url.m_query = raw.substr(pos + 1);
+        raw = raw.substr(0, pos);
+    }
+
+    // Parse scheme. If it is not a valid scheme, we assume that the raw url is a path.
+    auto rest = raw;
+    pos = raw.find(':');
+    if (pos != StringPiece::npos)
     {
         // Missing protocol scheme, so the raw url is invalid.
         if (0 == pos)
-            return false;
-        strScheme = base::strings::ToLower(strRawUrl.substr(0, pos));
-        // If it is not a valid scheme, we assume that the raw url is a path.
-        if (IsValidScheme(strScheme))
+            return url;
+        if (IsValidScheme(raw.substr(0, pos)))
         {
-            strRest = strRawUrl.substr(pos + 1);
-            return true;
+            url.m_scheme = raw.substr(0, pos);
+            rest = raw.substr(pos + 1);
         }
     }
-    strScheme = "";
-    strRest = strRawUrl;
-    return true;
+    if (base::strings::Equal(url.m_scheme, "http", true))
+        url.m_port = 80;
+    else if (base::strings::Equal(url.m_scheme, "https", true))
+        url.m_port = 443;
+
+    if (rest.empty())
+        return url;
+
+    // <scheme>:opaque
+    if (!url.m_scheme.empty() && rest[0] != '/')
+    {
+        url.m_opaque = rest;
+        return url;
+    }
+
+    if (!base::strings::StartsWith(rest, "//"))
+    {
+        // A relative path, or an invalid URL if there is a scheme.
+        if (url.m_scheme.empty())
+            url.m_path = rest;
+        return url;
+    }
+
+    // <scheme>:///<path>
+    if (rest.size() > 2 && '/' == rest[2])
+    {
+        pos = 3;
+        while (pos < rest.size() && '/' == rest[pos])
+            ++pos;
+        if (pos < rest.size())
+            url.m_path = rest.substr(pos - 1);
+        return url;
+    }
+
+    // <scheme>://<user>:<password>@<host>:<port>/<path>
+    if (rest.size() == 2)
+        return url;
+    pos = rest.find('/', 2);
+    if (!url.ParseAuthority(rest.substr(2, pos == StringPiece::npos ? pos : pos - 2)))
+    {
+        url.m_user = StringPiece();
+        url.m_password = StringPiece();
+        url.m_host = StringPiece();
+        url.m_port = 0;
+        return url;
+    }
+    url.m_path = pos == StringPiece::npos ? StringPiece("/") : rest.substr(pos);
+    return url;
 }
-bool ParseAuthority(const std::string& strAuthority,
-                    std::string& strUserName, std::string& strPassword,
-                    std::string& strHost, int& iPort)
+
+bool UrlView::ParseAuthority(StringPiece authority)
 {
-    if (strAuthority.empty())
-        return false;
-    auto spList = base::strings::Split(strAuthority, "@");
-    if (spList.size() > 2
-        || (spList.size() == 2 && spList[1].empty()))
+    if (authority.empty())
         return false;
 
-    std::string strHostPort;
-    if (spList.size() == 2)
+    auto hostPort = authority;
+    auto pos = FindOnce(authority, '@');
+    if (kTwice == pos)
+        return false;
+    if (pos != StringPiece::npos)
     {
         // Parse UserName:Password.
-        auto spList1 = base::strings::Split(spList[0], ":");
-        if (spList1.size() > 2)
+        hostPort = authority.substr(pos + 1);
+        if (hostPort.empty())
             return false;
-        strUserName = base::Unescape(spList1[0]);
-        if (spList1.size() == 2)
-            strPassword = base::Unescape(spList1[1]);
-        strHostPort = spList[1];
-    }
-    else
-        strHostPort = spList[0];
-    // Parse Host:Port.
-    auto spList1 = base::strings::Split(strHostPort, ":");
-    if (spList1.size() > 2)
-        return false;
-    strHost = base::Unescape(spList1[0]);
-    if (spList1.size() == 2)
-    {
-        if (base::strings::IsDigit(spList1[1]))
-            iPort = std::stoi(spList1[1]);
-        else
+        auto userInfo = authority.substr(0, pos);
+        pos = FindOnce(userInfo, ':');
+        if (kTwice == pos)
             return false;
+        m_user = userInfo.substr(0, pos);
+        if (pos != StringPiece::npos)
+            m_password = userInfo.substr(pos + 1);
     }
 
+    // Parse Host:Port.
+    pos = FindOnce(hostPort, ':');
+    if (kTwice == pos)
+        return false;
+    if (pos != StringPiece::npos && !ParsePort(hostPort.substr(pos + 1), m_port))
+        return false;
+    m_host = hostPort.substr(0, pos);
     return true;
 }
 
-} // !namespace
+std::string UrlView::GetUser() const
+{
+    return base::Unescape(m_user);
+}
+
+std::string UrlView::GetPassword() const
+{
+    return base::Unescape(m_password);
+}
+
+std::string UrlView::GetHost() const
+{
+    return base::Unescape(m_host);
+}
+
+std::string UrlView::GetPath() const
+{
+    return base::Unescape(m_path);
+}
+
+std::string UrlView::GetFragment() const
+{
+    return base::Unescape(m_fragment);
+}
 
 Url Url::Parse(const std::string& strRawUrl)
 {
-    // <scheme>://<user>:<password>@<host>:<port>/<path>?<query>#<frag>
-    // <scheme>:opaque?query#fragment
     Url url;
-    if (strRawUrl.empty())
-        return url;
-    do 
-    {
-        // Firstly, we will split fragment and query string.
-        std::string strPrefix;
-        auto spList = base::strings::Split(strRawUrl, "#");
-        if (spList.size() > 2)
-            break;
-        strPrefix = spList[0];
-        if (spList.size() == 2)
-            url.m_strFragment = base::Unescape(spList[1]);
-        spList = base::strings::Split(strPrefix, "?");
-        if (spList.size() > 2)
-            break;
-        strPrefix = spList[0];
-        if (spList.size() == 2)
-            url.m_strRawQuery = spList[1];
-        
-        // Parse scheme.
-        std::string strRest;
-        if (!ParseScheme(strPrefix, url.m_strScheme, strRest))
-            break;
-        if (url.GetScheme() == "http")
-            url.SetPort(80);
-        else if (url.GetScheme() == "https")
-            url.SetPort(443);
-
-        if (strRest.empty())
-            break;
-        
-        // <scheme>:opaque
-        if (!url.m_strScheme.empty() && strRest[0] != '/')
-        {
-            url.m_strOpaque = strRest;
-            break;
-        } // !if <scheme>:opaque
-
-        // Invalid URL.
-        if (!url.m_strScheme.empty()
-            && !base::strings::StartsWith(strRest, "//"))
-            break;
-
-        // Relative path.
-        if (url.m_strScheme.empty()
-            && !base::strings::StartsWith(strRest, "//"))
-        {
-            url.m_strPath = base::Unescape(strRest);
-            break;
-        }
-
-        // Secondly, we will parse the particular case.
-        // <scheme>:///<path>
-        if (strRest[2] == '/')
-        {
-            auto pos1 = strRest.find_first_not_of('/');
-            if (std::string::npos == pos1)
-                break;
-            url.m_strPath = base::Unescape(strRest.substr(pos1 - 1));
-            break;
-        } // !if <scheme>:///<path>
-
-        // <scheme>://<user>:<password>@<host>:<port>/<path>
-        auto pos1 = strRest.find_first_not_of('/');
-        if (std::string::npos == pos1)
-            break;
-        auto pos2 = strRest.find_first_of("/", pos1);
-        std::string strAuthority;
-        if (std::string::npos == pos2)
-            strAuthority = strRest.substr(pos1);
-        else
-            strAuthority = strRest.substr(pos1, pos2 - pos1);
-        if (!ParseAuthority(strAuthority, url.m_strUserName, url.m_strPassword,
-                            url.m_strHost, url.m_iPort))
-        {
-            url.m_strUserName = "";
-            url.m_strPassword = "";
-            url.m_strHost = "";
-            url.m_iPort = 0;
-            break;
-        }
-        if (pos2 == std::string::npos)
-        {
-            url.m_strPath = "/";
-            break;
-        }
-        url.m_strPath = base::Unescape(strRest.substr(pos2));
-        
-    } while (0);
-    
+    url.Assign(UrlView::Parse(strRawUrl));
     return url;
 }
 
+void Url::Assign(const UrlView& view)
+{
+    auto scheme = view.GetScheme();
+    m_strScheme.resize(scheme.size());
+    for (size_t i = 0; i < scheme.size(); ++i)
+        m_strScheme[i] = base::strings::ToLower(scheme[i]);
+    m_strOpaque.assign(view.GetOpaque().data(), view.GetOpaque().size());
+    AssignUnescaped(m_strUserName, view.GetRawUser());
+    AssignUnescaped(m_strPassword, view.GetRawPassword());
+    AssignUnescaped(m_strHost, view.GetRawHost());
+    m_iPort = view.GetPort();
+    AssignUnescaped(m_strPath, view.GetRawPath());
+    m_strRawQuery.assign(view.GetRawQuery().data(), view.GetRawQuery().size());
+    AssignUnescaped(m_strFragment, view.GetRawFragment());
+}
+
 std::string Url::HostPort() const
 {
     std::string hostPort;
@@ -267,16 +312,15 @@ Url Url::ResolveReference(const Url& ref) const
     url.SetRawQuery(ref.GetRawQuery());
     url.SetFragment(ref.GetFragment());
 
-    auto pathDirList = base::strings::Split(m_strPath, "/");
-    auto relDirList = base::strings::Split(ref.GetPath(), "/");
-    std::stack<std::string> pathDirStack;
-    for (auto v : pathDirList)
+    auto& refPath = ref.GetPath();
+    std::stack<base::strings::StringPiece> pathDirStack;
+    for (auto v : base::strings::SplitPieces(m_strPath, "/"))
     {
         if (v.empty())
             continue;
         pathDirStack.push(v);
     }
-    for (auto v : relDirList)
+    for (auto v : base::strings::SplitPieces(refPath, "/"))
     {
         if (v.empty() || "." == v)
             continue;
@@ -296,7 +340,7 @@ Url Url::ResolveReference(const Url& ref) const
         std::string strPath;
         while (!pathDirStack.empty())
         {
-            strPath = pathDirStack.top() + "/" + strPath;
+            strPath = pathDirStack.top().ToString() + "/" + strPath;
             pathDirStack.pop();
         }
         url.SetPath("/" + strPath);
@@ -19,10 +19,59 @@
 #pragma once
 
 #include <string>
+#include <utility>
+
+#include "net/base/strings/string_piece.h"
 
 namespace net {
 namespace http {
 
+// UrlView records where the components of a URL are in the string it was parsed
+// from, in one pass and without copying anything. The escaped components are
+// unescaped when they are asked for. The string must outlive the view.
+class UrlView
+{
+public:
+    typedef base::strings::StringPiece StringPiece;
+
+    // Parse reads |raw| as Url::Parse does, the components of an invalid URL
+    // are left empty the same way.
+    static UrlView Parse(StringPiece raw);
+
+    // The scheme is as written, Url keeps it in lower case.
+    StringPiece GetScheme() const { return m_scheme; }
+    StringPiece GetOpaque() const { return m_opaque; }
+    StringPiece GetRawUser() const { return m_user; }
+    StringPiece GetRawPassword() const { return m_password; }
+    StringPiece GetRawHost() const { return m_host; }
+    int GetPort() const { return m_port; }
+    StringPiece GetRawPath() const { return m_path; }
+    StringPiece GetRawQuery() const { return m_query; }
+    StringPiece GetRawFragment() const { return m_fragment; }
+
+    // The unescaped components.
+    std::string GetUser() const;
+    std::string GetPassword() const;
+    std::string GetHost() const;
+    std::string GetPath() const;
+    std::string GetFragment() const;
+
+    bool IsAbsolute() const { return !m_scheme.empty(); }
+
+private:
+    bool ParseAuthority(StringPiece authority);
+
+    StringPiece m_scheme;
+    StringPiece m_opaque;
+    StringPiece m_user;
+    StringPiece m_password;
+    StringPiece m_host;
+    int         m_port = -1;
+    StringPiece m_path;
+    StringPiece m_query;
+    StringPiece m_fragment;
+}; // !class UrlView
+
 class Url
 {
 public:
@@ -35,30 +84,34 @@ public:
     // The raw URL can be absolute or relative.
     static Url Parse(const std::string& strRawUrl);
 
-    std::string GetScheme() const { return m_strScheme; }
-    void SetScheme(const std::string& strScheme) { m_strScheme = strScheme; }
-    std::string GetOpaque() const { return m_strOpaque; }
-    void SetOpaque(const std::string& strOpaque) { m_strOpaque = strOpaque; }
-    std::string GetUser() const { return m_strUserName; }
-    void SetUser(const std::string& strUserName) { m_strUserName = strUserName; }
-    std::string GetPassword() const { return m_strPassword; }
-    void SetPassword(const std::string& strPassword) { m_strPassword = strPassword; }
-    std::string GetHost() const { return m_strHost; }
-    void SetHost(const std::string& strHost) { m_strHost = strHost; }
+    // Assign sets the components parsed by |view|, reusing the memory of the strings.
+    void Assign(const UrlView& view);
+
+    // The getters return references instead of copies, the setters move their argument.
+    const std::string& GetScheme() const { return m_strScheme; }
+    void SetScheme(std::string strScheme) { m_strScheme = std::move(strScheme); }
+    const std::string& GetOpaque() const { return m_strOpaque; }
+    void SetOpaque(std::string strOpaque) { m_strOpaque = std::move(strOpaque); }
+    const std::string& GetUser() const { return m_strUserName; }
+    void SetUser(std::string strUserName) { m_strUserName = std::move(strUserName); }
+    const std::string& GetPassword() const { return m_strPassword; }
+    void SetPassword(std::string strPassword) { m_strPassword = std::move(strPassword); }
+    const std::string& GetHost() const { return m_strHost; }
+    void SetHost(std::string strHost) { m_strHost = std::move(strHost); }
     int GetPort() const { return m_iPort; }
     void SetPort(int iPort) { m_iPort = iPort; }
-    std::string GetPath() const { return m_strPath; }
-    void SetPath(const std::string& strPath) { m_strPath = strPath; }
+    const std::string& GetPath() const { return m_strPath; }
+    void SetPath(std::string strPath) { m_strPath = std::move(strPath); }
 
     // HostPort returns the form of 'host:port'.
     std::string HostPort() const;
 
     // RawQuery is encoded query values, without '?'
     // For example, http://www.abc.com?a=1&b=2, the 'a=1&b=2' is raw query.
-    std::string GetRawQuery() const { return m_strRawQuery; }
-    void SetRawQuery(const std::string& strRawQuery) { m_strRawQuery = strRawQuery; }
-    std::string GetFragment() const { return m_strFragment; }
-    void SetFragment(const std::string& strFragment) { m_strFragment = strFragment; }
+    const std::string& GetRawQuery() const { return m_strRawQuery; }
+    void SetRawQuery(std::string strRawQuery) { m_strRawQuery = std::move(strRawQuery); }
+    const std::string& GetFragment() const { return m_strFragment; }
+    void SetFragment(std::string strFragment) { m_strFragment = std::move(strFragment); }
 
     // Whether the URL is absolute.
     bool IsAbsolute() const { return !m_strScheme.empty(); }
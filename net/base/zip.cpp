@@ -16,10 +16,14 @@
 // WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
 // ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#include <atomic>
 #include <cassert>
 #include <iomanip>
+#include <iterator>
 #include <memory>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 #include "net/base/zip.h"
 #include "third_party/zlib/zlib.h"
@@ -27,6 +31,349 @@
 namespace base {
 namespace zip {
 
+    namespace {
+
+        // The streams kept by a thread, each holds about 256 KiB for deflating.
+        const size_t kMaxPooledStreams = 4;
+        const size_t kMinGrowth = 4096;
+        const size_t kWindowSize = 32 * 1024;
+        // The gzip header without a name or time, the OS is unknown (RFC 1952, 2.3).
+        const unsigned char kGzipHeader[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+        // Short messages compress well beyond any sensible ratio.
+        const uint64_t kRatioSlack = 1024 * 1024;
+
+        int WindowBits(Format format, int windowBits)
+        {
+            if (format == kGzip)
+                return 16 + windowBits;
+            if (format == kRaw)
+                return -windowBits;
+            return windowBits;
+        }
+
+        // IsPadding returns whether the rest of a gzip stream is zeros, which gzip ignores.
+        bool IsPadding(const char* data, size_t length)
+        {
+            for (size_t i = 0; i < length; ++i)
+            {
+                if (data[i] != 0)
+                    return false;
+            }
+            return true;
+        }
+
+        template <typename T>
+        std::vector<std::unique_ptr<T>>& ThreadPool()
+        {
+            static thread_local std::vector<std::unique_ptr<T>> pool;
+            return pool;
+        }
+
+        template <typename T, typename Match>
+        std::unique_ptr<T> TakeFromPool(Match match)
+        {
+            auto& pool = ThreadPool<T>();
+            for (auto iter = pool.rbegin(); iter != pool.rend(); ++iter)
+            {
+                if (match(**iter))
+                {
+                    auto stream = std::move(*iter);
+                    pool.erase(std::next(iter).base());
+                    return stream;
+                }
+            }
+            return nullptr;
+        }
+
+        template <typename T>
+        void PutToPool(std::unique_ptr<T> stream)
+        {
+            auto& pool = ThreadPool<T>();
+            if (!stream->IsValid() || pool.size() >= kMaxPooledStreams)
+                return;
+            stream->Reset();
+            pool.push_back(std::move(stream));
+        }
+
+    } // !namespace anonymous
+
+    Deflater::Deflater(Format format /*= kGzip*/, int level /*= kDefaultLevel*/, int windowBits /*= kMaxWindowBits*/)
+        : m_stream(new z_stream())
+        , m_format(format)
+        , m_level(level)
+    {
+        m_valid = deflateInit2(m_stream.get(), level, Z_DEFLATED,
+            WindowBits(format, windowBits), 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+
+    Deflater::~Deflater()
+    {
+        if (m_valid)
+            deflateEnd(m_stream.get());
+    }
+
+    bool Deflater::IsValid() const
+    {
+        return m_valid;
+    }
+
+    Format Deflater::GetFormat() const
+    {
+        return m_format;
+    }
+
+    int Deflater::GetLevel() const
+    {
+        return m_level;
+    }
+
+    size_t Deflater::Bound(size_t length) const
+    {
+        return static_cast<size_t>(deflateBound(m_stream.get(), static_cast<uLong>(length)));
+    }
+
+    Status Deflater::Update(const char*& src, size_t& srcLength, char*& dst, size_t& dstLength, Flush flush)
+    {
+        if (!m_valid)
+            return kError;
+        m_stream->next_in = (z_const Bytef*)src;
+        m_stream->avail_in = (uInt)srcLength;
+        m_stream->next_out = (Bytef*)dst;
+        m_stream->avail_out = (uInt)dstLength;
+        int mode = flush == kFinish ? Z_FINISH : flush == kSyncFlush ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+        int err = deflate(m_stream.get(), mode);
+        src += srcLength - m_stream->avail_in;
+        srcLength = m_stream->avail_in;
+        dst += dstLength - m_stream->avail_out;
+        dstLength = m_stream->avail_out;
+        if (err == Z_STREAM_END)
+            return kStreamEnd;
+        // Z_BUF_ERROR only tells no progress was possible.
+        return err == Z_OK || err == Z_BUF_ERROR ? kOk : kError;
+    }
+
+    bool Deflater::Compress(const char* data, size_t length, std::string& out, Flush flush /*= kFinish*/)
+    {
+        size_t start = out.size();
+        // The output is written in place, the bound is enough for one call.
+        out.resize(start + Bound(length));
+        char* dst = &out[start];
+        size_t dstLength = out.size() - start;
+        while (true)
+        {
+            Status status = Update(data, length, dst, dstLength, flush);
+            if (status == kError)
+            {
+                out.resize(start);
+                return false;
+            }
+            if (dstLength > 0 && (flush != kFinish || status == kStreamEnd))
+                break;
+            if (dstLength == 0)
+            {
+                // The flush markers are not in the bound.
+                size_t used = out.size();
+                out.resize(used + kMinGrowth);
+                dst = &out[used];
+                dstLength = kMinGrowth;
+            }
+        }
+        out.resize(out.size() - dstLength);
+        return true;
+    }
+
+    bool Deflater::SetDictionary(const char* data, size_t length)
+    {
+        return m_valid && deflateSetDictionary(m_stream.get(), (const Bytef*)data, (uInt)length) == Z_OK;
+    }
+
+    void Deflater::Reset()
+    {
+        if (m_valid)
+            deflateReset(m_stream.get());
+    }
+
+    Inflater::Inflater(Format format /*= kGzip*/, int windowBits /*= kMaxWindowBits*/)
+        : m_stream(new z_stream())
+        , m_format(format)
+        , m_finished(false)
+        , m_tooLarge(false)
+        , m_totalIn(0)
+        , m_totalOut(0)
+    {
+        m_valid = inflateInit2(m_stream.get(), WindowBits(format, windowBits)) == Z_OK;
+    }
+
+    Inflater::~Inflater()
+    {
+        if (m_valid)
+            inflateEnd(m_stream.get());
+    }
+
+    bool Inflater::IsValid() const
+    {
+        return m_valid;
+    }
+
+    Format Inflater::GetFormat() const
+    {
+        return m_format;
+    }
+
+    bool Inflater::IsFinished() const
+    {
+        return m_finished;
+    }
+
+    void Inflater::SetLimits(const Limits& limits)
+    {
+        m_limits = limits;
+    }
+
+    bool Inflater::IsTooLarge() const
+    {
+        return m_tooLarge;
+    }
+
+    Status Inflater::Update(const char*& src, size_t& srcLength, char*& dst, size_t& dstLength, Flush flush /*= kNoFlush*/)
+    {
+        if (!m_valid)
+            return kError;
+        if (m_finished)
+            return kStreamEnd;
+        m_stream->next_in = (z_const Bytef*)src;
+        m_stream->avail_in = (uInt)srcLength;
+        m_stream->next_out = (Bytef*)dst;
+        m_stream->avail_out = (uInt)dstLength;
+        int mode = flush == kFinish ? Z_FINISH : flush == kSyncFlush ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+        int err = inflate(m_stream.get(), mode);
+        m_totalIn += srcLength - m_stream->avail_in;
+        m_totalOut += dstLength - m_stream->avail_out;
+        src += srcLength - m_stream->avail_in;
+        srcLength = m_stream->avail_in;
+        dst += dstLength - m_stream->avail_out;
+        dstLength = m_stream->avail_out;
+        if (err == Z_STREAM_END)
+        {
+            m_finished = true;
+            return kStreamEnd;
+        }
+        return err == Z_OK || err == Z_BUF_ERROR ? kOk : kError;
+    }
+
+    bool Inflater::Inflate(const char* data, size_t length, std::string& out, size_t maxSize /*= std::string::npos*/)
+    {
+        size_t start = out.size();
+        size_t allowed = Allowed(length);
+        size_t limit = maxSize;
+        if (maxSize >= start && allowed < maxSize - start)
+            limit = start + allowed;
+
+        size_t used = start;
+        // Inflate straight into |out|, it grows with what has been produced so far
+        // instead of by the size the trailer claims.
+        size_t growth = length < kMinGrowth / 4 ? kMinGrowth : length * 4;
+        if (out.capacity() - start > growth)
+            growth = out.capacity() - start;
+        while (true)
+        {
+            if (m_finished && (m_format != kGzip || !NextMember(data, length)))
+                break;
+            if (used >= limit)
+            {
+                // Only a byte more tells whether the message goes on.
+                growth = 1;
+            }
+            else if (growth > limit - used)
+            {
+                growth = limit - used;
+            }
+            out.resize(used + growth);
+            char* dst = &out[used];
+            size_t dstLength = growth;
+            Status status = Update(data, length, dst, dstLength, kSyncFlush);
+            used = out.size() - dstLength;
+            if (status == kError || used > limit)
+            {
+                m_tooLarge = status != kError && used - start > allowed;
+                out.resize(used);
+                return false;
+            }
+            // More output space is only needed when it has been filled.
+            if (dstLength > 0 && !m_finished)
+                break;
+            if (dstLength == 0)
+                growth = used - start;
+        }
+        out.resize(used);
+        return true;
+    }
+
+    void Inflater::Reset()
+    {
+        m_finished = false;
+        m_tooLarge = false;
+        m_totalIn = 0;
+        m_totalOut = 0;
+        if (m_valid)
+            inflateReset(m_stream.get());
+    }
+
+    size_t Inflater::Allowed(size_t length) const
+    {
+        uint64_t allowed = ~0ULL;
+        if (m_limits.MaxSize)
+            allowed = m_limits.MaxSize > m_totalOut ? m_limits.MaxSize - m_totalOut : 0;
+        if (m_limits.MaxRatio)
+        {
+            uint64_t byRatio = (m_totalIn + length) * m_limits.MaxRatio + kRatioSlack;
+            byRatio = byRatio > m_totalOut ? byRatio - m_totalOut : 0;
+            if (byRatio < allowed)
+                allowed = byRatio;
+        }
+        return allowed < std::string::npos ? static_cast<size_t>(allowed) : std::string::npos;
+    }
+
+    bool Inflater::NextMember(const char* data, size_t length)
+    {
+        if (IsPadding(data, length))
+            return false;
+        m_finished = false;
+        inflateReset(m_stream.get());
+        return true;
+    }
+
+    void Release(std::unique_ptr<Deflater> stream)
+    {
+        PutToPool(std::move(stream));
+    }
+
+    void Release(std::unique_ptr<Inflater> stream)
+    {
+        stream->SetLimits(Limits());
+        PutToPool(std::move(stream));
+    }
+
+    Pooled<Deflater> AcquireDeflater(Format format /*= kGzip*/, int level /*= kDefaultLevel*/)
+    {
+        auto stream = TakeFromPool<Deflater>([format, level](const Deflater& d) {
+            return d.GetFormat() == format && d.GetLevel() == level;
+        });
+        if (!stream)
+            stream.reset(new Deflater(format, level));
+        return Pooled<Deflater>(std::move(stream));
+    }
+
+    Pooled<Inflater> AcquireInflater(Format format /*= kGzip*/)
+    {
+        auto stream = TakeFromPool<Inflater>([format](const Inflater& i) {
+            return i.GetFormat() == format;
+        });
+        if (!stream)
+            stream.reset(new Inflater(format));
+        return Pooled<Inflater>(std::move(stream));
+    }
+
     size_t GetCompressLength(size_t srcLength)
     {
         return static_cast<size_t>(compressBound(static_cast<uLong>(srcLength)));
@@ -109,53 +456,20 @@ namespace zip {
 
     size_t GCompress(char * dst, size_t dstLength, const char * src, size_t srcLength)
     {
-        z_stream stream;
-        int err;
-
-        stream.next_in = (z_const Bytef *)src;
-        stream.avail_in = (uInt)srcLength;
-#ifdef MAXSEG_64K
-        /* Check for source > 64K on 16-bit machine: */
-        if ((uLong)stream.avail_in != srcLength) return 0;
-#endif
-        stream.next_out = (Bytef*)dst;
-        stream.avail_out = dstLength;
-        if ((uLong)stream.avail_out != dstLength) return 0;
-
-        stream.zalloc = (alloc_func)0;
-        stream.zfree = (free_func)0;
-        stream.opaque = (voidpf)0;
-
-        err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY);
-        if (err != Z_OK) return 0;
-
-        err = deflate(&stream, Z_FINISH);
-        if (err != Z_STREAM_END) {
-            deflateEnd(&stream);
-            return 0;
-        }
-        auto clen = stream.total_out;
-
-        err = deflateEnd(&stream);
-        if (err != Z_OK)
+        auto deflater = AcquireDeflater(kGzip);
+        size_t capacity = dstLength;
+        if (deflater->Update(src, srcLength, dst, dstLength, kFinish) != kStreamEnd)
             return 0;
-        return clen;
+        return capacity - dstLength;
     }
 
     std::string GCompress(const char * data, size_t length)
     {
         assert(data && length);
-        uLong dstLen = deflateBound(Z_NULL, length);
-        if (dstLen <= 0)
+        std::string out;
+        if (!AcquireDeflater(kGzip)->Compress(data, length, out))
             return "";
-        dstLen += 18;
-        std::unique_ptr<char[]> dst(new char[dstLen]);
-        if (!dst)
-            return "";
-        auto compressLen = GCompress(dst.get(), dstLen, data, length);
-        if (compressLen <= 0)
-            return "";
-        return std::string(dst.get(), compressLen);
+        return out;
     }
 
     std::string GCompress(const std::string & data)
@@ -163,64 +477,125 @@ namespace zip {
         return GCompress(data.c_str(), data.length());
     }
 
+    std::string GCompressParallel(const char* data, size_t length, size_t threads /*= 0*/, int level /*= kDefaultLevel*/)
+    {
+        assert(data && length);
+        size_t blocks = (length + kParallelBlockSize - 1) / kParallelBlockSize;
+        if (blocks <= 1)
+        {
+            std::string out;
+            if (!AcquireDeflater(kGzip, level)->Compress(data, length, out))
+                return "";
+            return out;
+        }
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        if (threads > blocks)
+            threads = blocks;
+
+        // Each block ends byte aligned by a sync flush, the last one finishes the stream,
+        // so the raw deflate outputs follow each other as one deflate stream.
+        std::vector<std::string> outputs(blocks);
+        std::vector<uLong> crcs(blocks);
+        std::atomic<size_t> next(0);
+        std::atomic<bool> failed(false);
+        auto work = [&]() {
+            try
+            {
+                auto deflater = AcquireDeflater(kRaw, level);
+                for (size_t i = next++; i < blocks && !failed; i = next++)
+                {
+                    size_t offset = i * kParallelBlockSize;
+                    size_t size = length - offset < kParallelBlockSize ? length - offset : kParallelBlockSize;
+                    size_t dictionary = offset < kWindowSize ? offset : kWindowSize;
+                    crcs[i] = crc32(0, (const Bytef*)data + offset, (uInt)size);
+                    if (!deflater->SetDictionary(data + offset - dictionary, dictionary) ||
+                        !deflater->Compress(data + offset, size, outputs[i], i + 1 == blocks ? kFinish : kSyncFlush))
+                        failed = true;
+                    deflater->Reset();
+                }
+            }
+            catch (...)
+            {
+                failed = true;
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads; ++i)
+            workers.emplace_back(work);
+        work();
+        for (auto& worker : workers)
+            worker.join();
+        if (failed)
+            return "";
+
+        size_t size = sizeof(kGzipHeader) + 8;
+        for (auto& output : outputs)
+            size += output.size();
+        std::string out;
+        out.reserve(size);
+        out.append((const char*)kGzipHeader, sizeof(kGzipHeader));
+        uLong crc = crcs[0];
+        for (size_t i = 0; i < blocks; ++i)
+        {
+            out += outputs[i];
+            if (i > 0)
+            {
+                size_t offset = i * kParallelBlockSize;
+                size_t blockSize = length - offset < kParallelBlockSize ? length - offset : kParallelBlockSize;
+                crc = crc32_combine(crc, crcs[i], (z_off_t)blockSize);
+            }
+        }
+        // CRC-32 and ISIZE, little endian.
+        uint32_t trailer[2] = { (uint32_t)crc, (uint32_t)length };
+        for (auto value : trailer)
+        {
+            for (int shift = 0; shift < 32; shift += 8)
+                out.push_back((char)(value >> shift));
+        }
+        return out;
+    }
+
+    std::string GCompressParallel(const std::string& data, size_t threads /*= 0*/, int level /*= kDefaultLevel*/)
+    {
+        return GCompressParallel(data.c_str(), data.length(), threads, level);
+    }
+
     size_t GDecompress(char* dst, size_t dstlen, const char* src, size_t srclen)
     {
-        z_stream stream;
-        int err;
-
-        stream.next_in = (z_const Bytef *)src;
-        stream.avail_in = (uInt)srclen;
-        /* Check for source > 64K on 16-bit machine: */
-        if ((uLong)stream.avail_in != srclen) return 0;
-
-        stream.next_out = (z_const Bytef *)dst;
-        stream.avail_out = dstlen;
-
-        stream.zalloc = (alloc_func)0;
-        stream.zfree = (free_func)0;
-
-        err = inflateInit2(&stream, 16 + MAX_WBITS);
-        if (err != Z_OK) return 0;
-
-        err = inflate(&stream, Z_FINISH);
-        if (err != Z_STREAM_END) {
-            inflateEnd(&stream);
-            if (err == Z_NEED_DICT || (err == Z_BUF_ERROR && stream.avail_in == 0))
-                return 0;
-            return 0;
-        }
-        auto actualSize = stream.total_out;
-
-        inflateEnd(&stream);
-        return actualSize;
+        auto inflater = AcquireInflater(kGzip);
+        size_t capacity = dstlen;
+        do
+        {
+            if (inflater->Update(src, srclen, dst, dstlen, kFinish) != kStreamEnd)
+                return 0;
+            inflater->Reset();
+        } while (!IsPadding(src, srclen));
+        return capacity - dstlen;
     }
 
-    std::string GDecompress(const char * data, size_t length)
+    bool GDecompress(const char* data, size_t length, std::string& out, const Limits& limits)
     {
-        if (length < 4)
-            return "";
         try
         {
-            unsigned int b[4];
-            b[0] = (unsigned int)data[length - 4] & 0x000000ff;
-            b[1] = (unsigned int)data[length - 3] & 0x000000ff;
-            b[2] = (unsigned int)data[length - 2] & 0x000000ff;
-            b[3] = (unsigned int)data[length - 1] & 0x000000ff;
-            auto size = b[0] | (b[1] << 8) | (b[2] << 16) | (b[3] << 24);
-            if (size == 0)
-                return "";
-            std::unique_ptr<char[]> dst(new char[size]);
-            if (!dst)
-                return "";
-            size_t actualSize = GDecompress(dst.get(), size, data, length);
-            return std::string(dst.get(), actualSize);
+            auto inflater = AcquireInflater(kGzip);
+            inflater->SetLimits(limits);
+            return inflater->Inflate(data, length, out) && inflater->IsFinished();
         }
         catch (...)
         {
-            return "";
+            return false;
         }
     }
 
+    std::string GDecompress(const char * data, size_t length)
+    {
+        std::string out;
+        if (!GDecompress(data, length, out, Limits(kDefaultMaxSize, kDefaultMaxRatio)))
+            return "";
+        return out;
+    }
+
     std::string GDecompress(const std::string& data)
     {
         return GDecompress(data.c_str(), data.length());
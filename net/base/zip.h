@@ -18,11 +18,173 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 
+struct z_stream_s;
+
 namespace base {
 namespace zip {
-    
+
+    // Format selects the framing around the deflate data.
+    enum Format
+    {
+        kZlib,
+        kGzip,
+        kRaw,
+    };
+
+    enum Flush
+    {
+        kNoFlush,
+        kSyncFlush,
+        kFinish,
+    };
+
+    enum Status
+    {
+        kError = -1,
+        kOk,
+        kStreamEnd,
+    };
+
+    const int kDefaultLevel = -1;
+    const int kMaxWindowBits = 15;
+
+    // The limits GDecompress applies unless others are given.
+    const size_t kDefaultMaxSize = 256 * 1024 * 1024;
+    const size_t kDefaultMaxRatio = 256;
+
+    // Limits bound what a compressed message may inflate to: at most MaxSize bytes, and
+    // beyond the first 1 MiB at most MaxRatio times the input so far. 0 disables a limit.
+    struct Limits
+    {
+        Limits() : MaxSize(0), MaxRatio(0) {}
+        Limits(size_t maxSize, size_t maxRatio) : MaxSize(maxSize), MaxRatio(maxRatio) {}
+
+        size_t MaxSize;
+        size_t MaxRatio;
+    };
+
+    // Deflater compresses a stream incrementally. Its z_stream and the window and hash
+    // allocations are kept between messages, Reset starts a new message.
+    class Deflater
+    {
+    public:
+        explicit Deflater(Format format = kGzip, int level = kDefaultLevel, int windowBits = kMaxWindowBits);
+        ~Deflater();
+
+        Deflater(const Deflater&) = delete;
+        Deflater& operator = (const Deflater&) = delete;
+
+        bool IsValid() const;
+        Format GetFormat() const;
+        int GetLevel() const;
+
+        // Bound returns the largest output a message of |length| bytes is compressed to.
+        size_t Bound(size_t length) const;
+
+        // Update compresses from |src| into |dst|, both are advanced past the bytes used.
+        // It returns kStreamEnd once the message is finished by kFinish.
+        Status Update(const char*& src, size_t& srcLength, char*& dst, size_t& dstLength, Flush flush);
+
+        // Compress compresses |length| bytes and appends the output to |out|.
+        bool Compress(const char* data, size_t length, std::string& out, Flush flush = kFinish);
+
+        // SetDictionary primes the window with |data|, e.g. the end of the data before
+        // a block compressed on its own. It is called before any input of a message.
+        bool SetDictionary(const char* data, size_t length);
+
+        void Reset();
+
+    private:
+        std::unique_ptr<z_stream_s> m_stream;
+        Format m_format;
+        int m_level;
+        bool m_valid;
+    };
+
+    // Inflater decompresses a stream incrementally, it is kept between messages like Deflater.
+    class Inflater
+    {
+    public:
+        explicit Inflater(Format format = kGzip, int windowBits = kMaxWindowBits);
+        ~Inflater();
+
+        Inflater(const Inflater&) = delete;
+        Inflater& operator = (const Inflater&) = delete;
+
+        bool IsValid() const;
+        Format GetFormat() const;
+
+        // IsFinished returns whether the end of the compressed message has been reached.
+        // The input after it is ignored until Reset, except that of further gzip members.
+        bool IsFinished() const;
+
+        // SetLimits bounds the output of Inflate until the next Reset, none by default.
+        void SetLimits(const Limits& limits);
+        // IsTooLarge returns whether Inflate has stopped at the limits.
+        bool IsTooLarge() const;
+
+        // Update decompresses from |src| into |dst|, both are advanced past the bytes used.
+        // It returns kStreamEnd at the end of the message, or of a gzip member.
+        Status Update(const char*& src, size_t& srcLength, char*& dst, size_t& dstLength, Flush flush = kNoFlush);
+
+        // Inflate decompresses |length| bytes, a part of a message, and appends the output
+        // to |out|. The members of a gzip stream are inflated one after another. It stops and
+        // returns false when |out| would grow beyond |maxSize| or the output beyond the limits.
+        bool Inflate(const char* data, size_t length, std::string& out, size_t maxSize = std::string::npos);
+
+        // Reset starts a new message, the limits are kept.
+        void Reset();
+
+    private:
+        // Allowed returns how much more output the limits allow with |length| more input.
+        size_t Allowed(size_t length) const;
+        // NextMember starts the gzip member beginning at |data|, trailing zeros are ignored.
+        bool NextMember(const char* data, size_t length);
+
+        std::unique_ptr<z_stream_s> m_stream;
+        Format m_format;
+        bool m_valid;
+        bool m_finished;
+        bool m_tooLarge;
+        Limits m_limits;
+        uint64_t m_totalIn;
+        uint64_t m_totalOut;
+    };
+
+    void Release(std::unique_ptr<Deflater> stream);
+    void Release(std::unique_ptr<Inflater> stream);
+
+    // Pooled holds a stream leased from the pool of the calling thread, the stream
+    // is reset and put back when the lease is destroyed.
+    template <typename T>
+    class Pooled
+    {
+    public:
+        explicit Pooled(std::unique_ptr<T> stream) : m_stream(std::move(stream)) {}
+        Pooled(Pooled&& other) : m_stream(std::move(other.m_stream)) {}
+        ~Pooled()
+        {
+            if (m_stream)
+                Release(std::move(m_stream));
+        }
+
+        Pooled(const Pooled&) = delete;
+        Pooled& operator = (const Pooled&) = delete;
+
+        T* operator -> () const { return m_stream.get(); }
+        T& operator * () const { return *m_stream; }
+
+    private:
+        std::unique_ptr<T> m_stream;
+    };
+
+    Pooled<Deflater> AcquireDeflater(Format format = kGzip, int level = kDefaultLevel);
+    Pooled<Inflater> AcquireInflater(Format format = kGzip);
+
     size_t GetCompressLength(size_t srcLength);
     size_t Compress(char* dst, size_t dstLength, const char* src, size_t srcLength);
     std::string Compress(const char* data, size_t length);
@@ -36,7 +198,19 @@ namespace zip {
     std::string GCompress(const char* data, size_t length);
     std::string GCompress(const std::string& data);
 
+    // The input of GCompressParallel is split into blocks of this size.
+    const size_t kParallelBlockSize = 128 * 1024;
+
+    // GCompressParallel compresses like GCompress on |threads| threads, 0 for one per core.
+    // The blocks are deflated on their own, with the 32 KiB before each as the dictionary,
+    // and make up one gzip stream. The output does not depend on the number of threads.
+    std::string GCompressParallel(const char* data, size_t length, size_t threads = 0, int level = kDefaultLevel);
+    std::string GCompressParallel(const std::string& data, size_t threads = 0, int level = kDefaultLevel);
+
     size_t GDecompress(char* dst, size_t dstlen, const char* src, size_t srclen);
+    // GDecompress inflates all the members of a gzip stream into |out|, growing it as the
+    // output is produced. It returns false when the data is corrupt or goes beyond |limits|.
+    bool GDecompress(const char* data, size_t length, std::string& out, const Limits& limits);
     std::string GDecompress(const char* data, size_t length);
     std::string GDecompress(const std::string& data);
 
@@ -0,0 +1,486 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/http/access_log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+
+#include "net/base/escape.h"
+
+namespace net {
+namespace http {
+
+namespace {
+
+// A ring holds 256 KB of records, about a thousand requests.
+const size_t kRingSize = 256 * 1024;
+// The strings of a record are cut at 1 KB.
+const size_t kMaxField = 1024;
+
+// A record is its length, the time, duration, bytes and status, then the strings below
+// each after its length.
+enum Field
+{
+    kRemoteAddress,
+    kMethod,
+    kPath,
+    kRawQuery,
+    kProto,
+    kReferer,
+    kUserAgent,
+    kFieldCount
+};
+
+const size_t kFixedSize = 4 + 8 + 8 + 8 + 4;
+const size_t kMaxRecord = kFixedSize + kFieldCount * (2 + kMaxField);
+
+// A batch is written once it exceeds 1 MB.
+const size_t kMaxBatch = 1024 * 1024;
+
+struct Record
+{
+    int64_t Time;
+    int64_t Duration;
+    uint64_t Bytes;
+    uint32_t Status;
+    base::strings::StringPiece Fields[kFieldCount];
+};
+
+void Put(char*& p, const void* value, size_t length)
+{
+    memcpy(p, value, length);
+    p += length;
+}
+
+void PutString(char*& p, base::strings::StringPiece value)
+{
+    uint16_t length = (uint16_t)(value.size() < kMaxField ? value.size() : kMaxField);
+    Put(p, &length, sizeof(length));
+    Put(p, value.data(), length);
+}
+
+// Decode reads the record |data| encodes, its strings point into it.
+void Decode(const char* data, Record& record)
+{
+    const char* p = data + 4;
+    memcpy(&record.Time, p, 8);
+    memcpy(&record.Duration, p + 8, 8);
+    memcpy(&record.Bytes, p + 16, 8);
+    memcpy(&record.Status, p + 24, 4);
+    p += kFixedSize - 4;
+    for (auto& field : record.Fields)
+    {
+        uint16_t length;
+        memcpy(&length, p, sizeof(length));
+        field = base::strings::StringPiece(p + 2, length);
+        p += 2 + length;
+    }
+}
+
+// RemoteHost returns the host of a "host:port" address.
+base::strings::StringPiece RemoteHost(base::strings::StringPiece address)
+{
+    for (size_t i = address.size(); i > 0; --i)
+    {
+        if (address[i - 1] == ':')
+            return address.substr(0, i - 1);
+    }
+    return address;
+}
+
+void AppendNumber(std::string& line, uint64_t value)
+{
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)value);
+    line += buffer;
+}
+
+// AppendTime appends |micros| since the epoch in UTC, as [10/Oct/2000:13:55:36 +0000]
+// or as 2000-10-10T13:55:36.123456Z for JSON.
+void AppendTime(std::string& line, int64_t micros, bool json)
+{
+    time_t seconds = (time_t)(micros / 1000000);
+    struct tm utc;
+#ifdef _WIN32
+    gmtime_s(&utc, &seconds);
+#else
+    gmtime_r(&seconds, &utc);
+#endif
+    char buffer[40];
+    if (json)
+    {
+        size_t length = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+        snprintf(buffer + length, sizeof(buffer) - length, ".%06dZ", (int)(micros % 1000000));
+    }
+    else
+    {
+        strftime(buffer, sizeof(buffer), "[%d/%b/%Y:%H:%M:%S +0000]", &utc);
+    }
+    line += buffer;
+}
+
+// AppendQuoted appends |value| between quotes, escaping the quotes, backslashes and
+// control characters as Apache does, "-" if it is empty.
+void AppendQuoted(std::string& line, base::strings::StringPiece value)
+{
+    line += '"';
+    if (value.empty())
+        line += '-';
+    for (char c : value)
+    {
+        unsigned char u = (unsigned char)c;
+        if (c == '"' || c == '\\')
+        {
+            line += '\\';
+            line += c;
+        }
+        else if (u < 0x20 || u == 0x7f)
+        {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\x%02x", u);
+            line += buffer;
+        }
+        else
+        {
+            line += c;
+        }
+    }
+    line += '"';
+}
+
+// AppendJsonString appends |value| as a JSON string, the bytes above 0x7f are kept.
+void AppendJsonString(std::string& line, base::strings::StringPiece value)
+{
+    line += '"';
+    for (char c : value)
+    {
+        unsigned char u = (unsigned char)c;
+        if (c == '"' || c == '\\')
+        {
+            line += '\\';
+            line += c;
+        }
+        else if (u < 0x20)
+        {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", u);
+            line += buffer;
+        }
+        else
+        {
+            line += c;
+        }
+    }
+    line += '"';
+}
+
+std::string RequestUri(const Record& record)
+{
+    std::string uri = base::EscapeUrl(record.Fields[kPath].ToString());
+    if (uri.empty())
+        uri = "/";
+    if (!record.Fields[kRawQuery].empty())
+    {
+        uri += '?';
+        uri.append(record.Fields[kRawQuery].data(), record.Fields[kRawQuery].size());
+    }
+    return uri;
+}
+
+void AppendCommon(std::string& line, const Record& record, bool combined)
+{
+    auto host = RemoteHost(record.Fields[kRemoteAddress]);
+    line.append(host.data(), host.size());
+    line += " - - ";
+    AppendTime(line, record.Time, false);
+    line += ' ';
+    auto& method = record.Fields[kMethod];
+    auto& proto = record.Fields[kProto];
+    AppendQuoted(line, method.ToString() + " " + RequestUri(record) + " " + proto.ToString());
+    line += ' ';
+    AppendNumber(line, record.Status);
+    line += ' ';
+    if (record.Bytes > 0)
+        AppendNumber(line, record.Bytes);
+    else
+        line += '-';
+    if (combined)
+    {
+        line += ' ';
+        AppendQuoted(line, record.Fields[kReferer]);
+        line += ' ';
+        AppendQuoted(line, record.Fields[kUserAgent]);
+    }
+    line += '\n';
+}
+
+void AppendJson(std::string& line, const Record& record)
+{
+    line += "{\"time\":\"";
+    AppendTime(line, record.Time, true);
+    line += "\",\"remote_addr\":";
+    AppendJsonString(line, RemoteHost(record.Fields[kRemoteAddress]));
+    line += ",\"method\":";
+    AppendJsonString(line, record.Fields[kMethod]);
+    line += ",\"uri\":";
+    AppendJsonString(line, RequestUri(record));
+    line += ",\"proto\":";
+    AppendJsonString(line, record.Fields[kProto]);
+    line += ",\"status\":";
+    AppendNumber(line, record.Status);
+    line += ",\"bytes\":";
+    AppendNumber(line, record.Bytes);
+    line += ",\"duration_us\":";
+    AppendNumber(line, (uint64_t)record.Duration);
+    line += ",\"referer\":";
+    AppendJsonString(line, record.Fields[kReferer]);
+    line += ",\"user_agent\":";
+    AppendJsonString(line, record.Fields[kUserAgent]);
+    line += "}\n";
+}
+
+} // !namespace anonymous
+
+// Ring is a single producer, single consumer ring buffer of records: the leaseholder
+// pushes, the thread of the log pops. The positions only grow, they wrap by masking.
+struct AccessLog::Ring
+{
+    Ring()
+        : Buffer(new char[kRingSize])
+        , Head(0)
+        , Tail(0)
+        , Dropped(0)
+    {
+    }
+
+    // Push copies a record in, it returns false if the ring is full.
+    bool Push(const char* record, size_t length)
+    {
+        uint64_t head = Head.load(std::memory_order_relaxed);
+        uint64_t tail = Tail.load(std::memory_order_acquire);
+        if (kRingSize - (size_t)(head - tail) < length)
+        {
+            Dropped.store(Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        Copy(head, record, length);
+        Head.store(head + length, std::memory_order_release);
+        return true;
+    }
+
+    // Pop copies the oldest record out to |record|, it returns false if the ring is empty.
+    bool Pop(char* record)
+    {
+        uint64_t tail = Tail.load(std::memory_order_relaxed);
+        uint64_t head = Head.load(std::memory_order_acquire);
+        if (head == tail)
+            return false;
+        uint32_t length;
+        CopyOut(tail, (char*)&length, sizeof(length));
+        CopyOut(tail, record, length);
+        Tail.store(tail + length, std::memory_order_release);
+        return true;
+    }
+
+    size_t GetSize() const
+    {
+        return (size_t)(Head.load(std::memory_order_relaxed) - Tail.load(std::memory_order_relaxed));
+    }
+
+    void Copy(uint64_t position, const char* data, size_t length)
+    {
+        size_t offset = (size_t)(position & (kRingSize - 1));
+        size_t first = kRingSize - offset < length ? kRingSize - offset : length;
+        memcpy(&Buffer[offset], data, first);
+        memcpy(&Buffer[0], data + first, length - first);
+    }
+
+    void CopyOut(uint64_t position, char* data, size_t length)
+    {
+        size_t offset = (size_t)(position & (kRingSize - 1));
+        size_t first = kRingSize - offset < length ? kRingSize - offset : length;
+        memcpy(data, &Buffer[offset], first);
+        memcpy(data + first, &Buffer[0], length - first);
+    }
+
+    std::unique_ptr<char[]> Buffer;
+    std::atomic<uint64_t> Head;
+    std::atomic<uint64_t> Tail;
+    std::atomic<uint64_t> Dropped;
+};
+
+AccessLog::AccessLog(Output output, Format format)
+    : m_output(output)
+    , m_format(format)
+    , m_flushInterval(200)
+    , m_halfFull(false)
+{
+    m_thread = std::thread(&AccessLog::Run, this);
+}
+
+AccessLog::~AccessLog()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_wakeup.notify_one();
+    m_thread.join();
+}
+
+std::shared_ptr<AccessLog> AccessLog::Create(const std::string & path, Format format /*= kCombined*/)
+{
+    auto file = std::make_shared<std::ofstream>(path, std::ios::out | std::ios::app | std::ios::binary);
+    if (!file->is_open())
+        return nullptr;
+    return Create([file](const std::string& lines) {
+        file->write(lines.data(), lines.size());
+        file->flush();
+    }, format);
+}
+
+std::shared_ptr<AccessLog> AccessLog::Create(Output output, Format format /*= kCombined*/)
+{
+    if (!output)
+        return nullptr;
+    return std::shared_ptr<AccessLog>(new AccessLog(output, format));
+}
+
+void AccessLog::Log(const Request & request, int statusCode, uint64_t bytesSent, std::chrono::microseconds duration)
+{
+    char record[kMaxRecord];
+    char* p = record + 4;
+    int64_t time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t micros = duration.count();
+    uint32_t status = (uint32_t)statusCode;
+    Put(p, &time, sizeof(time));
+    Put(p, &micros, sizeof(micros));
+    Put(p, &bytesSent, sizeof(bytesSent));
+    Put(p, &status, sizeof(status));
+
+    auto& url = request.GetUrl();
+    PutString(p, request.GetRemoteAddress());
+    PutString(p, request.GetMethod());
+    PutString(p, url.GetPath());
+    PutString(p, url.GetRawQuery());
+    PutString(p, request.GetProto());
+    PutString(p, request.GetHeaderView("Referer"));
+    PutString(p, request.GetHeaderView("User-Agent"));
+    uint32_t length = (uint32_t)(p - record);
+    memcpy(record, &length, sizeof(length));
+
+    bool wake = false;
+    {
+        auto ring = m_rings.Acquire();
+        if (ring->Push(record, length))
+            wake = ring->GetSize() > kRingSize / 2;
+    }
+    // Wake the thread up early rather than drop records. The flag keeps the requests
+    // from notifying it again and again until it has drained the rings.
+    if (wake && !m_halfFull.exchange(true))
+        m_wakeup.notify_one();
+}
+
+uint64_t AccessLog::GetDropped() const
+{
+    uint64_t dropped = 0;
+    m_rings.ForEach([&](const Ring& ring) {
+        dropped += ring.Dropped.load(std::memory_order_relaxed);
+    });
+    return dropped;
+}
+
+std::chrono::milliseconds AccessLog::GetFlushInterval() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_flushInterval;
+}
+
+void AccessLog::SetFlushInterval(std::chrono::milliseconds interval)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_flushInterval = interval;
+}
+
+void AccessLog::Flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint64_t request = ++m_flushRequests;
+    m_wakeup.notify_one();
+    m_flushed.wait(lock, [&] { return m_flushedRequests >= request || m_stopped; });
+}
+
+void AccessLog::Run()
+{
+    std::string lines;
+    while (true)
+    {
+        uint64_t requests;
+        bool stopped;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeup.wait_for(lock, m_flushInterval, [this] {
+                return m_stopped || m_flushRequests != m_flushedRequests || m_halfFull.load();
+            });
+            requests = m_flushRequests;
+            stopped = m_stopped;
+        }
+        m_halfFull.store(false);
+        Drain(lines);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_flushedRequests = requests;
+        }
+        m_flushed.notify_all();
+        if (stopped)
+            break;
+    }
+}
+
+void AccessLog::Drain(std::string & lines)
+{
+    std::unique_ptr<char[]> buffer(new char[kMaxRecord]);
+    Record record;
+    lines.clear();
+    m_rings.ForEach([&](Ring& ring) {
+        while (ring.Pop(buffer.get()))
+        {
+            Decode(buffer.get(), record);
+            if (m_format == kJson)
+                AppendJson(lines, record);
+            else
+                AppendCommon(lines, record, m_format == kCombined);
+            if (lines.size() >= kMaxBatch)
+            {
+                m_output(lines);
+                lines.clear();
+            }
+        }
+    });
+    if (!lines.empty())
+        m_output(lines);
+    lines.clear();
+}
+
+} // !namespace http
+} // !namespace net
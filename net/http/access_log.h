@@ -0,0 +1,109 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "net/base/lease_pool.h"
+#include "net/http/request.h"
+
+namespace net {
+namespace http {
+
+// AccessLog writes a line for every request a server serves, away from the requests:
+// Log encodes the request into a compact binary record and pushes it into a ring
+// buffer, a thread of the log formats the records and writes them in batches. The
+// requests never wait for the log, a record which doesn't fit in its ring is dropped
+// and counted.
+class AccessLog
+{
+public:
+    enum Format
+    {
+        // The Common Log Format: host - - [time] "request" status bytes.
+        kCommon,
+        // The Common Log Format followed by the "referer" and the "user agent".
+        kCombined,
+        // One JSON object a line.
+        kJson
+    };
+
+    // Output writes a batch of lines, on the thread of the log.
+    typedef std::function<void(const std::string& lines)> Output;
+
+    // The records logged so far are written before the log is destroyed.
+    ~AccessLog();
+
+protected:
+    AccessLog(Output output, Format format);
+
+public:
+    // Create appends the lines to the file at |path|, it returns nullptr if the file
+    // can't be opened.
+    static std::shared_ptr<AccessLog> Create(const std::string& path, Format format = kCombined);
+    static std::shared_ptr<AccessLog> Create(Output output, Format format = kCombined);
+
+    // Log records a request which has been answered with |statusCode| and |bytesSent|
+    // bytes in |duration|, it never blocks.
+    void Log(const Request& request, int statusCode, uint64_t bytesSent, std::chrono::microseconds duration);
+
+    // GetDropped returns the number of records dropped because their ring was full.
+    uint64_t GetDropped() const;
+
+    // The records are written every FlushInterval, 200 ms by default, or earlier when
+    // a ring is half full.
+    std::chrono::milliseconds GetFlushInterval() const;
+    void SetFlushInterval(std::chrono::milliseconds interval);
+
+    // Flush returns once the records logged before it are written.
+    void Flush();
+
+private:
+    struct Ring;
+
+    void Run();
+    // Drain formats the records of all the rings and writes them.
+    void Drain(std::string& lines);
+
+private:
+    Output m_output;
+    Format m_format;
+    base::LeasePool<Ring> m_rings;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::condition_variable m_flushed;
+    std::chrono::milliseconds m_flushInterval;
+    std::atomic<bool> m_halfFull;
+    uint64_t m_flushRequests = 0;
+    uint64_t m_flushedRequests = 0;
+    bool m_stopped = false;
+    std::thread m_thread;
+};
+
+} // !namespace http
+} // !namespace net
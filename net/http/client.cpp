@@ -16,6 +16,7 @@
 // WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
 // 
 
+#include "net/base/timer_wheel.h"
 #include "net/base/zip.h"
 #include "net/http/client.h"
 #include "net/http/status.h"
@@ -109,7 +110,9 @@ std::string RequestHeaders(std::shared_ptr<Request> request)
 {
     if (!request->GetUrl().GetUser().empty())
         request->SetBasicAuth(request->GetUrl().GetUser(), request->GetUrl().GetPassword());
-    auto headers = request->GetHeaders();
+    if (!request->GetBodyView().empty() && request->GetHeaderView("Content-Length").empty())
+        request->SetHeader("Content-Length", std::to_string(request->GetBodyView().length()));
+    auto& headers = request->GetHeadersView();
     std::string result;
     for (auto iter = headers.begin(); iter != headers.end(); ++iter)
     {
@@ -120,18 +123,22 @@ std::string RequestHeaders(std::shared_ptr<Request> request)
 
 bool IsIpV4(const std::string& host)
 {
-    auto vlist = base::strings::Split(host, ".");
-    if (vlist.size() != 4)
-        return false;
-    for (size_t i = 0; i < vlist.size(); ++i)
+    int count = 0;
+    for (auto part : base::strings::SplitPieces(host, "."))
     {
-        if (!base::strings::IsDigit(vlist[i]))
-            return false;
-        auto value = std::stoi(vlist[i]);
-        if (value < 0 || value > 255)
+        if (++count > 4 || part.empty())
             return false;
+        int value = 0;
+        for (char c : part)
+        {
+            if (!base::strings::IsDigit(c))
+                return false;
+            value = value * 10 + (c - '0');
+            if (value > 255)
+                return false;
+        }
     }
-    return true;
+    return count == 4;
 }
 
 } // !namespace anonymous
@@ -141,6 +148,12 @@ std::shared_ptr<Client> Client::Create(const std::chrono::seconds timeout /*= st
     return std::shared_ptr<Client>(new Client(timeout));
 }
 
+Client::~Client()
+{
+    for (auto& kv : m_http2Connections)
+        kv.second->Close();
+}
+
 std::shared_ptr<Response> Client::Do(std::shared_ptr<Request> request)
 {
     if (!request)
@@ -185,12 +198,30 @@ std::shared_ptr<Response> Client::PostForm(const std::string & url, const Values
     return Post(url, "application/x-www-form-urlencoded", ValuesToString(data));
 }
 
+bool Client::GetHttp2() const
+{
+    return m_http2;
+}
+
+void Client::SetHttp2(bool enable)
+{
+    m_http2 = enable;
+}
+
+std::chrono::milliseconds Client::GetRequestTimeout() const
+{
+    return m_requestTimeout;
+}
+
+void Client::SetRequestTimeout(std::chrono::milliseconds timeout)
+{
+    m_requestTimeout = timeout;
+}
+
 std::shared_ptr<Response> Client::Send(std::shared_ptr<Request> request)
 {
     if (!request)
         return nullptr;
-    std::string message;
-    message = RequestLine(request) + RequestHeaders(request) + "\r\n" + request->GetBody();
     std::string host = request->GetUrl().GetHost();
     if (!IsIpV4(host))
     {
@@ -201,6 +232,28 @@ std::shared_ptr<Response> Client::Send(std::shared_ptr<Request> request)
         host = inet_ntoa(*addr_list[0]);
     }
     uint16_t port = (uint16_t)request->GetUrl().GetPort();
+
+    if (m_http2)
+    {
+        // A request the server has not processed, e.g. when the connection is
+        // going away, is sent once more on a new connection.
+        for (int i = 0; i < 2; ++i)
+        {
+            auto conn = GetHttp2Connection(host, port);
+            if (!conn)
+                break;
+            bool retry = false;
+            auto response = conn->RoundTrip(request, retry);
+            if (response || !retry)
+                return response;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string message;
+    message = RequestLine(request) + RequestHeaders(request) + "\r\n";
+    auto body = request->GetBodyView();
+    message.append(body.data(), body.size());
     do 
     {
         SocketAddress remoteAddress;
@@ -217,7 +270,12 @@ std::shared_ptr<Response> Client::Send(std::shared_ptr<Request> request)
         m_connection.SetNoDelay(true);
         m_reader.Reset(&m_connection);
     } while (0);
-    
+
+    // The copy shares the socket of the connection.
+    StreamSocket connection = m_connection;
+    base::Deadline deadline([connection]() mutable { connection.Shutdown(); });
+    deadline.Reset(m_requestTimeout);
+
     int len = m_connection.Send((const void*)message.c_str(), message.length());
     if (len != (int)message.length())
     {
@@ -225,7 +283,14 @@ std::shared_ptr<Response> Client::Send(std::shared_ptr<Request> request)
         return nullptr;
     }
 
-    return ResponseReceived(request);
+    auto response = ResponseReceived(request);
+    deadline.Cancel();
+    if (deadline.Expired())
+    {
+        m_connection.Close();
+        return nullptr;
+    }
+    return response;
 }
 
 std::shared_ptr<Response> Client::DoFollowingRedirects(std::shared_ptr<Request> request)
@@ -265,33 +330,71 @@ std::shared_ptr<Response> Client::DoFollowingRedirects(std::shared_ptr<Request>
     return response;
 }
 
+std::shared_ptr<Http2ClientConnection> Client::GetHttp2Connection(const std::string & host, uint16_t port)
+{
+    std::string key = host + ":" + std::to_string(port);
+    {
+        std::lock_guard<std::mutex> lock(m_http2Mutex);
+        if (m_http1Servers.find(key) != m_http1Servers.end())
+            return nullptr;
+        auto iter = m_http2Connections.find(key);
+        if (iter != m_http2Connections.end() && !iter->second->IsClosed())
+            return iter->second;
+    }
+
+    // The lock is not held while connecting, so that requests to other servers
+    // are not blocked by a slow one.
+    auto s = std::make_shared<StreamSocket>();
+    if (!s->Connect(SocketAddress(host, port), m_timeout))
+        return nullptr;
+    s->SetNoDelay(true);
+    auto conn = Http2ClientConnection::Create(s);
+    bool started = conn->Start(m_timeout);
+
+    std::lock_guard<std::mutex> lock(m_http2Mutex);
+    if (!started)
+    {
+        m_http1Servers.insert(key);
+        return nullptr;
+    }
+    // Another request may have connected to the same server meanwhile.
+    auto iter = m_http2Connections.find(key);
+    if (iter != m_http2Connections.end() && !iter->second->IsClosed())
+    {
+        conn->Close();
+        return iter->second;
+    }
+    m_http2Connections[key] = conn;
+    return conn;
+}
+
 std::shared_ptr<net::http::Response> Client::ResponseReceived(std::shared_ptr<Request> request)
 {
     std::shared_ptr<Response> response;
 
     std::string requestLine = m_reader.ExtractStartLine();
-    auto vlist = base::strings::SplitN(requestLine, " ", 3);
+    auto vlist = base::strings::SplitPiecesN<3>(requestLine, " ");
     if (vlist.size() != 3)
         return nullptr;
 
     // Parse the start line.
-    auto proto = base::strings::Split(vlist[0], "/");
+    auto proto = base::strings::SplitPiecesN<3>(vlist[0], "/");
     if (proto.size() != 2)
         return nullptr;
 
     try
     {
-        auto protoNumber = base::strings::Split(proto[1], ".");
-        int protoMajor = std::stoi(protoNumber[0]);
+        auto protoNumber = base::strings::SplitPiecesN<3>(proto[1], ".");
+        int protoMajor = std::stoi(protoNumber[0].ToString());
         int protoMinor = 0;
         if (protoNumber.size() == 2)
-            protoMinor = std::stoi(protoNumber[1]);
+            protoMinor = std::stoi(protoNumber[1].ToString());
 
         response = Response::Create();
         response->SetRequest(request);
         response->SetProto(protoMajor, protoMinor);
-        response->SetStatusCode(std::stoi(vlist[1]));
-        response->SetStatus(vlist[2]);
+        response->SetStatusCode(std::stoi(vlist[1].ToString()));
+        response->SetStatus(vlist[2].ToString());
     }
     catch (...)
     {
@@ -303,12 +406,12 @@ std::shared_ptr<net::http::Response> Client::ResponseReceived(std::shared_ptr<Re
     auto headers = m_reader.ExtractHeaders(error);
     if (error)
         return nullptr;
-    for (auto h : headers)
+    for (auto& h : headers)
     {
-        auto kv = base::strings::SplitN(h, ":", 2);
+        auto kv = base::strings::SplitPiecesN<2>(h, ":");
         if (kv.size() != 2)
             continue;
-        response->SetHeader(base::strings::TrimSpace(kv[0]), base::strings::TrimSpace(kv[1]));
+        response->SetHeader(base::strings::TrimSpace(kv[0]).ToString(), base::strings::TrimSpace(kv[1]).ToString());
     }
 
     // Extract response body.
@@ -325,7 +428,8 @@ std::shared_ptr<net::http::Response> Client::ResponseReceived(std::shared_ptr<Re
         }
 
         // Normal message.
-        m_reader.ExtractContentMessage(response);
+        if (!m_reader.ExtractContentMessage(response))
+            return nullptr;
 
     } while (0);
 
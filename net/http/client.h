@@ -18,8 +18,13 @@
 
 #pragma once
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <string>
 
+#include "net/http/http2_client.h"
 #include "net/http/reader.h"
 #include "net/http/request.h"
 #include "net/http/response.h"
@@ -28,10 +33,12 @@
 namespace net {
 namespace http {
 
+// Client may be used by many threads. With HTTP/1.1 their requests are sent one
+// at a time, with HTTP/2 they are multiplexed on one connection per server.
 class Client
 {
 public:
-    ~Client() {}
+    ~Client();
 
     // Create makes an instance of Client
     // |timeout| represents the socket connect timeout.
@@ -54,6 +61,18 @@ public:
     // PostForm sends the key-value pairs to a server.
     std::shared_ptr<Response> PostForm(const std::string& url, const Values& data);
 
+    // SetHttp2 makes the client talk HTTP/2 to the servers with prior knowledge (h2c).
+    // A server which does not accept the HTTP/2 connection preface is remembered
+    // and talked to over HTTP/1.1. It is disabled by default.
+    bool GetHttp2() const;
+    void SetHttp2(bool enable);
+
+    // RequestTimeout bounds an HTTP/1.1 request from sending it to receiving its
+    // whole response, the connection is shut down when it passes. 0, the default,
+    // disables it.
+    std::chrono::milliseconds GetRequestTimeout() const;
+    void SetRequestTimeout(std::chrono::milliseconds timeout);
+
 private:
     Client(const std::chrono::seconds timeout) : m_timeout(timeout) {}
 
@@ -61,10 +80,22 @@ private:
     std::shared_ptr<Response> DoFollowingRedirects(std::shared_ptr<Request> request);
     std::shared_ptr<Response> ResponseReceived(std::shared_ptr<Request> request);
 
+    // GetHttp2Connection returns the HTTP/2 connection to a server, or nullptr
+    // if HTTP/1.1 should be used.
+    std::shared_ptr<Http2ClientConnection> GetHttp2Connection(const std::string& host, uint16_t port);
+
 private:
     StreamSocket m_connection;
     std::chrono::seconds m_timeout;
+    std::chrono::milliseconds m_requestTimeout = std::chrono::milliseconds(0);
     Reader m_reader;
+    std::mutex m_mutex;
+
+    bool m_http2 = false;
+    std::mutex m_http2Mutex;
+    // Keyed by "host:port".
+    std::map<std::string, std::shared_ptr<Http2ClientConnection>> m_http2Connections;
+    std::set<std::string> m_http1Servers;
 };
 
 } // !namespace http
@@ -75,6 +75,11 @@ void CommonRequestResponse::SetHeader(const Header & header)
     m_header = header;
 }
 
+void CommonRequestResponse::SetHeader(Header && header)
+{
+    m_header = std::move(header);
+}
+
 void CommonRequestResponse::SetHeader(const std::string & key, const std::string & value)
 {
     auto validKey = base::strings::TrimSpace(key);
@@ -93,6 +98,26 @@ void CommonRequestResponse::SetHeader(const std::string & key, const std::string
     }
 }
 
+base::strings::StringPiece CommonRequestResponse::GetHeaderView(const std::string & key) const
+{
+    auto v = m_header.find(key);
+    if (v == m_header.end())
+    {
+        return base::strings::StringPiece();
+    }
+    return v->second;
+}
+
+const Header & CommonRequestResponse::GetHeadersView() const
+{
+    return m_header;
+}
+
+base::strings::StringPiece CommonRequestResponse::GetBodyView() const
+{
+    return m_body;
+}
+
 std::string CommonRequestResponse::GetBody() const
 {
     return m_body;
@@ -101,6 +126,21 @@ std::string CommonRequestResponse::GetBody() const
 void CommonRequestResponse::SetBody(const std::string & body)
 {
     m_body = body;
+    ++m_bodyGeneration;
+}
+
+void CommonRequestResponse::SetBody(std::string && body)
+{
+    m_body = std::move(body);
+    ++m_bodyGeneration;
+}
+
+std::string CommonRequestResponse::TakeBody()
+{
+    std::string body;
+    body.swap(m_body);
+    ++m_bodyGeneration;
+    return body;
 }
 
 } // !namespace http
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "net/base/strings/string_piece.h"
 #include "net/http/httpdefs.h"
 
 namespace net {
@@ -36,10 +37,22 @@ public:
     std::vector<std::string> GetHeaders(const std::string& key) const;
     Header GetHeaders() const;
     void SetHeader(const Header& header);
+    void SetHeader(Header&& header);
     void SetHeader(const std::string& key, const std::string& value);
 
+    // The views don't copy, they are valid until the header or the body is changed.
+    // GetHeaderView returns the first value of |key|, empty if it is not present.
+    base::strings::StringPiece GetHeaderView(const std::string& key) const;
+    const Header& GetHeadersView() const;
+    base::strings::StringPiece GetBodyView() const;
+
     std::string GetBody() const;
     void SetBody(const std::string& body);
+    void SetBody(std::string&& body);
+
+    // TakeBody moves the body out and leaves it empty, e.g. to keep a large upload
+    // without copying it.
+    std::string TakeBody();
 
 protected:
     int m_protoMajor = 1;
@@ -47,6 +60,9 @@ protected:
     bool m_close = false;
     Header m_header;
     std::string m_body;
+    // m_bodyGeneration changes whenever the body is replaced, so that what is derived
+    // from the body can tell it is stale.
+    unsigned int m_bodyGeneration = 0;
 };
 
 } // !namespace http
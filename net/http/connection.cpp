@@ -24,16 +24,57 @@
 namespace net {
 namespace http {
 
+namespace {
+
+// ConnectionWriter hands the bytes read after the request over with the connection.
+class ConnectionWriter
+    : public Writer
+{
+public:
+    ConnectionWriter(std::shared_ptr<StreamSocket> s, Reader* reader)
+        : Writer(s)
+        , m_reader(reader)
+    {
+    }
+
+    std::shared_ptr<StreamSocket> Hijack(std::string& buffered) override
+    {
+        auto s = Writer::Hijack(buffered);
+        if (s)
+            buffered = m_reader->TakeBufferedBytes();
+        return s;
+    }
+
+private:
+    Reader* m_reader;
+};
+
+} // !namespace anonymous
+
 Connection::Connection(std::shared_ptr<StreamSocket> s)
     : m_streamSocket(s)
+    , m_writer(std::make_shared<ConnectionWriter>(s, &m_reader))
 {
     m_reader.Reset(s.get());
 }
 
 std::shared_ptr<Request> Connection::ReadRequest()
+{
+    auto request = ReadRequestHeader();
+    if (request && !ReadRequestBody(request))
+        return nullptr;
+    return request;
+}
+
+std::shared_ptr<Request> Connection::ReadRequestHeader()
 {
     auto startLine = m_reader.ExtractStartLine();
-    auto spList = base::strings::SplitN(startLine, " ", 3);
+    if (startLine == "PRI * HTTP/2.0")
+    {
+        m_http2Preface = true;
+        return nullptr;
+    }
+    auto spList = base::strings::SplitPiecesN<3>(startLine, " ");
     if (spList.size() != 3)
         return nullptr;
     
@@ -50,24 +91,123 @@ std::shared_ptr<Request> Connection::ReadRequest()
     if (h.end() == hostIter)
         return nullptr;
 
+    // The last request is reused if nobody else holds it.
+    Recycle();
+    if (m_request.use_count() != 1)
+        m_request = std::make_shared<Request>();
+    auto request = m_request;
+    if (!m_recycling)
+        m_request.reset();
+
     // Currently, we just support http scheme.
-    auto request = Request::Create(spList[0], "http://" + hostIter->second + spList[1]);
-    if (!request)
+    std::string rawUrl = "http://" + hostIter->second;
+    rawUrl.append(spList[1].data(), spList[1].size());
+    if (!request->Reset(spList[0].ToString(), rawUrl))
         return nullptr;
-    request->SetHeader(h);
-
-    Values formValues;
-    auto query = request->GetUrl().GetRawQuery();
-    ParseQueryForm(query, formValues);
-    request->SetFormValues(formValues);
-
-    m_reader.ExtractRequestMessage(request);
+    request->SetHeader(std::move(h));
+    if (spList[2] == "HTTP/1.0")
+        request->SetProto(1, 0);
 
     auto remoteAddress = m_streamSocket->GetForeignAddress();
-    request->SetRemoteAddress(remoteAddress.GetHost() + std::to_string(remoteAddress.GetPort()));
+    request->SetRemoteAddress(remoteAddress.GetHost() + ":" + std::to_string(remoteAddress.GetPort()));
 
     return request;
 }
 
+bool Connection::ReadRequestBody(std::shared_ptr<Request> request)
+{
+    return m_reader.ExtractRequestMessage(request);
+}
+
+void Connection::SetMaxBodySize(size_t size)
+{
+    m_reader.SetMaxBodySize(size);
+}
+
+std::shared_ptr<Context> Connection::NewContext(std::shared_ptr<Request> request)
+{
+    // The response is held back only while the next request is already waiting,
+    // otherwise a handler which writes and then blocks, e.g. a long poll, would
+    // stall with its data unsent. Switching back sends the held responses first.
+    m_writer->SetBuffered(HasBufferedRequest());
+    if (!m_recycling)
+        return Context::Create(m_writer, request);
+    if (m_context.use_count() == 1)
+        m_context->Reset(m_writer, request);
+    else
+        m_context = Context::Create(m_writer, request);
+    return m_context;
+}
+
+bool Connection::IsRecycling() const
+{
+    return m_recycling;
+}
+
+void Connection::SetRecycling(bool recycling)
+{
+    m_recycling = recycling;
+    if (!recycling)
+    {
+        m_request.reset();
+        m_context.reset();
+    }
+}
+
+void Connection::Recycle()
+{
+    // A context the handler still holds, e.g. in a thread it has started, is left to it
+    // with its request.
+    if (m_context.use_count() == 1)
+        m_context->Reset();
+    else
+        m_context.reset();
+}
+
+bool Connection::WaitForRequest()
+{
+    return m_reader.WaitForData();
+}
+
+bool Connection::IsHttp2Preface() const
+{
+    return m_http2Preface;
+}
+
+std::string Connection::TakeBufferedBytes()
+{
+    return m_reader.TakeBufferedBytes();
+}
+
+bool Connection::HasBufferedRequest() const
+{
+    return m_reader.HasBufferedHeaders();
+}
+
+std::shared_ptr<Writer> Connection::GetWriter() const
+{
+    return m_writer;
+}
+
+bool Connection::Flush()
+{
+    return m_writer->Flush();
+}
+
+uint64_t Connection::GetBytesReceived() const
+{
+    return m_reader.GetBytesReceived();
+}
+
+uint64_t Connection::GetBytesSent() const
+{
+    return m_writer->GetBytesSent() + m_writer->GetBufferedBytes();
+}
+
+bool Connection::IsHijacked() const
+{
+    return m_writer->IsHijacked();
+}
+
 } // !namespace http
 } // !namespace net
\ No newline at end of file
@@ -18,8 +18,10 @@
 
 #pragma once
 
+#include "net/http/context.h"
 #include "net/http/reader.h"
 #include "net/http/request.h"
+#include "net/http/writer.h"
 #include "net/socket/StreamSocket.h"
 
 namespace net {
@@ -33,9 +35,67 @@ public:
 
     std::shared_ptr<Request> ReadRequest();
 
+    // ReadRequest in two steps, so that the header and the body of a request
+    // may have their own deadlines.
+    std::shared_ptr<Request> ReadRequestHeader();
+    // ReadRequestBody returns false if the body is larger than allowed or incomplete,
+    // the connection can't be used for another request then.
+    bool ReadRequestBody(std::shared_ptr<Request> request);
+
+    // SetMaxBodySize bounds the body of the requests, 0 for no limit.
+    void SetMaxBodySize(size_t size);
+
+    // NewContext returns the context serving |request| on this connection.
+    std::shared_ptr<Context> NewContext(std::shared_ptr<Request> request);
+
+    // The request, response and context of the last request are recycled for the next one
+    // unless the handler still holds them, so that they and the capacity of their strings
+    // are not allocated again for every request. It is enabled by default.
+    bool IsRecycling() const;
+    void SetRecycling(bool recycling);
+
+    // WaitForRequest blocks until the first bytes of the next request are received,
+    // it returns false if the connection is closed.
+    bool WaitForRequest();
+
+    // IsHttp2Preface returns whether ReadRequest has stopped at the HTTP/2 client
+    // connection preface, whose first line "PRI * HTTP/2.0" has been consumed.
+    bool IsHttp2Preface() const;
+
+    // TakeBufferedBytes returns the bytes received after the last request.
+    std::string TakeBufferedBytes();
+
+    // HasBufferedRequest returns whether the next pipelined request has already
+    // been received, i.e. ReadRequest will not block waiting for its headers.
+    bool HasBufferedRequest() const;
+
+    // While the next pipelined request has already been received, the response is
+    // buffered in the writer, so that the responses of pipelined requests can be sent
+    // together. The other responses are sent as they are written. The caller flushes
+    // the writer before waiting for the next request.
+    std::shared_ptr<Writer> GetWriter() const;
+    bool Flush();
+
+    // The bytes received and sent on the connection so far, the sent ones include
+    // those buffered in the writer.
+    uint64_t GetBytesReceived() const;
+    uint64_t GetBytesSent() const;
+
+    // IsHijacked returns whether a handler has taken the connection over.
+    bool IsHijacked() const;
+
+private:
+    // Recycle releases the last request from the context kept for reuse.
+    void Recycle();
+
 private:
     std::shared_ptr<StreamSocket> m_streamSocket;
     Reader m_reader;
+    std::shared_ptr<Writer> m_writer;
+    bool m_http2Preface = false;
+    bool m_recycling = true;
+    std::shared_ptr<Request> m_request;
+    std::shared_ptr<Context> m_context;
 };
 
 } // !namespace http
@@ -23,8 +23,8 @@
 namespace net {
 namespace http {
 
-Context::Context(std::shared_ptr<StreamSocket> connection, std::shared_ptr<Request> request)
-    : m_connection(connection)
+Context::Context(std::shared_ptr<ResponseWriter> writer, std::shared_ptr<Request> request)
+    : m_writer(writer)
 {
     m_response = Response::Create();
     m_response->SetRequest(request);
@@ -32,7 +32,26 @@ Context::Context(std::shared_ptr<StreamSocket> connection, std::shared_ptr<Reque
 
 std::shared_ptr<Context> Context::Create(std::shared_ptr<StreamSocket> connection, std::shared_ptr<Request> request)
 {
-    return std::shared_ptr<Context>(new Context(connection, request));
+    return Create(std::make_shared<Writer>(connection), request);
+}
+
+std::shared_ptr<Context> Context::Create(std::shared_ptr<ResponseWriter> writer, std::shared_ptr<Request> request)
+{
+    return std::shared_ptr<Context>(new Context(writer, request));
+}
+
+void Context::Reset(
+    std::shared_ptr<ResponseWriter> writer /*= nullptr*/,
+    std::shared_ptr<Request> request /*= nullptr*/)
+{
+    m_writer = writer;
+    if (m_response.use_count() == 1)
+        m_response->Reset();
+    else
+        m_response = Response::Create();
+    m_response->SetRequest(request);
+    m_wroteHeader = false;
+    m_hijacked = false;
 }
 
 std::shared_ptr<Request> Context::GetRequest() const
@@ -47,52 +66,88 @@ std::shared_ptr<Response> Context::GetResponse() const
 
 int Context::WriteHeader()
 {
-    if (!m_connection)
+    if (!m_writer)
         return -1;
 
-    std::string message = m_response->GetProto() + " ";
-    message += std::to_string(m_response->GetStatusCode()) + " ";
-    message += m_response->GetStatus() + "\r\n";
-
-    auto headers = m_response->GetHeaders();
-    for (auto iter = headers.begin(); iter != headers.end(); ++iter)
-    {
-        message += iter->first + ": " + iter->second + "\r\n";
-    }
-    message += "\r\n";
-    int len = m_connection->Send(message.c_str(), message.length());
-    if (len == (int)message.length())
+    int len = m_writer->WriteHeader(*m_response, nullptr, 0);
+    if (len >= 0)
         m_wroteHeader = true;
     return len;
 }
 
 int Context::Write(const void * buffer, int length)
 {
-    return Write(std::string((const char*)buffer, length));
+    if (!m_writer || length < 0)
+        return -1;
+
+    if (m_wroteHeader)
+        return m_writer->Write(buffer, length);
+
+    m_response->SetHeader("Content-Length", std::to_string(length));
+    int len = m_writer->WriteHeader(*m_response, buffer, length);
+    if (len >= 0)
+        m_wroteHeader = true;
+    return len;
 }
 
 int Context::Write(const std::string & buffer)
 {
-    if (!m_connection)
+    return Write(buffer.data(), (int)buffer.length());
+}
+
+bool Context::Flush()
+{
+    if (!m_writer)
+        return false;
+    return m_writer->Flush();
+}
+
+int Context::WriteUnbuffered(const void * buffer, int length)
+{
+    if (!m_writer || !m_wroteHeader || length < 0)
         return -1;
+    return m_writer->WriteUnbuffered(buffer, length);
+}
+
+int Context::WriteUnbuffered(const std::string & buffer)
+{
+    return WriteUnbuffered(buffer.data(), (int)buffer.length());
+}
 
-    std::string message;
+void Context::Finish()
+{
+    if (m_hijacked)
+        return;
     if (!m_wroteHeader)
-    {
-        message = m_response->GetProto() + " ";
-        message += std::to_string(m_response->GetStatusCode()) + " ";
-        message += m_response->GetStatus() + "\r\n";
-
-        m_response->SetHeader("Content-Length", std::to_string(buffer.length()));
-        auto headers = m_response->GetHeaders();
-        for (auto iter = headers.begin(); iter != headers.end(); ++iter)
-        {
-            message += iter->first + ": " + iter->second + "\r\n";
-        }
-        message += "\r\n";
-    }
-    message += buffer;
-    return m_connection->Send(message.c_str(), message.length());
+        Write("");
+    if (m_writer)
+        m_writer->Finish();
+}
+
+bool Context::StartEventStream()
+{
+    if (m_wroteHeader)
+        return false;
+    m_response->SetHeader("Content-Type", "text/event-stream");
+    m_response->SetHeader("Cache-Control", "no-cache");
+    // An HTTP/1.x body without a length ends with the connection.
+    m_response->SetHeader("Connection", "close");
+    return WriteHeader() >= 0 && Flush();
+}
+
+bool Context::WriteEvent(const ServerSentEvent & event)
+{
+    return Write(sse::Format(event)) >= 0 && Flush();
+}
+
+std::shared_ptr<StreamSocket> Context::Hijack(std::string & buffered)
+{
+    if (!m_writer || m_hijacked)
+        return nullptr;
+    auto s = m_writer->Hijack(buffered);
+    if (s)
+        m_hijacked = true;
+    return s;
 }
 
 } // !namespace http
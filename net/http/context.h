@@ -18,8 +18,10 @@
 
 #pragma once
 
+#include "net/http/event_stream.h"
 #include "net/http/request.h"
 #include "net/http/response.h"
+#include "net/http/writer.h"
 #include "net/socket/StreamSocket.h"
 
 namespace net {
@@ -32,7 +34,7 @@ public:
 
 private:
     Context(
-        std::shared_ptr<StreamSocket> connection,
+        std::shared_ptr<ResponseWriter> writer,
         std::shared_ptr<Request> request);
 
 public:
@@ -41,6 +43,18 @@ public:
             std::shared_ptr<StreamSocket> connection,
             std::shared_ptr<Request> request);
 
+    // The response will be written through |writer|, which may buffer it.
+    static std::shared_ptr<Context>
+        Create(
+            std::shared_ptr<ResponseWriter> writer,
+            std::shared_ptr<Request> request);
+
+    // Reset makes this context serve |request|, keeping the memory of its response
+    // unless the response is still held elsewhere. Reset() releases the request.
+    void Reset(
+        std::shared_ptr<ResponseWriter> writer = nullptr,
+        std::shared_ptr<Request> request = nullptr);
+
     std::shared_ptr<Request> GetRequest() const;
     std::shared_ptr<Response> GetResponse() const;
 
@@ -48,10 +62,35 @@ public:
     int Write(const void* buffer, int length);
     int Write(const std::string& buffer);
 
+    // Flush sends the buffered response data to the client immediately.
+    bool Flush();
+
+    // WriteUnbuffered sends |buffer| to the client at once, after the buffered data.
+    // The headers must have been written.
+    int WriteUnbuffered(const void* buffer, int length);
+    int WriteUnbuffered(const std::string& buffer);
+
+    // Finish writes an empty response if the handler did not write anything,
+    // so that every request gets exactly one response, and ends the response.
+    void Finish();
+
+    // StartEventStream sends the headers of a text/event-stream response (Server-Sent Events).
+    // The response stays open until the handler returns, the connection is closed then.
+    bool StartEventStream();
+
+    // WriteEvent sends |event| to the client at once.
+    bool WriteEvent(const ServerSentEvent& event);
+
+    // Hijack lets the handler take the connection over, the server will neither read
+    // nor write it anymore. |buffered| receives the bytes received after the request.
+    // It returns nullptr if the connection can't be taken over, e.g. with HTTP/2.
+    std::shared_ptr<StreamSocket> Hijack(std::string& buffered);
+
 private:
-    std::shared_ptr<StreamSocket> m_connection;
+    std::shared_ptr<ResponseWriter> m_writer;
     std::shared_ptr<Response> m_response;
     bool m_wroteHeader = false;
+    bool m_hijacked = false;
 };
 
 } // !namespace http
@@ -0,0 +1,207 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/http/event_stream.h"
+
+#include <vector>
+
+#include "net/http/context.h"
+
+namespace net {
+namespace http {
+
+namespace {
+
+const char kHeartbeat[] = ":\n\n";
+
+// AppendField appends a field, a value can't span lines so it ends at the first line break.
+void AppendField(std::string& out, const char* name, const std::string& value)
+{
+    out += name;
+    out += ": ";
+    out.append(value, 0, value.find_first_of("\r\n"));
+    out += '\n';
+}
+
+} // !namespace anonymous
+
+namespace sse {
+
+std::string Format(const ServerSentEvent & event)
+{
+    std::string out;
+    if (!event.Id.empty())
+        AppendField(out, "id", event.Id);
+    if (!event.Event.empty())
+        AppendField(out, "event", event.Event);
+    if (event.Retry >= 0)
+        out += "retry: " + std::to_string(event.Retry) + "\n";
+
+    // Lines end with CRLF, LF or CR.
+    size_t start = 0;
+    while (true)
+    {
+        size_t end = event.Data.find_first_of("\r\n", start);
+        out += "data: ";
+        out.append(event.Data, start, end == std::string::npos ? std::string::npos : end - start);
+        out += '\n';
+        if (end == std::string::npos)
+            break;
+        start = end + 1;
+        if (event.Data[end] == '\r' && start < event.Data.size() && event.Data[start] == '\n')
+            ++start;
+    }
+    out += '\n';
+    return out;
+}
+
+} // !namespace sse
+
+std::shared_ptr<EventBroadcaster> EventBroadcaster::Create()
+{
+    return std::shared_ptr<EventBroadcaster>(new EventBroadcaster());
+}
+
+size_t EventBroadcaster::GetHighWaterMark() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_highWaterMark;
+}
+
+void EventBroadcaster::SetHighWaterMark(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_highWaterMark = bytes;
+}
+
+std::chrono::seconds EventBroadcaster::GetHeartbeatInterval() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_heartbeatInterval;
+}
+
+void EventBroadcaster::SetHeartbeatInterval(std::chrono::seconds interval)
+{
+    if (interval < std::chrono::seconds(1))
+        interval = std::chrono::seconds(1);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_heartbeatInterval = interval;
+}
+
+size_t EventBroadcaster::GetSubscriberCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_subscribers.size();
+}
+
+size_t EventBroadcaster::Publish(const ServerSentEvent & event)
+{
+    return Publish(std::make_shared<const std::string>(sse::Format(event)));
+}
+
+size_t EventBroadcaster::Publish(EventBuffer buffer)
+{
+    if (!buffer || buffer->empty())
+        return 0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto iter = m_subscribers.begin(); iter != m_subscribers.end();)
+    {
+        auto& subscriber = *iter;
+        if (subscriber->QueuedBytes + buffer->size() > m_highWaterMark)
+        {
+            // Drop the slow subscriber rather than buffering without bound.
+            subscriber->Dropped = true;
+            subscriber->Queue.clear();
+            subscriber->QueuedBytes = 0;
+            subscriber->Ready.notify_one();
+            iter = m_subscribers.erase(iter);
+            continue;
+        }
+        subscriber->Queue.push_back(buffer);
+        subscriber->QueuedBytes += buffer->size();
+        subscriber->Ready.notify_one();
+        ++iter;
+    }
+    return m_subscribers.size();
+}
+
+bool EventBroadcaster::Serve(std::shared_ptr<Context> ctx)
+{
+    if (!ctx->StartEventStream())
+        return false;
+
+    auto subscriber = std::make_shared<Subscriber>();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed)
+            return true;
+        m_subscribers.insert(subscriber);
+    }
+
+    bool ok = true;
+    std::vector<EventBuffer> events;
+    while (true)
+    {
+        events.clear();
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            subscriber->Ready.wait_for(lock, m_heartbeatInterval, [&] {
+                return !subscriber->Queue.empty() || subscriber->Dropped || m_closed;
+            });
+            if (subscriber->Dropped)
+            {
+                ok = false;
+                break;
+            }
+            if (m_closed)
+                break;
+            events.assign(subscriber->Queue.begin(), subscriber->Queue.end());
+            subscriber->Queue.clear();
+            subscriber->QueuedBytes = 0;
+        }
+
+        // The events are sent with the lock released, so that a slow client
+        // only delays its own queue. The shared buffers are sent as they are
+        // rather than copied into the buffer of every subscriber.
+        if (events.empty() && ctx->WriteUnbuffered(kHeartbeat, sizeof(kHeartbeat) - 1) < 0)
+            ok = false;
+        for (size_t i = 0; ok && i < events.size(); ++i)
+        {
+            if (ctx->WriteUnbuffered(*events[i]) < 0)
+                ok = false;
+        }
+        if (!ok)
+            break;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_subscribers.erase(subscriber);
+    return ok;
+}
+
+void EventBroadcaster::Close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    for (auto& subscriber : m_subscribers)
+        subscriber->Ready.notify_one();
+    m_subscribers.clear();
+}
+
+} // !namespace http
+} // !namespace net
@@ -0,0 +1,110 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace net {
+namespace http {
+
+class Context;
+
+// ServerSentEvent is an event of a text/event-stream response (Server-Sent Events).
+// Empty fields are not sent, Retry is sent if not negative.
+struct ServerSentEvent
+{
+    std::string Id;
+    std::string Event;
+    std::string Data;
+    int Retry = -1;
+};
+
+// EventBuffer is a serialized event, shared by all the subscribers it is sent to.
+typedef std::shared_ptr<const std::string> EventBuffer;
+
+namespace sse {
+
+// Format serializes |event|, each line of the data is sent as its own data field.
+std::string Format(const ServerSentEvent& event);
+
+} // !namespace sse
+
+// EventBroadcaster sends the published events to all its subscribers. An event is
+// serialized once and the subscribers queue the same buffer. A subscriber whose queue
+// grows beyond the high-water mark can't keep up and is dropped.
+class EventBroadcaster
+{
+public:
+    ~EventBroadcaster() {}
+
+private:
+    EventBroadcaster() {}
+
+public:
+    static std::shared_ptr<EventBroadcaster> Create();
+
+    // The high-water mark is the number of queued bytes a subscriber may have.
+    size_t GetHighWaterMark() const;
+    void SetHighWaterMark(size_t bytes);
+
+    // A comment is sent to idle subscribers to detect the clients which went away.
+    // An interval below one second is raised to one second.
+    std::chrono::seconds GetHeartbeatInterval() const;
+    void SetHeartbeatInterval(std::chrono::seconds interval);
+
+    size_t GetSubscriberCount() const;
+
+    // Publish queues the event for every subscriber and returns their number.
+    size_t Publish(const ServerSentEvent& event);
+    size_t Publish(EventBuffer buffer);
+
+    // Serve starts the event stream of |ctx| and sends the published events on it
+    // until the client goes away, the subscriber is dropped or the broadcaster is closed.
+    // It is called by the handler and returns false if the subscriber was dropped
+    // or the client went away.
+    bool Serve(std::shared_ptr<Context> ctx);
+
+    // Close ends all the event streams, the later subscribers return at once.
+    void Close();
+
+private:
+    struct Subscriber
+    {
+        std::deque<EventBuffer> Queue;
+        size_t QueuedBytes = 0;
+        bool Dropped = false;
+        std::condition_variable Ready;
+    };
+
+private:
+    mutable std::mutex m_mutex;
+    std::set<std::shared_ptr<Subscriber>> m_subscribers;
+    size_t m_highWaterMark = 1024 * 1024;
+    std::chrono::seconds m_heartbeatInterval = std::chrono::seconds(15);
+    bool m_closed = false;
+};
+
+} // !namespace http
+} // !namespace net
@@ -0,0 +1,116 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/http/form.h"
+
+#include "net/base/escape.h"
+#include "net/base/strings/string_utils.h"
+
+namespace net {
+namespace http {
+
+namespace {
+
+const uint32_t kEmptyBucket = static_cast<uint32_t>(-1);
+
+} // !namespace anonymous
+
+bool FormIndex::Find(StringPiece data, StringPiece key, std::string& value)
+{
+    if (!m_built || data.data() != m_data || data.size() != m_size)
+        Build(data);
+    auto pair = Lookup(key);
+    if (nullptr == pair)
+        return false;
+    value = base::Unescape(pair->Value);
+    return true;
+}
+
+size_t FormIndex::Size(StringPiece data)
+{
+    if (!m_built || data.data() != m_data || data.size() != m_size)
+        Build(data);
+    return m_pairs.size();
+}
+
+void FormIndex::Clear()
+{
+    m_data = nullptr;
+    m_size = 0;
+    m_built = false;
+    m_pairs.clear();
+    m_buckets.clear();
+}
+
+void FormIndex::Build(StringPiece data)
+{
+    Clear();
+    m_data = data.data();
+    m_size = data.size();
+    m_built = true;
+    for (auto kv : base::strings::SplitPieces(data, "&"))
+    {
+        auto pos = kv.find('=');
+        auto key = base::strings::TrimSpace(kv.substr(0, pos));
+        if (key.empty())
+            continue;
+        m_pairs.push_back({ key, pos == StringPiece::npos ? StringPiece() : kv.substr(pos + 1) });
+    }
+    if (m_pairs.size() < kHashThreshold)
+        return;
+
+    // Twice as many buckets as pairs keep the probes short.
+    size_t buckets = 1;
+    while (buckets < 2 * m_pairs.size())
+        buckets <<= 1;
+    m_buckets.assign(buckets, kEmptyBucket);
+    for (uint32_t i = 0; i < m_pairs.size(); ++i)
+    {
+        size_t b = base::strings::HashIgnoreCase(m_pairs[i].Key) & (buckets - 1);
+        while (m_buckets[b] != kEmptyBucket && !base::strings::Equal(m_pairs[m_buckets[b]].Key, m_pairs[i].Key))
+            b = (b + 1) & (buckets - 1);
+        if (m_buckets[b] == kEmptyBucket)
+            m_buckets[b] = i;
+    }
+}
+
+const FormIndex::Pair* FormIndex::Lookup(StringPiece key) const
+{
+    if (m_buckets.empty())
+    {
+        for (auto& pair : m_pairs)
+        {
+            if (base::strings::Equal(pair.Key, key))
+                return &pair;
+        }
+        return nullptr;
+    }
+
+    // The hash ignores case, the keys are still compared exactly.
+    size_t mask = m_buckets.size() - 1;
+    for (size_t b = base::strings::HashIgnoreCase(key) & mask; m_buckets[b] != kEmptyBucket; b = (b + 1) & mask)
+    {
+        auto& pair = m_pairs[m_buckets[b]];
+        if (base::strings::Equal(pair.Key, key))
+            return &pair;
+    }
+    return nullptr;
+}
+
+} // !namespace http
+} // !namespace net
@@ -0,0 +1,73 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "net/base/strings/string_piece.h"
+
+namespace net {
+namespace http {
+
+// FormIndex looks up the values of an application/x-www-form-urlencoded string,
+// e.g. a query string or a POST body, without copying it. The pairs are found by
+// the first lookup and a value is unescaped when it is returned. The keys are
+// hashed once there are kHashThreshold pairs or more.
+//
+// The index refers to the string, it is rebuilt when it is given another one
+// and must be cleared when the memory of the string is reused.
+class FormIndex
+{
+public:
+    typedef base::strings::StringPiece StringPiece;
+
+    static const size_t kHashThreshold = 16;
+
+    // Find sets |value| to the first value of |key| in |data|, the keys are trimmed
+    // like ParseQueryForm does. It returns false if |key| is not present.
+    bool Find(StringPiece data, StringPiece key, std::string& value);
+
+    // Size returns the number of pairs with a key in |data|.
+    size_t Size(StringPiece data);
+
+    // Clear drops the index, keeping its memory.
+    void Clear();
+
+private:
+    struct Pair
+    {
+        StringPiece Key;
+        StringPiece Value;
+    };
+
+    void Build(StringPiece data);
+    const Pair* Lookup(StringPiece key) const;
+
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_built = false;
+    std::vector<Pair> m_pairs;
+    // The index of the first pair of a key, by its hash with linear probing.
+    std::vector<uint32_t> m_buckets;
+};
+
+} // !namespace http
+} // !namespace net
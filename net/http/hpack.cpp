@@ -0,0 +1,640 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/http/hpack.h"
+
+#include <unordered_map>
+
+namespace net {
+namespace http {
+
+namespace {
+
+// The entry size is the sum of its name's length, its value's length and 32 (RFC 7541, 4.1).
+const size_t kEntryOverhead = 32;
+
+// Integers beyond this value are rejected to avoid overflow.
+const uint64_t kMaxInteger = 0xFFFFFFFF;
+
+// The static table (RFC 7541, Appendix A). Index 1 is the first entry.
+const HeaderField kStaticTable[] = {
+    HeaderField(":authority", ""),
+    HeaderField(":method", "GET"),
+    HeaderField(":method", "POST"),
+    HeaderField(":path", "/"),
+    HeaderField(":path", "/index.html"),
+    HeaderField(":scheme", "http"),
+    HeaderField(":scheme", "https"),
+    HeaderField(":status", "200"),
+    HeaderField(":status", "204"),
+    HeaderField(":status", "206"),
+    HeaderField(":status", "304"),
+    HeaderField(":status", "400"),
+    HeaderField(":status", "404"),
+    HeaderField(":status", "500"),
+    HeaderField("accept-charset", ""),
+    HeaderField("accept-encoding", "gzip, deflate"),
+    HeaderField("accept-language", ""),
+    HeaderField("accept-ranges", ""),
+    HeaderField("accept", ""),
+    HeaderField("access-control-allow-origin", ""),
+    HeaderField("age", ""),
+    HeaderField("allow", ""),
+    HeaderField("authorization", ""),
+    HeaderField("cache-control", ""),
+    HeaderField("content-disposition", ""),
+    HeaderField("content-encoding", ""),
+    HeaderField("content-language", ""),
+    HeaderField("content-length", ""),
+    HeaderField("content-location", ""),
+    HeaderField("content-range", ""),
+    HeaderField("content-type", ""),
+    HeaderField("cookie", ""),
+    HeaderField("date", ""),
+    HeaderField("etag", ""),
+    HeaderField("expect", ""),
+    HeaderField("expires", ""),
+    HeaderField("from", ""),
+    HeaderField("host", ""),
+    HeaderField("if-match", ""),
+    HeaderField("if-modified-since", ""),
+    HeaderField("if-none-match", ""),
+    HeaderField("if-range", ""),
+    HeaderField("if-unmodified-since", ""),
+    HeaderField("last-modified", ""),
+    HeaderField("link", ""),
+    HeaderField("location", ""),
+    HeaderField("max-forwards", ""),
+    HeaderField("proxy-authenticate", ""),
+    HeaderField("proxy-authorization", ""),
+    HeaderField("range", ""),
+    HeaderField("referer", ""),
+    HeaderField("refresh", ""),
+    HeaderField("retry-after", ""),
+    HeaderField("server", ""),
+    HeaderField("set-cookie", ""),
+    HeaderField("strict-transport-security", ""),
+    HeaderField("transfer-encoding", ""),
+    HeaderField("user-agent", ""),
+    HeaderField("vary", ""),
+    HeaderField("via", ""),
+    HeaderField("www-authenticate", ""),
+};
+const size_t kStaticTableSize = sizeof(kStaticTable) / sizeof(kStaticTable[0]);
+
+struct HuffmanCode
+{
+    uint32_t Code;
+    int Bits;
+};
+
+// The Huffman code (RFC 7541, Appendix B), indexed by symbol. 256 is EOS.
+const HuffmanCode kHuffmanCodes[257] = {
+    { 0x00001ff8, 13 }, { 0x007fffd8, 23 }, { 0x0fffffe2, 28 }, { 0x0fffffe3, 28 },
+    { 0x0fffffe4, 28 }, { 0x0fffffe5, 28 }, { 0x0fffffe6, 28 }, { 0x0fffffe7, 28 },
+    { 0x0fffffe8, 28 }, { 0x00ffffea, 24 }, { 0x3ffffffc, 30 }, { 0x0fffffe9, 28 },
+    { 0x0fffffea, 28 }, { 0x3ffffffd, 30 }, { 0x0fffffeb, 28 }, { 0x0fffffec, 28 },
+    { 0x0fffffed, 28 }, { 0x0fffffee, 28 }, { 0x0fffffef, 28 }, { 0x0ffffff0, 28 },
+    { 0x0ffffff1, 28 }, { 0x0ffffff2, 28 }, { 0x3ffffffe, 30 }, { 0x0ffffff3, 28 },
+    { 0x0ffffff4, 28 }, { 0x0ffffff5, 28 }, { 0x0ffffff6, 28 }, { 0x0ffffff7, 28 },
+    { 0x0ffffff8, 28 }, { 0x0ffffff9, 28 }, { 0x0ffffffa, 28 }, { 0x0ffffffb, 28 },
+    { 0x00000014,  6 }, { 0x000003f8, 10 }, { 0x000003f9, 10 }, { 0x00000ffa, 12 },
+    { 0x00001ff9, 13 }, { 0x00000015,  6 }, { 0x000000f8,  8 }, { 0x000007fa, 11 },
+    { 0x000003fa, 10 }, { 0x000003fb, 10 }, { 0x000000f9,  8 }, { 0x000007fb, 11 },
+    { 0x000000fa,  8 }, { 0x00000016,  6 }, { 0x00000017,  6 }, { 0x00000018,  6 },
+    { 0x00000000,  5 }, { 0x00000001,  5 }, { 0x00000002,  5 }, { 0x00000019,  6 },
+    { 0x0000001a,  6 }, { 0x0000001b,  6 }, { 0x0000001c,  6 }, { 0x0000001d,  6 },
+    { 0x0000001e,  6 }, { 0x0000001f,  6 }, { 0x0000005c,  7 }, { 0x000000fb,  8 },
+    { 0x00007ffc, 15 }, { 0x00000020,  6 }, { 0x00000ffb, 12 }, { 0x000003fc, 10 },
+    { 0x00001ffa, 13 }, { 0x00000021,  6 }, { 0x0000005d,  7 }, { 0x0000005e,  7 },
+    { 0x0000005f,  7 }, { 0x00000060,  7 }, { 0x00000061,  7 }, { 0x00000062,  7 },
+    { 0x00000063,  7 }, { 0x00000064,  7 }, { 0x00000065,  7 }, { 0x00000066,  7 },
+    { 0x00000067,  7 }, { 0x00000068,  7 }, { 0x00000069,  7 }, { 0x0000006a,  7 },
+    { 0x0000006b,  7 }, { 0x0000006c,  7 }, { 0x0000006d,  7 }, { 0x0000006e,  7 },
+    { 0x0000006f,  7 }, { 0x00000070,  7 }, { 0x00000071,  7 }, { 0x00000072,  7 },
+    { 0x000000fc,  8 }, { 0x00000073,  7 }, { 0x000000fd,  8 }, { 0x00001ffb, 13 },
+    { 0x0007fff0, 19 }, { 0x00001ffc, 13 }, { 0x00003ffc, 14 }, { 0x00000022,  6 },
+    { 0x00007ffd, 15 }, { 0x00000003,  5 }, { 0x00000023,  6 }, { 0x00000004,  5 },
+    { 0x00000024,  6 }, { 0x00000005,  5 }, { 0x00000025,  6 }, { 0x00000026,  6 },
+    { 0x00000027,  6 }, { 0x00000006,  5 }, { 0x00000074,  7 }, { 0x00000075,  7 },
+    { 0x00000028,  6 }, { 0x00000029,  6 }, { 0x0000002a,  6 }, { 0x00000007,  5 },
+    { 0x0000002b,  6 }, { 0x00000076,  7 }, { 0x0000002c,  6 }, { 0x00000008,  5 },
+    { 0x00000009,  5 }, { 0x0000002d,  6 }, { 0x00000077,  7 }, { 0x00000078,  7 },
+    { 0x00000079,  7 }, { 0x0000007a,  7 }, { 0x0000007b,  7 }, { 0x00007ffe, 15 },
+    { 0x000007fc, 11 }, { 0x00003ffd, 14 }, { 0x00001ffd, 13 }, { 0x0ffffffc, 28 },
+    { 0x000fffe6, 20 }, { 0x003fffd2, 22 }, { 0x000fffe7, 20 }, { 0x000fffe8, 20 },
+    { 0x003fffd3, 22 }, { 0x003fffd4, 22 }, { 0x003fffd5, 22 }, { 0x007fffd9, 23 },
+    { 0x003fffd6, 22 }, { 0x007fffda, 23 }, { 0x007fffdb, 23 }, { 0x007fffdc, 23 },
+    { 0x007fffdd, 23 }, { 0x007fffde, 23 }, { 0x00ffffeb, 24 }, { 0x007fffdf, 23 },
+    { 0x00ffffec, 24 }, { 0x00ffffed, 24 }, { 0x003fffd7, 22 }, { 0x007fffe0, 23 },
+    { 0x00ffffee, 24 }, { 0x007fffe1, 23 }, { 0x007fffe2, 23 }, { 0x007fffe3, 23 },
+    { 0x007fffe4, 23 }, { 0x001fffdc, 21 }, { 0x003fffd8, 22 }, { 0x007fffe5, 23 },
+    { 0x003fffd9, 22 }, { 0x007fffe6, 23 }, { 0x007fffe7, 23 }, { 0x00ffffef, 24 },
+    { 0x003fffda, 22 }, { 0x001fffdd, 21 }, { 0x000fffe9, 20 }, { 0x003fffdb, 22 },
+    { 0x003fffdc, 22 }, { 0x007fffe8, 23 }, { 0x007fffe9, 23 }, { 0x001fffde, 21 },
+    { 0x007fffea, 23 }, { 0x003fffdd, 22 }, { 0x003fffde, 22 }, { 0x00fffff0, 24 },
+    { 0x001fffdf, 21 }, { 0x003fffdf, 22 }, { 0x007fffeb, 23 }, { 0x007fffec, 23 },
+    { 0x001fffe0, 21 }, { 0x001fffe1, 21 }, { 0x003fffe0, 22 }, { 0x001fffe2, 21 },
+    { 0x007fffed, 23 }, { 0x003fffe1, 22 }, { 0x007fffee, 23 }, { 0x007fffef, 23 },
+    { 0x000fffea, 20 }, { 0x003fffe2, 22 }, { 0x003fffe3, 22 }, { 0x003fffe4, 22 },
+    { 0x007ffff0, 23 }, { 0x003fffe5, 22 }, { 0x003fffe6, 22 }, { 0x007ffff1, 23 },
+    { 0x03ffffe0, 26 }, { 0x03ffffe1, 26 }, { 0x000fffeb, 20 }, { 0x0007fff1, 19 },
+    { 0x003fffe7, 22 }, { 0x007ffff2, 23 }, { 0x003fffe8, 22 }, { 0x01ffffec, 25 },
+    { 0x03ffffe2, 26 }, { 0x03ffffe3, 26 }, { 0x03ffffe4, 26 }, { 0x07ffffde, 27 },
+    { 0x07ffffdf, 27 }, { 0x03ffffe5, 26 }, { 0x00fffff1, 24 }, { 0x01ffffed, 25 },
+    { 0x0007fff2, 19 }, { 0x001fffe3, 21 }, { 0x03ffffe6, 26 }, { 0x07ffffe0, 27 },
+    { 0x07ffffe1, 27 }, { 0x03ffffe7, 26 }, { 0x07ffffe2, 27 }, { 0x00fffff2, 24 },
+    { 0x001fffe4, 21 }, { 0x001fffe5, 21 }, { 0x03ffffe8, 26 }, { 0x03ffffe9, 26 },
+    { 0x0ffffffd, 28 }, { 0x07ffffe3, 27 }, { 0x07ffffe4, 27 }, { 0x07ffffe5, 27 },
+    { 0x000fffec, 20 }, { 0x00fffff3, 24 }, { 0x000fffed, 20 }, { 0x001fffe6, 21 },
+    { 0x003fffe9, 22 }, { 0x001fffe7, 21 }, { 0x001fffe8, 21 }, { 0x007ffff3, 23 },
+    { 0x003fffea, 22 }, { 0x003fffeb, 22 }, { 0x01ffffee, 25 }, { 0x01ffffef, 25 },
+    { 0x00fffff4, 24 }, { 0x00fffff5, 24 }, { 0x03ffffea, 26 }, { 0x007ffff4, 23 },
+    { 0x03ffffeb, 26 }, { 0x07ffffe6, 27 }, { 0x03ffffec, 26 }, { 0x03ffffed, 26 },
+    { 0x07ffffe7, 27 }, { 0x07ffffe8, 27 }, { 0x07ffffe9, 27 }, { 0x07ffffea, 27 },
+    { 0x07ffffeb, 27 }, { 0x0ffffffe, 28 }, { 0x07ffffec, 27 }, { 0x07ffffed, 27 },
+    { 0x07ffffee, 27 }, { 0x07ffffef, 27 }, { 0x07fffff0, 27 }, { 0x03ffffee, 26 },
+    { 0x3fffffff, 30 },
+};
+
+const int kEos = 256;
+
+// HuffmanDecodeTable is a state machine consuming 4 bits at a time.
+// Each state is an internal node of the Huffman tree, state 0 is the root.
+class HuffmanDecodeTable
+{
+public:
+    struct Entry
+    {
+        uint16_t Next;
+        int16_t Symbol; // -1 if no symbol is emitted.
+        bool Failed;
+    };
+
+    HuffmanDecodeTable()
+    {
+        // Build the tree, a child greater than 0 is an internal node,
+        // otherwise it is a leaf holding the symbol -(child + 1).
+        m_nodes.push_back(Node());
+        for (int sym = 0; sym <= kEos; ++sym)
+        {
+            int node = 0;
+            for (int i = kHuffmanCodes[sym].Bits - 1; i >= 0; --i)
+            {
+                int bit = (kHuffmanCodes[sym].Code >> i) & 1;
+                if (0 == i)
+                {
+                    m_nodes[node].Child[bit] = -(sym + 1);
+                    break;
+                }
+                if (0 == m_nodes[node].Child[bit])
+                {
+                    Node child;
+                    child.Depth = m_nodes[node].Depth + 1;
+                    child.AllOnes = m_nodes[node].AllOnes && bit == 1;
+                    m_nodes.push_back(child);
+                    m_nodes[node].Child[bit] = (int)m_nodes.size() - 1;
+                }
+                node = m_nodes[node].Child[bit];
+            }
+        }
+
+        m_entries.resize(m_nodes.size() * 16);
+        for (size_t state = 0; state < m_nodes.size(); ++state)
+        {
+            for (int nibble = 0; nibble < 16; ++nibble)
+            {
+                Entry& e = m_entries[state * 16 + nibble];
+                e.Symbol = -1;
+                e.Failed = false;
+                int node = (int)state;
+                for (int i = 3; i >= 0; --i)
+                {
+                    int child = m_nodes[node].Child[(nibble >> i) & 1];
+                    if (child > 0)
+                    {
+                        node = child;
+                        continue;
+                    }
+                    int sym = -(child + 1);
+                    // The codes are at least 5 bits long, so a nibble emits one symbol at most.
+                    if (kEos == sym || e.Symbol >= 0)
+                        e.Failed = true;
+                    e.Symbol = (int16_t)sym;
+                    node = 0;
+                }
+                e.Next = (uint16_t)node;
+            }
+        }
+    }
+
+    const Entry& Get(int state, int nibble) const
+    {
+        return m_entries[state * 16 + nibble];
+    }
+
+    // A string may end in a state reached by less than 8 bits of EOS's prefix (RFC 7541, 5.2).
+    bool CanEnd(int state) const
+    {
+        return m_nodes[state].AllOnes && m_nodes[state].Depth < 8;
+    }
+
+private:
+    struct Node
+    {
+        int Child[2] = { 0, 0 };
+        int Depth = 0;
+        bool AllOnes = true;
+    };
+    std::vector<Node> m_nodes;
+    std::vector<Entry> m_entries;
+};
+
+const HuffmanDecodeTable& GetHuffmanDecodeTable()
+{
+    static HuffmanDecodeTable table;
+    return table;
+}
+
+struct StaticTableIndex
+{
+    std::unordered_map<std::string, size_t> Names;
+    std::unordered_map<std::string, size_t> Fields;
+
+    StaticTableIndex()
+    {
+        for (size_t i = kStaticTableSize; i > 0; --i)
+        {
+            // Iterate backwards so that the lowest index wins.
+            const HeaderField& field = kStaticTable[i - 1];
+            Names[field.first] = i;
+            Fields[field.first + '\0' + field.second] = i;
+        }
+    }
+};
+
+const StaticTableIndex& GetStaticTableIndex()
+{
+    static StaticTableIndex index;
+    return index;
+}
+
+bool IsSensitive(const std::string& name)
+{
+    return "authorization" == name
+        || "proxy-authorization" == name
+        || "set-cookie" == name;
+}
+
+} // !namespace anonymous
+
+namespace hpack {
+
+void EncodeInteger(uint64_t value, int n, uint8_t flags, std::string& out)
+{
+    uint64_t max = (1 << n) - 1;
+    if (value < max)
+    {
+        out.push_back((char)(flags | value));
+        return;
+    }
+    out.push_back((char)(flags | max));
+    value -= max;
+    while (value >= 128)
+    {
+        out.push_back((char)(0x80 | (value & 0x7F)));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+bool DecodeInteger(const uint8_t*& p, const uint8_t* end, int n, uint64_t& value)
+{
+    if (p >= end)
+        return false;
+    uint64_t max = (1 << n) - 1;
+    value = *p++ & max;
+    if (value < max)
+        return true;
+    int shift = 0;
+    while (p < end)
+    {
+        // Continuation bytes of 0x80 add nothing, so the value alone does not bound them.
+        if (shift > 56)
+            return false;
+        uint8_t b = *p++;
+        value += (uint64_t)(b & 0x7F) << shift;
+        if (value > kMaxInteger)
+            return false;
+        if (0 == (b & 0x80))
+            return true;
+        shift += 7;
+    }
+    return false;
+}
+
+size_t HuffmanEncodedLength(const std::string& str)
+{
+    size_t bits = 0;
+    for (size_t i = 0; i < str.length(); ++i)
+        bits += kHuffmanCodes[(uint8_t)str[i]].Bits;
+    return (bits + 7) / 8;
+}
+
+void HuffmanEncode(const std::string& str, std::string& out)
+{
+    uint64_t bits = 0;
+    int count = 0;
+    for (size_t i = 0; i < str.length(); ++i)
+    {
+        const HuffmanCode& code = kHuffmanCodes[(uint8_t)str[i]];
+        bits = (bits << code.Bits) | code.Code;
+        count += code.Bits;
+        while (count >= 8)
+        {
+            count -= 8;
+            out.push_back((char)(bits >> count));
+        }
+    }
+    if (count > 0)
+    {
+        // Pad with the most significant bits of EOS, which are all ones.
+        bits = (bits << (8 - count)) | (0xFF >> count);
+        out.push_back((char)bits);
+    }
+}
+
+bool HuffmanDecode(const uint8_t* data, size_t length, std::string& out)
+{
+    const HuffmanDecodeTable& table = GetHuffmanDecodeTable();
+    int state = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        for (int shift = 4; shift >= 0; shift -= 4)
+        {
+            const HuffmanDecodeTable::Entry& e = table.Get(state, (data[i] >> shift) & 0x0F);
+            if (e.Failed)
+                return false;
+            if (e.Symbol >= 0)
+                out.push_back((char)e.Symbol);
+            state = e.Next;
+        }
+    }
+    return table.CanEnd(state);
+}
+
+} // !namespace hpack
+
+void HpackDynamicTable::SetMaxSize(size_t maxSize)
+{
+    m_maxSize = maxSize;
+    Evict(0);
+}
+
+void HpackDynamicTable::Add(const std::string & name, const std::string & value)
+{
+    size_t size = name.length() + value.length() + kEntryOverhead;
+    if (size > m_maxSize)
+    {
+        // An entry larger than the table empties it (RFC 7541, 4.4).
+        m_entries.clear();
+        m_size = 0;
+        return;
+    }
+    Evict(size);
+    m_entries.emplace_front(name, value);
+    m_size += size;
+}
+
+void HpackDynamicTable::Evict(size_t size)
+{
+    while (!m_entries.empty() && m_size + size > m_maxSize)
+    {
+        const HeaderField& field = m_entries.back();
+        m_size -= field.first.length() + field.second.length() + kEntryOverhead;
+        m_entries.pop_back();
+    }
+}
+
+HpackDecoder::HpackDecoder(size_t maxTableSize /*= 4096*/)
+    : m_table(maxTableSize)
+    , m_maxTableSize(maxTableSize)
+{
+}
+
+void HpackDecoder::SetMaxTableSize(size_t size)
+{
+    m_maxTableSize = size;
+    if (m_table.GetMaxSize() > size)
+        m_table.SetMaxSize(size);
+}
+
+void HpackDecoder::SetMaxHeaderListSize(size_t size)
+{
+    m_maxHeaderListSize = size;
+}
+
+bool HpackDecoder::Decode(const char * data, size_t length, HeaderFieldList & headers)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = p + length;
+    bool first = true;
+    // An indexed field takes a byte of the block, but may add a whole table entry to the list.
+    size_t listSize = 0;
+    while (p < end)
+    {
+        uint8_t b = *p;
+        uint64_t index = 0;
+        if (b & 0x80)
+        {
+            // Indexed header field.
+            HeaderField field;
+            if (!hpack::DecodeInteger(p, end, 7, index) || !LookUp(index, field))
+                return false;
+            listSize += field.first.length() + field.second.length() + kEntryOverhead;
+            if (m_maxHeaderListSize > 0 && listSize > m_maxHeaderListSize)
+                return false;
+            headers.push_back(field);
+        }
+        else if ((b & 0xE0) == 0x20)
+        {
+            // Dynamic table size update, only allowed at the beginning of a block.
+            if (!first || !hpack::DecodeInteger(p, end, 5, index) || index > m_maxTableSize)
+                return false;
+            m_table.SetMaxSize((size_t)index);
+            continue;
+        }
+        else
+        {
+            // Literal header field, with incremental indexing (01),
+            // without indexing (0000) or never indexed (0001).
+            bool indexing = (b & 0xC0) == 0x40;
+            HeaderField field;
+            if (!hpack::DecodeInteger(p, end, indexing ? 6 : 4, index))
+                return false;
+            if (index > 0)
+            {
+                HeaderField nameField;
+                if (!LookUp(index, nameField))
+                    return false;
+                field.first = nameField.first;
+            }
+            else if (!ReadString(p, end, field.first))
+                return false;
+            if (!ReadString(p, end, field.second))
+                return false;
+            if (indexing)
+                m_table.Add(field.first, field.second);
+            listSize += field.first.length() + field.second.length() + kEntryOverhead;
+            if (m_maxHeaderListSize > 0 && listSize > m_maxHeaderListSize)
+                return false;
+            headers.push_back(field);
+        }
+        first = false;
+    }
+    return true;
+}
+
+bool HpackDecoder::ReadString(const uint8_t *& p, const uint8_t * end, std::string & str)
+{
+    if (p >= end)
+        return false;
+    bool huffman = (*p & 0x80) != 0;
+    uint64_t length = 0;
+    if (!hpack::DecodeInteger(p, end, 7, length))
+        return false;
+    if (length > (uint64_t)(end - p))
+        return false;
+    str.clear();
+    if (huffman)
+    {
+        str.reserve((size_t)length * 8 / 5);
+        if (!hpack::HuffmanDecode(p, (size_t)length, str))
+            return false;
+    }
+    else
+        str.assign(reinterpret_cast<const char*>(p), (size_t)length);
+    p += length;
+    return true;
+}
+
+bool HpackDecoder::LookUp(uint64_t index, HeaderField & field) const
+{
+    if (0 == index)
+        return false;
+    if (index <= kStaticTableSize)
+    {
+        field = kStaticTable[index - 1];
+        return true;
+    }
+    index -= kStaticTableSize + 1;
+    if (index >= m_table.GetCount())
+        return false;
+    field = m_table.Get((size_t)index);
+    return true;
+}
+
+HpackEncoder::HpackEncoder(size_t maxTableSize /*= 4096*/)
+    : m_table(maxTableSize)
+    , m_pendingTableSize(maxTableSize)
+{
+}
+
+void HpackEncoder::SetMaxTableSize(size_t size)
+{
+    // Keep the table within 4 KiB, a larger table only costs memory here.
+    if (size > 4096)
+        size = 4096;
+    if (size == m_table.GetMaxSize() && !m_tableSizeChanged)
+        return;
+    m_pendingTableSize = size;
+    m_tableSizeChanged = true;
+}
+
+void HpackEncoder::Encode(const HeaderFieldList & headers, std::string & out)
+{
+    if (m_tableSizeChanged)
+    {
+        m_table.SetMaxSize(m_pendingTableSize);
+        hpack::EncodeInteger(m_pendingTableSize, 5, 0x20, out);
+        m_tableSizeChanged = false;
+    }
+    for (auto iter = headers.begin(); iter != headers.end(); ++iter)
+        EncodeField(*iter, out);
+}
+
+void HpackEncoder::EncodeField(const HeaderField & field, std::string & out)
+{
+    const StaticTableIndex& staticIndex = GetStaticTableIndex();
+    auto fieldIter = staticIndex.Fields.find(field.first + '\0' + field.second);
+    if (fieldIter != staticIndex.Fields.end())
+    {
+        hpack::EncodeInteger(fieldIter->second, 7, 0x80, out);
+        return;
+    }
+
+    size_t nameIndex = 0;
+    auto nameIter = staticIndex.Names.find(field.first);
+    if (nameIter != staticIndex.Names.end())
+        nameIndex = nameIter->second;
+    for (size_t i = 0; i < m_table.GetCount(); ++i)
+    {
+        const HeaderField& entry = m_table.Get(i);
+        if (entry.first != field.first)
+            continue;
+        if (entry.second == field.second)
+        {
+            hpack::EncodeInteger(kStaticTableSize + 1 + i, 7, 0x80, out);
+            return;
+        }
+        if (0 == nameIndex)
+            nameIndex = kStaticTableSize + 1 + i;
+    }
+
+    size_t size = field.first.length() + field.second.length() + kEntryOverhead;
+    if (IsSensitive(field.first))
+        hpack::EncodeInteger(nameIndex, 4, 0x10, out);
+    else if (size <= m_table.GetMaxSize() / 2)
+    {
+        hpack::EncodeInteger(nameIndex, 6, 0x40, out);
+        m_table.Add(field.first, field.second);
+    }
+    else
+        hpack::EncodeInteger(nameIndex, 4, 0x00, out);
+    if (0 == nameIndex)
+        EncodeString(field.first, out);
+    EncodeString(field.second, out);
+}
+
+void HpackEncoder::EncodeString(const std::string & str, std::string & out)
+{
+    size_t huffmanLength = hpack::HuffmanEncodedLength(str);
+    if (huffmanLength < str.length())
+    {
+        hpack::EncodeInteger(huffmanLength, 7, 0x80, out);
+        hpack::HuffmanEncode(str, out);
+    }
+    else
+    {
+        hpack::EncodeInteger(str.length(), 7, 0x00, out);
+        out.append(str);
+    }
+}
+
+} // !namespace http
+} // !namespace net
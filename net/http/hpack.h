@@ -0,0 +1,123 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace net {
+namespace http {
+
+// HPACK: Header Compression for HTTP/2 (RFC 7541).
+
+// HeaderField is a name-value pair, names are lower case in HTTP/2.
+typedef std::pair<std::string, std::string> HeaderField;
+typedef std::vector<HeaderField> HeaderFieldList;
+
+// HpackDynamicTable is the FIFO table of header fields shared by an encoder and its peer decoder.
+class HpackDynamicTable
+{
+public:
+    HpackDynamicTable(size_t maxSize = 4096) : m_maxSize(maxSize) {}
+
+    size_t GetSize() const { return m_size; }
+    size_t GetMaxSize() const { return m_maxSize; }
+    void SetMaxSize(size_t maxSize);
+
+    size_t GetCount() const { return m_entries.size(); }
+    // |index| is 0-based, 0 is the newest entry.
+    const HeaderField& Get(size_t index) const { return m_entries[index]; }
+    void Add(const std::string& name, const std::string& value);
+
+private:
+    void Evict(size_t size);
+
+private:
+    std::deque<HeaderField> m_entries;
+    size_t m_size = 0;
+    size_t m_maxSize;
+};
+
+class HpackDecoder
+{
+public:
+    HpackDecoder(size_t maxTableSize = 4096);
+
+    // SetMaxTableSize sets the limit announced by SETTINGS_HEADER_TABLE_SIZE.
+    // The encoder may choose any table size up to it.
+    void SetMaxTableSize(size_t size);
+
+    // SetMaxHeaderListSize bounds the decoded header list, counted as the sum of the
+    // entry sizes of its fields (RFC 7540, 6.5.2), 0 for no limit, the default.
+    void SetMaxHeaderListSize(size_t size);
+
+    // Decode decodes a complete header block.
+    // It returns false if the block is malformed or decodes to a header list larger
+    // than allowed, which is a connection error.
+    bool Decode(const char* data, size_t length, HeaderFieldList& headers);
+
+private:
+    bool ReadString(const uint8_t*& p, const uint8_t* end, std::string& str);
+    bool LookUp(uint64_t index, HeaderField& field) const;
+
+private:
+    HpackDynamicTable m_table;
+    size_t m_maxTableSize;
+    size_t m_maxHeaderListSize = 0;
+};
+
+class HpackEncoder
+{
+public:
+    HpackEncoder(size_t maxTableSize = 4096);
+
+    // SetMaxTableSize applies the SETTINGS_HEADER_TABLE_SIZE of the peer.
+    // A dynamic table size update will be emitted at the start of the next block.
+    void SetMaxTableSize(size_t size);
+
+    // Encode appends the header block of |headers| to |out|.
+    void Encode(const HeaderFieldList& headers, std::string& out);
+
+private:
+    void EncodeField(const HeaderField& field, std::string& out);
+    void EncodeString(const std::string& str, std::string& out);
+
+private:
+    HpackDynamicTable m_table;
+    size_t m_pendingTableSize;
+    bool m_tableSizeChanged = false;
+};
+
+namespace hpack {
+
+// EncodeInteger appends |value| with an |n|-bit prefix, |flags| fills the bits above the prefix.
+void EncodeInteger(uint64_t value, int n, uint8_t flags, std::string& out);
+bool DecodeInteger(const uint8_t*& p, const uint8_t* end, int n, uint64_t& value);
+
+size_t HuffmanEncodedLength(const std::string& str);
+void HuffmanEncode(const std::string& str, std::string& out);
+bool HuffmanDecode(const uint8_t* data, size_t length, std::string& out);
+
+} // !namespace hpack
+
+} // !namespace http
+} // !namespace net
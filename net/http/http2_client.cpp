@@ -0,0 +1,300 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/http/http2_client.h"
+
+#include <thread>
+
+#include "net/base/strings/string_utils.h"
+#include "net/base/zip.h"
+#include "net/http/status.h"
+
+namespace net {
+namespace http {
+
+namespace {
+
+// The connection-specific header fields are not used in HTTP/2 (RFC 7540, 8.1.2.2).
+bool IsConnectionHeader(const std::string& name)
+{
+    return name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+        name == "transfer-encoding" || name == "upgrade" || name == "host";
+}
+
+HeaderFieldList RequestHeaderFields(std::shared_ptr<Request> request)
+{
+    if (!request->GetUrl().GetUser().empty())
+        request->SetBasicAuth(request->GetUrl().GetUser(), request->GetUrl().GetPassword());
+
+    std::string method = request->GetMethod();
+    if (method.empty())
+        method = "GET";
+    std::string scheme = request->GetUrl().GetScheme();
+    if (scheme.empty())
+        scheme = "http";
+    std::string path = request->GetUrl().RequestURI();
+    if (path.empty())
+        path = "/";
+
+    HeaderFieldList fields;
+    fields.emplace_back(":method", method);
+    fields.emplace_back(":scheme", scheme);
+    fields.emplace_back(":authority", request->GetHost());
+    fields.emplace_back(":path", path);
+    auto& headers = request->GetHeadersView();
+    for (auto iter = headers.begin(); iter != headers.end(); ++iter)
+    {
+        auto name = base::strings::ToLower(iter->first);
+        if (IsConnectionHeader(name) || name == "content-length")
+            continue;
+        fields.emplace_back(name, iter->second);
+    }
+    if (!request->GetBodyView().empty())
+        fields.emplace_back("content-length", std::to_string(request->GetBodyView().length()));
+    return fields;
+}
+
+} // !namespace anonymous
+
+Http2ClientConnection::Http2ClientConnection(std::shared_ptr<StreamSocket> s)
+    : Http2Connection(s, false)
+{
+}
+
+std::shared_ptr<Http2ClientConnection> Http2ClientConnection::Create(std::shared_ptr<StreamSocket> s)
+{
+    return std::shared_ptr<Http2ClientConnection>(new Http2ClientConnection(s));
+}
+
+bool Http2ClientConnection::Start(std::chrono::seconds timeout)
+{
+    if (m_socket->Send(kHttp2Preface, (int)kHttp2PrefaceLength) != (int)kHttp2PrefaceLength)
+        return false;
+
+    // The reading thread keeps the connection alive until the socket is closed.
+    auto self = std::static_pointer_cast<Http2ClientConnection>(shared_from_this());
+    std::thread t([self]() {
+        Http2FrameReader reader;
+        reader.Reset(self->m_socket.get());
+        self->Run(reader);
+    });
+    t.detach();
+
+    std::unique_lock<std::mutex> lock(m_exchangesMutex);
+    m_exchangesChanged.wait_for(lock, timeout, [this]() { return m_ready || m_finished; });
+    if (m_ready)
+        return true;
+    lock.unlock();
+    Close();
+    return false;
+}
+
+std::shared_ptr<Response> Http2ClientConnection::RoundTrip(std::shared_ptr<Request> request, bool & retry)
+{
+    retry = false;
+    auto fields = RequestHeaderFields(request);
+    auto body = request->GetBodyView();
+
+    auto exchange = std::make_shared<Exchange>();
+    uint32_t streamId = 0;
+    {
+        std::unique_lock<std::mutex> lock(m_exchangesMutex);
+        m_exchangesChanged.wait(lock, [this]() {
+            return m_finished || m_exchanges.size() < GetPeerMaxConcurrentStreams();
+        });
+        if (m_finished || IsClosed() || m_nextStreamId > 0x7FFFFFFF)
+        {
+            retry = true;
+            return nullptr;
+        }
+        // The streams are opened in the order of their identifiers.
+        streamId = m_nextStreamId;
+        m_nextStreamId += 2;
+        m_exchanges[streamId] = exchange;
+        OpenStream(streamId, false);
+        if (!SendHeaders(streamId, fields, body.empty()))
+        {
+            m_exchanges.erase(streamId);
+            retry = true;
+            return nullptr;
+        }
+    }
+    if (!body.empty())
+        SendData(streamId, body.data(), body.length(), true);
+
+    std::unique_lock<std::mutex> lock(m_exchangesMutex);
+    m_exchangesChanged.wait(lock, [&exchange]() { return exchange->Done || exchange->Failed; });
+    retry = exchange->Retry;
+    if (exchange->Failed)
+        return nullptr;
+    exchange->Message->SetRequest(request);
+    return exchange->Message;
+}
+
+void Http2ClientConnection::Close()
+{
+    GoAway(Http2NoError);
+    m_socket->Shutdown();
+}
+
+void Http2ClientConnection::OnHeaders(uint32_t streamId, HeaderFieldList & headers, bool endStream)
+{
+    std::lock_guard<std::mutex> lock(m_exchangesMutex);
+    auto iter = m_exchanges.find(streamId);
+    if (iter == m_exchanges.end())
+        return;
+    auto& exchange = iter->second;
+
+    if (!exchange->Message)
+    {
+        int status = 0;
+        Header h;
+        for (auto& field : headers)
+        {
+            if (field.first == ":status")
+            {
+                try
+                {
+                    status = std::stoi(field.second);
+                }
+                catch (...)
+                {
+                    status = 0;
+                }
+            }
+            else if (!field.first.empty() && field.first[0] != ':')
+            {
+                h.emplace(field.first, field.second);
+            }
+        }
+        if (status < 100 || status > 999)
+        {
+            ResetStream(streamId, Http2ProtocolError);
+            Fail(streamId, false);
+            return;
+        }
+        // Interim responses are skipped.
+        if (status < 200)
+            return;
+        exchange->Message = Response::Create();
+        exchange->Message->SetProto(2, 0);
+        exchange->Message->SetStatusCode(status);
+        exchange->Message->SetStatus(StatusText((Status)status));
+        exchange->Message->SetHeader(h);
+    }
+    else
+    {
+        // Trailers.
+        for (auto& field : headers)
+        {
+            if (!field.first.empty() && field.first[0] != ':')
+                exchange->Message->SetHeader(field.first, field.second);
+        }
+    }
+    if (endStream)
+        Complete(streamId);
+}
+
+void Http2ClientConnection::OnData(uint32_t streamId, const char * data, size_t length, bool endStream)
+{
+    // The response bodies are kept whole, their data is consumed as it arrives.
+    ConsumeData(streamId, length);
+    std::lock_guard<std::mutex> lock(m_exchangesMutex);
+    auto iter = m_exchanges.find(streamId);
+    if (iter == m_exchanges.end())
+        return;
+    iter->second->Body.append(data, length);
+    if (endStream)
+        Complete(streamId);
+}
+
+void Http2ClientConnection::OnStreamReset(uint32_t streamId, uint32_t errorCode)
+{
+    std::lock_guard<std::mutex> lock(m_exchangesMutex);
+    // A refused stream has not been processed (RFC 7540, 8.1.4).
+    Fail(streamId, errorCode == Http2RefusedStream);
+}
+
+void Http2ClientConnection::OnGoAway(uint32_t lastStreamId, uint32_t errorCode)
+{
+    std::lock_guard<std::mutex> lock(m_exchangesMutex);
+    // The streams above |lastStreamId| have not been processed.
+    for (auto iter = m_exchanges.begin(); iter != m_exchanges.end();)
+    {
+        auto streamId = (iter++)->first;
+        if (streamId > lastStreamId)
+            Fail(streamId, true);
+    }
+}
+
+void Http2ClientConnection::OnSettings()
+{
+    std::lock_guard<std::mutex> lock(m_exchangesMutex);
+    m_ready = true;
+    m_exchangesChanged.notify_all();
+}
+
+void Http2ClientConnection::OnReadFinished()
+{
+    std::lock_guard<std::mutex> lock(m_exchangesMutex);
+    m_finished = true;
+    while (!m_exchanges.empty())
+        Fail(m_exchanges.begin()->first, false);
+    m_exchangesChanged.notify_all();
+}
+
+void Http2ClientConnection::LocalSettings(std::string & payload) const
+{
+    http2::AppendSetting(payload, Http2SettingEnablePush, 0);
+}
+
+void Http2ClientConnection::Complete(uint32_t streamId)
+{
+    auto iter = m_exchanges.find(streamId);
+    if (iter == m_exchanges.end())
+        return;
+    auto exchange = iter->second;
+    m_exchanges.erase(iter);
+    if (!exchange->Message)
+    {
+        exchange->Failed = true;
+    }
+    else
+    {
+        if (exchange->Message->GetHeader("Content-Encoding").find("gzip") != std::string::npos)
+            exchange->Message->SetBody(base::zip::GDecompress(exchange->Body));
+        else
+            exchange->Message->SetBody(std::move(exchange->Body));
+        exchange->Done = true;
+    }
+    m_exchangesChanged.notify_all();
+}
+
+void Http2ClientConnection::Fail(uint32_t streamId, bool retry)
+{
+    auto iter = m_exchanges.find(streamId);
+    if (iter == m_exchanges.end())
+        return;
+    iter->second->Failed = true;
+    iter->second->Retry = retry;
+    m_exchanges.erase(iter);
+    m_exchangesChanged.notify_all();
+}
+
+} // !namespace http
+} // !namespace net
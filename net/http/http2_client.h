@@ -0,0 +1,95 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "net/http/http2_connection.h"
+#include "net/http/request.h"
+#include "net/http/response.h"
+
+namespace net {
+namespace http {
+
+// Http2ClientConnection sends requests to a server over one HTTP/2 connection
+// with prior knowledge (RFC 7540, 3.4). RoundTrip may be called from many threads,
+// each request is sent on its own stream.
+class Http2ClientConnection
+    : public Http2Connection
+{
+public:
+    ~Http2ClientConnection() {}
+
+private:
+    Http2ClientConnection(std::shared_ptr<StreamSocket> s);
+
+public:
+    static std::shared_ptr<Http2ClientConnection> Create(std::shared_ptr<StreamSocket> s);
+
+    // Start sends the connection preface and waits for the SETTINGS of the server.
+    // It returns false if the server does not speak HTTP/2.
+    bool Start(std::chrono::seconds timeout);
+
+    // RoundTrip sends |request| on a new stream and waits for its response.
+    // |retry| is set if the server has not processed the request, which may be sent
+    // again on another connection.
+    std::shared_ptr<Response> RoundTrip(std::shared_ptr<Request> request, bool& retry);
+
+    // Close ends the connection, the pending requests fail.
+    void Close();
+
+protected:
+    void OnHeaders(uint32_t streamId, HeaderFieldList& headers, bool endStream) override;
+    void OnData(uint32_t streamId, const char* data, size_t length, bool endStream) override;
+    void OnStreamReset(uint32_t streamId, uint32_t errorCode) override;
+    void OnGoAway(uint32_t lastStreamId, uint32_t errorCode) override;
+    void OnSettings() override;
+    void OnReadFinished() override;
+    void LocalSettings(std::string& payload) const override;
+
+private:
+    struct Exchange
+    {
+        std::shared_ptr<Response> Message;
+        std::string Body;
+        bool Done = false;
+        bool Failed = false;
+        bool Retry = false;
+    };
+
+    // The members below are called with m_exchangesMutex locked.
+    void Complete(uint32_t streamId);
+    void Fail(uint32_t streamId, bool retry);
+
+private:
+    std::mutex m_exchangesMutex;
+    std::condition_variable m_exchangesChanged;
+    std::map<uint32_t, std::shared_ptr<Exchange>> m_exchanges;
+    uint32_t m_nextStreamId = 1;
+    bool m_ready = false;
+    bool m_finished = false;
+};
+
+} // !namespace http
+} // !namespace net
@@ -0,0 +1,845 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/http/http2_connection.h"
+
+#include "net/http/writer.h"
+
+namespace net {
+namespace http {
+
+namespace {
+
+// Our receive windows. The connection window is credited as the data is read, the
+// window of a stream as its data is consumed (ConsumeData).
+const int64_t kConnectionWindowSize = 16 * 1024 * 1024;
+const int64_t kStreamWindowSize = 1024 * 1024;
+
+// SendData blocks while more bytes of the stream are waiting to be sent.
+const size_t kMaxPendingBytes = 64 * 1024;
+
+// The writer sends up to this many bytes of frames at once.
+const size_t kWriteBatchSize = 64 * 1024;
+
+// The frames we owe the peer, e.g. PING and SETTINGS acknowledgements or RST_STREAM,
+// wait for the writer in the control queue. A peer which makes us queue more while it
+// does not read is sent GOAWAY instead.
+const size_t kMaxControlBytes = 256 * 1024;
+
+const size_t kMaxHeaderBlockSize = 256 * 1024;
+// The decoded header list may be much larger than its block, it is bounded as well
+// and the limit is announced by SETTINGS_MAX_HEADER_LIST_SIZE.
+const size_t kMaxHeaderListSize = 256 * 1024;
+const int kMaxPriorityDepth = 64;
+
+void ParsePriority(const char* p, uint32_t& parent, int& weight, bool& exclusive)
+{
+    uint32_t dependency = http2::ReadUInt32(p);
+    exclusive = (dependency & 0x80000000) != 0;
+    parent = dependency & 0x7FFFFFFF;
+    weight = (uint8_t)p[4] + 1;
+}
+
+} // !namespace anonymous
+
+Http2Connection::Http2Connection(std::shared_ptr<StreamSocket> s, bool server)
+    : m_socket(s)
+    , m_server(server)
+{
+}
+
+Http2Connection::~Http2Connection()
+{
+    if (m_writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopWriter = true;
+            m_cv.notify_all();
+        }
+        m_writer.join();
+    }
+}
+
+bool Http2Connection::SendHeaders(uint32_t streamId, const HeaderFieldList & headers, bool endStream)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto stream = FindStream(streamId);
+    if (m_broken || !stream || stream->LocalClosed)
+        return false;
+    if (stream->Pending.empty() && stream->VirtualTime < m_virtualTime)
+        stream->VirtualTime = m_virtualTime;
+    PendingFrame frame;
+    frame.Headers = true;
+    frame.Fields = headers;
+    frame.EndStream = endStream;
+    stream->Pending.push_back(std::move(frame));
+    stream->LocalClosed = endStream;
+    m_cv.notify_all();
+    return true;
+}
+
+bool Http2Connection::SendData(uint32_t streamId, const char * data, size_t length, bool endStream)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto stream = FindStream(streamId);
+    if (!stream)
+        return false;
+    do
+    {
+        while (!m_broken && !stream->Closed && stream->PendingBytes >= kMaxPendingBytes)
+            m_cv.wait(lock);
+        if (m_broken || stream->Closed || stream->LocalClosed)
+            return false;
+
+        size_t len = length;
+        if (len > kMaxPendingBytes)
+            len = kMaxPendingBytes;
+        if (stream->Pending.empty() && stream->VirtualTime < m_virtualTime)
+            stream->VirtualTime = m_virtualTime;
+        PendingFrame frame;
+        frame.Data.assign(data, len);
+        frame.EndStream = endStream && len == length;
+        stream->Pending.push_back(std::move(frame));
+        stream->PendingBytes += len;
+        stream->LocalClosed = endStream && len == length;
+        data += len;
+        length -= len;
+        m_cv.notify_all();
+    } while (length > 0);
+    return true;
+}
+
+void Http2Connection::ResetStream(uint32_t streamId, uint32_t errorCode)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ResetStreamLocked(streamId, errorCode);
+}
+
+void Http2Connection::GoAway(uint32_t errorCode)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_goingAway)
+        return;
+    m_goingAway = true;
+    http2::AppendGoAway(m_control, m_lastPeerStreamId, errorCode);
+    m_cv.notify_all();
+}
+
+bool Http2Connection::IsClosed() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_broken || m_stopWriter || m_goingAway || m_peerGoneAway;
+}
+
+uint32_t Http2Connection::ApplyRemoteSettings(const std::string & payload)
+{
+    if (payload.size() % 6 != 0)
+        return Http2FrameSizeError;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < payload.size(); i += 6)
+    {
+        uint16_t id = http2::ReadUInt16(payload.data() + i);
+        uint32_t value = http2::ReadUInt32(payload.data() + i + 2);
+        switch (id)
+        {
+        case Http2SettingHeaderTableSize:
+            m_encoder.SetMaxTableSize(value);
+            break;
+        case Http2SettingEnablePush:
+            if (value > 1)
+                return Http2ProtocolError;
+            break;
+        case Http2SettingMaxConcurrentStreams:
+            m_peerMaxConcurrentStreams = value;
+            break;
+        case Http2SettingInitialWindowSize:
+        {
+            if (value > (uint32_t)kHttp2MaxWindowSize)
+                return Http2FlowControlError;
+            // The change applies to the windows of all the streams (RFC 7540, 6.9.2).
+            int64_t delta = (int64_t)value - m_peerInitialWindowSize;
+            for (auto& kv : m_streams)
+            {
+                kv.second->SendWindow += delta;
+                if (kv.second->SendWindow > kHttp2MaxWindowSize)
+                    return Http2FlowControlError;
+            }
+            m_peerInitialWindowSize = value;
+            break;
+        }
+        case Http2SettingMaxFrameSize:
+            if (value < kHttp2DefaultMaxFrameSize || value > kHttp2MaxFrameSizeLimit)
+                return Http2ProtocolError;
+            m_peerMaxFrameSize = value;
+            break;
+        default:
+            // Unknown settings are ignored.
+            break;
+        }
+    }
+    m_cv.notify_all();
+    return Http2NoError;
+}
+
+void Http2Connection::OpenStream(uint32_t streamId, bool remoteClosed)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto stream = CreateStream(streamId);
+    stream->RemoteClosed = remoteClosed;
+    if (!IsLocalStream(streamId) && streamId > m_lastPeerStreamId)
+        m_lastPeerStreamId = streamId;
+}
+
+void Http2Connection::Run(Http2FrameReader & reader)
+{
+    {
+        std::string settings;
+        LocalSettings(settings);
+        http2::AppendSetting(settings, Http2SettingInitialWindowSize, (uint32_t)kStreamWindowSize);
+        http2::AppendSetting(settings, Http2SettingMaxHeaderListSize, (uint32_t)kMaxHeaderListSize);
+        m_decoder.SetMaxHeaderListSize(kMaxHeaderListSize);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        http2::AppendFrame(m_control, Http2Settings, 0, 0, settings.data(), settings.size());
+        // The connection window can only be raised by WINDOW_UPDATE.
+        http2::AppendWindowUpdate(m_control, 0, (uint32_t)(kConnectionWindowSize - kHttp2DefaultWindowSize));
+        m_recvWindow = kConnectionWindowSize;
+    }
+    m_writer = std::thread(&Http2Connection::WriteLoop, this);
+
+    Http2Frame frame;
+    bool frameSizeError = false;
+    while (reader.ReadFrame(frame, frameSizeError))
+    {
+        uint32_t error = HandleFrame(frame);
+        if (error == Http2NoError && IsControlQueueFull())
+            error = Http2EnhanceYourCalm;
+        if (error != Http2NoError)
+        {
+            GoAway(error);
+            break;
+        }
+    }
+    if (frameSizeError)
+        GoAway(Http2FrameSizeError);
+
+    {
+        // No WINDOW_UPDATE will come anymore, the senders blocked on a window would wait
+        // forever. The streams are closed, only the GOAWAY queued is still sent.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_broken = true;
+        for (auto& kv : m_streams)
+        {
+            kv.second->Closed = true;
+            kv.second->Pending.clear();
+            kv.second->PendingBytes = 0;
+        }
+        m_streams.clear();
+        m_cv.notify_all();
+    }
+    OnReadFinished();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopWriter = true;
+        m_cv.notify_all();
+    }
+    m_writer.join();
+}
+
+uint32_t Http2Connection::GetPeerMaxConcurrentStreams() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_peerMaxConcurrentStreams;
+}
+
+size_t Http2Connection::GetActiveStreamCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_streams.size();
+}
+
+bool Http2Connection::IsControlQueueFull() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_control.size() > kMaxControlBytes;
+}
+
+bool Http2Connection::IsLocalStream(uint32_t streamId) const
+{
+    // Clients use odd stream identifiers, servers even ones.
+    return (streamId % 2 == 0) == m_server;
+}
+
+std::shared_ptr<Http2Connection::Stream> Http2Connection::FindStream(uint32_t streamId) const
+{
+    auto iter = m_streams.find(streamId);
+    if (iter == m_streams.end())
+        return nullptr;
+    return iter->second;
+}
+
+std::shared_ptr<Http2Connection::Stream> Http2Connection::CreateStream(uint32_t streamId)
+{
+    auto stream = std::make_shared<Stream>();
+    stream->Id = streamId;
+    stream->SendWindow = m_peerInitialWindowSize;
+    stream->RecvWindow = kStreamWindowSize;
+    stream->VirtualTime = m_virtualTime;
+    m_streams[streamId] = stream;
+    return stream;
+}
+
+void Http2Connection::CloseStream(uint32_t streamId)
+{
+    auto stream = FindStream(streamId);
+    if (!stream)
+        return;
+    stream->Closed = true;
+    stream->Pending.clear();
+    stream->PendingBytes = 0;
+    m_streams.erase(streamId);
+    // The children of a closed stream depend on its parent (RFC 7540, 5.3.4).
+    for (auto& kv : m_streams)
+    {
+        if (kv.second->Parent == streamId)
+            kv.second->Parent = stream->Parent;
+    }
+    m_cv.notify_all();
+}
+
+void Http2Connection::MaybeCloseStream(const std::shared_ptr<Stream>& stream)
+{
+    if (stream->LocalClosed && stream->RemoteClosed && stream->Pending.empty())
+        CloseStream(stream->Id);
+}
+
+void Http2Connection::ResetStreamLocked(uint32_t streamId, uint32_t errorCode)
+{
+    http2::AppendRstStream(m_control, streamId, errorCode);
+    CloseStream(streamId);
+    m_cv.notify_all();
+}
+
+void Http2Connection::SetPriority(Stream & stream, const Priority & priority)
+{
+    uint32_t parent = priority.Parent;
+    auto parentStream = FindStream(parent);
+    if (!parentStream)
+    {
+        parent = 0;
+    }
+    else
+    {
+        // If the new parent depends on the stream, it first moves to the
+        // former parent of the stream (RFC 7540, 5.3.3).
+        uint32_t ancestor = parentStream->Parent;
+        for (int depth = 0; ancestor != 0 && depth < kMaxPriorityDepth; ++depth)
+        {
+            if (ancestor == stream.Id)
+            {
+                parentStream->Parent = stream.Parent;
+                break;
+            }
+            auto next = FindStream(ancestor);
+            if (!next)
+                break;
+            ancestor = next->Parent;
+        }
+    }
+    if (priority.Exclusive)
+    {
+        for (auto& kv : m_streams)
+        {
+            if (kv.second->Parent == parent && kv.first != stream.Id)
+                kv.second->Parent = stream.Id;
+        }
+    }
+    stream.Parent = parent;
+    stream.Weight = priority.Weight;
+}
+
+uint32_t Http2Connection::HandleFrame(Http2Frame & frame)
+{
+    // A header block is not interleaved with other frames (RFC 7540, 6.10).
+    if (m_headerStreamId != 0 &&
+        (frame.Type != Http2Continuation || frame.StreamId != m_headerStreamId))
+        return Http2ProtocolError;
+    // The connection preface ends with a SETTINGS frame (RFC 7540, 3.5).
+    if (!m_receivedSettings)
+    {
+        if (frame.Type != Http2Settings || (frame.Flags & Http2FlagAck))
+            return Http2ProtocolError;
+        m_receivedSettings = true;
+    }
+
+    switch (frame.Type)
+    {
+    case Http2Data:
+        return HandleData(frame);
+
+    case Http2Headers:
+    {
+        // The push is disabled, so only the client opens streams, with odd identifiers.
+        if (frame.StreamId == 0 || frame.StreamId % 2 == 0 || !http2::RemovePadding(frame))
+            return Http2ProtocolError;
+        size_t offset = 0;
+        m_headerHasPriority = (frame.Flags & Http2FlagPriority) != 0;
+        if (m_headerHasPriority)
+        {
+            if (frame.Payload.size() < 5)
+                return Http2FrameSizeError;
+            ParsePriority(frame.Payload.data(), m_headerPriority.Parent,
+                m_headerPriority.Weight, m_headerPriority.Exclusive);
+            if (m_headerPriority.Parent == frame.StreamId)
+                return Http2ProtocolError;
+            offset = 5;
+        }
+        m_headerStreamId = frame.StreamId;
+        m_headerEndStream = (frame.Flags & Http2FlagEndStream) != 0;
+        m_headerBlock.assign(frame.Payload, offset, std::string::npos);
+        if (frame.Flags & Http2FlagEndHeaders)
+            return HandleHeaderBlock();
+        return Http2NoError;
+    }
+
+    case Http2Continuation:
+        if (m_headerStreamId == 0)
+            return Http2ProtocolError;
+        if (m_headerBlock.size() + frame.Payload.size() > kMaxHeaderBlockSize)
+            return Http2EnhanceYourCalm;
+        m_headerBlock.append(frame.Payload);
+        if (frame.Flags & Http2FlagEndHeaders)
+            return HandleHeaderBlock();
+        return Http2NoError;
+
+    case Http2Priority:
+    {
+        if (frame.StreamId == 0)
+            return Http2ProtocolError;
+        if (frame.Payload.size() != 5)
+            return Http2FrameSizeError;
+        Priority priority;
+        ParsePriority(frame.Payload.data(), priority.Parent, priority.Weight, priority.Exclusive);
+        if (priority.Parent == frame.StreamId)
+            return Http2ProtocolError;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // The priority of idle or closed streams is not kept.
+        auto stream = FindStream(frame.StreamId);
+        if (stream)
+            SetPriority(*stream, priority);
+        return Http2NoError;
+    }
+
+    case Http2RstStream:
+        return HandleRstStream(frame);
+
+    case Http2Settings:
+        return HandleSettings(frame);
+
+    case Http2PushPromise:
+        // Servers do not receive it, and the push is disabled by clients.
+        return Http2ProtocolError;
+
+    case Http2Ping:
+    {
+        if (frame.StreamId != 0)
+            return Http2ProtocolError;
+        if (frame.Payload.size() != 8)
+            return Http2FrameSizeError;
+        if (frame.Flags & Http2FlagAck)
+            return Http2NoError;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        http2::AppendFrame(m_control, Http2Ping, Http2FlagAck, 0, frame.Payload.data(), frame.Payload.size());
+        m_cv.notify_all();
+        return Http2NoError;
+    }
+
+    case Http2GoAway:
+    {
+        if (frame.StreamId != 0)
+            return Http2ProtocolError;
+        if (frame.Payload.size() < 8)
+            return Http2FrameSizeError;
+        uint32_t lastStreamId = http2::ReadUInt32(frame.Payload.data()) & 0x7FFFFFFF;
+        uint32_t errorCode = http2::ReadUInt32(frame.Payload.data() + 4);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_peerGoneAway = true;
+        }
+        OnGoAway(lastStreamId, errorCode);
+        return Http2NoError;
+    }
+
+    case Http2WindowUpdate:
+        return HandleWindowUpdate(frame);
+
+    default:
+        // Frames of unknown types are ignored (RFC 7540, 4.1).
+        return Http2NoError;
+    }
+}
+
+uint32_t Http2Connection::HandleHeaderBlock()
+{
+    uint32_t streamId = m_headerStreamId;
+    bool endStream = m_headerEndStream;
+    m_headerStreamId = 0;
+
+    // The block is decoded even if the stream is refused, to keep the HPACK state in sync.
+    HeaderFieldList headers;
+    bool decoded = m_decoder.Decode(m_headerBlock.data(), m_headerBlock.size(), headers);
+    m_headerBlock.clear();
+    if (!decoded)
+        return Http2CompressionError;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto stream = FindStream(streamId);
+        if (!stream)
+        {
+            // Frames of the streams we have reset may still arrive.
+            if (IsLocalStream(streamId) || streamId <= m_lastPeerStreamId)
+                return Http2NoError;
+            m_lastPeerStreamId = streamId;
+            if (m_goingAway)
+                return Http2NoError;
+            stream = CreateStream(streamId);
+        }
+        else if (stream->RemoteClosed)
+        {
+            ResetStreamLocked(streamId, Http2StreamClosed);
+            return Http2NoError;
+        }
+        if (m_headerHasPriority)
+            SetPriority(*stream, m_headerPriority);
+        stream->RemoteClosed = endStream;
+        MaybeCloseStream(stream);
+    }
+    OnHeaders(streamId, headers, endStream);
+    return Http2NoError;
+}
+
+uint32_t Http2Connection::HandleData(Http2Frame & frame)
+{
+    if (frame.StreamId == 0)
+        return Http2ProtocolError;
+    // The padding counts for flow control.
+    int64_t length = (int64_t)frame.Payload.size();
+    if (!http2::RemovePadding(frame))
+        return Http2ProtocolError;
+    bool endStream = (frame.Flags & Http2FlagEndStream) != 0;
+
+    bool reset = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_recvWindow -= length;
+        if (m_recvWindow < 0)
+            return Http2FlowControlError;
+        m_recvConsumed += length;
+        if (m_recvConsumed >= kConnectionWindowSize / 2)
+        {
+            http2::AppendWindowUpdate(m_control, 0, (uint32_t)m_recvConsumed);
+            m_recvWindow += m_recvConsumed;
+            m_recvConsumed = 0;
+            m_cv.notify_all();
+        }
+
+        auto stream = FindStream(frame.StreamId);
+        if (!stream)
+        {
+            if (!IsLocalStream(frame.StreamId) && frame.StreamId > m_lastPeerStreamId)
+                return Http2ProtocolError;
+            return Http2NoError;
+        }
+        if (stream->RemoteClosed)
+        {
+            ResetStreamLocked(frame.StreamId, Http2StreamClosed);
+            return Http2NoError;
+        }
+        stream->RecvWindow -= length;
+        if (stream->RecvWindow < 0)
+        {
+            ResetStreamLocked(frame.StreamId, Http2FlowControlError);
+            reset = true;
+        }
+        else
+        {
+            // Only the data passed to OnData waits for ConsumeData.
+            stream->RemoteClosed = endStream;
+            ConsumeDataLocked(*stream, length - (int64_t)frame.Payload.size());
+            MaybeCloseStream(stream);
+        }
+    }
+    if (reset)
+    {
+        OnStreamReset(frame.StreamId, Http2FlowControlError);
+        return Http2NoError;
+    }
+    OnData(frame.StreamId, frame.Payload.data(), frame.Payload.size(), endStream);
+    return Http2NoError;
+}
+
+void Http2Connection::ConsumeData(uint32_t streamId, size_t length)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto stream = FindStream(streamId);
+    if (stream)
+        ConsumeDataLocked(*stream, (int64_t)length);
+}
+
+void Http2Connection::ConsumeDataLocked(Stream & stream, int64_t length)
+{
+    // The window of a stream the peer has closed is not needed anymore.
+    if (length <= 0 || stream.RemoteClosed)
+        return;
+    stream.RecvConsumed += length;
+    if (stream.RecvConsumed >= kStreamWindowSize / 2)
+    {
+        http2::AppendWindowUpdate(m_control, stream.Id, (uint32_t)stream.RecvConsumed);
+        stream.RecvWindow += stream.RecvConsumed;
+        stream.RecvConsumed = 0;
+        m_cv.notify_all();
+    }
+}
+
+uint32_t Http2Connection::HandleSettings(Http2Frame & frame)
+{
+    if (frame.StreamId != 0)
+        return Http2ProtocolError;
+    if (frame.Flags & Http2FlagAck)
+        return frame.Payload.empty() ? Http2NoError : Http2FrameSizeError;
+    uint32_t error = ApplyRemoteSettings(frame.Payload);
+    if (error != Http2NoError)
+        return error;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        http2::AppendFrame(m_control, Http2Settings, Http2FlagAck, 0, nullptr, 0);
+        m_cv.notify_all();
+    }
+    OnSettings();
+    return Http2NoError;
+}
+
+uint32_t Http2Connection::HandleWindowUpdate(Http2Frame & frame)
+{
+    if (frame.Payload.size() != 4)
+        return Http2FrameSizeError;
+    int64_t increment = http2::ReadUInt32(frame.Payload.data()) & 0x7FFFFFFF;
+    if (frame.StreamId == 0)
+    {
+        if (increment == 0)
+            return Http2ProtocolError;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sendWindow += increment;
+        if (m_sendWindow > kHttp2MaxWindowSize)
+            return Http2FlowControlError;
+        m_cv.notify_all();
+        return Http2NoError;
+    }
+
+    uint32_t errorCode = Http2NoError;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto stream = FindStream(frame.StreamId);
+        if (!stream)
+            return Http2NoError;
+        stream->SendWindow += increment;
+        if (increment == 0)
+            errorCode = Http2ProtocolError;
+        else if (stream->SendWindow > kHttp2MaxWindowSize)
+            errorCode = Http2FlowControlError;
+        if (errorCode != Http2NoError)
+            ResetStreamLocked(frame.StreamId, errorCode);
+        m_cv.notify_all();
+    }
+    if (errorCode != Http2NoError)
+        OnStreamReset(frame.StreamId, errorCode);
+    return Http2NoError;
+}
+
+uint32_t Http2Connection::HandleRstStream(Http2Frame & frame)
+{
+    if (frame.StreamId == 0)
+        return Http2ProtocolError;
+    if (frame.Payload.size() != 4)
+        return Http2FrameSizeError;
+    uint32_t errorCode = http2::ReadUInt32(frame.Payload.data());
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!FindStream(frame.StreamId))
+        {
+            if (!IsLocalStream(frame.StreamId) && frame.StreamId > m_lastPeerStreamId)
+                return Http2ProtocolError;
+            return Http2NoError;
+        }
+        CloseStream(frame.StreamId);
+    }
+    OnStreamReset(frame.StreamId, errorCode);
+    return Http2NoError;
+}
+
+void Http2Connection::WriteLoop()
+{
+    Writer writer(m_socket);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        std::string out;
+        out.swap(m_control);
+        while (out.size() < kWriteBatchSize)
+        {
+            auto stream = NextStream();
+            if (!stream)
+                break;
+            m_virtualTime = stream->VirtualTime;
+            EmitFrame(*stream, out);
+            MaybeCloseStream(stream);
+        }
+        if (out.empty())
+        {
+            if (m_stopWriter)
+                break;
+            m_cv.wait(lock);
+            continue;
+        }
+
+        // The queues have room again.
+        m_cv.notify_all();
+        lock.unlock();
+        bool ok = writer.Write(out) == (int)out.size();
+        lock.lock();
+        if (!ok)
+        {
+            m_broken = true;
+            m_cv.notify_all();
+            break;
+        }
+    }
+}
+
+bool Http2Connection::IsSendable(const Stream & stream, uint32_t firstUnopened) const
+{
+    if (stream.Pending.empty())
+        return false;
+    const PendingFrame& frame = stream.Pending.front();
+    if (frame.Headers)
+    {
+        // New streams are opened in the order of their identifiers (RFC 7540, 5.1.1).
+        return stream.HeadersSent || !IsLocalStream(stream.Id) || stream.Id == firstUnopened;
+    }
+    if (frame.Offset == frame.Data.size())
+        return true;
+    return stream.SendWindow > 0 && m_sendWindow > 0;
+}
+
+std::shared_ptr<Http2Connection::Stream> Http2Connection::NextStream() const
+{
+    uint32_t firstUnopened = 0;
+    for (auto& kv : m_streams)
+    {
+        if (IsLocalStream(kv.first) && !kv.second->HeadersSent && !kv.second->Pending.empty())
+        {
+            firstUnopened = kv.first;
+            break;
+        }
+    }
+
+    // The stream which has sent the least, in proportion to its weight, goes first.
+    // A stream waits while one of its ancestors has something to send (RFC 7540, 5.3.1).
+    std::shared_ptr<Stream> next;
+    for (auto& kv : m_streams)
+    {
+        const auto& stream = kv.second;
+        if (!IsSendable(*stream, firstUnopened))
+            continue;
+        bool blocked = false;
+        uint32_t parent = stream->Parent;
+        for (int depth = 0; parent != 0 && depth < kMaxPriorityDepth; ++depth)
+        {
+            auto ancestor = FindStream(parent);
+            if (!ancestor)
+                break;
+            if (IsSendable(*ancestor, firstUnopened))
+            {
+                blocked = true;
+                break;
+            }
+            parent = ancestor->Parent;
+        }
+        if (blocked)
+            continue;
+        if (!next || stream->VirtualTime < next->VirtualTime)
+            next = stream;
+    }
+    return next;
+}
+
+void Http2Connection::EmitFrame(Stream & stream, std::string & out)
+{
+    PendingFrame& frame = stream.Pending.front();
+    size_t sent = 0;
+    bool done = true;
+    if (frame.Headers)
+    {
+        std::string block;
+        m_encoder.Encode(frame.Fields, block);
+        size_t offset = 0;
+        do
+        {
+            size_t length = block.size() - offset;
+            if (length > m_peerMaxFrameSize)
+                length = m_peerMaxFrameSize;
+            uint8_t flags = 0;
+            if (offset + length == block.size())
+                flags |= Http2FlagEndHeaders;
+            if (offset == 0 && frame.EndStream)
+                flags |= Http2FlagEndStream;
+            http2::AppendFrame(out, offset == 0 ? Http2Headers : Http2Continuation,
+                flags, stream.Id, block.data() + offset, length);
+            offset += length;
+        } while (offset < block.size());
+        stream.HeadersSent = true;
+        sent = block.size();
+    }
+    else
+    {
+        int64_t length = (int64_t)(frame.Data.size() - frame.Offset);
+        if (length > stream.SendWindow)
+            length = stream.SendWindow;
+        if (length > m_sendWindow)
+            length = m_sendWindow;
+        if (length > m_peerMaxFrameSize)
+            length = m_peerMaxFrameSize;
+        done = frame.Offset + length == frame.Data.size();
+        http2::AppendFrame(out, Http2Data, done && frame.EndStream ? Http2FlagEndStream : 0,
+            stream.Id, frame.Data.data() + frame.Offset, (size_t)length);
+        frame.Offset += (size_t)length;
+        stream.SendWindow -= length;
+        m_sendWindow -= length;
+        stream.PendingBytes -= (size_t)length;
+        sent = (size_t)length;
+    }
+    stream.VirtualTime += (sent + kHttp2FrameHeaderLength) * 256 / stream.Weight;
+    if (done)
+        stream.Pending.pop_front();
+}
+
+} // !namespace http
+} // !namespace net
@@ -0,0 +1,204 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "net/http/hpack.h"
+#include "net/http/http2_frame.h"
+#include "net/socket/StreamSocket.h"
+
+namespace net {
+namespace http {
+
+// Http2Connection implements the parts of an HTTP/2 connection (RFC 7540) shared by
+// the server and the client: settings, flow control, stream states and write scheduling.
+//
+// One thread runs Run and reads the frames, the frames are sent by a writer thread.
+// SendHeaders and SendData may be called from any thread, they queue the frames per stream
+// and the writer picks the next stream by priority (weighted fair queuing among siblings,
+// a stream waits while its parent has something to send), within the flow-control windows.
+class Http2Connection
+    : public std::enable_shared_from_this<Http2Connection>
+{
+public:
+    virtual ~Http2Connection();
+
+    // SendHeaders queues a HEADERS frame. The header block is encoded when the frame is
+    // sent, so that the HPACK dynamic table sees the blocks in the order of the wire.
+    bool SendHeaders(uint32_t streamId, const HeaderFieldList& headers, bool endStream);
+
+    // SendData queues DATA frames, it blocks while too much data of the stream is waiting
+    // for the flow-control window. It returns false if the stream or connection is closed.
+    bool SendData(uint32_t streamId, const char* data, size_t length, bool endStream);
+
+    void ResetStream(uint32_t streamId, uint32_t errorCode);
+
+    // GoAway tells the peer that no more streams will be processed.
+    void GoAway(uint32_t errorCode);
+
+    bool IsClosed() const;
+
+protected:
+    Http2Connection(std::shared_ptr<StreamSocket> s, bool server);
+
+    // ApplyRemoteSettings applies the SETTINGS payload of the peer.
+    // It returns Http2NoError or the error code of the connection error.
+    uint32_t ApplyRemoteSettings(const std::string& payload);
+
+    // OpenStream registers a stream before its first frame is sent or received,
+    // e.g. the stream 1 of an upgraded HTTP/1.1 request.
+    void OpenStream(uint32_t streamId, bool remoteClosed);
+
+    // Run sends the SETTINGS and reads the frames until the connection ends.
+    void Run(Http2FrameReader& reader);
+
+    // The callbacks are invoked from the thread of Run.
+    virtual void OnHeaders(uint32_t streamId, HeaderFieldList& headers, bool endStream) = 0;
+    // The data passed to OnData counts against the receive window of its stream until
+    // ConsumeData returns it, so that a peer can't send faster than it is consumed.
+    virtual void OnData(uint32_t streamId, const char* data, size_t length, bool endStream) = 0;
+    // OnStreamReset is invoked when the peer or a stream error resets a stream.
+    virtual void OnStreamReset(uint32_t streamId, uint32_t errorCode) = 0;
+    virtual void OnGoAway(uint32_t lastStreamId, uint32_t errorCode) {}
+    // OnSettings is invoked once the SETTINGS of the peer have been applied.
+    virtual void OnSettings() {}
+    // OnReadFinished is invoked when reading stops. The streams are closed by then, so that
+    // SendHeaders and SendData fail, a queued GOAWAY is still sent until it returns.
+    virtual void OnReadFinished() {}
+
+    // Our SETTINGS, which are sent by Run.
+    virtual void LocalSettings(std::string& payload) const = 0;
+
+    // ConsumeData credits the receive window of a stream with |length| bytes of its data
+    // once they are consumed. It may be called from any thread.
+    void ConsumeData(uint32_t streamId, size_t length);
+
+    uint32_t GetPeerMaxConcurrentStreams() const;
+    size_t GetActiveStreamCount() const;
+
+private:
+    struct PendingFrame
+    {
+        bool Headers = false;
+        HeaderFieldList Fields;
+        std::string Data;
+        size_t Offset = 0;
+        bool EndStream = false;
+    };
+
+    struct Stream
+    {
+        uint32_t Id = 0;
+        bool LocalClosed = false;
+        bool RemoteClosed = false;
+        bool HeadersSent = false;
+        bool Closed = false;
+        int64_t SendWindow = kHttp2DefaultWindowSize;
+        int64_t RecvWindow = kHttp2DefaultWindowSize;
+        int64_t RecvConsumed = 0;
+        uint32_t Parent = 0;
+        int Weight = 16;
+        uint64_t VirtualTime = 0;
+        std::deque<PendingFrame> Pending;
+        size_t PendingBytes = 0;
+    };
+
+    struct Priority
+    {
+        uint32_t Parent = 0;
+        int Weight = 16;
+        bool Exclusive = false;
+    };
+
+    // IsControlQueueFull returns whether the control frames waiting to be sent are
+    // beyond their limit.
+    bool IsControlQueueFull() const;
+
+    // The members below are called with m_mutex locked.
+    bool IsLocalStream(uint32_t streamId) const;
+    std::shared_ptr<Stream> FindStream(uint32_t streamId) const;
+    std::shared_ptr<Stream> CreateStream(uint32_t streamId);
+    void CloseStream(uint32_t streamId);
+    void MaybeCloseStream(const std::shared_ptr<Stream>& stream);
+    void ResetStreamLocked(uint32_t streamId, uint32_t errorCode);
+    void ConsumeDataLocked(Stream& stream, int64_t length);
+    void SetPriority(Stream& stream, const Priority& priority);
+
+    // Handle* return Http2NoError or the error code of a connection error.
+    uint32_t HandleFrame(Http2Frame& frame);
+    uint32_t HandleHeaderBlock();
+    uint32_t HandleData(Http2Frame& frame);
+    uint32_t HandleSettings(Http2Frame& frame);
+    uint32_t HandleWindowUpdate(Http2Frame& frame);
+    uint32_t HandleRstStream(Http2Frame& frame);
+
+    // Writer thread.
+    void WriteLoop();
+    bool IsSendable(const Stream& stream, uint32_t firstUnopened) const;
+    std::shared_ptr<Stream> NextStream() const;
+    void EmitFrame(Stream& stream, std::string& out);
+
+protected:
+    std::shared_ptr<StreamSocket> m_socket;
+    bool m_server;
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::map<uint32_t, std::shared_ptr<Stream>> m_streams;
+    std::string m_control;
+    std::thread m_writer;
+    bool m_stopWriter = false;
+    bool m_broken = false;
+    bool m_goingAway = false;
+
+    HpackEncoder m_encoder;
+    HpackDecoder m_decoder;
+
+    // Peer settings.
+    uint32_t m_peerMaxFrameSize = kHttp2DefaultMaxFrameSize;
+    uint32_t m_peerMaxConcurrentStreams = 0xFFFFFFFF;
+    int64_t m_peerInitialWindowSize = kHttp2DefaultWindowSize;
+
+    int64_t m_sendWindow = kHttp2DefaultWindowSize;
+    int64_t m_recvWindow = kHttp2DefaultWindowSize;
+    int64_t m_recvConsumed = 0;
+    uint64_t m_virtualTime = 0;
+
+    uint32_t m_lastPeerStreamId = 0;
+    bool m_receivedSettings = false;
+    bool m_peerGoneAway = false;
+
+    // The header block being received in HEADERS and CONTINUATION frames.
+    uint32_t m_headerStreamId = 0;
+    bool m_headerEndStream = false;
+    bool m_headerHasPriority = false;
+    Priority m_headerPriority;
+    std::string m_headerBlock;
+};
+
+} // !namespace http
+} // !namespace net
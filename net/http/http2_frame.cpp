@@ -0,0 +1,185 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/http/http2_frame.h"
+
+namespace net {
+namespace http {
+
+const char kHttp2Preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+namespace {
+
+const int kReceiveBufferSize = 16 * 1024;
+
+} // !namespace anonymous
+
+void Http2FrameReader::Reset(StreamSocket * s, const std::string & buffered /*= ""*/)
+{
+    m_stream = s;
+    m_buffer = buffered;
+    m_offset = 0;
+}
+
+bool Http2FrameReader::ReadPreface()
+{
+    if (!Fill(kHttp2PrefaceLength))
+        return false;
+    if (m_buffer.compare(m_offset, kHttp2PrefaceLength, kHttp2Preface) != 0)
+        return false;
+    m_offset += kHttp2PrefaceLength;
+    return true;
+}
+
+bool Http2FrameReader::ReadFrame(Http2Frame & frame, bool & frameSizeError)
+{
+    frameSizeError = false;
+    if (!Fill(kHttp2FrameHeaderLength))
+        return false;
+    const char* header = m_buffer.data() + m_offset;
+    uint32_t length = http2::ReadUInt24(header);
+    frame.Type = (uint8_t)header[3];
+    frame.Flags = (uint8_t)header[4];
+    frame.StreamId = http2::ReadUInt32(header + 5) & 0x7FFFFFFF;
+    if (length > m_maxFrameSize)
+    {
+        frameSizeError = true;
+        return false;
+    }
+    if (!Fill(kHttp2FrameHeaderLength + length))
+        return false;
+    frame.Payload.assign(m_buffer, m_offset + kHttp2FrameHeaderLength, length);
+    m_offset += kHttp2FrameHeaderLength + length;
+    return true;
+}
+
+bool Http2FrameReader::Fill(size_t length)
+{
+    if (m_buffer.size() - m_offset >= length)
+        return true;
+    if (!m_stream)
+        return false;
+    if (m_offset > 0)
+    {
+        m_buffer.erase(0, m_offset);
+        m_offset = 0;
+    }
+    char buffer[kReceiveBufferSize];
+    while (m_buffer.size() < length)
+    {
+        int len = m_stream->Receive(buffer, kReceiveBufferSize);
+        if (len <= 0)
+        {
+            m_error = WSAGetLastError();
+            return false;
+        }
+        m_buffer.append(buffer, len);
+    }
+    return true;
+}
+
+namespace http2 {
+
+void AppendFrameHeader(std::string & out, size_t length, uint8_t type, uint8_t flags, uint32_t streamId)
+{
+    out.push_back((char)((length >> 16) & 0xFF));
+    out.push_back((char)((length >> 8) & 0xFF));
+    out.push_back((char)(length & 0xFF));
+    out.push_back((char)type);
+    out.push_back((char)flags);
+    AppendUInt32(out, streamId & 0x7FFFFFFF);
+}
+
+void AppendFrame(std::string & out, uint8_t type, uint8_t flags, uint32_t streamId, const char * payload, size_t length)
+{
+    AppendFrameHeader(out, length, type, flags, streamId);
+    if (length > 0)
+        out.append(payload, length);
+}
+
+void AppendSetting(std::string & payload, uint16_t id, uint32_t value)
+{
+    payload.push_back((char)(id >> 8));
+    payload.push_back((char)(id & 0xFF));
+    AppendUInt32(payload, value);
+}
+
+void AppendRstStream(std::string & out, uint32_t streamId, uint32_t errorCode)
+{
+    AppendFrameHeader(out, 4, Http2RstStream, 0, streamId);
+    AppendUInt32(out, errorCode);
+}
+
+void AppendGoAway(std::string & out, uint32_t lastStreamId, uint32_t errorCode)
+{
+    AppendFrameHeader(out, 8, Http2GoAway, 0, 0);
+    AppendUInt32(out, lastStreamId & 0x7FFFFFFF);
+    AppendUInt32(out, errorCode);
+}
+
+void AppendWindowUpdate(std::string & out, uint32_t streamId, uint32_t increment)
+{
+    AppendFrameHeader(out, 4, Http2WindowUpdate, 0, streamId);
+    AppendUInt32(out, increment & 0x7FFFFFFF);
+}
+
+uint32_t ReadUInt32(const char * p)
+{
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+}
+
+uint32_t ReadUInt24(const char * p)
+{
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+    return ((uint32_t)b[0] << 16) | ((uint32_t)b[1] << 8) | b[2];
+}
+
+uint16_t ReadUInt16(const char * p)
+{
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+    return (uint16_t)(((uint32_t)b[0] << 8) | b[1]);
+}
+
+void AppendUInt32(std::string & out, uint32_t value)
+{
+    out.push_back((char)((value >> 24) & 0xFF));
+    out.push_back((char)((value >> 16) & 0xFF));
+    out.push_back((char)((value >> 8) & 0xFF));
+    out.push_back((char)(value & 0xFF));
+}
+
+bool RemovePadding(Http2Frame & frame)
+{
+    if (0 == (frame.Flags & Http2FlagPadded))
+        return true;
+    if (frame.Payload.empty())
+        return false;
+    size_t padLength = (uint8_t)frame.Payload[0];
+    if (padLength >= frame.Payload.size())
+        return false;
+    frame.Payload.erase(frame.Payload.size() - padLength);
+    frame.Payload.erase(0, 1);
+    frame.Flags &= ~Http2FlagPadded;
+    return true;
+}
+
+} // !namespace http2
+
+} // !namespace http
+} // !namespace net
@@ -0,0 +1,153 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "net/socket/StreamSocket.h"
+
+namespace net {
+namespace http {
+
+// HTTP/2 framing layer (RFC 7540, 4 and 6).
+
+// The client connection preface (RFC 7540, 3.5).
+extern const char kHttp2Preface[];
+const size_t kHttp2PrefaceLength = 24;
+
+const size_t kHttp2FrameHeaderLength = 9;
+const uint32_t kHttp2DefaultMaxFrameSize = 16384;
+const uint32_t kHttp2MaxFrameSizeLimit = 16777215;
+const int32_t kHttp2DefaultWindowSize = 65535;
+const int32_t kHttp2MaxWindowSize = 0x7FFFFFFF;
+
+enum Http2FrameType
+{
+    Http2Data = 0x0,
+    Http2Headers = 0x1,
+    Http2Priority = 0x2,
+    Http2RstStream = 0x3,
+    Http2Settings = 0x4,
+    Http2PushPromise = 0x5,
+    Http2Ping = 0x6,
+    Http2GoAway = 0x7,
+    Http2WindowUpdate = 0x8,
+    Http2Continuation = 0x9,
+};
+
+enum Http2FrameFlag
+{
+    Http2FlagEndStream = 0x1,
+    Http2FlagAck = 0x1,
+    Http2FlagEndHeaders = 0x4,
+    Http2FlagPadded = 0x8,
+    Http2FlagPriority = 0x20,
+};
+
+enum Http2SettingId
+{
+    Http2SettingHeaderTableSize = 0x1,
+    Http2SettingEnablePush = 0x2,
+    Http2SettingMaxConcurrentStreams = 0x3,
+    Http2SettingInitialWindowSize = 0x4,
+    Http2SettingMaxFrameSize = 0x5,
+    Http2SettingMaxHeaderListSize = 0x6,
+};
+
+enum Http2ErrorCode
+{
+    Http2NoError = 0x0,
+    Http2ProtocolError = 0x1,
+    Http2InternalError = 0x2,
+    Http2FlowControlError = 0x3,
+    Http2SettingsTimeout = 0x4,
+    Http2StreamClosed = 0x5,
+    Http2FrameSizeError = 0x6,
+    Http2RefusedStream = 0x7,
+    Http2Cancel = 0x8,
+    Http2CompressionError = 0x9,
+    Http2ConnectError = 0xa,
+    Http2EnhanceYourCalm = 0xb,
+    Http2InadequateSecurity = 0xc,
+    Http2Http11Required = 0xd,
+};
+
+struct Http2Frame
+{
+    uint8_t Type = 0;
+    uint8_t Flags = 0;
+    uint32_t StreamId = 0;
+    std::string Payload;
+};
+
+// Http2FrameReader reads frames from a stream socket.
+class Http2FrameReader
+{
+public:
+    Http2FrameReader() {}
+    ~Http2FrameReader() {}
+
+    // |buffered| holds the bytes already received from |s|, e.g. by the HTTP/1 reader.
+    void Reset(StreamSocket* s, const std::string& buffered = "");
+
+    void SetMaxFrameSize(uint32_t size) { m_maxFrameSize = size; }
+
+    // ReadPreface consumes the client connection preface.
+    bool ReadPreface();
+
+    // ReadFrame returns false when the socket fails. A frame larger than the
+    // max frame size sets |frameSizeError|, which is a connection error.
+    bool ReadFrame(Http2Frame& frame, bool& frameSizeError);
+
+    int GetErrorCode() const { return m_error; }
+
+private:
+    bool Fill(size_t length);
+
+private:
+    StreamSocket* m_stream = nullptr;
+    std::string m_buffer;
+    size_t m_offset = 0;
+    uint32_t m_maxFrameSize = kHttp2DefaultMaxFrameSize;
+    int m_error = 0;
+};
+
+namespace http2 {
+
+// The helpers append a serialized frame to |out|.
+void AppendFrameHeader(std::string& out, size_t length, uint8_t type, uint8_t flags, uint32_t streamId);
+void AppendFrame(std::string& out, uint8_t type, uint8_t flags, uint32_t streamId, const char* payload, size_t length);
+void AppendSetting(std::string& payload, uint16_t id, uint32_t value);
+void AppendRstStream(std::string& out, uint32_t streamId, uint32_t errorCode);
+void AppendGoAway(std::string& out, uint32_t lastStreamId, uint32_t errorCode);
+void AppendWindowUpdate(std::string& out, uint32_t streamId, uint32_t increment);
+
+uint32_t ReadUInt32(const char* p);
+uint32_t ReadUInt24(const char* p);
+uint16_t ReadUInt16(const char* p);
+void AppendUInt32(std::string& out, uint32_t value);
+
+// RemovePadding strips the padding of a PADDED frame payload.
+bool RemovePadding(Http2Frame& frame);
+
+} // !namespace http2
+
+} // !namespace http
+} // !namespace net
@@ -0,0 +1,422 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/http/http2_server.h"
+
+#include <climits>
+#include <thread>
+
+#include "net/base/strings/string_utils.h"
+#include "net/http/status.h"
+#include "net/http/utils.h"
+
+namespace net {
+namespace http {
+
+namespace {
+
+const uint32_t kMaxConcurrentStreams = 100;
+
+// The data of the request bodies being received on a connection is consumed, so that
+// the client may send more, while they buffer up to this many bytes together. Beyond
+// it only the oldest request receives more, the others wait for it to be dispatched.
+const size_t kMaxReceivingBytes = 8 * 1024 * 1024;
+
+// The connection-specific header fields are not used in HTTP/2 (RFC 7540, 8.1.2.2).
+bool IsConnectionHeader(const std::string& name)
+{
+    return name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+        name == "transfer-encoding" || name == "upgrade";
+}
+
+// ContentLength sets |length| to the Content-Length of |request|, or -1 if it has none.
+// It returns false if the value is not a number.
+bool ContentLength(const Request& request, long long& length)
+{
+    auto value = request.GetHeaderView("content-length");
+    length = -1;
+    if (value.empty())
+        return true;
+    length = 0;
+    for (char c : value)
+    {
+        if (c < '0' || c > '9' || length > (LLONG_MAX - 9) / 10)
+            return false;
+        length = length * 10 + (c - '0');
+    }
+    return true;
+}
+
+bool HasUpperCase(const std::string& str)
+{
+    for (auto c : str)
+    {
+        if (c >= 'A' && c <= 'Z')
+            return true;
+    }
+    return false;
+}
+
+// StreamResponseWriter sends a response on an HTTP/2 stream.
+class StreamResponseWriter
+    : public ResponseWriter
+{
+public:
+    StreamResponseWriter(std::shared_ptr<Http2Connection> connection, uint32_t streamId)
+        : m_connection(connection)
+        , m_streamId(streamId)
+    {
+    }
+
+    int WriteHeader(const Response& response, const void* body, int length) override
+    {
+        HeaderFieldList fields;
+        fields.emplace_back(":status", std::to_string(response.GetStatusCode()));
+        auto& headers = response.GetHeadersView();
+        for (auto iter = headers.begin(); iter != headers.end(); ++iter)
+        {
+            auto name = base::strings::ToLower(iter->first);
+            if (IsConnectionHeader(name))
+                continue;
+            fields.emplace_back(name, iter->second);
+        }
+
+        // The stream ends with the last byte of a body of known length.
+        try
+        {
+            m_remaining = std::stoll(response.GetHeader("Content-Length"));
+        }
+        catch (...)
+        {
+            m_remaining = -1;
+        }
+        m_ended = m_remaining == 0;
+        if (!m_connection->SendHeaders(m_streamId, fields, m_ended))
+            return -1;
+        if (length > 0)
+            return Write(body, length);
+        return 0;
+    }
+
+    int Write(const void* buffer, int length) override
+    {
+        if (m_ended || length < 0)
+            return -1;
+        if (m_remaining > 0)
+        {
+            m_remaining -= length;
+            m_ended = m_remaining <= 0;
+        }
+        if (!m_connection->SendData(m_streamId, (const char*)buffer, length, m_ended))
+            return -1;
+        return length;
+    }
+
+    bool Flush() override
+    {
+        // The frames are sent as soon as the flow control allows.
+        return true;
+    }
+
+    bool Finish() override
+    {
+        if (m_ended)
+            return true;
+        m_ended = true;
+        return m_connection->SendData(m_streamId, "", 0, true);
+    }
+
+private:
+    std::shared_ptr<Http2Connection> m_connection;
+    uint32_t m_streamId;
+    long long m_remaining = -1;
+    bool m_ended = false;
+};
+
+} // !namespace anonymous
+
+Http2ServerConnection::Http2ServerConnection(std::shared_ptr<StreamSocket> s, std::shared_ptr<Handler> handler)
+    : Http2Connection(s, true)
+    , m_handler(handler)
+{
+}
+
+std::shared_ptr<Http2ServerConnection> Http2ServerConnection::Create(std::shared_ptr<StreamSocket> s, std::shared_ptr<Handler> handler)
+{
+    return std::shared_ptr<Http2ServerConnection>(new Http2ServerConnection(s, handler));
+}
+
+void Http2ServerConnection::Serve(const std::string & buffered)
+{
+    Http2FrameReader reader;
+    reader.Reset(m_socket.get(), buffered);
+    if (!reader.ReadPreface())
+        return;
+    Run(reader);
+}
+
+void Http2ServerConnection::ServeUpgrade(std::shared_ptr<Request> request, const std::string & settings, const std::string & buffered)
+{
+    if (ApplyRemoteSettings(settings) != Http2NoError)
+        return;
+    Http2FrameReader reader;
+    reader.Reset(m_socket.get(), buffered);
+    if (!reader.ReadPreface())
+        return;
+
+    // The request has been received entirely, the stream 1 is half-closed (remote).
+    OpenStream(1, true);
+    request->SetProto(2, 0);
+    PendingRequest pending;
+    pending.Message = request;
+    pending.Body = request->TakeBody();
+    Dispatch(1, pending);
+    Run(reader);
+}
+
+void Http2ServerConnection::SetMaxBodySize(size_t size)
+{
+    m_maxBodySize = size;
+}
+
+void Http2ServerConnection::OnHeaders(uint32_t streamId, HeaderFieldList & headers, bool endStream)
+{
+    auto iter = m_requests.find(streamId);
+    if (iter != m_requests.end())
+    {
+        // Trailers.
+        auto pending = TakeRequest(iter);
+        if (!endStream || (pending.ContentLength >= 0 && pending.ContentLength != (long long)pending.Body.size()))
+        {
+            ResetStream(streamId, Http2ProtocolError);
+            return;
+        }
+        for (auto& field : headers)
+        {
+            if (!field.first.empty() && field.first[0] != ':')
+                pending.Message->SetHeader(field.first, field.second);
+        }
+        Dispatch(streamId, pending);
+        return;
+    }
+
+    // A reset stream leaves the count of the active ones while its handler still runs,
+    // so the handlers are counted as well, or a client resetting its streams right away
+    // could start any number of them.
+    bool refused = GetActiveStreamCount() > kMaxConcurrentStreams;
+    if (!refused)
+    {
+        std::lock_guard<std::mutex> lock(m_servingMutex);
+        refused = m_serving >= kMaxConcurrentStreams;
+    }
+    if (refused)
+    {
+        ResetStream(streamId, Http2RefusedStream);
+        return;
+    }
+    PendingRequest pending;
+    pending.Message = CreateRequest(headers);
+    // The data must add up to the Content-Length (RFC 7540, 8.1.2.6).
+    if (!pending.Message || !ContentLength(*pending.Message, pending.ContentLength) ||
+        (endStream && pending.ContentLength > 0))
+    {
+        ResetStream(streamId, Http2ProtocolError);
+        return;
+    }
+    if (m_maxBodySize > 0 && pending.ContentLength > (long long)m_maxBodySize)
+    {
+        ResetStream(streamId, Http2Cancel);
+        return;
+    }
+    if (endStream)
+        Dispatch(streamId, pending);
+    else
+        m_requests[streamId] = pending;
+}
+
+void Http2ServerConnection::OnData(uint32_t streamId, const char * data, size_t length, bool endStream)
+{
+    auto iter = m_requests.find(streamId);
+    if (iter == m_requests.end())
+        return;
+    auto& pending = iter->second;
+    if (m_maxBodySize > 0 && pending.Body.size() + length > m_maxBodySize)
+    {
+        TakeRequest(iter);
+        ResetStream(streamId, Http2Cancel);
+        return;
+    }
+    auto size = pending.Body.size() + length;
+    if (pending.ContentLength >= 0 &&
+        (size > (unsigned long long)pending.ContentLength || (endStream && size != (unsigned long long)pending.ContentLength)))
+    {
+        TakeRequest(iter);
+        ResetStream(streamId, Http2ProtocolError);
+        return;
+    }
+    pending.Body.append(data, length);
+    m_receiving += length;
+    if (endStream)
+    {
+        auto request = TakeRequest(iter);
+        Dispatch(streamId, request);
+        return;
+    }
+
+    // The oldest request is always credited, so that one of them completes.
+    if (m_receiving <= kMaxReceivingBytes || iter == m_requests.begin())
+        ConsumeData(streamId, length);
+    else
+        pending.Uncredited += length;
+}
+
+void Http2ServerConnection::OnStreamReset(uint32_t streamId, uint32_t errorCode)
+{
+    auto iter = m_requests.find(streamId);
+    if (iter != m_requests.end())
+        TakeRequest(iter);
+}
+
+void Http2ServerConnection::OnReadFinished()
+{
+    m_requests.clear();
+    m_receiving = 0;
+    // The streams are closed, the handlers still writing fail and return.
+    std::unique_lock<std::mutex> lock(m_servingMutex);
+    m_servingDone.wait(lock, [this]() { return m_serving == 0; });
+}
+
+void Http2ServerConnection::LocalSettings(std::string & payload) const
+{
+    http2::AppendSetting(payload, Http2SettingMaxConcurrentStreams, kMaxConcurrentStreams);
+}
+
+std::shared_ptr<Request> Http2ServerConnection::CreateRequest(const HeaderFieldList & headers)
+{
+    std::string method, scheme, authority, path;
+    Header h;
+    bool regular = false;
+    for (auto& field : headers)
+    {
+        const std::string& name = field.first;
+        if (!name.empty() && name[0] == ':')
+        {
+            // The pseudo-header fields come first (RFC 7540, 8.1.2.1).
+            if (regular)
+                return nullptr;
+            if (name == ":method")
+                method = field.second;
+            else if (name == ":scheme")
+                scheme = field.second;
+            else if (name == ":authority")
+                authority = field.second;
+            else if (name == ":path")
+                path = field.second;
+            else
+                return nullptr;
+            continue;
+        }
+
+        regular = true;
+        if (name.empty() || HasUpperCase(name) || IsConnectionHeader(name))
+            return nullptr;
+        if (name == "te" && field.second != "trailers")
+            return nullptr;
+        if (name == "cookie")
+        {
+            // The cookie may be split into several fields (RFC 7540, 8.1.2.5).
+            auto cookie = h.find(name);
+            if (cookie != h.end())
+            {
+                cookie->second += "; " + field.second;
+                continue;
+            }
+        }
+        h.emplace(name, field.second);
+    }
+    // CONNECT is not supported.
+    if (method.empty() || scheme.empty() || path.empty())
+        return nullptr;
+
+    auto host = authority;
+    auto hostIter = h.find("host");
+    if (hostIter != h.end())
+        host = hostIter->second;
+    else if (!authority.empty())
+        h.emplace("host", authority);
+    if (host.empty())
+        return nullptr;
+
+    auto request = Request::Create(method, scheme + "://" + host + path);
+    if (!request)
+        return nullptr;
+    request->SetProto(2, 0);
+    request->SetHeader(std::move(h));
+
+    auto remoteAddress = m_socket->GetForeignAddress();
+    request->SetRemoteAddress(remoteAddress.GetHost() + ":" + std::to_string(remoteAddress.GetPort()));
+    return request;
+}
+
+Http2ServerConnection::PendingRequest Http2ServerConnection::TakeRequest(std::map<uint32_t, PendingRequest>::iterator iter)
+{
+    auto pending = std::move(iter->second);
+    m_receiving -= pending.Body.size();
+    m_requests.erase(iter);
+
+    for (auto entry = m_requests.begin(); entry != m_requests.end(); ++entry)
+    {
+        if (entry != m_requests.begin() && m_receiving > kMaxReceivingBytes)
+            break;
+        if (entry->second.Uncredited > 0)
+        {
+            ConsumeData(entry->first, entry->second.Uncredited);
+            entry->second.Uncredited = 0;
+        }
+    }
+    return pending;
+}
+
+void Http2ServerConnection::Dispatch(uint32_t streamId, PendingRequest & pending)
+{
+    SetRequestBody(pending.Message, std::move(pending.Body));
+    {
+        std::lock_guard<std::mutex> lock(m_servingMutex);
+        ++m_serving;
+    }
+    auto self = std::static_pointer_cast<Http2ServerConnection>(shared_from_this());
+    std::thread t(&Http2ServerConnection::ServeStream, self, streamId, pending.Message);
+    t.detach();
+}
+
+void Http2ServerConnection::ServeStream(uint32_t streamId, std::shared_ptr<Request> request)
+{
+    auto ctx = Context::Create(std::make_shared<StreamResponseWriter>(shared_from_this(), streamId), request);
+    if (m_handler)
+        m_handler->ServeHTTP(ctx);
+    else
+        ctx->GetResponse()->SetStatusCode(Status::NotFound);
+    ctx->Finish();
+
+    std::lock_guard<std::mutex> lock(m_servingMutex);
+    --m_serving;
+    m_servingDone.notify_all();
+}
+
+} // !namespace http
+} // !namespace net
@@ -0,0 +1,109 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "net/http/handler.h"
+#include "net/http/http2_connection.h"
+
+namespace net {
+namespace http {
+
+// Http2ServerConnection serves an HTTP/2 connection (RFC 7540) with a handler.
+// Every stream is served by its own thread, so the responses are multiplexed
+// on the connection in the order of the stream priorities.
+class Http2ServerConnection
+    : public Http2Connection
+{
+public:
+    ~Http2ServerConnection() {}
+
+private:
+    Http2ServerConnection(
+        std::shared_ptr<StreamSocket> s,
+        std::shared_ptr<Handler> handler);
+
+public:
+    static std::shared_ptr<Http2ServerConnection>
+        Create(
+            std::shared_ptr<StreamSocket> s,
+            std::shared_ptr<Handler> handler);
+
+    // Serve reads the client connection preface, which starts |buffered|,
+    // and serves the connection until it is closed.
+    void Serve(const std::string& buffered);
+
+    // ServeUpgrade serves a connection upgraded with "Upgrade: h2c" (RFC 7540, 3.2)
+    // once the 101 response is sent. |request| is served as the stream 1 and
+    // |settings| holds the decoded HTTP2-Settings header.
+    void ServeUpgrade(
+        std::shared_ptr<Request> request,
+        const std::string& settings,
+        const std::string& buffered);
+
+    // SetMaxBodySize bounds the body of a request, 0 for no limit. A stream sending
+    // more is reset. It is called before Serve.
+    void SetMaxBodySize(size_t size);
+
+protected:
+    void OnHeaders(uint32_t streamId, HeaderFieldList& headers, bool endStream) override;
+    void OnData(uint32_t streamId, const char* data, size_t length, bool endStream) override;
+    void OnStreamReset(uint32_t streamId, uint32_t errorCode) override;
+    void OnReadFinished() override;
+    void LocalSettings(std::string& payload) const override;
+
+private:
+    struct PendingRequest
+    {
+        std::shared_ptr<Request> Message;
+        std::string Body;
+        // The Content-Length of the request, -1 if it has none.
+        long long ContentLength = -1;
+        // The data received but not consumed yet, see kMaxReceivingBytes.
+        size_t Uncredited = 0;
+    };
+
+    std::shared_ptr<Request> CreateRequest(const HeaderFieldList& headers);
+    // TakeRequest removes a request being received and lets the requests held back
+    // by the receive budget have more of their data.
+    PendingRequest TakeRequest(std::map<uint32_t, PendingRequest>::iterator iter);
+    void Dispatch(uint32_t streamId, PendingRequest& pending);
+    void ServeStream(uint32_t streamId, std::shared_ptr<Request> request);
+
+private:
+    std::shared_ptr<Handler> m_handler;
+    size_t m_maxBodySize = 0;
+    // The requests being received, only used by the reading thread.
+    std::map<uint32_t, PendingRequest> m_requests;
+    // The bytes of the bodies in m_requests.
+    size_t m_receiving = 0;
+
+    // The handlers running, reset streams included.
+    std::mutex m_servingMutex;
+    std::condition_variable m_servingDone;
+    size_t m_serving = 0;
+};
+
+} // !namespace http
+} // !namespace net
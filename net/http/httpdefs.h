@@ -28,7 +28,7 @@ namespace http {
     {
         std::size_t operator() (const std::string& key) const
         {
-            return std::hash<std::string>{}(base::strings::ToLower(key));
+            return base::strings::HashIgnoreCase(key);
         }
     };
 
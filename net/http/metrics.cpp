@@ -0,0 +1,228 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/http/metrics.h"
+
+#include <cstdio>
+
+#include "net/http/status.h"
+
+namespace net {
+namespace http {
+
+namespace {
+
+// The latencies are kept up to an hour with two significant digits, about 26 KB a phase.
+const uint64_t kHighestLatency = 3600ULL * 1000 * 1000;
+const int kLatencyDigits = 2;
+
+// Increase adds to a counter of a leased shard, which only its recorder writes.
+void Increase(std::atomic<uint64_t>& counter, uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+struct CounterInfo
+{
+    Metrics::Counter Counter;
+    const char* Name;
+    const char* Help;
+};
+
+const CounterInfo kCounters[] = {
+    { Metrics::kConnectionsAccepted, "connections_accepted_total", "The connections accepted." },
+    { Metrics::kConnectionsRejected, "connections_rejected_total", "The connections answered with 503 at the connection limit." },
+    { Metrics::kConnectionsClosed, "connections_closed_total", "The connections closed." },
+    { Metrics::kBytesReceived, "received_bytes_total", "The bytes received." },
+    { Metrics::kBytesSent, "sent_bytes_total", "The bytes sent." },
+    { Metrics::kParseErrors, "parse_errors_total", "The connections closed on a malformed or truncated request." },
+    { Metrics::kTimeouts, "timeouts_total", "The connections closed by a passed deadline." },
+};
+
+const char* const kPhaseNames[] = { "first_byte", "read_header", "handler", "write", "request" };
+
+const double kQuantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+// AppendSeconds appends |microseconds| as seconds.
+void AppendSeconds(std::string& text, double microseconds)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.6f", microseconds / 1e6);
+    text += buffer;
+}
+
+void AppendHeader(std::string& text, const std::string& name, const char* type, const char* help)
+{
+    text += "# HELP " + name + " " + help + "\n";
+    text += "# TYPE " + name + " " + type + "\n";
+}
+
+} // !namespace anonymous
+
+struct Metrics::Shard
+{
+    Shard()
+    {
+        for (auto& counter : Counters)
+            counter.store(0, std::memory_order_relaxed);
+        for (auto& latency : Latency)
+            latency.reset(new base::Histogram(kHighestLatency, kLatencyDigits));
+    }
+
+    std::atomic<uint64_t> Counters[kCounterCount];
+    std::unique_ptr<base::Histogram> Latency[kPhaseCount];
+};
+
+Metrics::RequestSample::RequestSample()
+    : StatusCode(0)
+    , BytesReceived(0)
+    , BytesSent(0)
+{
+    for (auto& latency : Latency)
+        latency = -1;
+}
+
+Metrics::Metrics()
+{
+}
+
+Metrics::~Metrics()
+{
+}
+
+std::shared_ptr<Metrics> Metrics::Create()
+{
+    return std::shared_ptr<Metrics>(new Metrics());
+}
+
+void Metrics::Add(Counter counter, uint64_t n /*= 1*/)
+{
+    if (counter < 0 || counter >= kCounterCount)
+        return;
+    auto shard = m_shards.Acquire();
+    Increase(shard->Counters[counter], n);
+}
+
+void Metrics::RecordRequest(const RequestSample & sample)
+{
+    int statusClass = sample.StatusCode / 100;
+    auto shard = m_shards.Acquire();
+    if (statusClass >= 1 && statusClass <= 5)
+        Increase(shard->Counters[kRequests1xx + statusClass - 1], 1);
+    Increase(shard->Counters[kBytesReceived], sample.BytesReceived);
+    Increase(shard->Counters[kBytesSent], sample.BytesSent);
+    for (int phase = 0; phase < kPhaseCount; ++phase)
+    {
+        if (sample.Latency[phase] >= 0)
+            shard->Latency[phase]->Record((uint64_t)sample.Latency[phase]);
+    }
+}
+
+uint64_t Metrics::Get(Counter counter) const
+{
+    if (counter < 0 || counter >= kCounterCount)
+        return 0;
+    uint64_t value = 0;
+    m_shards.ForEach([&](const Shard& shard) {
+        value += shard.Counters[counter].load(std::memory_order_relaxed);
+    });
+    return value;
+}
+
+uint64_t Metrics::GetActiveConnections() const
+{
+    // The counters are read one after the other, a connection may have been closed
+    // since the accepted ones were counted.
+    uint64_t accepted = Get(kConnectionsAccepted);
+    uint64_t closed = Get(kConnectionsClosed);
+    return accepted > closed ? accepted - closed : 0;
+}
+
+void Metrics::GetLatency(Phase phase, base::Histogram & histogram) const
+{
+    if (phase < 0 || phase >= kPhaseCount)
+        return;
+    m_shards.ForEach([&](const Shard& shard) {
+        histogram.Add(*shard.Latency[phase]);
+    });
+}
+
+std::string Metrics::ToPrometheus(const std::string & prefix /*= "http_server"*/) const
+{
+    std::string text;
+    for (auto& info : kCounters)
+    {
+        auto name = prefix + "_" + info.Name;
+        AppendHeader(text, name, "counter", info.Help);
+        text += name + " " + std::to_string(Get(info.Counter)) + "\n";
+    }
+
+    auto name = prefix + "_connections_active";
+    AppendHeader(text, name, "gauge", "The connections open.");
+    text += name + " " + std::to_string(GetActiveConnections()) + "\n";
+
+    name = prefix + "_requests_total";
+    AppendHeader(text, name, "counter", "The requests served by status class.");
+    for (int statusClass = 1; statusClass <= 5; ++statusClass)
+    {
+        text += name + "{code=\"" + std::to_string(statusClass) + "xx\"} " +
+            std::to_string(Get((Counter)(kRequests1xx + statusClass - 1))) + "\n";
+    }
+
+    name = prefix + "_phase_duration_seconds";
+    AppendHeader(text, name, "summary", "The latencies of the phases of the requests.");
+    for (int phase = 0; phase < kPhaseCount; ++phase)
+    {
+        base::Histogram latency(kHighestLatency, kLatencyDigits);
+        GetLatency((Phase)phase, latency);
+        std::string label = std::string("phase=\"") + kPhaseNames[phase] + "\"";
+        for (auto quantile : kQuantiles)
+        {
+            char buffer[16];
+            snprintf(buffer, sizeof(buffer), "%g", quantile);
+            text += name + "{" + label + ",quantile=\"" + buffer + "\"} ";
+            AppendSeconds(text, (double)latency.Percentile(quantile * 100));
+            text += "\n";
+        }
+        text += name + "_sum{" + label + "} ";
+        AppendSeconds(text, latency.GetMean() * latency.GetCount());
+        text += "\n";
+        text += name + "_count{" + label + "} " + std::to_string(latency.GetCount()) + "\n";
+    }
+    return text;
+}
+
+MetricsHandler::MetricsHandler(std::shared_ptr<Metrics> metrics)
+    : m_metrics(metrics)
+{
+}
+
+void MetricsHandler::ServeHTTP(std::shared_ptr<Context> ctx)
+{
+    auto response = ctx->GetResponse();
+    response->SetHeader("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+    if (!m_metrics)
+    {
+        response->SetStatusCode(Status::NotFound);
+        return;
+    }
+    ctx->Write(m_metrics->ToPrometheus());
+}
+
+} // !namespace http
+} // !namespace net
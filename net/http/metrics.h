@@ -0,0 +1,128 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "net/base/histogram.h"
+#include "net/base/lease_pool.h"
+#include "net/http/handler.h"
+
+namespace net {
+namespace http {
+
+// Metrics counts the connections, requests and bytes of a server and keeps histograms
+// of the latencies of the phases of its requests. Recording takes no lock: a recorder
+// leases one of the shards, writes it without locked instructions and gives it back.
+// The readers merge the shards.
+class Metrics
+{
+public:
+    enum Counter
+    {
+        kConnectionsAccepted,
+        // The connections answered with 503 at the connection limit.
+        kConnectionsRejected,
+        kConnectionsClosed,
+        // The requests by status class, 1xx to 5xx.
+        kRequests1xx,
+        kRequests2xx,
+        kRequests3xx,
+        kRequests4xx,
+        kRequests5xx,
+        kBytesReceived,
+        kBytesSent,
+        // The connections closed on a malformed or truncated request.
+        kParseErrors,
+        // The connections closed by a passed deadline.
+        kTimeouts,
+        kCounterCount
+    };
+
+    // The latencies are in microseconds.
+    enum Phase
+    {
+        // From accepting the connection to the first byte of its first request.
+        kFirstByte,
+        // From the first byte of a request to the end of its headers.
+        kReadHeader,
+        // The time spent in the handler.
+        kHandler,
+        // From the end of the handler to the response being sent, or buffered
+        // when the next request is pipelined.
+        kWrite,
+        // From the first byte of a request to the end of its response.
+        kRequest,
+        kPhaseCount
+    };
+
+    struct RequestSample
+    {
+        RequestSample();
+
+        int StatusCode;
+        uint64_t BytesReceived;
+        uint64_t BytesSent;
+        // The latencies of the phases, the negative ones have not been measured.
+        int64_t Latency[kPhaseCount];
+    };
+
+    ~Metrics();
+
+protected:
+    Metrics();
+
+public:
+    static std::shared_ptr<Metrics> Create();
+
+    void Add(Counter counter, uint64_t n = 1);
+    void RecordRequest(const RequestSample& sample);
+
+    uint64_t Get(Counter counter) const;
+    uint64_t GetActiveConnections() const;
+    // GetLatency adds the latencies of |phase| to |histogram|.
+    void GetLatency(Phase phase, base::Histogram& histogram) const;
+
+    // ToPrometheus returns the metrics in the Prometheus text exposition format,
+    // their names start with |prefix|.
+    std::string ToPrometheus(const std::string& prefix = "http_server") const;
+
+private:
+    struct Shard;
+
+    base::LeasePool<Shard> m_shards;
+};
+
+// MetricsHandler serves the metrics in the Prometheus text format, e.g. on /metrics.
+class MetricsHandler
+    : public Handler
+{
+public:
+    MetricsHandler(std::shared_ptr<Metrics> metrics);
+
+    void ServeHTTP(std::shared_ptr<Context> ctx) override;
+
+private:
+    std::shared_ptr<Metrics> m_metrics;
+};
+
+} // !namespace http
+} // !namespace net
@@ -28,18 +28,29 @@ namespace http {
 
 namespace {
 
-int LocateLine(const char* buffer, size_t offset, size_t len)
+const int kReceiveBufferSize = 4096;
+// A body is received into a buffer growing with it, so that a Content-Length
+// alone does not make a large allocation.
+const size_t kBodyGrowth = 64 * 1024;
+
+// ParseSize parses a length made of digits only, e.g. no sign or trailing text
+// as std::stoi would accept. It returns false if |str| isn't one or overflows.
+bool ParseSize(base::strings::StringPiece str, bool hex, size_t& size)
 {
-    if (!buffer || offset >= len)
-        return -1;
-    for (size_t i = offset; i < len; ++i)
+    if (str.empty())
+        return false;
+    size_t base = hex ? 16 : 10;
+    size = 0;
+    for (char c : str)
     {
-        if ('\n' == buffer[i])
-        {
-            return i;
-        }
+        if (!base::strings::IsDigit(c, hex))
+            return false;
+        size_t digit = (size_t)base::strings::HexDigitToInt(c);
+        if (size > (SIZE_MAX - digit) / base)
+            return false;
+        size = size * base + digit;
     }
-    return -1;
+    return true;
 }
 
 } // !namespace anonymous
@@ -48,6 +59,7 @@ void Reader::Reset(StreamSocket * s)
 {
     m_stream = s;
     m_buffer.clear();
+    m_offset = 0;
 }
 
 int Reader::GetErrorCode() const
@@ -55,242 +67,216 @@ int Reader::GetErrorCode() const
     return m_error;
 }
 
-std::string Reader::ExtractStartLine()
+uint64_t Reader::GetBytesReceived() const
 {
-    char buffer[1024];
-    std::string message;
-    do
-    {
-        int len = m_stream->Receive(buffer, 1024);
-        if (len <= 0)
-        {
-            m_error = WSAGetLastError();
-            return "";
-        }
+    return m_bytesReceived;
+}
 
-        int linePos = LocateLine(buffer, 0, len);
-        if (linePos < 0)
-        {
-            message += std::string(buffer, len);
-            continue;
-        }
-        message += std::string(buffer, linePos);
-        m_buffer = std::string(buffer + linePos + 1, len - linePos - 1);
-        break;
-    } while (true);
-    if (!message.empty() && '\r' == message.back())
-        message.pop_back();
-    return message;
+size_t Reader::GetBufferedBytes() const
+{
+    return m_buffer.size() - m_offset;
 }
 
-std::vector<std::string> Reader::ExtractHeaders(bool& error)
+bool Reader::HasBufferedHeaders() const
 {
-    std::vector<std::string> headers;
+    // Skip the empty lines which may be sent between pipelined requests.
+    auto pos = m_buffer.find_first_not_of("\r\n", m_offset);
+    if (std::string::npos == pos)
+        return false;
+    return m_buffer.find("\n\r\n", pos) != std::string::npos
+        || m_buffer.find("\n\n", pos) != std::string::npos;
+}
 
-    std::string message;
-    auto pos = m_buffer.find("\r\n\r\n");
-    if (std::string::npos != pos)
+bool Reader::Fill()
+{
+    if (!m_stream)
+        return false;
+    // Drop the consumed bytes before growing the buffer.
+    if (m_offset > 0)
     {
-        message = m_buffer.substr(0, pos);
-        m_buffer.erase(0, pos + 4);
-        goto end;
+        m_buffer.erase(0, m_offset);
+        m_offset = 0;
     }
-    else if (base::strings::StartsWith(m_buffer, "\r\n"))
+    char buffer[kReceiveBufferSize];
+    int len = m_stream->Receive(buffer, kReceiveBufferSize);
+    if (len <= 0)
     {
-        m_buffer.erase(0, 2);
-        goto end;
+        m_error = WSAGetLastError();
+        return false;
     }
-    else
-        message = m_buffer;
+    m_buffer.append(buffer, len);
+    m_bytesReceived += len;
+    return true;
+}
 
-    char buffer[1024];
-    bool finished = false;
+bool Reader::ReadLine(std::string& line)
+{
+    size_t searchPos = m_offset;
     do
     {
-        int len = m_stream->Receive(buffer, 1024);
-        if (len <= 0)
-        {
-            error = true;
-            m_error = WSAGetLastError();
-            return headers;
-        }
-        int linePos = 0;
-        int lastPos = 0;
-        while (linePos >= 0)
-        {
-            linePos = LocateLine(buffer, lastPos, len);
-            if (linePos < 0)
-            {
-                message += std::string(buffer + lastPos, len - lastPos);
-                break;
-            }
-            linePos += 1;
-            message += std::string(buffer + lastPos, linePos - lastPos);
-            lastPos = linePos;
-            if (message.size() == 1 || base::strings::StartsWith(message, "\r\n"))
-            {
-                message.clear();
-                finished = true;
-                break;
-            }
-
-            if ('\n' == message[message.length() - 2])
-            {
-                message.erase(message.length() - 2);
-                finished = true;
-                break;
-            }
-            else if (message.size() > 2
-                && '\r' == message[message.length() - 2]
-                && '\n' == message[message.length() - 3])
-            {
-                if (message.size() > 3 && '\r' == message[message.length() - 4])
-                    message.erase(message.length() - 4);
-                else
-                    message.erase(message.length() - 3);
-                finished = true;
-                break;
-            }
-        }
-        if (finished)
+        auto pos = m_buffer.find('\n', searchPos);
+        if (std::string::npos != pos)
         {
-            m_buffer = std::string(buffer + lastPos, len - lastPos);
-            break;
+            line.assign(m_buffer, m_offset, pos - m_offset);
+            m_offset = pos + 1;
+            if (!line.empty() && '\r' == line.back())
+                line.pop_back();
+            return true;
         }
+        searchPos = m_buffer.size() - m_offset;
+        if (!Fill())
+            return false;
+        // Fill may have compacted the buffer.
+        searchPos += m_offset;
     } while (true);
+}
 
-end:
-    error = false;
-    headers = base::strings::Split(message, "\n");
-    for (auto iter = headers.begin(); iter != headers.end();)
+bool Reader::ReadBytes(size_t length, std::string& message)
+{
+    size_t buffered = GetBufferedBytes();
+    if (buffered > length)
+        buffered = length;
+    message.reserve(length < kBodyGrowth ? length : kBodyGrowth);
+    message.assign(m_buffer, m_offset, buffered);
+    m_offset += buffered;
+    if (buffered == length)
+        return true;
+
+    // Receive the rest straight into the message instead of the buffer.
+    size_t received = buffered;
+    while (received < length)
     {
-        if (iter->empty())
-            iter = headers.erase(iter);
-        else
+        if (message.size() == received)
+        {
+            size_t growth = received < kBodyGrowth ? kBodyGrowth : received;
+            message.resize(length - received < growth ? length : received + growth);
+        }
+        int len = m_stream->Receive(&message[received], (int)(message.size() - received));
+        if (len <= 0)
         {
-            if (iter->back() == '\r')
-                iter->pop_back();
-            ++iter;
+            m_error = WSAGetLastError();
+            message.resize(received);
+            return false;
         }
+        received += len;
+        m_bytesReceived += len;
     }
-    return headers;
+    return true;
 }
 
-std::string Reader::ExtractOneChunked()
+std::string Reader::TakeBufferedBytes()
 {
-    std::string message;
-    int needSize = 0;
-    auto pos = m_buffer.find('\n');
+    std::string bytes = m_buffer.substr(m_offset);
+    m_buffer.clear();
+    m_offset = 0;
+    return bytes;
+}
 
-    auto RemoveLine = [&]() {
-        if (base::strings::StartsWith(m_buffer, "\r\n"))
-            m_buffer.erase(0, 2);
-        else if (m_buffer.size() < 2)
-        {
-            char b[2];
-            int l = m_stream->Receive(b, 2);
-            if (l > 0)
-            {
-                m_buffer += std::string(b);
-                if (base::strings::StartsWith(m_buffer, "\r\n"))
-                    m_buffer.erase(0, 2);
-            }
-            else
-                m_error = WSAGetLastError();
-        }
-    };
+bool Reader::WaitForData()
+{
+    return GetBufferedBytes() > 0 || Fill();
+}
+
+void Reader::SetDecompressLimits(const base::zip::Limits& limits)
+{
+    m_decompressLimits = limits;
+}
 
-    if (pos != std::string::npos)
+void Reader::SetMaxBodySize(size_t size)
+{
+    m_maxBodySize = size;
+}
+
+std::string Reader::ExtractStartLine()
+{
+    std::string line;
+    do
     {
-        try
-        {
-            // std::stoi works well for "xxx/r".
-            auto lineSize = std::stoi(m_buffer.substr(0, pos), 0, 16);
-            m_buffer.erase(0, pos + 1);
-            if (lineSize <= 0)
-                return "";
-            if (m_buffer.size() >= (size_t)lineSize)
-            {
-                message = m_buffer.substr(0, lineSize);
-                m_buffer.erase(0, lineSize);
-                RemoveLine();
-                return message;
-            }
-            needSize = lineSize - m_buffer.size();
-        }
-        catch (...)
-        {
+        if (!ReadLine(line))
             return "";
-        }
+        // Ignore the empty lines preceding the start line (RFC 7230, 3.5).
+    } while (line.empty());
+    return line;
+}
 
-    }
-    else
+std::vector<std::string> Reader::ExtractHeaders(bool& error)
+{
+    std::vector<std::string> headers;
+    std::string line;
+    do
     {
-        char buffer[1024];
-        int len = m_stream->Receive(buffer, 1024);
-        if (len <= 0)
+        if (!ReadLine(line))
         {
-            m_error = WSAGetLastError();
-            return "";
-        }
-        int line = LocateLine(buffer, 0, len);
-        if (line < 0)
-            return "";
-        std::string chunkedSize = m_buffer + std::string(buffer, line);
-        m_buffer = std::string(buffer + line + 1, len - line - 1);
-        try
-        {
-            auto lineSize = std::stoi(chunkedSize, 0, 16);
-            if (lineSize <= 0)
-                return "";
-            needSize = lineSize - m_buffer.size();
-            if (needSize <= 0)
-            {
-                message = m_buffer.substr(0, lineSize);
-                m_buffer.erase(0, lineSize);
-                RemoveLine();
-                return message;
-            }
-        }
-        catch (...)
-        {
-            return "";
+            error = true;
+            return headers;
         }
-    }
+        if (line.empty())
+            break;
+        headers.push_back(line);
+    } while (true);
+    error = false;
+    return headers;
+}
 
-    if (needSize <= 0)
+std::string Reader::ExtractOneChunked()
+{
+    std::string line;
+    if (!ReadLine(line))
         return "";
-    std::string chunkedSize;
-    std::unique_ptr<char[]> buffer(new char[needSize + 2]); // include '\r\n'
 
-    message = m_buffer;
-    int remainSize = needSize + 2;
-    do
+    int lineSize = 0;
+    try
     {
-        int len = m_stream->Receive(buffer.get(), remainSize);
-        if (len < 0)
+        // std::stoi ignores the chunk extensions after the size.
+        lineSize = std::stoi(line, 0, 16);
+    }
+    catch (...)
+    {
+        return "";
+    }
+
+    if (lineSize <= 0)
+    {
+        // The last chunk is followed by optional trailers and an empty line.
+        do
         {
-            m_error = WSAGetLastError();
-            return "";
-        }
-        if (len == 0)
-            continue;
-        message += std::string(buffer.get(), len);
-        remainSize -= len;
-        if (remainSize == 0)
-            break;;
-    } while (true);
+            if (!ReadLine(line))
+                break;
+        } while (!line.empty());
+        return "";
+    }
 
+    std::string message;
+    if (!ReadBytes(lineSize, message))
+        return "";
     // Remove "\r\n".
-    message.pop_back();
-    message.pop_back();
-    m_buffer.clear();
+    ReadLine(line);
     return message;
 }
 
 void Reader::ExtractChunkedMessage(std::shared_ptr<Response> response)
 {
     std::string message;
+    if (response->GetHeader("Content-Encoding").find("gzip") != std::string::npos)
+    {
+        // Each chunk is inflated as it arrives, the compressed message is not kept.
+        auto inflater = base::zip::AcquireInflater(base::zip::kGzip);
+        inflater->SetLimits(m_decompressLimits);
+        bool failed = false;
+        do
+        {
+            auto chunked = ExtractOneChunked();
+            if (chunked.empty())
+                break;
+            if (!failed)
+                failed = !inflater->Inflate(chunked.data(), chunked.size(), message);
+        } while (true);
+        if (failed || !inflater->IsFinished())
+            message.clear();
+        response->SetBody(std::move(message));
+        return;
+    }
+
     do
     {
         auto chunked = ExtractOneChunked();
@@ -298,85 +284,107 @@ void Reader::ExtractChunkedMessage(std::shared_ptr<Response> response)
             break;
         message += chunked;
     } while (true);
-
-    if (response->GetHeader("Content-Encoding").find("gzip") != std::string::npos)
-        response->SetBody(base::zip::GDecompress(message));
-    else
-        response->SetBody(message);
+    response->SetBody(std::move(message));
 }
 
-void Reader::ExtractContentMessage(std::shared_ptr<Response> response)
+bool Reader::ExtractContentMessage(std::shared_ptr<Response> response)
 {
     auto contentLength = response->GetHeader("Content-length");
     std::string body;
     
-    ExtractRawMessage(contentLength, body);
+    if (!ExtractRawMessage(contentLength, body))
+        return false;
 
     if (response->GetHeader("Content-Encoding").find("gzip") != std::string::npos)
-        response->SetBody(base::zip::GDecompress(body));
+    {
+        std::string inflated;
+        if (!base::zip::GDecompress(body.data(), body.size(), inflated, m_decompressLimits))
+            inflated.clear();
+        response->SetBody(std::move(inflated));
+    }
     else
-        response->SetBody(body);
+    {
+        response->SetBody(std::move(body));
+    }
+    return true;
 }
 
-void Reader::ExtractRequestMessage(std::shared_ptr<Request> request)
+bool Reader::ExtractRequestMessage(std::shared_ptr<Request> request)
 {
     auto contentLength = request->GetHeader("Content-length");
-    std::string body;
-
-    ExtractRawMessage(contentLength, body);
+    auto transferEncoding = request->GetHeaderView("Transfer-Encoding");
+    // Read into the storage of the last body, e.g. of a recycled request.
+    std::string body = request->TakeBody();
+    body.clear();
 
-    if (request->GetHeader("Content-Encoding").find("gzip") != std::string::npos)
-        body = base::zip::GDecompress(body);
-    request->SetBody(body);
-    
-    auto contentType = request->GetHeader("Content-Type");
-    if (contentType.empty())
-        return;
-    base::strings::ToLowerSelf(contentType);
-    if (contentType.find("application/x-www-form-urlencoded") == std::string::npos)
-        return;
-    Values formValues;
-    ParseQueryForm(body, formValues);
-    request->SetPostFormValues(formValues);
+    if (!transferEncoding.empty())
+    {
+        // A request framed both ways, or by a coding we don't know, can't be
+        // delimited the same way by every hop, which would let the rest of its
+        // body pass for the next request (RFC 7230, 3.3.3).
+        if (!contentLength.empty() || !base::strings::Equal(base::strings::TrimSpace(transferEncoding), "chunked", true))
+            return false;
+        if (!ExtractChunkedBody(body))
+            return false;
+    }
+    else if (!ExtractRawMessage(contentLength, body))
+    {
+        return false;
+    }
+    SetRequestBody(request, std::move(body));
+    return true;
 }
 
-void Reader::ExtractRawMessage(const std::string& contentLength, std::string & message)
+bool Reader::ExtractChunkedBody(std::string & message)
 {
-    int len = 0;
-    try
+    std::string line;
+    std::string chunk;
+    while (true)
     {
-        len = std::stoi(contentLength) - (int)m_buffer.size();
+        if (!ReadLine(line))
+            return false;
+        size_t size = 0;
+        if (!ParseSize(base::strings::TrimSpace(base::strings::StringPiece(line).substr(0, line.find(';'))), true, size))
+            return false;
+        if (size == 0)
+            break;
+        if (m_maxBodySize > 0 && (size > m_maxBodySize || message.size() + size > m_maxBodySize))
+            return false;
+        if (!ReadBytes(size, chunk))
+            return false;
+        message.append(chunk);
+        // The data is followed by a line break.
+        if (!ReadLine(line) || !line.empty())
+            return false;
     }
-    catch(...)
+
+    // The last chunk is followed by optional trailers and an empty line.
+    do
     {
-        return;
-    }
-    
-    if (len < 0)
-        return;
-    else if (0 == len)
-        message = m_buffer;
-    else
+        if (!ReadLine(line))
+            return false;
+    } while (!line.empty());
+    return true;
+}
+
+bool Reader::ExtractRawMessage(const std::string& contentLength, std::string & message)
+{
+    if (contentLength.empty())
+        return true;
+    size_t len = 0;
+    if (!ParseSize(contentLength, false, len))
     {
-        std::unique_ptr<char[]> buffer(new char[len]);
-        int remainSize = len;
-        message = m_buffer;
-        do
-        {
-            int recvBytes = m_stream->Receive(buffer.get(), remainSize);
-            if (recvBytes < 0)
-            {
-                m_error = WSAGetLastError();
-                return;
-            }
-            if (recvBytes == 0)
-                continue;
-            message += std::string(buffer.get(), recvBytes);
-            remainSize -= recvBytes;
-            if (0 == remainSize)
-                break;
-        } while (true);
+        // The message can't be delimited (RFC 7230, 3.3.3).
+        return false;
     }
+
+    if (len == 0)
+        return true;
+    if (m_maxBodySize > 0 && len > m_maxBodySize)
+        return false;
+    // Take exactly |len| bytes, anything behind belongs to the next message.
+    // A shorter body leaves the connection in the middle of a message.
+    return ReadBytes(len, message);
 }
 
 } // !namespace http
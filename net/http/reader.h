@@ -18,10 +18,12 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "net/base/zip.h"
 #include "net/http/response.h"
 #include "net/socket/StreamSocket.h"
 
@@ -36,22 +38,66 @@ public:
 
     void Reset(StreamSocket* s);
     int GetErrorCode() const;
+    // GetBytesReceived returns the number of bytes received from the socket so far.
+    uint64_t GetBytesReceived() const;
+
+    // GetBufferedBytes returns the number of bytes received but not consumed yet.
+    // With HTTP pipelining these bytes belong to the next request(s).
+    size_t GetBufferedBytes() const;
+
+    // HasBufferedHeaders returns whether a complete header block is already buffered,
+    // so the next message can be parsed without blocking on the socket.
+    bool HasBufferedHeaders() const;
+
+    // TakeBufferedBytes removes and returns the bytes received but not consumed yet,
+    // e.g. when the connection switches to another protocol.
+    std::string TakeBufferedBytes();
+
+    // WaitForData blocks until some bytes are buffered, it returns false if the
+    // connection is closed.
+    bool WaitForData();
+
+    // SetDecompressLimits bounds the size a gzip encoded response body may inflate to,
+    // a body beyond them is dropped. base::zip::kDefaultMaxSize and kDefaultMaxRatio by default.
+    void SetDecompressLimits(const base::zip::Limits& limits);
+
+    // SetMaxBodySize bounds the body of a message, 0 for no limit, the default.
+    void SetMaxBodySize(size_t size);
 
     std::string ExtractStartLine();
     std::vector<std::string> ExtractHeaders(bool& error);
     std::string ExtractOneChunked();
     void ExtractChunkedMessage(std::shared_ptr<Response> response);
-    void ExtractContentMessage(std::shared_ptr<Response> response);
+    // The Extract*Message functions below return false if the body can't be delimited,
+    // is larger than allowed or the connection ends before all of it has been received.
+    // A request body may be chunked, a request with both Transfer-Encoding and
+    // Content-Length is rejected.
+    bool ExtractContentMessage(std::shared_ptr<Response> response);
 
-    void ExtractRequestMessage(std::shared_ptr<Request> request);
+    bool ExtractRequestMessage(std::shared_ptr<Request> request);
 
 protected:
-    void ExtractRawMessage(const std::string& contentLength, std::string& message);
+    // ExtractRawMessage reads a body of |contentLength| bytes, which must be a decimal number.
+    bool ExtractRawMessage(const std::string& contentLength, std::string& message);
+    // ExtractChunkedBody reads a chunked body (RFC 7230, 4.1), the trailers are dropped.
+    bool ExtractChunkedBody(std::string& message);
+
+    // Fill receives more bytes from the socket and appends them to the buffer.
+    bool Fill();
+    // ReadLine extracts one line without the trailing "\r\n" or "\n".
+    bool ReadLine(std::string& line);
+    // ReadBytes extracts exactly |length| bytes.
+    bool ReadBytes(size_t length, std::string& message);
 
 protected:
+    // The unread bytes are m_buffer[m_offset, m_buffer.size()).
     std::string m_buffer;
+    size_t m_offset = 0;
     StreamSocket* m_stream = nullptr;
     int m_error = 0;
+    uint64_t m_bytesReceived = 0;
+    size_t m_maxBodySize = 0;
+    base::zip::Limits m_decompressLimits = base::zip::Limits(base::zip::kDefaultMaxSize, base::zip::kDefaultMaxRatio);
 };
 
 } // !namespace http
@@ -47,14 +47,13 @@ std::vector<std::shared_ptr<Cookie>> ParseCookies(
         return cookies;
     }
 
-    auto vlist = base::strings::Split(c->second, ";");
-    for (auto item : vlist)
+    for (auto item : base::strings::SplitPieces(c->second, ";"))
     {
         if (base::strings::TrimSpace(item).empty())
         {
             continue;
         }
-        auto kv = base::strings::SplitN(item, "=", 2);
+        auto kv = base::strings::SplitPiecesN<2>(item, "=");
         if (kv.size() == 0)
             continue;
         auto k = base::strings::TrimSpace(kv[0]);
@@ -72,7 +71,7 @@ std::vector<std::shared_ptr<Cookie>> ParseCookies(
         }
         if (kv.size() == 2)
         {
-            cookie->Value = base::strings::TrimSpace(kv[1]);
+            cookie->Value = base::strings::TrimSpace(kv[1]).ToString();
         }
         cookies.push_back(cookie);
     }
@@ -85,6 +84,19 @@ std::shared_ptr<Request> Request::Create(
     const std::string & method,
     const std::string & url,
     const std::string& body)
+{
+    std::shared_ptr<Request> request(new Request());
+    if (!request->Reset(method, url, body))
+    {
+        return nullptr;
+    }
+    return request;
+}
+
+bool Request::Reset(
+    const std::string & method,
+    const std::string & url,
+    const std::string& body /*= ""*/)
 {
     std::string validMethod(method);
     if (base::strings::TrimSpace(validMethod).empty())
@@ -93,24 +105,33 @@ std::shared_ptr<Request> Request::Create(
     }
     if (!IsValidMethod(validMethod))
     {
-        return nullptr;
+        return false;
     }
-    auto u = Url::Parse(url);
-    if (u.GetHost().empty())
+    auto view = UrlView::Parse(url);
+    if (view.GetRawHost().empty())
     {
-        return nullptr;
+        return false;
     }
 
-    std::shared_ptr<Request> request(new Request());
-    request->SetMethod(validMethod);
-    request->SetProto(1, 1);
-    request->SetUrl(u);
-    request->SetHost(u.HostPort());
-    request->SetBody(body);
-    request->SetHeader("Host", u.GetHost());
-    request->SetHeader("Accept-Encoding", "gzip, deflate");
-    request->SetHeader("Connection", "Keep-Alive");
-    return request;
+    // Clear keeps the capacity of the strings and the buckets of the tables.
+    m_header.clear();
+    m_form.clear();
+    m_postForm.clear();
+    m_queryForm = true;
+    m_bodyForm = false;
+    m_queryIndex.Clear();
+    m_bodyIndex.Clear();
+    m_remoteAddress.clear();
+    m_close = false;
+    SetMethod(validMethod);
+    SetProto(1, 1);
+    m_url.Assign(view);
+    SetHost(m_url.HostPort());
+    SetBody(body);
+    SetHeader("Host", m_url.GetHost());
+    SetHeader("Accept-Encoding", "gzip, deflate");
+    SetHeader("Connection", "Keep-Alive");
+    return true;
 }
 
 std::string Request::GetMethod() const
@@ -124,6 +145,12 @@ void Request::SetMethod(const std::string & method)
 }
 
 Url & Request::GetUrl()
+{
+    m_queryIndex.Clear();
+    return m_url;
+}
+
+const Url & Request::GetUrl() const
 {
     return m_url;
 }
@@ -131,6 +158,19 @@ Url & Request::GetUrl()
 void Request::SetUrl(const Url & url)
 {
     m_url = url;
+    m_queryIndex.Clear();
+}
+
+void Request::SetUrl(Url && url)
+{
+    m_url = std::move(url);
+    m_queryIndex.Clear();
+}
+
+void Request::SetRawQuery(std::string rawQuery)
+{
+    m_url.SetRawQuery(std::move(rawQuery));
+    m_queryIndex.Clear();
 }
 
 std::string Request::GetHost() const
@@ -192,20 +232,21 @@ std::tuple<std::string, std::string, bool> Request::BasicAuth() const
         auto v = m_header.find("Authorization");
         if (v == m_header.end())
             break;
-        auto vlist = base::strings::SplitN(v->second, " ", 2);
+        auto vlist = base::strings::SplitPiecesN<2>(v->second, " ");
         if (vlist.size() != 2)
             break;
         if (!base::strings::Equal(vlist[0], "Basic", true))
             break;
-        auto value = base::base64::Decode(vlist[1]);
+        auto value = base::base64::Decode(
+            reinterpret_cast<const unsigned char*>(vlist[1].data()), vlist[1].size());
         if (value.empty())
             break;
 
-        auto auth = base::strings::SplitN(value, ":", 2);
+        auto auth = base::strings::SplitPiecesN<2>(value, ":");
         if (auth.size() == 2)
-            return{ auth[0], auth[1], true };
+            return{ auth[0].ToString(), auth[1].ToString(), true };
         else
-            return{ auth[0], "", true };
+            return{ auth[0].ToString(), "", true };
     } while (0);
     return{ "", "", false };
 }
@@ -219,19 +260,45 @@ void Request::SetBasicAuth(const std::string & username, const std::string & pas
 void Request::SetFormValues(const Values & form)
 {
     m_form = form;
+    m_queryForm = false;
+}
+
+void Request::SetFormValues(Values && form)
+{
+    m_form = std::move(form);
+    m_queryForm = false;
 }
 
 void Request::SetPostFormValues(const Values & form)
 {
     m_postForm = form;
+    m_bodyForm = false;
+}
+
+void Request::SetPostFormValues(Values && form)
+{
+    m_postForm = std::move(form);
+    m_bodyForm = false;
+}
+
+void Request::UseBodyAsPostForm()
+{
+    m_postForm.clear();
+    m_bodyForm = true;
+    m_bodyIndex.Clear();
 }
 
 std::string Request::FormValue(const std::string & key) const
 {
-    auto v = m_postForm.find(key);
-    if (v != m_postForm.end())
-        return v->second;
-    v = m_form.find(key);
+    std::string value;
+    if (FindPostFormValue(key, value))
+        return value;
+    if (m_queryForm)
+    {
+        m_queryIndex.Find(m_url.GetRawQuery(), key, value);
+        return value;
+    }
+    auto v = m_form.find(key);
     if (v != m_form.end())
         return v->second;
     return "";
@@ -239,10 +306,28 @@ std::string Request::FormValue(const std::string & key) const
 
 std::string Request::PostFormValue(const std::string & key) const
 {
+    std::string value;
+    FindPostFormValue(key, value);
+    return value;
+}
+
+bool Request::FindPostFormValue(const std::string & key, std::string & value) const
+{
+    if (m_bodyForm)
+    {
+        // The body may have been replaced in the same memory.
+        if (m_bodyIndexGeneration != m_bodyGeneration)
+        {
+            m_bodyIndex.Clear();
+            m_bodyIndexGeneration = m_bodyGeneration;
+        }
+        return m_bodyIndex.Find(GetBodyView(), key, value);
+    }
     auto v = m_postForm.find(key);
-    if (v != m_postForm.end())
-        return v->second;
-    return "";
+    if (v == m_postForm.end())
+        return false;
+    value = v->second;
+    return true;
 }
 
 std::string Request::Referer() const
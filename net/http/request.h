@@ -25,6 +25,7 @@
 #include "net/base/url.h"
 #include "net/http/common.h"
 #include "net/http/cookie.h"
+#include "net/http/form.h"
 #include "net/http/httpdefs.h"
 
 namespace net {
@@ -34,16 +35,28 @@ class Request
     : public CommonRequestResponse
 {
 public:
+    // A request can also be a plain value, e.g. one reused for the requests of a connection.
+    Request() {}
     ~Request() {}
 
     // Create news a request based on a method, URL and optional body.
     static std::shared_ptr<Request> Create(const std::string& method, const std::string& url, const std::string& body = "");
 
+    // Reset makes this request a new one as Create does, keeping the memory of its
+    // strings and tables. It returns false and leaves the request as it was
+    // if the method or the URL is invalid.
+    bool Reset(const std::string& method, const std::string& url, const std::string& body = "");
+
     std::string GetMethod() const;
     void SetMethod(const std::string& method);
 
+    // The mutable GetUrl resets the form index of the query, so the URL must not be
+    // changed through a reference kept across form lookups.
     Url& GetUrl();
+    const Url& GetUrl() const;
     void SetUrl(const Url& url);
+    void SetUrl(Url&& url);
+    void SetRawQuery(std::string rawQuery);
 
     std::string GetHost() const;
     void SetHost(const std::string& host);
@@ -70,15 +83,24 @@ public:
     // with the provided username and password.
     void SetBasicAuth(const std::string& username, const std::string& password);
 
-    // SetForm keeps the query string parameters.
+    // SetForm keeps the query string parameters. Unless it is called, the form
+    // values are read from the query string of the URL when they are asked for.
     void SetFormValues(const Values& form);
+    void SetFormValues(Values&& form);
 
     // SetPostForm keeps the the named component of POST or PUT request body.
     void SetPostFormValues(const Values& form);
+    void SetPostFormValues(Values&& form);
+
+    // UseBodyAsPostForm makes the urlencoded body the POST form, which is read
+    // when a value is asked for.
+    void UseBodyAsPostForm();
 
     // FormValue returns the first value from the named component of the query.
     // POST and PUT body parameters take precedence over URL query string values.
     // If the key is not present, the empty string will be given.
+    // The forms are indexed by the first lookup, so the first lookups of a request
+    // from several threads must be synchronized.
     std::string FormValue(const std::string& key) const;
 
     // PostFormValue returns the first value from the named component of the POST or PUT request body.
@@ -93,14 +115,20 @@ public:
     std::string UserAgent() const;
 
 private:
-    Request() {}
+    bool FindPostFormValue(const std::string& key, std::string& value) const;
 
-private:
     std::string m_method;
     Url m_url;
     std::string m_host;
     Values m_form;
     Values m_postForm;
+    // The forms read from the query string and the body.
+    bool m_queryForm = true;
+    bool m_bodyForm = false;
+    mutable FormIndex m_queryIndex;
+    mutable FormIndex m_bodyIndex;
+    // The generation of the body m_bodyIndex was built for.
+    mutable unsigned int m_bodyIndexGeneration = 0;
     std::string m_remoteAddress;
 };
 
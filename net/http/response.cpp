@@ -27,6 +27,19 @@ std::shared_ptr<Response> Response::Create()
     return std::shared_ptr<Response>(new Response());
 }
 
+void Response::Reset()
+{
+    m_protoMajor = 1;
+    m_protoMinor = 1;
+    m_close = false;
+    m_header.clear();
+    m_body.clear();
+    ++m_bodyGeneration;
+    m_statusCode = 200;
+    m_status.clear();
+    m_request.reset();
+}
+
 int Response::GetStatusCode() const
 {
     return m_statusCode;
@@ -31,10 +31,15 @@ class Response
     : public CommonRequestResponse
 {
 public:
+    // A response can also be a plain value, e.g. one reused for the requests of a connection.
+    Response() {}
     ~Response() {}
 
     static std::shared_ptr<Response> Create();
 
+    // Reset makes this response a new one, keeping the memory of its strings and tables.
+    void Reset();
+
     int GetStatusCode() const;
     void SetStatusCode(int code);
     void SetStatus(const std::string& status);
@@ -42,9 +47,6 @@ public:
     std::shared_ptr<Request> GetRequest() const;
     void SetRequest(std::shared_ptr<Request> request);
 
-private:
-    Response() {}
-
 private:
     int m_statusCode = 200;
     std::string m_status;
@@ -18,20 +18,178 @@
 
 #include "net/http/server.h"
 
+#include <atomic>
 #include <thread>
 
+#include "net/base/base64.h"
 #include "net/base/strings/string_utils.h"
+#include "net/base/timer_wheel.h"
 #include "net/http/connection.h"
+#include "net/http/http2_server.h"
+#include "net/http/status.h"
+#include "net/http/utils.h"
 
 namespace net {
 namespace http {
 
 namespace {
 
+// IsHttp2Upgrade returns whether |request| asks for an upgrade to h2c (RFC 7540, 3.2),
+// |settings| receives the decoded payload of its HTTP2-Settings header.
+bool IsHttp2Upgrade(std::shared_ptr<Request> request, std::string& settings)
+{
+    auto upgrade = base::strings::TrimSpace(request->GetHeader("Upgrade"));
+    if (!base::strings::Equal(upgrade, "h2c", true))
+        return false;
+    auto values = request->GetHeaders("HTTP2-Settings");
+    if (values.size() != 1)
+        return false;
+
+    // The header is base64url encoded without padding.
+    auto value = base::strings::TrimSpace(values[0]);
+    settings = base::base64::Decode(value, base::base64::kUrlSafe | base::base64::kNoPadding);
+    if (settings.empty() && !value.empty())
+        return false;
+    return settings.size() % 6 == 0;
+}
+
+// WantsKeepAlive returns whether the client of |request| keeps the connection open.
+bool WantsKeepAlive(std::shared_ptr<Request> request)
+{
+    auto values = request->GetHeaders("Connection");
+    if (HasHeaderToken(values, "close"))
+        return false;
+    // HTTP/1.0 connections are closed unless the client asks otherwise.
+    if (request->GetProto() == "HTTP/1.0")
+        return HasHeaderToken(values, "keep-alive");
+    return true;
+}
+
+const char kServiceUnavailable[] =
+    "HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+
+typedef std::chrono::steady_clock Clock;
+
+// The listener is polled this often for Shutdown.
+const std::chrono::microseconds kAcceptPollInterval = std::chrono::milliseconds(100);
+
+// RequestTimer times the phases of the requests of a connection and records them with
+// the bytes of the connection to Metrics and AccessLog. It does nothing without them.
+class RequestTimer
+{
+public:
+    RequestTimer(Metrics* metrics, AccessLog* accessLog, const Connection& conn)
+        : m_metrics(metrics)
+        , m_accessLog(accessLog)
+        , m_enabled(metrics || accessLog)
+        , m_conn(conn)
+    {
+    }
+
+    // Start marks the first byte of a request, the first one of the connection
+    // is timed from |accepted| as well.
+    void Start(bool first, Clock::time_point accepted)
+    {
+        if (!m_enabled)
+            return;
+        m_start = m_last = Clock::now();
+        if (first)
+            m_sample.Latency[Metrics::kFirstByte] = Microseconds(accepted, m_start);
+    }
+
+    // Mark starts the next phase.
+    void Mark()
+    {
+        if (m_enabled)
+            m_last = Clock::now();
+    }
+
+    // End ends |phase| and starts the next one.
+    void End(Metrics::Phase phase)
+    {
+        if (!m_enabled)
+            return;
+        auto now = Clock::now();
+        m_sample.Latency[phase] = Microseconds(m_last, now);
+        m_last = now;
+    }
+
+    // Record records |request|, timed until the end of the last phase.
+    void Record(const Request& request, int statusCode)
+    {
+        if (!m_enabled)
+            return;
+        m_sample.StatusCode = statusCode;
+        m_sample.Latency[Metrics::kRequest] = Microseconds(m_start, m_last);
+        uint64_t received = m_conn.GetBytesReceived();
+        uint64_t sent = m_conn.GetBytesSent();
+        m_sample.BytesReceived = received - m_received;
+        m_sample.BytesSent = sent - m_sent;
+        m_received = received;
+        m_sent = sent;
+        if (m_metrics)
+            m_metrics->RecordRequest(m_sample);
+        if (m_accessLog)
+        {
+            m_accessLog->Log(request, statusCode, m_sample.BytesSent,
+                std::chrono::microseconds(m_sample.Latency[Metrics::kRequest]));
+        }
+        m_sample = Metrics::RequestSample();
+    }
+
+    // The bytes after the last request, e.g. of a malformed one, are counted at the end.
+    ~RequestTimer()
+    {
+        if (!m_metrics)
+            return;
+        m_metrics->Add(Metrics::kBytesReceived, m_conn.GetBytesReceived() - m_received);
+        m_metrics->Add(Metrics::kBytesSent, m_conn.GetBytesSent() - m_sent);
+    }
+
+private:
+    static int64_t Microseconds(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+    }
+
+private:
+    Metrics* m_metrics;
+    AccessLog* m_accessLog;
+    bool m_enabled;
+    const Connection& m_conn;
+    Metrics::RequestSample m_sample;
+    Clock::time_point m_start;
+    Clock::time_point m_last;
+    uint64_t m_received = 0;
+    uint64_t m_sent = 0;
+};
+
 } // !namespace anonymous
 
+struct Server::ConnectionState
+{
+    std::shared_ptr<StreamSocket> Socket;
+    std::list<ConnectionState*>::iterator Iter;
+    Clock::time_point Accepted;
+    // Set by the deadlines when they shut the connection down.
+    std::atomic<bool> TimedOut{ false };
+    std::list<ConnectionState*>::iterator IdleIter;
+    bool Tracked = false;
+    bool Idle = false;
+    bool Evicted = false;
+};
+
 Server::Server(const SocketAddress & address)
     : m_address(address)
+    , m_metrics(Metrics::Create())
+{
+}
+
+Server::Server(const ServerSocket& listener)
+    : m_address(listener.GetLocalAddress())
+    , m_ss(listener)
+    , m_adopted(true)
+    , m_metrics(Metrics::Create())
 {
 }
 
@@ -73,6 +231,13 @@ std::shared_ptr<Server> Server::Create(const SocketAddress & address)
     return std::shared_ptr<Server>(new Server(address));
 }
 
+std::shared_ptr<Server> Server::Create(const ServerSocket& listener)
+{
+    if (listener.GetNativeHandle() == INVALID_SOCKET)
+        return nullptr;
+    return std::shared_ptr<Server>(new Server(listener));
+}
+
 std::chrono::seconds Server::GetReadTimeout() const
 {
     return m_readTimeout;
@@ -93,6 +258,102 @@ void Server::SetWriteTimeout(std::chrono::seconds timeout)
     m_writeTimeout = timeout;
 }
 
+std::chrono::milliseconds Server::GetReadHeaderTimeout() const
+{
+    return m_readHeaderTimeout;
+}
+
+void Server::SetReadHeaderTimeout(std::chrono::milliseconds timeout)
+{
+    m_readHeaderTimeout = timeout;
+}
+
+std::chrono::milliseconds Server::GetReadBodyTimeout() const
+{
+    return m_readBodyTimeout;
+}
+
+void Server::SetReadBodyTimeout(std::chrono::milliseconds timeout)
+{
+    m_readBodyTimeout = timeout;
+}
+
+std::chrono::milliseconds Server::GetIdleTimeout() const
+{
+    return m_idleTimeout;
+}
+
+void Server::SetIdleTimeout(std::chrono::milliseconds timeout)
+{
+    m_idleTimeout = timeout;
+}
+
+std::chrono::milliseconds Server::GetRequestTimeout() const
+{
+    return m_requestTimeout;
+}
+
+void Server::SetRequestTimeout(std::chrono::milliseconds timeout)
+{
+    m_requestTimeout = timeout;
+}
+
+size_t Server::GetMaxConnections() const
+{
+    return m_maxConnections;
+}
+
+void Server::SetMaxConnections(size_t max)
+{
+    m_maxConnections = max;
+}
+
+int Server::GetMaxRequestsPerConnection() const
+{
+    return m_maxRequestsPerConnection;
+}
+
+void Server::SetMaxRequestsPerConnection(int max)
+{
+    m_maxRequestsPerConnection = max;
+}
+
+size_t Server::GetMaxRequestBodySize() const
+{
+    return m_maxRequestBodySize;
+}
+
+void Server::SetMaxRequestBodySize(size_t size)
+{
+    m_maxRequestBodySize = size;
+}
+
+size_t Server::GetConnectionCount() const
+{
+    std::lock_guard<std::mutex> lock(m_connectionsMutex);
+    return m_connectionCount;
+}
+
+std::shared_ptr<Metrics> Server::GetMetrics() const
+{
+    return m_metrics;
+}
+
+void Server::SetMetrics(std::shared_ptr<Metrics> metrics)
+{
+    m_metrics = metrics;
+}
+
+std::shared_ptr<AccessLog> Server::GetAccessLog() const
+{
+    return m_accessLog;
+}
+
+void Server::SetAccessLog(std::shared_ptr<AccessLog> accessLog)
+{
+    m_accessLog = accessLog;
+}
+
 std::shared_ptr<Handler> Server::GetHandler() const
 {
     return m_handler;
@@ -103,44 +364,316 @@ void Server::SetHandler(std::shared_ptr<Handler> handler)
     m_handler = handler;
 }
 
+bool Server::GetEnableHttp2() const
+{
+    return m_enableHttp2;
+}
+
+void Server::SetEnableHttp2(bool enable)
+{
+    m_enableHttp2 = enable;
+}
+
 bool Server::ListenAndServe()
 {
-    if (!m_ss.Bind(m_address))
-        return false;
-    if (!m_ss.Listen())
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(m_connectionsMutex);
+        if (m_shuttingDown || m_listening)
+            return false;
+        m_listening = true;
+    }
+    bool served = Listen() && AcceptConnections();
+
+    std::lock_guard<std::mutex> lock(m_connectionsMutex);
+    m_ss.Close();
+    m_listening = false;
+    m_stateChanged.notify_all();
+    return served;
+}
 
-    while (true)
+bool Server::Listen()
+{
+    if (m_adopted)
+        return true;
+    return m_ss.Bind(m_address) && m_ss.Listen();
+}
+
+bool Server::AcceptConnections()
+{
+    while (!m_shuttingDown)
     {
+        // Accept only once a connection is pending, so that Shutdown stops the loop in time.
+        if (!m_ss.Poll(kAcceptPollInterval, SELECT_READ))
+            continue;
         auto s = m_ss.Accept();
+        if (!s->GetImpl())
+            continue;
+        auto metrics = m_metrics;
+        auto accepted = metrics ? Clock::now() : Clock::time_point();
 
         s->SetReceiveTimeout(m_readTimeout);
         s->SetSendTimeout(m_writeTimeout);
 
-        std::thread t(&Server::Serve, this, s);
+        if (!AddConnection())
+        {
+            // All the connections are busy, the client may come back later.
+            s->Send(kServiceUnavailable, sizeof(kServiceUnavailable) - 1);
+            s->Shutdown();
+            if (metrics)
+                metrics->Add(Metrics::kConnectionsRejected);
+            continue;
+        }
+        if (metrics)
+            metrics->Add(Metrics::kConnectionsAccepted);
+
+        std::thread t(&Server::Serve, this, s, accepted);
         t.detach();
     }
     return true;
 }
 
-void Server::Serve(std::shared_ptr<StreamSocket> s)
+bool Server::Shutdown(std::chrono::milliseconds timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(m_connectionsMutex);
+    m_shuttingDown = true;
+
+    // The idle connections are closed, the busy ones close once their request is served.
+    for (auto state : m_idleConnections)
+        state->Socket->Shutdown();
+
+    bool drained = m_stateChanged.wait_until(lock, deadline, [this] {
+        return !m_listening && m_threadCount == 0;
+    });
+    if (!drained)
+    {
+        for (auto state : m_connections)
+            state->Socket->Shutdown();
+    }
+    return drained;
+}
+
+bool Server::HandOff(StreamSocket& channel)
+{
+    ServerSocket listener;
+    {
+        std::lock_guard<std::mutex> lock(m_connectionsMutex);
+        if (!m_listening || m_shuttingDown)
+            return false;
+        listener = m_ss;
+    }
+    // The channel is used outside of the lock, the other process may be slow to answer.
+    return listener.HandOff(channel);
+}
+
+void Server::Serve(std::shared_ptr<StreamSocket> s, std::chrono::steady_clock::time_point accepted)
+{
+    ConnectionState state;
+    state.Socket = s;
+    state.Accepted = accepted;
+    if (TrackConnection(state))
+        ServeConnection(s, state);
+    RemoveConnection(state);
+
+    auto metrics = m_metrics;
+    if (metrics)
+    {
+        if (state.TimedOut)
+            metrics->Add(Metrics::kTimeouts);
+        metrics->Add(Metrics::kConnectionsClosed);
+    }
+
+    // The server may be gone once the thread is no longer counted.
+    std::lock_guard<std::mutex> lock(m_connectionsMutex);
+    --m_threadCount;
+    m_stateChanged.notify_all();
+}
+
+void Server::ServeConnection(std::shared_ptr<StreamSocket> s, ConnectionState& state)
 {
     Connection conn(s);
+    conn.SetMaxBodySize(m_maxRequestBodySize);
+    auto metrics = m_metrics;
+    auto accessLog = m_accessLog;
+    RequestTimer timer(metrics.get(), accessLog.get(), conn);
 
-    while (true)
+    // A passed deadline shuts the connection down, which ends the blocking reads and writes.
+    base::Deadline deadline([s, &state] { state.TimedOut = true; s->Shutdown(); });
+    base::Deadline requestDeadline([s, &state] { state.TimedOut = true; s->Shutdown(); });
+    deadline.Reset(m_readHeaderTimeout);
+
+    for (int requests = 0; ; ++requests)
     {
-        auto request = conn.ReadRequest();
+        // A connection waiting for its first or next request is idle, it may be closed
+        // to make room for a new one or by Shutdown. The requests are timed from their
+        // first byte.
+        if (requests == 0 || !conn.HasBufferedRequest())
+        {
+            if (requests > 0)
+                deadline.Reset(m_idleTimeout);
+            bool received = SetIdle(state, true) && conn.WaitForRequest();
+            if (!SetIdle(state, false) || !received)
+                break;
+        }
+        if (requests > 0)
+            deadline.Reset(m_readHeaderTimeout);
+        timer.Start(requests == 0, state.Accepted);
+        requestDeadline.Reset(m_requestTimeout);
+
+        auto request = conn.ReadRequestHeader();
         if (!request)
+        {
+            deadline.Cancel();
+            requestDeadline.Cancel();
+            if (conn.IsHttp2Preface() && m_enableHttp2 && conn.Flush())
+            {
+                // HTTP/2 with prior knowledge, the first line of the preface was consumed.
+                auto h2 = Http2ServerConnection::Create(s, m_handler);
+                h2->SetMaxBodySize(m_maxRequestBodySize);
+                h2->Serve(std::string(kHttp2Preface, 16) + conn.TakeBufferedBytes());
+            }
+            else if (metrics && !conn.IsHttp2Preface() && !state.TimedOut)
+            {
+                metrics->Add(Metrics::kParseErrors);
+            }
+            break;
+        }
+        timer.End(Metrics::kReadHeader);
+        deadline.Reset(m_readBodyTimeout);
+        bool bodyRead = conn.ReadRequestBody(request);
+        deadline.Cancel();
+        // The request is bounded until it is read, the handler may keep the
+        // connection as long as it needs, e.g. for a WebSocket or an event stream.
+        requestDeadline.Cancel();
+        if (!bodyRead)
+        {
+            // The next request would be read from the middle of this one.
+            if (metrics && !state.TimedOut)
+                metrics->Add(Metrics::kParseErrors);
+            break;
+        }
+
+        std::string settings;
+        if (m_enableHttp2 && IsHttp2Upgrade(request, settings))
+        {
+            auto writer = conn.GetWriter();
+            if (writer->Write("HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n") < 0 ||
+                !conn.Flush())
+                return;
+            auto h2 = Http2ServerConnection::Create(s, m_handler);
+            h2->SetMaxBodySize(m_maxRequestBodySize);
+            h2->ServeUpgrade(request, settings, conn.TakeBufferedBytes());
             return;
-        if (m_handler)
+        }
+
+        auto ctx = conn.NewContext(request);
+        auto response = ctx->GetResponse();
+        if (!WantsKeepAlive(request) || m_shuttingDown ||
+            (m_maxRequestsPerConnection > 0 && requests + 1 >= m_maxRequestsPerConnection))
         {
-            auto ctx = Context::Create(s, request);
+            response->SetHeader("Connection", "close");
+        }
+        else
+        {
+            if (request->GetProto() == "HTTP/1.0")
+                response->SetHeader("Connection", "keep-alive");
+            std::string keepAlive;
+            auto idleSeconds = std::chrono::duration_cast<std::chrono::seconds>(m_idleTimeout).count();
+            if (idleSeconds > 0)
+                keepAlive = "timeout=" + std::to_string(idleSeconds);
+            if (m_maxRequestsPerConnection > 0)
+            {
+                if (!keepAlive.empty())
+                    keepAlive += ", ";
+                keepAlive += "max=" + std::to_string(m_maxRequestsPerConnection - requests - 1);
+            }
+            if (!keepAlive.empty())
+                response->SetHeader("Keep-Alive", keepAlive);
+        }
+
+        timer.Mark();
+        if (m_handler)
             m_handler->ServeHTTP(ctx);
+        else
+            response->SetStatusCode(Status::NotFound);
+        timer.End(Metrics::kHandler);
+        ctx->Finish();
+        if (conn.IsHijacked())
+        {
+            timer.Record(*request, response->GetStatusCode());
+            return;
         }
-        auto c = request->GetHeader("Connection");
-        if (base::strings::Equal(c, "close", true))
+
+        // HTTP pipelining: while the next request is already buffered, serve it
+        // first and send the responses in order with a single send.
+        // Once the server is shutting down, the connection is closed after the response.
+        bool keepAlive = !base::strings::Equal(response->GetHeader("Connection"), "close", true) &&
+            !m_shuttingDown;
+        bool flushed = (keepAlive && conn.HasBufferedRequest()) || conn.Flush();
+        timer.End(Metrics::kWrite);
+        timer.Record(*request, response->GetStatusCode());
+        if (!keepAlive)
             break;
+        if (!flushed)
+            return;
+    }
+    conn.Flush();
+}
+
+bool Server::AddConnection()
+{
+    std::lock_guard<std::mutex> lock(m_connectionsMutex);
+    if (m_maxConnections > 0 && m_connectionCount >= m_maxConnections)
+    {
+        if (m_idleConnections.empty())
+            return false;
+        // Make room by closing the connection which has been idle the longest.
+        auto state = m_idleConnections.front();
+        m_idleConnections.pop_front();
+        state->Idle = false;
+        state->Evicted = true;
+        state->Socket->Shutdown();
+        --m_connectionCount;
     }
+    ++m_connectionCount;
+    ++m_threadCount;
+    return true;
+}
+
+bool Server::TrackConnection(ConnectionState & state)
+{
+    std::lock_guard<std::mutex> lock(m_connectionsMutex);
+    if (m_shuttingDown)
+        return false;
+    state.Iter = m_connections.insert(m_connections.end(), &state);
+    state.Tracked = true;
+    return true;
+}
+
+void Server::RemoveConnection(ConnectionState & state)
+{
+    std::lock_guard<std::mutex> lock(m_connectionsMutex);
+    if (state.Idle)
+        m_idleConnections.erase(state.IdleIter);
+    state.Idle = false;
+    if (state.Tracked)
+        m_connections.erase(state.Iter);
+    state.Tracked = false;
+    if (!state.Evicted)
+        --m_connectionCount;
+}
+
+bool Server::SetIdle(ConnectionState & state, bool idle)
+{
+    std::lock_guard<std::mutex> lock(m_connectionsMutex);
+    if (state.Evicted || (idle && m_shuttingDown))
+        return false;
+    if (idle && !state.Idle)
+        state.IdleIter = m_idleConnections.insert(m_idleConnections.end(), &state);
+    else if (!idle && state.Idle)
+        m_idleConnections.erase(state.IdleIter);
+    state.Idle = idle;
+    return true;
 }
 
 } // !namespace http
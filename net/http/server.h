@@ -18,9 +18,16 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
 #include <string>
 
+#include "net/http/access_log.h"
 #include "net/http/handler.h"
+#include "net/http/metrics.h"
 #include "net/socket/ServerSocket.h"
 #include "net/socket/SocketAddress.h"
 
@@ -34,31 +41,137 @@ public:
 
 protected:
     Server(const SocketAddress& address);
+    Server(const ServerSocket& listener);
 
 public:
     static std::shared_ptr<Server> Create(uint16_t port);
     static std::shared_ptr<Server> Create(const std::string& address);
     static std::shared_ptr<Server> Create(const SocketAddress& address);
+    // Create serves the connections of a socket which is already listening, e.g. one
+    // handed over by the previous instance of the server, see ServerSocket::TakeOver.
+    static std::shared_ptr<Server> Create(const ServerSocket& listener);
 
     std::chrono::seconds GetReadTimeout() const;
     void SetReadTimeout(std::chrono::seconds timeout);
     std::chrono::seconds GetWriteTimeout() const;
     void SetWriteTimeout(std::chrono::seconds timeout);
 
+    // The deadlines below are kept by a timer wheel and shut the connection down
+    // when they pass. A timeout of 0, the default, disables them.
+    // ReadHeaderTimeout bounds reading the headers of a request, from the connection
+    // for the first request and from its first byte for the next ones.
+    std::chrono::milliseconds GetReadHeaderTimeout() const;
+    void SetReadHeaderTimeout(std::chrono::milliseconds timeout);
+    // ReadBodyTimeout bounds reading the body of a request.
+    std::chrono::milliseconds GetReadBodyTimeout() const;
+    void SetReadBodyTimeout(std::chrono::milliseconds timeout);
+    // IdleTimeout bounds waiting for the next request on a keep-alive connection.
+    std::chrono::milliseconds GetIdleTimeout() const;
+    void SetIdleTimeout(std::chrono::milliseconds timeout);
+    // RequestTimeout bounds a request from its first byte until it is read completely,
+    // the handler, a hijacked connection or an event stream are not cut by it.
+    std::chrono::milliseconds GetRequestTimeout() const;
+    void SetRequestTimeout(std::chrono::milliseconds timeout);
+
     std::shared_ptr<Handler> GetHandler() const;
     void SetHandler(std::shared_ptr<Handler> handler);
 
+    // HTTP/2 over cleartext TCP (h2c) is served when the client starts with the
+    // HTTP/2 connection preface or asks for "Upgrade: h2c". It is enabled by default.
+    bool GetEnableHttp2() const;
+    void SetEnableHttp2(bool enable);
+
+    // MaxConnections bounds the connections served at once, 0 for no limit. At the limit
+    // the connection which has waited the longest for its first or next request is closed
+    // for a new one, and a new connection is answered with 503 if none is waiting.
+    size_t GetMaxConnections() const;
+    void SetMaxConnections(size_t max);
+
+    // MaxRequestsPerConnection closes a keep-alive connection after that many requests,
+    // 0 for no limit. The responses tell it in their Keep-Alive header.
+    int GetMaxRequestsPerConnection() const;
+    void SetMaxRequestsPerConnection(int max);
+
+    // MaxRequestBodySize bounds the Content-Length of a request, 0 for no limit.
+    // A larger request closes the connection. It is 64 MiB by default.
+    size_t GetMaxRequestBodySize() const;
+    void SetMaxRequestBodySize(size_t size);
+
+    size_t GetConnectionCount() const;
+
+    // Metrics counts the connections, requests and bytes of the HTTP/1.x connections
+    // and times the phases of their requests. Every server has its own metrics, several
+    // servers may share the same ones to add them up. nullptr turns them off.
+    std::shared_ptr<Metrics> GetMetrics() const;
+    void SetMetrics(std::shared_ptr<Metrics> metrics);
+
+    // AccessLog logs the requests of the HTTP/1.x connections, none by default.
+    std::shared_ptr<AccessLog> GetAccessLog() const;
+    void SetAccessLog(std::shared_ptr<AccessLog> accessLog);
+
+    // ListenAndServe accepts the connections until Shutdown is called, it returns false
+    // if the address can't be listened on or the server has been shut down.
     bool ListenAndServe();
 
+    // Shutdown stops the server gracefully: it stops accepting connections, closes the
+    // idle ones and lets the requests in progress finish, their connections are closed
+    // after the response. It returns true once ListenAndServe has returned and all the
+    // connections are closed. When |timeout| passes first, it shuts the remaining
+    // connections down and returns false, the server must then outlive the handlers
+    // still running.
+    bool Shutdown(std::chrono::milliseconds timeout);
+
+    // HandOff passes the listening socket to the process on the other end of |channel|,
+    // see ServerSocket::HandOff. Both servers accept the connections until this one
+    // is shut down. It returns false if the server isn't listening.
+    bool HandOff(StreamSocket& channel);
+
 protected:
-    void Serve(std::shared_ptr<StreamSocket> s);
+    struct ConnectionState;
+
+    bool Listen();
+    bool AcceptConnections();
+    void Serve(std::shared_ptr<StreamSocket> s, std::chrono::steady_clock::time_point accepted);
+    void ServeConnection(std::shared_ptr<StreamSocket> s, ConnectionState& state);
+
+    // AddConnection counts a new connection, evicting an idle one at the limit.
+    bool AddConnection();
+    // TrackConnection lists a connection for Shutdown, it returns false if the server
+    // is shutting down.
+    bool TrackConnection(ConnectionState& state);
+    void RemoveConnection(ConnectionState& state);
+    // SetIdle moves a connection in or out of the idle list, it returns false
+    // if the connection has been evicted or can't be idle while shutting down.
+    bool SetIdle(ConnectionState& state, bool idle);
 
 private:
     SocketAddress m_address;
     ServerSocket m_ss;
+    bool m_adopted = false;
     std::chrono::seconds m_readTimeout;
     std::chrono::seconds m_writeTimeout;
+    std::chrono::milliseconds m_readHeaderTimeout = std::chrono::milliseconds(0);
+    std::chrono::milliseconds m_readBodyTimeout = std::chrono::milliseconds(0);
+    std::chrono::milliseconds m_idleTimeout = std::chrono::milliseconds(0);
+    std::chrono::milliseconds m_requestTimeout = std::chrono::milliseconds(0);
     std::shared_ptr<Handler> m_handler;
+    bool m_enableHttp2 = true;
+    std::shared_ptr<Metrics> m_metrics;
+    std::shared_ptr<AccessLog> m_accessLog;
+
+    size_t m_maxConnections = 0;
+    int m_maxRequestsPerConnection = 0;
+    size_t m_maxRequestBodySize = 64 * 1024 * 1024;
+    mutable std::mutex m_connectionsMutex;
+    size_t m_connectionCount = 0;
+    // The threads serving a connection, evicted ones included.
+    size_t m_threadCount = 0;
+    std::list<ConnectionState*> m_connections;
+    // The idle connections, least recently used first.
+    std::list<ConnectionState*> m_idleConnections;
+    std::atomic<bool> m_shuttingDown{ false };
+    bool m_listening = false;
+    std::condition_variable m_stateChanged;
 };
 
 } // !namespace http
@@ -19,20 +19,20 @@
 #include "net/http/utils.h"
 
 #include "net/base/escape.h"
+#include "net/base/zip.h"
 
 namespace net {
 namespace http {
 
 void ParseQueryForm(const std::string & query, Values & formValues)
 {
-    auto kvpairs = base::strings::Split(query, "&");
-    for (auto kv : kvpairs)
+    for (auto kv : base::strings::SplitPieces(query, "&"))
     {
-        auto pair = base::strings::SplitN(kv, "=", 2);
+        auto pair = base::strings::SplitPiecesN<2>(kv, "=");
         auto k = base::strings::TrimSpace(pair[0]);
         if (k.empty())
             continue;
-        formValues.emplace(k, pair.size() == 2 ? base::Unescape(pair[1]) : "");
+        formValues.emplace(k.ToString(), pair.size() == 2 ? base::Unescape(pair[1]) : "");
     }
 }
 
@@ -45,13 +45,14 @@ Values ParseQueryForm(const std::string & query)
 
 void ParseHeader(const std::vector<std::string>& rawHeaderList, Header & header)
 {
-    for (auto h : rawHeaderList)
+    for (auto& h : rawHeaderList)
     {
-        auto kv = base::strings::SplitN(h, ":", 2);
+        auto kv = base::strings::SplitPiecesN<2>(h, ":");
         auto k = base::strings::TrimSpace(kv[0]);
         if (k.empty())
             continue;
-        header.emplace(k, kv.size() == 2 ? base::strings::TrimSpace(kv[1]) : "");
+        auto v = kv.size() == 2 ? base::strings::TrimSpace(kv[1]) : base::strings::StringPiece();
+        header.emplace(k.ToString(), v.ToString());
     }
 }
 
@@ -62,5 +63,30 @@ Header ParseHeader(const std::vector<std::string>& rawHeaderList)
     return h;
 }
 
+bool HasHeaderToken(const std::vector<std::string>& values, const std::string & token)
+{
+    for (auto& value : values)
+    {
+        for (auto item : base::strings::SplitPieces(value, ","))
+        {
+            if (base::strings::Equal(base::strings::TrimSpace(item), token, true))
+                return true;
+        }
+    }
+    return false;
+}
+
+void SetRequestBody(std::shared_ptr<Request> request, std::string && body)
+{
+    if (request->GetHeaderView("Content-Encoding").find("gzip") != base::strings::StringPiece::npos)
+        body = base::zip::GDecompress(body);
+
+    request->SetBody(std::move(body));
+    auto contentType = request->GetHeader("Content-Type");
+    base::strings::ToLowerSelf(contentType);
+    if (contentType.find("application/x-www-form-urlencoded") != std::string::npos)
+        request->UseBodyAsPostForm();
+}
+
 } // !namespace http
 } // !namespace net
\ No newline at end of file
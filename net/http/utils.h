@@ -18,9 +18,11 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 
 #include "net/http/httpdefs.h"
+#include "net/http/request.h"
 
 namespace net {
 namespace http {
@@ -31,5 +33,13 @@ Values ParseQueryForm(const std::string& query);
 void ParseHeader(const std::vector<std::string>& rawHeaderList, Header& header);
 Header ParseHeader(const std::vector<std::string>& rawHeaderList);
 
+// HasHeaderToken returns whether the comma separated header values contain |token|,
+// e.g. "upgrade" in "Connection: keep-alive, Upgrade".
+bool HasHeaderToken(const std::vector<std::string>& values, const std::string& token);
+
+// SetRequestBody sets the body of |request|, decoding its Content-Encoding,
+// and parses the form values of an urlencoded body. |body| is moved into the request.
+void SetRequestBody(std::shared_ptr<Request> request, std::string&& body);
+
 } // !namespace http
 } // !namespace net
\ No newline at end of file
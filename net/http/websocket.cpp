@@ -0,0 +1,648 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/http/websocket.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define NET_WEBSOCKET_SSE2
+#endif
+
+#include "net/base/base64.h"
+#include "net/base/sha1.h"
+#include "net/base/zip.h"
+#include "net/base/strings/string_utils.h"
+#include "net/http/status.h"
+#include "net/http/utils.h"
+
+namespace net {
+namespace http {
+
+namespace {
+
+const char kWebSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+const int kReceiveBufferSize = 16 * 1024;
+const size_t kMaxControlPayload = 125;
+// Small messages grow rather than shrink when deflated.
+const size_t kMinCompressLength = 32;
+const unsigned char kDeflateTail[4] = { 0x00, 0x00, 0xFF, 0xFF };
+
+bool IsValidUtf8(const std::string& str)
+{
+    auto p = (const unsigned char*)str.data();
+    auto end = p + str.size();
+    while (p < end)
+    {
+        unsigned char c = *p;
+        if (c < 0x80)
+        {
+            ++p;
+            continue;
+        }
+        size_t n;
+        uint32_t cp;
+        if (c >= 0xC2 && c <= 0xDF)
+        {
+            n = 1;
+            cp = c & 0x1F;
+        }
+        else if (c >= 0xE0 && c <= 0xEF)
+        {
+            n = 2;
+            cp = c & 0x0F;
+        }
+        else if (c >= 0xF0 && c <= 0xF4)
+        {
+            n = 3;
+            cp = c & 0x07;
+        }
+        else
+        {
+            return false;
+        }
+        if ((size_t)(end - p) <= n)
+            return false;
+        for (size_t i = 1; i <= n; ++i)
+        {
+            if ((p[i] & 0xC0) != 0x80)
+                return false;
+            cp = (cp << 6) | (p[i] & 0x3F);
+        }
+        // Overlong forms, surrogates and code points beyond U+10FFFF.
+        if ((n == 2 && cp < 0x800) || (n == 3 && cp < 0x10000) ||
+            (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+            return false;
+        p += n + 1;
+    }
+    return true;
+}
+
+bool IsValidCloseCode(uint16_t code)
+{
+    if (code >= 3000 && code <= 4999)
+        return true;
+    return code >= 1000 && code <= 1011 && code != 1004 &&
+        code != WebSocketCloseNoStatus && code != 1006;
+}
+
+struct DeflateParams
+{
+    bool Enabled = false;
+    int ServerMaxWindowBits = 15;
+    bool ServerNoContextTakeover = false;
+    bool ClientNoContextTakeover = false;
+    std::string Response;
+};
+
+// ParseDeflateOffer accepts a permessage-deflate offer (RFC 7692, 7.1),
+// offers with unknown or malformed parameters are declined.
+bool ParseDeflateOffer(base::strings::StringPiece extension, DeflateParams& result)
+{
+    DeflateParams offer;
+    offer.Response = "permessage-deflate";
+    // The parameters follow the name of the extension.
+    base::strings::SplitIterator param(extension, ";"), end;
+    for (++param; param != end; ++param)
+    {
+        auto kv = base::strings::SplitPiecesN<2>(*param, "=");
+        auto name = base::strings::ToLower(base::strings::TrimSpace(kv[0]));
+        std::string value;
+        if (kv.size() == 2)
+            value = base::strings::Trim(base::strings::TrimSpace(kv[1]), "\"").ToString();
+        if (name == "server_no_context_takeover" && kv.size() == 1)
+        {
+            offer.ServerNoContextTakeover = true;
+            offer.Response += "; server_no_context_takeover";
+        }
+        else if (name == "client_no_context_takeover" && kv.size() == 1)
+        {
+            offer.ClientNoContextTakeover = true;
+        }
+        else if (name == "server_max_window_bits")
+        {
+            // zlib does not support raw deflate with a window of 8 bits.
+            if (!base::strings::IsDigit(value) || value.size() > 2)
+                return false;
+            int bits = std::stoi(value);
+            if (bits < 9 || bits > 15)
+                return false;
+            offer.ServerMaxWindowBits = bits;
+            offer.Response += "; server_max_window_bits=" + value;
+        }
+        else if (name == "client_max_window_bits")
+        {
+            // The inflater always uses a window of 15 bits, which fits any client window.
+            if (kv.size() == 2)
+            {
+                if (!base::strings::IsDigit(value) || value.size() > 2)
+                    return false;
+                int bits = std::stoi(value);
+                if (bits < 8 || bits > 15)
+                    return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    offer.Enabled = true;
+    result = offer;
+    return true;
+}
+
+bool NegotiateDeflate(const std::vector<std::string>& headers, DeflateParams& result)
+{
+    for (auto& header : headers)
+    {
+        for (auto extension : base::strings::SplitPieces(header, ","))
+        {
+            auto name = base::strings::TrimSpace(*base::strings::SplitIterator(extension, ";"));
+            if (base::strings::Equal(name, "permessage-deflate", true) &&
+                ParseDeflateOffer(extension, result))
+                return true;
+        }
+    }
+    return false;
+}
+
+} // !namespace anonymous
+
+namespace websocket {
+
+std::string AcceptKey(const std::string & key)
+{
+    return base::base64::Encode(base::sha1::Sum(key + kWebSocketGuid));
+}
+
+void Mask(char * data, size_t length, const uint8_t key[4], size_t offset /*= 0*/)
+{
+    uint8_t k[4];
+    for (int i = 0; i < 4; ++i)
+        k[i] = key[(offset + i) & 3];
+    size_t i = 0;
+#if defined(NET_WEBSOCKET_SSE2)
+    if (length >= 16)
+    {
+        uint32_t k32;
+        memcpy(&k32, k, 4);
+        __m128i mask = _mm_set1_epi32((int)k32);
+        for (; i + 16 <= length; i += 16)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+            _mm_storeu_si128((__m128i*)(data + i), _mm_xor_si128(v, mask));
+        }
+    }
+#endif
+    for (; i < length; ++i)
+        data[i] ^= k[i & 3];
+}
+
+void AppendFrame(std::string & out, uint8_t opcode, bool fin, bool rsv1,
+    const char * payload, size_t length, const uint8_t * maskKey /*= nullptr*/)
+{
+    char header[14];
+    size_t n = 0;
+    header[n++] = (char)((fin ? 0x80 : 0) | (rsv1 ? 0x40 : 0) | (opcode & 0x0F));
+    char masked = maskKey ? (char)0x80 : 0;
+    if (length < 126)
+    {
+        header[n++] = masked | (char)length;
+    }
+    else if (length <= 0xFFFF)
+    {
+        header[n++] = masked | 126;
+        header[n++] = (char)(length >> 8);
+        header[n++] = (char)length;
+    }
+    else
+    {
+        header[n++] = masked | 127;
+        for (int shift = 56; shift >= 0; shift -= 8)
+            header[n++] = (char)((uint64_t)length >> shift);
+    }
+    if (maskKey)
+    {
+        memcpy(header + n, maskKey, 4);
+        n += 4;
+    }
+    out.append(header, n);
+    size_t start = out.size();
+    out.append(payload, length);
+    if (maskKey && length > 0)
+        Mask(&out[start], length, maskKey);
+}
+
+} // !namespace websocket
+
+// Compression keeps the deflate streams of a connection, the contexts are kept
+// between messages unless a no_context_takeover parameter was negotiated.
+struct WebSocket::Compression
+{
+    base::zip::Deflater Deflater;
+    base::zip::Inflater Inflater;
+    bool ResetDeflater;
+    bool ResetInflater;
+    bool Valid;
+
+    Compression(int windowBits, bool resetDeflater, bool resetInflater)
+        : Deflater(base::zip::kRaw, base::zip::kDefaultLevel, windowBits)
+        , Inflater(base::zip::kRaw)
+        , ResetDeflater(resetDeflater)
+        , ResetInflater(resetInflater)
+        , Valid(Deflater.IsValid() && Inflater.IsValid())
+    {
+    }
+
+    // Compress deflates a message and removes the trailing empty block (RFC 7692, 7.2.1).
+    bool Compress(const char* data, size_t length, std::string& out)
+    {
+        out.clear();
+        if (!Deflater.Compress(data, length, out, base::zip::kSyncFlush))
+            return false;
+        if (out.size() < 4 || memcmp(out.data() + out.size() - 4, kDeflateTail, 4) != 0)
+            return false;
+        out.resize(out.size() - 4);
+        if (ResetDeflater)
+            Deflater.Reset();
+        return true;
+    }
+
+    // Decompress inflates a message, |tooBig| is set when it exceeds |maxSize|.
+    bool Decompress(const std::string& in, std::string& out, size_t maxSize, bool& tooBig)
+    {
+        out.clear();
+        bool ok = Inflater.Inflate(in.data(), in.size(), out, maxSize);
+        // A final block ends the stream, the next message starts a new one.
+        if (ok && !Inflater.IsFinished())
+            ok = Inflater.Inflate((const char*)kDeflateTail, sizeof(kDeflateTail), out, maxSize);
+        tooBig = out.size() > maxSize;
+        if (!ok)
+            return false;
+        if (ResetInflater || Inflater.IsFinished())
+            Inflater.Reset();
+        return true;
+    }
+};
+
+WebSocket::WebSocket(std::shared_ptr<StreamSocket> s, const std::string & buffered)
+    : m_socket(s)
+    , m_buffer(buffered)
+{
+}
+
+WebSocket::~WebSocket()
+{
+}
+
+bool WebSocket::IsUpgradeRequest(std::shared_ptr<Request> request)
+{
+    return request->GetMethod() == "GET" &&
+        HasHeaderToken(request->GetHeaders("Upgrade"), "websocket") &&
+        HasHeaderToken(request->GetHeaders("Connection"), "upgrade");
+}
+
+std::shared_ptr<WebSocket>
+WebSocket::Upgrade(
+    std::shared_ptr<Context> ctx,
+    bool enableCompression /*= true*/)
+{
+    auto request = ctx->GetRequest();
+    auto response = ctx->GetResponse();
+    if (!IsUpgradeRequest(request))
+    {
+        response->SetStatusCode(Status::BadRequest);
+        return nullptr;
+    }
+    if (base::strings::TrimSpace(request->GetHeader("Sec-WebSocket-Version")) != "13")
+    {
+        response->SetStatusCode(Status::UpgradeRequired);
+        response->SetHeader("Sec-WebSocket-Version", "13");
+        return nullptr;
+    }
+    auto key = base::strings::TrimSpace(request->GetHeader("Sec-WebSocket-Key"));
+    if (base::base64::Decode(key).size() != 16)
+    {
+        response->SetStatusCode(Status::BadRequest);
+        return nullptr;
+    }
+
+    DeflateParams deflate;
+    if (enableCompression)
+        NegotiateDeflate(request->GetHeaders("Sec-WebSocket-Extensions"), deflate);
+
+    response->SetStatusCode(Status::SwitchingProtocols);
+    response->SetHeader("Upgrade", "websocket");
+    response->SetHeader("Connection", "Upgrade");
+    response->SetHeader("Sec-WebSocket-Accept", websocket::AcceptKey(key));
+    if (deflate.Enabled)
+        response->SetHeader("Sec-WebSocket-Extensions", deflate.Response);
+    if (ctx->WriteHeader() < 0)
+        return nullptr;
+
+    std::string buffered;
+    auto s = ctx->Hijack(buffered);
+    if (!s)
+        return nullptr;
+    s->SetNoDelay(true);
+
+    auto ws = std::shared_ptr<WebSocket>(new WebSocket(s, buffered));
+    if (deflate.Enabled)
+    {
+        ws->m_compression.reset(new Compression(deflate.ServerMaxWindowBits,
+            deflate.ServerNoContextTakeover, deflate.ClientNoContextTakeover));
+        if (!ws->m_compression->Valid)
+        {
+            ws->Fail(WebSocketCloseInternalError);
+            return nullptr;
+        }
+    }
+    return ws;
+}
+
+size_t WebSocket::GetMaxMessageSize() const
+{
+    return m_maxMessageSize;
+}
+
+void WebSocket::SetMaxMessageSize(size_t size)
+{
+    m_maxMessageSize = size;
+}
+
+bool WebSocket::IsCompressed() const
+{
+    return m_compression != nullptr;
+}
+
+bool WebSocket::ReadMessage(std::string & message, int & opcode)
+{
+    message.clear();
+    if (m_closed)
+        return false;
+    int messageOpcode = -1;
+    bool compressed = false;
+    while (true)
+    {
+        WebSocketFrame frame;
+        uint16_t error = 0;
+        if (!ReadFrame(frame, error))
+        {
+            if (error != 0)
+                return Fail(error);
+            m_closed = true;
+            return false;
+        }
+
+        switch (frame.Opcode)
+        {
+        case WebSocketPing:
+        {
+            std::lock_guard<std::mutex> lock(m_writeMutex);
+            SendFrame(WebSocketPong, false, frame.Payload.data(), frame.Payload.size());
+            continue;
+        }
+        case WebSocketPong:
+            continue;
+        case WebSocketClose:
+        {
+            uint16_t code = WebSocketCloseNoStatus;
+            if (frame.Payload.size() == 1)
+                return Fail(WebSocketCloseProtocolError);
+            if (frame.Payload.size() >= 2)
+            {
+                code = (uint16_t)(((uint8_t)frame.Payload[0] << 8) | (uint8_t)frame.Payload[1]);
+                if (!IsValidCloseCode(code))
+                    return Fail(WebSocketCloseProtocolError);
+                if (!IsValidUtf8(frame.Payload.substr(2)))
+                    return Fail(WebSocketCloseInvalidPayload);
+            }
+            {
+                // Echo the status code back (RFC 6455, 5.5.1).
+                std::lock_guard<std::mutex> lock(m_writeMutex);
+                SendFrame(WebSocketClose, false, frame.Payload.data(),
+                    code == WebSocketCloseNoStatus ? 0 : 2);
+            }
+            m_closed = true;
+            m_socket->Shutdown();
+            return false;
+        }
+        case WebSocketContinuation:
+            if (messageOpcode < 0 || frame.Rsv1)
+                return Fail(WebSocketCloseProtocolError);
+            break;
+        default:
+            if (messageOpcode >= 0)
+                return Fail(WebSocketCloseProtocolError);
+            messageOpcode = frame.Opcode;
+            compressed = frame.Rsv1;
+            break;
+        }
+
+        if (message.size() + frame.Payload.size() > m_maxMessageSize)
+            return Fail(WebSocketCloseMessageTooBig);
+        message += frame.Payload;
+        if (!frame.Fin)
+            continue;
+
+        if (compressed)
+        {
+            std::string inflated;
+            bool tooBig = false;
+            if (!m_compression->Decompress(message, inflated, m_maxMessageSize, tooBig))
+                return Fail(tooBig ? WebSocketCloseMessageTooBig : WebSocketCloseInvalidPayload);
+            message.swap(inflated);
+        }
+        if (messageOpcode == WebSocketText && !IsValidUtf8(message))
+            return Fail(WebSocketCloseInvalidPayload);
+        opcode = messageOpcode;
+        return true;
+    }
+}
+
+bool WebSocket::WriteMessage(const std::string & message, int opcode /*= WebSocketText*/)
+{
+    return WriteMessage(message.data(), message.size(), opcode);
+}
+
+bool WebSocket::WriteMessage(const char * data, size_t length, int opcode /*= WebSocketText*/)
+{
+    if (opcode != WebSocketText && opcode != WebSocketBinary)
+        return false;
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (m_compression && length >= kMinCompressLength)
+    {
+        // The deflater is shared by the messages, so they are compressed in sending order.
+        std::string compressed;
+        if (!m_compression->Compress(data, length, compressed))
+            return false;
+        return SendFrame((uint8_t)opcode, true, compressed.data(), compressed.size());
+    }
+    return SendFrame((uint8_t)opcode, false, data, length);
+}
+
+bool WebSocket::Ping(const std::string & data /*= ""*/)
+{
+    if (data.size() > kMaxControlPayload)
+        return false;
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    return SendFrame(WebSocketPing, false, data.data(), data.size());
+}
+
+bool WebSocket::Close(uint16_t code /*= WebSocketCloseNormal*/, const std::string & reason /*= ""*/)
+{
+    if (reason.size() + 2 > kMaxControlPayload)
+        return false;
+    std::string payload;
+    payload.push_back((char)(code >> 8));
+    payload.push_back((char)code);
+    payload += reason;
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    return SendFrame(WebSocketClose, false, payload.data(), payload.size());
+}
+
+bool WebSocket::ReadFrame(WebSocketFrame & frame, uint16_t & error)
+{
+    error = 0;
+    if (!Fill(2))
+        return false;
+    auto p = (const uint8_t*)m_buffer.data() + m_offset;
+    frame.Fin = (p[0] & 0x80) != 0;
+    frame.Rsv1 = (p[0] & 0x40) != 0;
+    frame.Opcode = p[0] & 0x0F;
+    bool masked = (p[1] & 0x80) != 0;
+    uint64_t length = p[1] & 0x7F;
+
+    // The client masks all its frames (RFC 6455, 5.1), RSV1 is only
+    // allowed on data frames with permessage-deflate.
+    bool control = (frame.Opcode & 0x08) != 0;
+    if ((p[0] & 0x30) || (frame.Rsv1 && (!m_compression || control)) || !masked)
+    {
+        error = WebSocketCloseProtocolError;
+        return false;
+    }
+    switch (frame.Opcode)
+    {
+    case WebSocketContinuation:
+    case WebSocketText:
+    case WebSocketBinary:
+    case WebSocketClose:
+    case WebSocketPing:
+    case WebSocketPong:
+        break;
+    default:
+        error = WebSocketCloseProtocolError;
+        return false;
+    }
+    if (control && (!frame.Fin || length > kMaxControlPayload))
+    {
+        error = WebSocketCloseProtocolError;
+        return false;
+    }
+
+    size_t header = 2;
+    if (length == 126)
+    {
+        if (!Fill(4))
+            return false;
+        p = (const uint8_t*)m_buffer.data() + m_offset;
+        length = ((uint64_t)p[2] << 8) | p[3];
+        header = 4;
+    }
+    else if (length == 127)
+    {
+        if (!Fill(10))
+            return false;
+        p = (const uint8_t*)m_buffer.data() + m_offset;
+        length = 0;
+        for (int i = 2; i < 10; ++i)
+            length = (length << 8) | p[i];
+        header = 10;
+    }
+    if (length > m_maxMessageSize)
+    {
+        error = WebSocketCloseMessageTooBig;
+        return false;
+    }
+
+    header += 4;
+    if (!Fill(header + (size_t)length))
+        return false;
+    p = (const uint8_t*)m_buffer.data() + m_offset;
+    uint8_t key[4];
+    memcpy(key, p + header - 4, 4);
+    frame.Payload.assign((const char*)p + header, (size_t)length);
+    if (length > 0)
+        websocket::Mask(&frame.Payload[0], (size_t)length, key);
+    m_offset += header + (size_t)length;
+    return true;
+}
+
+bool WebSocket::Fill(size_t length)
+{
+    if (m_buffer.size() - m_offset >= length)
+        return true;
+    if (m_offset > 0)
+    {
+        m_buffer.erase(0, m_offset);
+        m_offset = 0;
+    }
+    char buffer[kReceiveBufferSize];
+    while (m_buffer.size() < length)
+    {
+        int len = m_socket->Receive(buffer, kReceiveBufferSize);
+        if (len <= 0)
+            return false;
+        m_buffer.append(buffer, len);
+    }
+    return true;
+}
+
+bool WebSocket::SendFrame(uint8_t opcode, bool rsv1, const char * payload, size_t length)
+{
+    if (m_closeSent)
+        return false;
+    if (opcode == WebSocketClose)
+        m_closeSent = true;
+    std::string frame;
+    websocket::AppendFrame(frame, opcode, true, rsv1, payload, length);
+    const char* data = frame.data();
+    size_t remaining = frame.size();
+    while (remaining > 0)
+    {
+        int len = m_socket->Send(data, (int)remaining);
+        if (len <= 0)
+            return false;
+        data += len;
+        remaining -= len;
+    }
+    return true;
+}
+
+bool WebSocket::Fail(uint16_t code)
+{
+    Close(code);
+    m_closed = true;
+    m_socket->Shutdown();
+    return false;
+}
+
+} // !namespace http
+} // !namespace net
@@ -0,0 +1,145 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "net/http/context.h"
+#include "net/socket/StreamSocket.h"
+
+namespace net {
+namespace http {
+
+// The WebSocket Protocol (RFC 6455) with the permessage-deflate extension (RFC 7692).
+
+enum WebSocketOpcode
+{
+    WebSocketContinuation = 0x0,
+    WebSocketText = 0x1,
+    WebSocketBinary = 0x2,
+    WebSocketClose = 0x8,
+    WebSocketPing = 0x9,
+    WebSocketPong = 0xA,
+};
+
+enum WebSocketCloseCode
+{
+    WebSocketCloseNormal = 1000,
+    WebSocketCloseGoingAway = 1001,
+    WebSocketCloseProtocolError = 1002,
+    WebSocketCloseUnsupportedData = 1003,
+    WebSocketCloseNoStatus = 1005,
+    WebSocketCloseInvalidPayload = 1007,
+    WebSocketClosePolicyViolation = 1008,
+    WebSocketCloseMessageTooBig = 1009,
+    WebSocketCloseInternalError = 1011,
+};
+
+struct WebSocketFrame
+{
+    bool Fin = true;
+    bool Rsv1 = false;
+    uint8_t Opcode = 0;
+    std::string Payload;
+};
+
+namespace websocket {
+
+// AcceptKey returns the Sec-WebSocket-Accept value for a Sec-WebSocket-Key.
+std::string AcceptKey(const std::string& key);
+
+// Mask applies the masking key to |data|, |offset| is the position of |data| in the payload.
+// Masking and unmasking are the same operation.
+void Mask(char* data, size_t length, const uint8_t key[4], size_t offset = 0);
+
+// AppendFrame appends a frame to |out|, masked if |maskKey| is not null.
+void AppendFrame(std::string& out, uint8_t opcode, bool fin, bool rsv1,
+    const char* payload, size_t length, const uint8_t* maskKey = nullptr);
+
+} // !namespace websocket
+
+// WebSocket is the server side of a WebSocket connection. ReadMessage is called
+// by one thread, WriteMessage, Ping and Close may be called from any thread.
+class WebSocket
+{
+public:
+    ~WebSocket();
+
+private:
+    WebSocket(std::shared_ptr<StreamSocket> s, const std::string& buffered);
+
+public:
+    // IsUpgradeRequest returns whether |request| asks for a WebSocket connection.
+    static bool IsUpgradeRequest(std::shared_ptr<Request> request);
+
+    // Upgrade sends the handshake response (RFC 6455, 4.2.2) and takes the connection
+    // of |ctx| over, the headers of the context response are sent too.
+    // If the request is not a valid upgrade request, it responds with an error
+    // status and returns nullptr.
+    static std::shared_ptr<WebSocket>
+        Upgrade(
+            std::shared_ptr<Context> ctx,
+            bool enableCompression = true);
+
+    // Messages larger than the limit close the connection with 1009.
+    size_t GetMaxMessageSize() const;
+    void SetMaxMessageSize(size_t size);
+
+    // IsCompressed returns whether permessage-deflate was negotiated.
+    bool IsCompressed() const;
+
+    // ReadMessage reads the next text or binary message. It answers the pings on the
+    // way and returns false once the connection is closed.
+    bool ReadMessage(std::string& message, int& opcode);
+
+    bool WriteMessage(const std::string& message, int opcode = WebSocketText);
+    bool WriteMessage(const char* data, size_t length, int opcode = WebSocketText);
+
+    bool Ping(const std::string& data = "");
+
+    // Close starts the closing handshake, ReadMessage returns false once the peer answers.
+    bool Close(uint16_t code = WebSocketCloseNormal, const std::string& reason = "");
+
+private:
+    struct Compression;
+
+    bool ReadFrame(WebSocketFrame& frame, uint16_t& error);
+    bool Fill(size_t length);
+    // SendFrame is called with m_writeMutex held.
+    bool SendFrame(uint8_t opcode, bool rsv1, const char* payload, size_t length);
+    bool Fail(uint16_t code);
+
+private:
+    std::shared_ptr<StreamSocket> m_socket;
+    std::string m_buffer;
+    size_t m_offset = 0;
+    size_t m_maxMessageSize = 16 * 1024 * 1024;
+
+    std::mutex m_writeMutex;
+    bool m_closeSent = false;
+    bool m_closed = false;
+
+    std::unique_ptr<Compression> m_compression;
+};
+
+} // !namespace http
+} // !namespace net
@@ -0,0 +1,168 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#include "net/http/writer.h"
+
+namespace net {
+namespace http {
+
+namespace {
+
+// Buffered data beyond this size is sent without waiting for Flush.
+const size_t kFlushThreshold = 64 * 1024;
+
+} // !namespace anonymous
+
+Writer::Writer(std::shared_ptr<StreamSocket> s)
+    : m_stream(s)
+{
+}
+
+std::shared_ptr<StreamSocket> Writer::GetStreamSocket() const
+{
+    return m_stream;
+}
+
+int Writer::GetErrorCode() const
+{
+    return m_error;
+}
+
+uint64_t Writer::GetBytesSent() const
+{
+    return m_bytesSent;
+}
+
+bool Writer::GetBuffered() const
+{
+    return m_buffered;
+}
+
+void Writer::SetBuffered(bool buffered)
+{
+    if (!buffered)
+        Flush();
+    m_buffered = buffered;
+}
+
+size_t Writer::GetBufferedBytes() const
+{
+    return m_buffer.size();
+}
+
+int Writer::WriteHeader(const Response & response, const void * body, int length)
+{
+    std::string message = response.GetProto() + " ";
+    message += std::to_string(response.GetStatusCode()) + " ";
+    message += response.GetStatus() + "\r\n";
+
+    auto& headers = response.GetHeadersView();
+    for (auto iter = headers.begin(); iter != headers.end(); ++iter)
+    {
+        message += iter->first + ": " + iter->second + "\r\n";
+    }
+    message += "\r\n";
+    // A large body is sent from where it is instead of being copied behind the headers.
+    if ((size_t)length > kFlushThreshold)
+    {
+        int len = Write(message);
+        if (len < 0 || Write(body, length) < 0)
+            return -1;
+        return len + length;
+    }
+    if (length > 0)
+        message.append((const char*)body, length);
+    return Write(message);
+}
+
+int Writer::Write(const void * buffer, int length)
+{
+    if (!m_stream || length < 0)
+        return -1;
+    if (!m_buffered)
+        return SendAll((const char*)buffer, length) ? length : -1;
+
+    if (m_buffer.size() + length <= kFlushThreshold)
+    {
+        m_buffer.append((const char*)buffer, length);
+        return length;
+    }
+
+    // Too large to keep, send the pending data and this one.
+    if (!Flush())
+        return -1;
+    if ((size_t)length <= kFlushThreshold)
+    {
+        m_buffer.append((const char*)buffer, length);
+        return length;
+    }
+    return SendAll((const char*)buffer, length) ? length : -1;
+}
+
+int Writer::Write(const std::string & buffer)
+{
+    return Write(buffer.data(), (int)buffer.length());
+}
+
+bool Writer::Flush()
+{
+    if (m_buffer.empty())
+        return true;
+    bool ok = SendAll(m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
+    return ok;
+}
+
+int Writer::WriteUnbuffered(const void * buffer, int length)
+{
+    if (!m_stream || length < 0 || !Flush())
+        return -1;
+    return SendAll((const char*)buffer, length) ? length : -1;
+}
+
+std::shared_ptr<StreamSocket> Writer::Hijack(std::string & buffered)
+{
+    if (m_hijacked || !Flush())
+        return nullptr;
+    m_hijacked = true;
+    m_buffered = false;
+    buffered.clear();
+    return m_stream;
+}
+
+bool Writer::SendAll(const char * buffer, size_t length)
+{
+    if (!m_stream)
+        return false;
+    while (length > 0)
+    {
+        int len = m_stream->Send(buffer, (int)length);
+        if (len <= 0)
+        {
+            m_error = WSAGetLastError();
+            return false;
+        }
+        buffer += len;
+        length -= len;
+        m_bytesSent += len;
+    }
+    return true;
+}
+
+} // !namespace http
+} // !namespace net
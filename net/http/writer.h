@@ -0,0 +1,117 @@
+// The MIT License (MIT)
+//
+// Copyright(c) 2016 huan.wang
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files(the "Software"),
+// to deal in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// 
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "net/http/response.h"
+#include "net/socket/StreamSocket.h"
+
+namespace net {
+namespace http {
+
+// ResponseWriter sends the response of a request, as an HTTP/1.x message on the
+// connection or on the stream of the request in HTTP/2.
+class ResponseWriter
+{
+public:
+    virtual ~ResponseWriter() {}
+
+    // WriteHeader sends the status line and headers of |response|, followed by the
+    // first |length| bytes of the body. It returns -1 on failure.
+    virtual int WriteHeader(const Response& response, const void* body, int length) = 0;
+
+    // Write sends more of the body. It returns |length| on success and -1 on failure.
+    virtual int Write(const void* buffer, int length) = 0;
+
+    virtual bool Flush() = 0;
+
+    // WriteUnbuffered flushes the buffered data and sends |buffer| at once, without
+    // copying it into the buffer. It returns |length| on success and -1 on failure.
+    virtual int WriteUnbuffered(const void* buffer, int length)
+    {
+        if (Write(buffer, length) < 0 || !Flush())
+            return -1;
+        return length;
+    }
+
+    // Finish is called once the response is complete.
+    virtual bool Finish() = 0;
+
+    // Hijack takes the connection over from the server, e.g. for WebSocket.
+    // |buffered| receives the bytes already received after the request.
+    // It returns nullptr if the connection can't be taken over.
+    virtual std::shared_ptr<StreamSocket> Hijack(std::string& buffered) { return nullptr; }
+};
+
+// Writer sends the messages of a connection.
+// In buffered mode the data is kept in memory until Flush is called, so that the
+// responses of pipelined requests can be sent with a single send.
+class Writer
+    : public ResponseWriter
+{
+public:
+    Writer(std::shared_ptr<StreamSocket> s);
+    ~Writer() {}
+
+    std::shared_ptr<StreamSocket> GetStreamSocket() const;
+    int GetErrorCode() const;
+    // GetBytesSent returns the number of bytes sent to the socket so far.
+    uint64_t GetBytesSent() const;
+
+    bool GetBuffered() const;
+    void SetBuffered(bool buffered);
+
+    // GetBufferedBytes returns the number of bytes waiting for Flush.
+    size_t GetBufferedBytes() const;
+
+    int WriteHeader(const Response& response, const void* body, int length) override;
+
+    // Write returns |length| on success and -1 on failure.
+    // The buffer is flushed automatically once it grows beyond the flush threshold.
+    int Write(const void* buffer, int length) override;
+    int Write(const std::string& buffer);
+
+    // Flush sends all the buffered data.
+    bool Flush() override;
+
+    int WriteUnbuffered(const void* buffer, int length) override;
+
+    // The connection stays open for the next response.
+    bool Finish() override { return true; }
+
+    std::shared_ptr<StreamSocket> Hijack(std::string& buffered) override;
+    bool IsHijacked() const { return m_hijacked; }
+
+private:
+    bool SendAll(const char* buffer, size_t length);
+
+private:
+    std::shared_ptr<StreamSocket> m_stream;
+    std::string m_buffer;
+    bool m_buffered = false;
+    bool m_hijacked = false;
+    int m_error = 0;
+    uint64_t m_bytesSent = 0;
+};
+
+} // !namespace http
+} // !namespace net
@@ -22,6 +22,37 @@
 #include "net/socket/ServerSocketImpl.h"
 
 namespace net {
+namespace {
+
+bool ReceiveAll(StreamSocket& channel, void* buffer, int length)
+{
+    auto p = static_cast<char*>(buffer);
+    while (length > 0)
+    {
+        int n = channel.Receive(p, length);
+        if (n <= 0)
+            return false;
+        p += n;
+        length -= n;
+    }
+    return true;
+}
+
+bool SendAll(StreamSocket& channel, const void* buffer, int length)
+{
+    auto p = static_cast<const char*>(buffer);
+    while (length > 0)
+    {
+        int n = channel.Send(p, length);
+        if (n <= 0)
+            return false;
+        p += n;
+        length -= n;
+    }
+    return true;
+}
+
+} // !namespace anonymous
 
 ServerSocket::ServerSocket()
     : Socket(std::make_shared<ServerSocketImpl>())
@@ -83,4 +114,58 @@ std::shared_ptr<StreamSocket> ServerSocket::Accept()
     return std::make_shared<StreamSocket>(GetImpl()->Accept());
 }
 
+ServerSocket ServerSocket::FromNativeHandle(NativeHandle handle)
+{
+    return ServerSocket(Socket(std::make_shared<ServerSocketImpl>(handle)));
+}
+
+bool ServerSocket::SetInheritable(bool inheritable)
+{
+    return std::static_pointer_cast<ServerSocketImpl>(GetImpl())->SetInheritable(inheritable);
+}
+
+bool ServerSocket::Duplicate(uint32_t processId, std::string& sharedInfo) const
+{
+    return std::static_pointer_cast<ServerSocketImpl>(GetImpl())->Duplicate(processId, sharedInfo);
+}
+
+ServerSocket ServerSocket::FromSharedInfo(const std::string& sharedInfo)
+{
+    auto pImpl = std::make_shared<ServerSocketImpl>();
+    pImpl->Adopt(sharedInfo);
+    return ServerSocket(Socket(pImpl));
+}
+
+bool ServerSocket::HandOff(StreamSocket& channel) const
+{
+    uint32_t processId = 0;
+    if (!ReceiveAll(channel, &processId, sizeof(processId)))
+        return false;
+    std::string sharedInfo;
+    if (!Duplicate(ntohl(processId), sharedInfo))
+        return false;
+    uint32_t length = htonl(static_cast<uint32_t>(sharedInfo.size()));
+    return SendAll(channel, &length, sizeof(length))
+        && SendAll(channel, sharedInfo.data(), static_cast<int>(sharedInfo.size()));
+}
+
+ServerSocket ServerSocket::TakeOver(StreamSocket& channel)
+{
+    // The shared information is a WSAPROTOCOL_INFO, much smaller than this.
+    const uint32_t kMaxSharedInfo = 4096;
+
+    uint32_t processId = htonl(static_cast<uint32_t>(GetCurrentProcessId()));
+    uint32_t length = 0;
+    std::string sharedInfo;
+    if (SendAll(channel, &processId, sizeof(processId))
+        && ReceiveAll(channel, &length, sizeof(length))
+        && (length = ntohl(length)) <= kMaxSharedInfo)
+    {
+        sharedInfo.resize(length);
+        if (!ReceiveAll(channel, &sharedInfo[0], static_cast<int>(length)))
+            sharedInfo.clear();
+    }
+    return FromSharedInfo(sharedInfo);
+}
+
 } //!net
\ No newline at end of file
@@ -37,6 +37,23 @@ public:
     virtual bool Bind(uint16_t port, bool bReuse = false);
     virtual bool Listen(int backlog = 64);
     virtual std::shared_ptr<StreamSocket> Accept();
+
+    // A listening socket can be passed to another process, e.g. the new binary of an
+    // upgraded server, which accepts from the same queue so that no connection is refused
+    // while the old one shuts down.
+    // FromNativeHandle adopts a handle inherited from the parent process, the parent
+    // makes it inheritable with SetInheritable before creating the child.
+    static ServerSocket FromNativeHandle(NativeHandle handle);
+    bool SetInheritable(bool inheritable);
+    // Duplicate describes the socket for the process |processId| in |sharedInfo|,
+    // which that process hands to FromSharedInfo to get its own handle.
+    bool Duplicate(uint32_t processId, std::string& sharedInfo) const;
+    static ServerSocket FromSharedInfo(const std::string& sharedInfo);
+    // HandOff passes the socket to the process on the other end of |channel|, which
+    // calls TakeOver: it sends its process id and gets the shared information back.
+    // The socket returned by TakeOver has no handle on failure.
+    bool HandOff(StreamSocket& channel) const;
+    static ServerSocket TakeOver(StreamSocket& channel);
 };
 
 } //!net
\ No newline at end of file
@@ -24,8 +24,45 @@ ServerSocketImpl::ServerSocketImpl()
 {
 }
 
+ServerSocketImpl::ServerSocketImpl(NativeHandle sockfd)
+    : ServerSocketImpl()
+{
+    // An inherited handle still needs WinSock to be initialized in this process.
+    Reset(sockfd);
+}
+
 ServerSocketImpl::~ServerSocketImpl()
 {
 }
 
+bool ServerSocketImpl::SetInheritable(bool inheritable)
+{
+    return SetHandleInformation(reinterpret_cast<HANDLE>(m_sockfd), HANDLE_FLAG_INHERIT,
+        inheritable ? HANDLE_FLAG_INHERIT : 0) != FALSE;
+}
+
+bool ServerSocketImpl::Duplicate(uint32_t processId, std::string& sharedInfo) const
+{
+    WSAPROTOCOL_INFOW info;
+    if (WSADuplicateSocketW(m_sockfd, processId, &info) != 0)
+        return false;
+    sharedInfo.assign(reinterpret_cast<const char*>(&info), sizeof(info));
+    return true;
+}
+
+bool ServerSocketImpl::Adopt(const std::string& sharedInfo)
+{
+    if (sharedInfo.size() != sizeof(WSAPROTOCOL_INFOW))
+        return false;
+    WSAPROTOCOL_INFOW info;
+    memcpy(&info, sharedInfo.data(), sizeof(info));
+    auto sockfd = WSASocketW(FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO,
+        &info, 0, WSA_FLAG_OVERLAPPED);
+    if (INVALID_SOCKET == sockfd)
+        return false;
+    Close();
+    Reset(sockfd);
+    return true;
+}
+
 } //!net
\ No newline at end of file
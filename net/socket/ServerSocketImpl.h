@@ -17,6 +17,8 @@
 // ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
+#include <string>
+
 #include "net/socket/SocketImpl.h"
 
 namespace net {
@@ -26,7 +28,12 @@ class ServerSocketImpl :
 {
 public:
     ServerSocketImpl();
+    ServerSocketImpl(NativeHandle sockfd);
     virtual ~ServerSocketImpl();
+
+    bool SetInheritable(bool inheritable);
+    bool Duplicate(uint32_t processId, std::string& sharedInfo) const;
+    bool Adopt(const std::string& sharedInfo);
 };
 
 } //!net
\ No newline at end of file
@@ -16,7 +16,6 @@
 // WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
 // ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
-#include <cassert>
 #include <thread>
 #include "net/socket/StreamSocketImpl.h"
 
@@ -43,7 +42,8 @@ int StreamSocketImpl::Send(const char* buffer, int length, int flags /*= 0*/)
     while (remaining > 0)
     {
         int n = SocketImpl::Send(p, remaining, flags);
-        assert(n >= 0);
+        if (n < 0)
+            return sent > 0 ? sent : n;
         p += n;
         sent += n;
         remaining -= n;